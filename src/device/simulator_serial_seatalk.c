@@ -189,13 +189,19 @@ static int simulator_open(
  */
 static int simulator_close(struct device_t * device)
 {
+	struct itimerval timerval;
+
 	if (device == NULL)
 		return -1;
 	if (device->fd < 0)
 		return 0;
 
-	sigaction(SIGALRM, NULL, NULL);
+	/* stop the periodic handler */
+	memset(&timerval, 0, sizeof(timerval));
+	setitimer(ITIMER_REAL, &timerval, NULL);
+
 	close(simulator_data.fd);
+	simulator_data.fd = -1;
 	close(device->fd);
 
 	device->fd = -1;
@@ -1,6 +1,9 @@
 #include <navcom/destination/dst_lua.h>
 #include <navcom/destination/dst_lua_private.h>
 #include <navcom/lua_helper.h>
+#include <navcom/lua_cache.h>
+#include <navcom/lua_alloc.h>
+#include <navcom/lua_gc.h>
 #include <navcom/lua_syslog.h>
 #include <navcom/lua_debug.h>
 #include <navcom/lua_message.h>
@@ -55,6 +58,8 @@ static int process_message(
 		struct dst_lua_data_t * data,
 		const struct message_t * msg)
 {
+	int rc;
+
 	if (data == NULL)
 		return EXIT_FAILURE;
 	if (msg == NULL)
@@ -62,8 +67,11 @@ static int process_message(
 
 	if (setjmp(data->env) == 0) {
 		lua_getglobal(data->lua, "handle");
-		lua_pushlightuserdata(data->lua, (void*)msg);
-		return luaH_check_error(data->lua, lua_pcall(data->lua, 1, 0, 0));
+		luaH_pushmsg(data->lua, data->msg, (struct message_t *)msg);
+		rc = luaH_check_error(data->lua, lua_pcall(data->lua, 1, 0, 0));
+		luaH_clearmsg(data->lua, data->msg);
+		luaH_gc_called(&data->gc);
+		return rc;
 	} else {
 		lua_atpanic(data->lua, NULL);
 		syslog(LOG_CRIT, "LUA: %s", lua_tostring(data->lua, -1));
@@ -97,6 +105,7 @@ static int init_proc(
 {
 	int rc;
 	lua_State * lua = NULL;
+	size_t limit = 0;
 	const struct property_t * prop_script = NULL;
 	const struct property_t * prop_debug = NULL;
 	struct dst_lua_data_t * data;
@@ -120,7 +129,10 @@ static int init_proc(
 		return rc;
 
 	/* setup lua state */
-	lua = luaL_newstate();
+	if (luaH_alloc_limit_from_prop(properties, &limit) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	luaH_alloc_init(&data->alloc, limit);
+	lua = luaH_newstate(&data->alloc);
 	if (!lua) {
 		syslog(LOG_ERR, "unable to create lua state");
 		return EXIT_FAILURE;
@@ -136,13 +148,18 @@ static int init_proc(
 			syslog(LOG_ERR, "unable to setup lua state");
 			return EXIT_FAILURE;
 		}
+		data->msg = luaH_newmsg(lua, 1);
 
 		/* load/execute script */
-		if (luaL_dofile(lua, prop_script->value) != LUA_OK) {
+		if (luaH_dofile(lua, prop_script->value) != LUA_OK) {
 			syslog(LOG_ERR, "unable to load and execute script: '%s'", prop_script->value);
 			lua_close(lua);
 			return EXIT_FAILURE;
 		}
+		if (luaH_gc_setup(&data->gc, lua, properties) != EXIT_SUCCESS) {
+			lua_close(lua);
+			return EXIT_FAILURE;
+		}
 
 		data->lua = lua;
 		return EXIT_SUCCESS;
@@ -172,9 +189,12 @@ static int exit_proc(struct proc_config_t * config)
 
 	data = (struct dst_lua_data_t *)config->data;
 	if (data->lua) {
+		luaH_alloc_log_stats(&data->alloc, config->cfg ? config->cfg->name : "dst_lua");
+		luaH_gc_log_stats(&data->gc, config->cfg ? config->cfg->name : "dst_lua");
 		lua_close(data->lua);
 		data->lua = NULL;
 	}
+	luaH_alloc_destroy(&data->alloc);
 
 	free(config->data);
 	config->data = NULL;
@@ -229,7 +249,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
@@ -251,6 +271,10 @@ static int proc(struct proc_config_t * config)
 					syslog(LOG_WARNING, "unknown msg type: %08x\n", msg.type);
 					break;
 			}
+
+			/* collect garbage while idle */
+			while (!proc_input_pending(config) && luaH_gc_idle(&data->gc, data->lua))
+				;
 			continue;
 		}
 	}
@@ -267,6 +291,12 @@ static void help(void)
 	printf("\n");
 	printf("Configuration options:\n");
 	printf("  script : filename of the Lua script to execute.\n");
+	printf("  memory_limit : [optional] maximum memory of the Lua state in KiB, default: unlimited\n");
+	printf("  gc : [optional] 'auto' or 'idle', default: 'auto'. With 'idle' the garbage is\n");
+	printf("       collected in small steps between messages instead of during script calls.\n");
+	printf("  gc_pause : [optional] pause of the garbage collector in percent, default: 400 with 'idle'\n");
+	printf("  gc_stepmul : [optional] step multiplier of the garbage collector in percent\n");
+	printf("  gc_step : [optional] work per idle step of the garbage collector in KiB, default: 4\n");
 	printf("  DEBUG  : [optional] a combination of 'c', 'r' and 'l' for debugging purposes.\n");
 	printf("           c : call, traces function calls\n");
 	printf("           r : return, traces function returns\n");
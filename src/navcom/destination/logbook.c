@@ -11,7 +11,6 @@
 #include <string.h>
 #include <unistd.h>
 #include <limits.h>
-#include <math.h>
 #include <stdbool.h>
 #include <nmea/nmea.h>
 
@@ -125,15 +124,78 @@ static long elapsed_ms_time(const struct timeval * tm)
 	return dt;
 }
 
-static double sqr(double x)
+/**
+ * Returns the angle in micro degrees, negative for the specified direction.
+ */
+static int64_t signed_microdeg(const struct nmea_angle_t * angle, char dir, char negative)
+{
+	uint32_t v = 0;
+
+	nmea_angle_to_microdeg(&v, angle);
+	return (dir == negative) ? -(int64_t)v : (int64_t)v;
+}
+
+/**
+ * Returns the cosine of the angle (in micro degrees, within [-90, 90]
+ * degrees) in units of 2^-30. Taylor polynomials are used, of the
+ * cosine up to 45 degrees, of the sine of the complement beyond.
+ */
+static int64_t cos_q30(int64_t microdeg)
+{
+	static const int64_t ONE = (int64_t)1 << 30;
+	static const int64_t RAD = 18740714; /* radians per micro degree, in units of 2^-30 / 1e6 */
+
+	int64_t x;
+	int64_t x2;
+	int64_t t;
+
+	if (microdeg < 0)
+		microdeg = -microdeg;
+	if (microdeg > 45000000) {
+		x = (90000000 - microdeg) * RAD / 1000000;
+		x2 = (x * x) >> 30;
+		t = ONE - x2 / 42;
+		t = ONE - ((x2 * t) >> 30) / 20;
+		t = ONE - ((x2 * t) >> 30) / 6;
+		return (x * t) >> 30;
+	}
+	x = microdeg * RAD / 1000000;
+	x2 = (x * x) >> 30;
+	t = ONE - x2 / 56;
+	t = ONE - ((x2 * t) >> 30) / 30;
+	t = ONE - ((x2 * t) >> 30) / 12;
+	return ONE - ((x2 * t) >> 30) / 2;
+}
+
+/**
+ * Returns the integer square root.
+ */
+static uint64_t isqrt(uint64_t v)
 {
-	return x * x;
+	uint64_t r = 0;
+	uint64_t b = (uint64_t)1 << 62;
+
+	while (b > v)
+		b >>= 2;
+	for (; b; b >>= 2) {
+		if (v >= r + b) {
+			v -= r + b;
+			r = (r >> 1) + b;
+		} else {
+			r >>= 1;
+		}
+	}
+	return r;
 }
 
 /**
  * Returns the number of meters the positon has changed since the last
  * write update.
  *
+ * The distance is computed in fixed point, as equirectangular projection
+ * of the differences in micro degrees. This is precise enough for the
+ * distances between consecutive positions.
+ *
  * @param[in] last Last written information.
  * @param[in] curr Current information to compare.
  * @retval    -1 Unable to calculate distance
@@ -143,33 +205,27 @@ static long diff_position(
 		const struct information_t * last,
 		const struct information_t * curr)
 {
-	static const double EARTH_RADIUS = 6378000.0; /* [m] mean radius */
+	static const uint64_t METERS_PER_DEGREE = 111317; /* 2 * pi * 6378000 m / 360 */
 
-	double lat_0 = 0.0;
-	double lat_1 = 0.0;
-	double lon_0 = 0.0;
-	double lon_1 = 0.0;
+	int64_t lat_0 = signed_microdeg(&last->lat, last->lat_dir, 'S');
+	int64_t lon_0 = signed_microdeg(&last->lon, last->lon_dir, 'W');
+	int64_t lat_1 = signed_microdeg(&curr->lat, curr->lat_dir, 'S');
+	int64_t lon_1 = signed_microdeg(&curr->lon, curr->lon_dir, 'W');
+	int64_t dlat = lat_1 - lat_0;
+	int64_t dlon = lon_1 - lon_0;
+	int64_t dx;
 
-	nmea_angle_to_double(&lat_0, &last->lat);
-	nmea_angle_to_double(&lon_0, &last->lon);
-	nmea_angle_to_double(&lat_1, &curr->lat);
-	nmea_angle_to_double(&lon_1, &curr->lon);
-
-	if (last->lat_dir != 'N')
-		lat_0 = -lat_0;
-	if (last->lon_dir != 'W')
-		lon_0 = -lon_0;
-	if (curr->lat_dir != 'N')
-		lat_1 = -lat_1;
-	if (curr->lon_dir != 'W')
-		lon_1 = -lon_1;
+	if ((lat_0 < -90000000) || (lat_0 > 90000000) || (lat_1 < -90000000) || (lat_1 > 90000000))
+		return -1;
 
-	/* calculate distance in meters on sphere, precise enough approximation */
+	/* shorter way across the antimeridian */
+	if (dlon > 180000000)
+		dlon -= 360000000;
+	else if (dlon < -180000000)
+		dlon += 360000000;
 
-	return (long)round(EARTH_RADIUS * atan(sqrt(
-		sqr(cos(lat_1) * sin(lon_1 - lon_0))
-			+ sqr(cos(lat_0) * sin(lat_1) - sin(lat_1) * cos(lat_1) * cos(lon_1 - lon_0)))
-		/ (sin(lat_0) * sin(lat_1) + cos(lat_0) * cos(lat_1) * cos(lon_1 - lon_0))));
+	dx = dlon * cos_q30((lat_0 + lat_1) / 2) / ((int64_t)1 << 30);
+	return (long)((isqrt((uint64_t)(dx * dx + dlat * dlat)) * METERS_PER_DEGREE + 500000) / 1000000);
 }
 
 /**
@@ -709,7 +765,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
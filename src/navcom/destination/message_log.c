@@ -2,31 +2,174 @@
 #include <navcom/message.h>
 #include <navcom/message_comm.h>
 #include <navcom/property_read.h>
+#include <navcom/trace.h>
+#include <navcom/metrics.h>
 #include <common/macros.h>
 #include <common/fileutil.h>
 #include <sys/select.h>
 #include <sys/signalfd.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <syslog.h>
 
+/**
+ * Default values of the properties.
+ */
+#define DEFAULT_BUFFER 65536
+#define DEFAULT_FLUSH  1000
+
 struct message_log_data_t {
 	int enable;
 	char dst[PATH_MAX];
 	uint32_t max_errors;
+
+	uint32_t buffer_size; /* size of the user space buffer in bytes */
+	uint32_t flush_interval; /* maximum time data stays in the buffer, msec */
+	uint32_t sync_interval; /* maximum time data stays in the page cache, msec, 0 = no sync */
+
+	FILE * file; /* destination, kept open */
+	char * buffer;
+	int dirty; /* data in the buffer, not flushed yet */
+	int unsynced; /* data flushed but not synced yet */
+	uint64_t flush_time; /* time to flush the buffer at the latest, nsec */
+	uint64_t sync_time; /* time to sync the file at the latest, nsec */
 };
 
+/**
+ * Opens the destination file for appending, buffered by the
+ * user space buffer.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int open_file(struct message_log_data_t * data)
+{
+	data->file = fopen(data->dst, "at");
+	if (data->file == NULL) {
+		syslog(LOG_ERR, "unable to open destination '%s': %s", data->dst, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (setvbuf(data->file, data->buffer, _IOFBF, data->buffer_size) != 0)
+		syslog(LOG_WARNING, "unable to set buffer for destination '%s'", data->dst);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Writes the data of the page cache to the storage.
+ */
+static int sync_file(struct message_log_data_t * data)
+{
+	data->unsynced = 0;
+	if (data->file == NULL)
+		return EXIT_SUCCESS;
+	if (fdatasync(fileno(data->file)) < 0) {
+		syslog(LOG_ERR, "unable to sync destination '%s': %s", data->dst, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Writes the buffered data to the file. If the file is to be synced,
+ * the time to do so is determined.
+ */
+static int flush_file(struct message_log_data_t * data)
+{
+	if (!data->dirty)
+		return EXIT_SUCCESS;
+	data->dirty = 0;
+	if (data->file == NULL)
+		return EXIT_SUCCESS;
+	if (fflush(data->file) != 0) {
+		syslog(LOG_ERR, "unable to write destination '%s': %s", data->dst, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (data->sync_interval && !data->unsynced) {
+		data->unsynced = 1;
+		data->sync_time = metrics_now() + (uint64_t)data->sync_interval * 1000000;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Flushes and syncs (if configured) all data and closes the file.
+ */
+static void close_file(struct message_log_data_t * data)
+{
+	if (data->file == NULL)
+		return;
+	flush_file(data);
+	if (data->unsynced)
+		sync_file(data);
+	fclose(data->file);
+	data->file = NULL;
+}
+
+/**
+ * Closes and opens the file again, e.g. after it was rotated.
+ */
+static int reopen_file(struct message_log_data_t * data)
+{
+	if (strlen(data->dst) == 0)
+		return EXIT_SUCCESS;
+	close_file(data);
+	return open_file(data);
+}
+
+/**
+ * Flushes and syncs the file, if their time has come.
+ */
+static int service_file(struct message_log_data_t * data)
+{
+	uint64_t now = metrics_now();
+	int rc = EXIT_SUCCESS;
+
+	if (data->dirty && (now >= data->flush_time))
+		rc = flush_file(data);
+	if (data->unsynced && (now >= data->sync_time)) {
+		if (sync_file(data) != EXIT_SUCCESS)
+			rc = EXIT_FAILURE;
+	}
+	return rc;
+}
+
+/**
+ * Returns the time until the next flush or sync is due, for select.
+ *
+ * @retval NULL Nothing to do.
+ */
+static struct timeval * service_timeout(const struct message_log_data_t * data, struct timeval * tm)
+{
+	uint64_t now;
+	uint64_t t;
+
+	if (data->dirty && data->unsynced)
+		t = min(data->flush_time, data->sync_time);
+	else if (data->dirty)
+		t = data->flush_time;
+	else if (data->unsynced)
+		t = data->sync_time;
+	else
+		return NULL;
+
+	now = metrics_now();
+	t = (t > now) ? (t - now) / 1000 : 0;
+	tm->tv_sec = t / 1000000;
+	tm->tv_usec = t % 1000000;
+	return tm;
+}
+
 #if defined(NEEDS_NMEA)
 static int log_nmea_message(
 		const struct message_t * msg,
-		const struct message_log_data_t * data)
+		struct message_log_data_t * data)
 {
 	int rc;
 	char buf[NMEA_MAX_SENTENCE];
-	FILE * file;
 
 	if (msg == NULL)
 		return EXIT_FAILURE;
@@ -40,19 +183,22 @@ static int log_nmea_message(
 		return EXIT_FAILURE;
 	}
 
-	/* only to syslog if no destination is configured */
+	/* only to the trace buffer if no destination is configured */
 	if (strlen(data->dst) == 0) {
-		syslog(LOG_DEBUG, "%s", buf);
+		TRACE(TRACE_DESTINATION, "%s", buf);
 		return EXIT_SUCCESS;
 	}
 
-	file = fopen(data->dst, "at");
-	if (file == NULL) {
-		syslog(LOG_ERR, "unable to open destination '%s': %s", data->dst, strerror(errno));
+	if ((data->file == NULL) && (open_file(data) != EXIT_SUCCESS))
 		return EXIT_FAILURE;
+	if (fprintf(data->file, "%s\n", buf) < 0) {
+		syslog(LOG_ERR, "unable to write destination '%s': %s", data->dst, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (!data->dirty) {
+		data->dirty = 1;
+		data->flush_time = metrics_now() + (uint64_t)data->flush_interval * 1000000;
 	}
-	fprintf(file, "%s\n", buf);
-	fclose(file);
 
 	return EXIT_SUCCESS;
 }
@@ -87,18 +233,38 @@ static int init_proc(
 	if (property_read_uint32(properties, "max_errors",  &data->max_errors) != EXIT_SUCCESS)
 		return EXIT_FAILURE;
 
+	data->buffer_size = DEFAULT_BUFFER;
+	data->flush_interval = DEFAULT_FLUSH;
+	data->sync_interval = 0;
+	if (property_read_uint32(properties, "buffer", &data->buffer_size) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (property_read_uint32(properties, "flush", &data->flush_interval) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (property_read_uint32(properties, "sync", &data->sync_interval) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (data->buffer_size == 0) {
+		syslog(LOG_ERR, "%s:invalid buffer size", config->cfg->name);
+		return EXIT_FAILURE;
+	}
+	data->buffer = malloc(data->buffer_size);
+	if (data->buffer == NULL)
+		return EXIT_FAILURE;
+
 	prop_dst = proplist_find(properties, "dst");
 	if (prop_dst) {
 		if (file_is_writable(prop_dst->value)) {
 			strncpy(data->dst, prop_dst->value, sizeof(data->dst));
 		} else {
-			syslog(LOG_ERR, "%s:destination not writable, logging to syslog only", config->cfg->name);
+			syslog(LOG_ERR, "%s:destination not writable, logging to trace only", config->cfg->name);
 		}
 	} else {
-		syslog(LOG_ERR, "%s:no destination specified, logging to syslog only", config->cfg->name);
+		syslog(LOG_ERR, "%s:no destination specified, logging to trace only", config->cfg->name);
 	}
 
-	syslog(LOG_DEBUG, "%s:enable:%d dst:'%s'", config->cfg->name, data->enable, data->dst);
+	syslog(LOG_DEBUG, "%s:enable:%d dst:'%s' buffer:%u flush:%u sync:%u", config->cfg->name,
+		data->enable, data->dst, data->buffer_size, data->flush_interval, data->sync_interval);
+	if ((strlen(data->dst) > 0) && (open_file(data) != EXIT_SUCCESS))
+		return EXIT_FAILURE;
 	return EXIT_SUCCESS;
 }
 
@@ -112,6 +278,10 @@ static int exit_proc(struct proc_config_t * config)
 		return EXIT_FAILURE;
 
 	if (config->data) {
+		struct message_log_data_t * data = (struct message_log_data_t *)config->data;
+		close_file(data);
+		if (data->buffer)
+			free(data->buffer);
 		free(config->data);
 		config->data = NULL;
 	}
@@ -128,6 +298,7 @@ static int proc(struct proc_config_t * config)
 	uint32_t cnt_error = 0;
 	struct message_log_data_t * data;
 	struct signalfd_siginfo signal_info;
+	struct timeval tm;
 
 	if (!config)
 		return EXIT_FAILURE;
@@ -146,13 +317,14 @@ static int proc(struct proc_config_t * config)
 		if (config->signal_fd > fd_max)
 			fd_max = config->signal_fd;
 
-		rc = select(fd_max + 1, &rfds, NULL, NULL, NULL);
+		rc = select(fd_max + 1, &rfds, NULL, NULL, service_timeout(data, &tm));
 		if (rc < 0 && errno != EINTR) {
 			syslog(LOG_ERR, "error in 'select': %s", strerror(errno));
 			return EXIT_FAILURE;
 		} else if (rc < 0 && errno == EINTR) {
 			break;
 		} else if (rc == 0) {
+			service_file(data);
 			continue;
 		}
 
@@ -168,18 +340,28 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
 					switch (msg.data.attr.system) {
 						case SYSTEM_TERMINATE:
+							close_file(data);
 							return EXIT_SUCCESS;
+						case SYSTEM_REOPEN:
+							if (reopen_file(data) != EXIT_SUCCESS)
+								++cnt_error;
+							break;
 						default:
 							break;
 					}
 					break;
 
+				case MSG_TIMER:
+					if (flush_file(data) != EXIT_SUCCESS)
+						++cnt_error;
+					break;
+
 				case MSG_NMEA:
 #if defined(NEEDS_NMEA)
 					if (data->enable) {
@@ -206,9 +388,11 @@ static int proc(struct proc_config_t * config)
 					syslog(LOG_WARNING, "unknown msg type: %08x\n", msg.type);
 					break;
 			}
+			service_file(data);
 			continue;
 		}
 	}
+	close_file(data);
 	return EXIT_SUCCESS;
 }
 
@@ -225,7 +409,15 @@ static void help(void)
 	printf("               if this threshold is reached. As errors counts all write errors to\n");
 	printf("               the configured destination or a corrupt NMEA message.\n");
 	printf("  dst        : device/file to which the messages are being logged. If this is not\n");
-	printf("               specified, messages are logged only to syslog.\n");
+	printf("               specified, messages are logged only to the trace buffer of navd\n");
+	printf("               (category 'destination', see option --trace).\n");
+	printf("  buffer     : size of the write buffer in bytes, default: %d\n", DEFAULT_BUFFER);
+	printf("  flush      : maximum time in msec messages stay in the buffer, default: %d.\n", DEFAULT_FLUSH);
+	printf("               The buffer is also flushed if it is full, or a timer message is received.\n");
+	printf("  sync       : maximum time in msec written data may stay in the page cache before\n");
+	printf("               it is synced to the storage (fdatasync), default: 0 (never)\n");
+	printf("\n");
+	printf("The destination file is reopened upon SIGHUP (to the hub), e.g. after log rotation.\n");
 	printf("\n");
 	printf("Example:\n");
 	printf("  log : message_log { enable };\n");
@@ -234,6 +426,8 @@ static void help(void)
 	printf("\n");
 	printf("  log : message_log { enable, dst:'some_logfile.txt' };\n");
 	printf("\n");
+	printf("  log : message_log { enable, dst:'/var/log/nmea.txt', flush:5000, sync:60000 };\n");
+	printf("\n");
 }
 
 const struct proc_desc_t message_log = {
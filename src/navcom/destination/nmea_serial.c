@@ -2,15 +2,23 @@
 #include <navcom/property_serial.h>
 #include <navcom/message.h>
 #include <navcom/message_comm.h>
+#include <navcom/message_queue.h>
 #include <common/macros.h>
 #include <sys/select.h>
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <sys/signalfd.h>
 
+/**
+ * Maximum number of different sentences held in the output mode 'latest'.
+ */
+#define MAX_LATEST 32
+
 /**
  * Source specific data.
  */
@@ -18,6 +26,25 @@ struct nmea_serial_data_t
 {
 	int initialized;
 	struct serial_config_t serial_config;
+
+	/**
+	 * Output mode 'latest': only the latest message per sentence is
+	 * held and the sentences are sent round robin at the line rate.
+	 */
+	int latest;
+
+	/**
+	 * Latest messages not sent yet, at most one per sentence. A newer
+	 * message replaces the older one at its position, therefore the
+	 * sentences are sent round robin.
+	 */
+	struct message_queue_t pending;
+
+	/**
+	 * Earliest time to send the next sentence, the previous one
+	 * is on the wire until then.
+	 */
+	struct timespec next;
 };
 
 static void init_data(struct nmea_serial_data_t * data)
@@ -31,35 +58,105 @@ static void init_data(struct nmea_serial_data_t * data)
 	data->serial_config.parity = PARITY_NONE;
 }
 
+/**
+ * Sends the NMEA sentence to the device.
+ *
+ * @param[in] ops Device operations.
+ * @param[in] device The device to write to.
+ * @param[in] msg The message to send.
+ * @param[out] len Number of characters written, may be NULL.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
 static int send_data(
 		const struct device_operations_t * ops,
 		struct device_t * device,
-		const struct message_t * msg)
+		const struct message_t * msg,
+		uint32_t * len)
 {
 	int rc;
-	char buf[NMEA_MAX_SENTENCE + 1];
+	char buf[NMEA_MAX_SENTENCE + 3];
 
 	memset(buf, 0, sizeof(buf));
-	rc = nmea_write(buf, sizeof(buf), &msg->data.attr.nmea);
+	rc = nmea_write(buf, NMEA_MAX_SENTENCE + 1, &msg->data.attr.nmea);
 	if (rc < 0) {
 		syslog(LOG_ERR, "unable to write NMEA data to buffer");
 		return EXIT_FAILURE;
 	}
 
+	/* sentences are terminated by <CR><LF> on the wire */
+	buf[rc++] = '\r';
+	buf[rc++] = '\n';
+
 	rc = ops->write(device, buf, (uint32_t)rc);
 	if (rc < 0) {
 		syslog(LOG_ERR, "unable to write to serial device: %s", strerror(errno));
 		return EXIT_FAILURE;
 	}
 
+	if (len)
+		*len = (uint32_t)rc;
 	return EXIT_SUCCESS;
 }
 
+/**
+ * Returns the time in nsec needed to transmit the specified number
+ * of characters, according to the serial configuration (start bit,
+ * data bits, parity and stop bits).
+ */
+static uint64_t line_time(const struct serial_config_t * config, uint32_t len)
+{
+	uint64_t bits = 1 + config->data_bits + config->stop_bits;
+
+	if (config->parity != PARITY_NONE)
+		++bits;
+	return (uint64_t)len * bits * 1000000000ull / config->baud_rate;
+}
+
+/**
+ * Returns the time in nsec from 'a' to 'b', zero if 'b' is before 'a'.
+ */
+static uint64_t time_until(const struct timespec * a, const struct timespec * b)
+{
+	int64_t t = (int64_t)(b->tv_sec - a->tv_sec) * 1000000000ll + (b->tv_nsec - a->tv_nsec);
+
+	return (t > 0) ? (uint64_t)t : 0;
+}
+
+/**
+ * Sends the next pending sentence, if the previous one is through.
+ * The time the sentence needs on the wire is used to determine the
+ * time of the next one.
+ */
+static void send_latest(
+		struct nmea_serial_data_t * data,
+		const struct device_operations_t * ops,
+		struct device_t * device)
+{
+	struct timespec now;
+	uint64_t t;
+	uint32_t len = 0;
+
+	if (message_queue_empty(&data->pending))
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (time_until(&now, &data->next) > 0)
+		return;
+
+	send_data(ops, device, message_queue_front(&data->pending), &len);
+	message_queue_pop(&data->pending);
+
+	t = line_time(&data->serial_config, len);
+	data->next.tv_sec = now.tv_sec + (now.tv_nsec + t) / 1000000000ull;
+	data->next.tv_nsec = (now.tv_nsec + t) % 1000000000ull;
+}
+
 static int init_proc(
 		struct proc_config_t * config,
 		const struct property_list_t * properties)
 {
 	struct nmea_serial_data_t * data = NULL;
+	const char * mode;
 
 	if (!config)
 		return EXIT_FAILURE;
@@ -72,6 +169,18 @@ static int init_proc(
 	config->data = data;
 	init_data(data);
 
+	mode = proplist_value(properties, "mode");
+	if (mode) {
+		if (strcmp(mode, "latest") == 0) {
+			data->latest = 1;
+		} else if (strcmp(mode, "all") != 0) {
+			syslog(LOG_ERR, "invalid mode: '%s'", mode);
+			return EXIT_FAILURE;
+		}
+	}
+	if (message_queue_init(&data->pending, MAX_LATEST, MESSAGE_QUEUE_COALESCE) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
 	if (prop_serial_read_device(&data->serial_config, properties, "device") != EXIT_SUCCESS)
 		return EXIT_FAILURE;
 	if (prop_serial_read_baudrate(&data->serial_config, properties, "baud") != EXIT_SUCCESS)
@@ -97,6 +206,7 @@ static int exit_proc(struct proc_config_t * config)
 		return EXIT_FAILURE;
 
 	if (config->data) {
+		message_queue_destroy(&((struct nmea_serial_data_t *)config->data)->pending);
 		free(config->data);
 		config->data = NULL;
 	}
@@ -109,6 +219,9 @@ static int proc(struct proc_config_t * config)
 	int rc;
 	int fd_max;
 	fd_set rfds;
+	struct timeval tv;
+	struct timespec now;
+	uint64_t t;
 	struct message_t msg;
 	struct signalfd_siginfo signal_info;
 
@@ -147,13 +260,23 @@ static int proc(struct proc_config_t * config)
 		if (config->signal_fd > fd_max)
 			fd_max = config->signal_fd;
 
-		rc = select(fd_max + 1, &rfds, NULL, NULL, NULL);
+		/* pending sentences are sent when the previous one is through */
+		if (!message_queue_empty(&data->pending)) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			t = time_until(&now, &data->next);
+			tv.tv_sec = t / 1000000000ull;
+			tv.tv_usec = (t % 1000000000ull) / 1000;
+			rc = select(fd_max + 1, &rfds, NULL, NULL, &tv);
+		} else {
+			rc = select(fd_max + 1, &rfds, NULL, NULL, NULL);
+		}
 		if (rc < 0 && errno != EINTR) {
 			syslog(LOG_ERR, "error in 'select': %s", strerror(errno));
 			return EXIT_FAILURE;
 		} else if (rc < 0 && errno == EINTR) {
 			break;
 		} else if (rc == 0) {
+			send_latest(data, ops, &device);
 			continue;
 		}
 
@@ -169,7 +292,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
@@ -182,7 +305,12 @@ static int proc(struct proc_config_t * config)
 					break;
 
 				case MSG_NMEA:
-					send_data(ops, &device, &msg);
+					if (data->latest) {
+						message_queue_push(&data->pending, &msg);
+						send_latest(data, ops, &device);
+					} else {
+						send_data(ops, &device, &msg, NULL);
+					}
 					break;
 
 				default:
@@ -195,11 +323,39 @@ static int proc(struct proc_config_t * config)
 	return EXIT_SUCCESS;
 }
 
+static void help(void)
+{
+	printf("\n");
+	printf("nmea_serial\n");
+	printf("\n");
+	printf("Writes NMEA sentences to a serial interface.\n");
+	printf("\n");
+	printf("Configuration options:\n");
+	printf("  device : the device to write data to\n");
+	printf("  baud   : baud rate to operate on, valid values:\n");
+	printf("           300, 600, 1200, 2400, 4800, 9600, 19200\n");
+	printf("           38400, 57600, 115200, 230400\n");
+	printf("  parity : parity check to use, valid values:\n");
+	printf("           none, even, odd, mark\n");
+	printf("  data   : number of data bits, valid values:\n");
+	printf("           5, 6, 7, 8\n");
+	printf("  stop   : number of stop bits, valid values:\n");
+	printf("           1, 2\n");
+	printf("  mode   : output mode, valid values:\n");
+	printf("           all    : every sentence is written (default)\n");
+	printf("           latest : only the latest sentence of every type is kept,\n");
+	printf("                    written round robin at the line rate\n");
+	printf("\n");
+	printf("Example:\n");
+	printf("  out : nmea_serial { device:'/dev/ttyUSB1', baud:4800, mode:'latest' };\n");
+	printf("\n");
+}
+
 const struct proc_desc_t nmea_serial ={
 	.name = "nmea_serial",
 	.init = init_proc,
 	.exit = exit_proc,
 	.func = proc,
-	.help = NULL,
+	.help = help,
 };
 
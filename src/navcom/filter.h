@@ -3,6 +3,8 @@
 
 #include <navcom/message.h>
 #include <common/property.h>
+#include <stddef.h>
+#include <stdio.h>
 
 /**
  * Positive result of a filter operation.
@@ -43,6 +45,23 @@ typedef int (*filter_function)(
 		struct filter_context_t *,
 		const struct property_list_t *);
 
+/**
+ * Prototype of a filter function to process a batch of messages at once.
+ * The result of every message is stored in the array of results, see
+ * filter_function.
+ *
+ * @retval EXIT_SUCCESS The results are valid.
+ * @retval EXIT_FAILURE The batch was not processed, none of the results
+ *   is valid.
+ */
+typedef int (*filter_batch_function)(
+		struct message_t *,
+		const struct message_t *,
+		int *,
+		size_t,
+		struct filter_context_t *,
+		const struct property_list_t *);
+
 /**
  * Prototype of a filter configuration function.
  *
@@ -62,6 +81,22 @@ typedef int (*filter_init_function)(
 typedef int (*filter_exit_function)(
 		struct filter_context_t *);
 
+/**
+ * Prototype for a function to write filter specific statistics.
+ */
+typedef void (*filter_stats_function)(
+		const struct filter_context_t *,
+		FILE *);
+
+/**
+ * Prototype for a function to do work of low priority while the
+ * hub is idle.
+ *
+ * @return Non-zero if there is still work left.
+ */
+typedef int (*filter_idle_function)(
+		struct filter_context_t *);
+
 /**
  * Prototype for a function to print a specific help.
  */
@@ -101,6 +136,29 @@ struct filter_desc_t {
 	 */
 	filter_function func;
 
+	/**
+	 * The filters function to process a batch of messages, called
+	 * with all messages of a source received at once. This is optional,
+	 * if it is NULL, the function 'func' is called for every message.
+	 */
+	filter_batch_function batch;
+
+	/**
+	 * Writes filter specific statistics as key/value pairs, each with
+	 * a leading blank, into the line of the filter within the statistics
+	 * file of the hub. This is optional. If the filter is executed by
+	 * workers, this may be called concurrently to the filter function.
+	 */
+	filter_stats_function stats;
+
+	/**
+	 * Does work of low priority, e.g. garbage collection, in small
+	 * portions while the hub is idle. Called repeatedly as long as
+	 * it returns non-zero and there is nothing else to do. This is
+	 * optional. It is not called if the filter is executed by workers.
+	 */
+	filter_idle_function idle;
+
 	/**
 	 * Prints specific help information about the filter.
 	 */
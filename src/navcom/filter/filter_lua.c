@@ -1,5 +1,8 @@
 #include <navcom/filter/filter_lua.h>
 #include <navcom/lua_helper.h>
+#include <navcom/lua_cache.h>
+#include <navcom/lua_alloc.h>
+#include <navcom/lua_gc.h>
 #include <navcom/lua_syslog.h>
 #include <navcom/lua_debug.h>
 #include <navcom/lua_message.h>
@@ -16,6 +19,13 @@ struct filter_lua_data_t
 {
 	lua_State * lua;
 	jmp_buf env;
+	int msg_out; /* reference of the message object for the output */
+	int msg_in; /* reference of the message object for the input */
+	int batch; /* non-zero if the script provides the function 'filter_batch' */
+	struct lua_msg_array_t msgs_out; /* message objects for batch output */
+	struct lua_msg_array_t msgs_in; /* message objects for batch input */
+	struct lua_alloc_t alloc; /* allocator of the Lua state */
+	struct lua_gc_t gc; /* scheduling of the garbage collector */
 };
 
 static int panic(lua_State * lua)
@@ -79,6 +89,7 @@ static int init_filter(
 	const struct property_t * prop_script = NULL;
 	const struct property_t * prop_debug = NULL;
 	struct filter_lua_data_t * data = NULL;
+	size_t limit = 0;
 
 	if (ctx == NULL)
 		return EXIT_FAILURE;
@@ -103,7 +114,10 @@ static int init_filter(
 		return EXIT_FAILURE;
 
 	/* setup lua state */
-	lua = luaL_newstate();
+	if (luaH_alloc_limit_from_prop(properties, &limit) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	luaH_alloc_init(&data->alloc, limit);
+	lua = luaH_newstate(&data->alloc);
 	if (lua == NULL) {
 		syslog(LOG_ERR, "unable to create lua state");
 		return EXIT_FAILURE;
@@ -119,13 +133,25 @@ static int init_filter(
 			syslog(LOG_ERR, "unable to setup lua state");
 			return EXIT_FAILURE;
 		}
+		data->msg_out = luaH_newmsg(lua, 0);
+		data->msg_in = luaH_newmsg(lua, 1);
+		luaH_newmsgarray(lua, &data->msgs_out, 0);
+		luaH_newmsgarray(lua, &data->msgs_in, 1);
 
 		/* load/execute script */
-		if (luaL_dofile(lua, prop_script->value) != LUA_OK) {
+		if (luaH_dofile(lua, prop_script->value) != LUA_OK) {
 			syslog(LOG_ERR, "unable to load and execute script: '%s'", prop_script->value);
 			lua_close(lua);
 			return EXIT_FAILURE;
 		}
+		if (luaH_gc_setup(&data->gc, lua, properties) != EXIT_SUCCESS) {
+			lua_close(lua);
+			return EXIT_FAILURE;
+		}
+
+		lua_getglobal(lua, "filter_batch");
+		data->batch = lua_isfunction(lua, -1);
+		lua_pop(lua, 1);
 
 		data->lua = lua;
 		return EXIT_SUCCESS;
@@ -152,6 +178,9 @@ static int exit_filter(struct filter_context_t * ctx)
 		lua_close(data->lua);
 		data->lua = NULL;
 	}
+	luaH_freemsgarray(&data->msgs_out);
+	luaH_freemsgarray(&data->msgs_in);
+	luaH_alloc_destroy(&data->alloc);
 
 	free(data);
 	ctx->data = NULL;
@@ -186,9 +215,12 @@ static int filter(
 
 	if (setjmp(data->env) == 0) {
 		lua_getglobal(data->lua, "filter");
-		lua_pushlightuserdata(data->lua, (void*)out);
-		lua_pushlightuserdata(data->lua, (void*)in);
+		luaH_pushmsg(data->lua, data->msg_out, out);
+		luaH_pushmsg(data->lua, data->msg_in, (struct message_t *)in);
 		rc = luaH_check_error(data->lua, lua_pcall(data->lua, 2, 1, 0));
+		luaH_clearmsg(data->lua, data->msg_out);
+		luaH_clearmsg(data->lua, data->msg_in);
+		luaH_gc_called(&data->gc);
 
 		if (rc == EXIT_SUCCESS) {
 			rc = luaL_checkinteger(data->lua, -1);
@@ -208,6 +240,124 @@ static int filter(
 	}
 }
 
+/**
+ * Executes the filtering of a batch of messages with one call of the
+ * function 'filter_batch' of the Lua script. The function gets the
+ * output and input messages as tables and the number of messages,
+ * and returns either one result for all messages or a table of
+ * results, one per message. Scripts may reuse the table of results
+ * for all batches, only the first n entries are read.
+ *
+ * If the script does not provide 'filter_batch', the function 'filter'
+ * is called for every message.
+ */
+static int filter_batch(
+		struct message_t * out,
+		const struct message_t * in,
+		int * results,
+		size_t n,
+		struct filter_context_t * ctx,
+		const struct property_list_t * properties)
+{
+	int rc;
+	size_t i;
+	struct filter_lua_data_t * data = NULL;
+
+	if (out == NULL)
+		return EXIT_FAILURE;
+	if (in == NULL)
+		return EXIT_FAILURE;
+	if (results == NULL)
+		return EXIT_FAILURE;
+	if (ctx == NULL)
+		return EXIT_FAILURE;
+	if (ctx->data == NULL)
+		return EXIT_FAILURE;
+
+	data = (struct filter_lua_data_t *)ctx->data;
+	if (data->lua == NULL)
+		return EXIT_FAILURE;
+
+	if (!data->batch) {
+		for (i = 0; i < n; ++i)
+			results[i] = filter(&out[i], &in[i], ctx, properties);
+		return EXIT_SUCCESS;
+	}
+
+	if (setjmp(data->env) == 0) {
+		lua_getglobal(data->lua, "filter_batch");
+		if ((luaH_pushmsgarray(data->lua, &data->msgs_out, out, n) != EXIT_SUCCESS)
+			|| (luaH_pushmsgarray(data->lua, &data->msgs_in, (struct message_t *)in, n) != EXIT_SUCCESS)) {
+			syslog(LOG_ERR, "unable to pass batch of messages to script");
+			luaH_clearmsgarray(&data->msgs_out);
+			lua_pop(data->lua, lua_gettop(data->lua));
+			return EXIT_FAILURE;
+		}
+		lua_pushunsigned(data->lua, n);
+		rc = luaH_check_error(data->lua, lua_pcall(data->lua, 3, 1, 0));
+		luaH_clearmsgarray(&data->msgs_out);
+		luaH_clearmsgarray(&data->msgs_in);
+		luaH_gc_called(&data->gc);
+
+		if (rc == EXIT_SUCCESS) {
+			if (lua_istable(data->lua, -1)) {
+				for (i = 0; i < n; ++i) {
+					lua_rawgeti(data->lua, -1, (int)(i + 1));
+					results[i] = lua_isnumber(data->lua, -1)
+						? lua_tointeger(data->lua, -1) : FILTER_FAILURE;
+					lua_pop(data->lua, 1);
+				}
+			} else {
+				rc = luaL_checkinteger(data->lua, -1);
+				for (i = 0; i < n; ++i)
+					results[i] = rc;
+			}
+			lua_pop(data->lua, lua_gettop(data->lua));
+			return EXIT_SUCCESS;
+		} else {
+			lua_pop(data->lua, lua_gettop(data->lua));
+			return EXIT_FAILURE;
+		}
+	} else {
+		lua_atpanic(data->lua, NULL);
+		syslog(LOG_CRIT, "LUA: %s", lua_tostring(data->lua, -1));
+		lua_pop(data->lua, 1);
+		lua_close(data->lua);
+		data->lua = NULL;
+		return EXIT_FAILURE;
+	}
+}
+
+/**
+ * Collects garbage of the Lua state step by step, if configured
+ * to do so, while the hub is idle. See luaH_gc_idle.
+ */
+static int idle(struct filter_context_t * ctx)
+{
+	struct filter_lua_data_t * data;
+
+	if (ctx == NULL || ctx->data == NULL)
+		return 0;
+
+	data = (struct filter_lua_data_t *)ctx->data;
+	return luaH_gc_idle(&data->gc, data->lua);
+}
+
+/**
+ * Writes the memory and garbage collector statistics of the Lua state.
+ */
+static void stats(const struct filter_context_t * ctx, FILE * file)
+{
+	const struct filter_lua_data_t * data;
+
+	if (ctx == NULL || ctx->data == NULL || file == NULL)
+		return;
+
+	data = (const struct filter_lua_data_t *)ctx->data;
+	luaH_alloc_write_stats(&data->alloc, file);
+	luaH_gc_write_stats(&data->gc, file);
+}
+
 static void help(void)
 {
 	printf("\n");
@@ -217,6 +367,12 @@ static void help(void)
 	printf("\n");
 	printf("Configuration options:\n");
 	printf("  script : filename of the Lua script to execute.\n");
+	printf("  memory_limit : [optional] maximum memory of the Lua state in KiB, default: unlimited\n");
+	printf("  gc : [optional] 'auto' or 'idle', default: 'auto'. With 'idle' the garbage is\n");
+	printf("       collected in small steps between messages instead of during script calls.\n");
+	printf("  gc_pause : [optional] pause of the garbage collector in percent, default: 400 with 'idle'\n");
+	printf("  gc_stepmul : [optional] step multiplier of the garbage collector in percent\n");
+	printf("  gc_step : [optional] work per idle step of the garbage collector in KiB, default: 4\n");
 	printf("  DEBUG  : [optional] a combination of 'c', 'r' and 'l' for debugging purposes.\n");
 	printf("           c : call, traces function calls\n");
 	printf("           r : return, traces function returns\n");
@@ -236,6 +392,23 @@ static void help(void)
 	printf("    return FILTER_SUCCESS\n");
 	printf("  end\n");
 	printf("\n");
+	printf("The fields of the messages are accessible directly, e.g. 'msg_in.msg_type'\n");
+	printf("or 'msg_in.sog' of a NMEA RMC sentence. The input message is read only.\n");
+	printf("\n");
+	printf("Messages which arrive together are passed as batch to the function\n");
+	printf("'filter_batch', if the script provides it. It returns one result for\n");
+	printf("all messages or a table of results, one per message:\n");
+	printf("\n");
+	printf("  function filter_batch(msgs_out, msgs_in, n)\n");
+	printf("    for i = 1, n do\n");
+	printf("      msg_clone(msgs_out[i], msgs_in[i])\n");
+	printf("    end\n");
+	printf("    return FILTER_SUCCESS\n");
+	printf("  end\n");
+	printf("\n");
+	printf("The tables 'msgs_out' and 'msgs_in' are read only and reused for all\n");
+	printf("batches, the script modifies the output messages, not the tables.\n");
+	printf("\n");
 }
 
 const struct filter_desc_t filter_lua = {
@@ -243,6 +416,9 @@ const struct filter_desc_t filter_lua = {
 	.init = init_filter,
 	.exit = exit_filter,
 	.func = filter,
+	.batch = filter_batch,
+	.stats = stats,
+	.idle = idle,
 	.help = help,
 };
 
@@ -0,0 +1,368 @@
+#include <navcom/filter_pool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/**
+ * Maximum number of messages a worker filters from one queue, before
+ * the queue is put back into the run queue. This keeps other queues
+ * from starving.
+ */
+#define WORKER_BATCH 16
+
+/**
+ * Appends the queue to the run queue, the mutex must be locked.
+ */
+static void schedule(struct filter_pool_t * pool, struct filter_queue_t * queue)
+{
+	queue->scheduled = 1;
+	queue->link = NULL;
+	if (pool->run_last)
+		pool->run_last->link = queue;
+	else
+		pool->run_first = queue;
+	pool->run_last = queue;
+	pthread_cond_signal(&pool->cond);
+}
+
+/**
+ * Notifies the hub about available results, only if it was not already
+ * notified. The mutex must be locked.
+ */
+static void notify(struct filter_pool_t * pool)
+{
+	uint64_t value = 1;
+
+	if (pool->notified)
+		return;
+	pool->notified = 1;
+	if (write(pool->efd, &value, sizeof(value)) < 0)
+		syslog(LOG_ERR, "unable to notify about filter results: %s", strerror(errno));
+}
+
+/**
+ * Executes the filter for one slot. Results of executions taking longer
+ * than the timeout of the queue are discarded.
+ *
+ * @param[in] queue The queue the slot belongs to.
+ * @param[inout] slot The slot to execute the filter for.
+ * @param[out] duration The execution time in nsec.
+ * @retval 1 The execution exceeded the timeout.
+ * @retval 0 Success
+ */
+static int execute(struct filter_queue_t * queue, struct filter_slot_t * slot, uint64_t * duration)
+{
+	uint64_t t = metrics_now();
+
+	memset(&slot->out, 0, sizeof(slot->out));
+	slot->result = queue->filter->func(&slot->out, &slot->in, queue->ctx, queue->cfg);
+	*duration = metrics_now() - t;
+	if (queue->timeout && (*duration > (uint64_t)queue->timeout * 1000000)) {
+		slot->result = FILTER_DISCARD;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Worker thread, takes queues from the run queue and filters their messages.
+ */
+static void * worker(void * arg)
+{
+	struct filter_pool_t * pool = (struct filter_pool_t *)arg;
+	struct filter_queue_t * queue;
+	struct filter_slot_t * slot;
+	size_t n;
+	int timeout;
+	uint64_t duration;
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (!pool->stop && pool->run_first == NULL)
+			pthread_cond_wait(&pool->cond, &pool->mutex);
+		if (pool->stop)
+			break;
+
+		queue = pool->run_first;
+		pool->run_first = queue->link;
+		if (pool->run_first == NULL)
+			pool->run_last = NULL;
+
+		for (n = 0; n < WORKER_BATCH && queue->next != queue->head && !pool->stop; ++n) {
+			slot = &queue->slots[queue->next % queue->capacity];
+			pthread_mutex_unlock(&pool->mutex);
+			timeout = execute(queue, slot, &duration);
+			pthread_mutex_lock(&pool->mutex);
+			histogram_add(&queue->exec_time, duration);
+			if (timeout) {
+				++queue->timeouts;
+				syslog(LOG_WARNING, "filter '%s' exceeded timeout of %u msec, result discarded",
+					queue->filter->name, queue->timeout);
+			}
+			++queue->next;
+			notify(pool);
+		}
+
+		if (queue->next != queue->head)
+			schedule(pool, queue);
+		else
+			queue->scheduled = 0;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+/**
+ * Initializes a filter queue.
+ *
+ * @param[out] queue The queue to initialize.
+ * @param[in] filter The filter to execute for the messages of the queue.
+ * @param[in] ctx The context of the filter, already initialized.
+ * @param[in] cfg The configuration of the filter.
+ * @param[in] capacity Maximum number of messages within the queue, submitted
+ *   but not collected yet. Limited to FILTER_QUEUE_SIZE_MAX.
+ * @param[in] timeout Maximum execution time of the filter in msec,
+ *   0 means unlimited.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int filter_queue_init(
+		struct filter_queue_t * queue,
+		const struct filter_desc_t * filter,
+		struct filter_context_t * ctx,
+		const struct property_list_t * cfg,
+		size_t capacity,
+		uint32_t timeout)
+{
+	if (queue == NULL)
+		return EXIT_FAILURE;
+	memset(queue, 0, sizeof(struct filter_queue_t));
+	if (filter == NULL || filter->func == NULL)
+		return EXIT_FAILURE;
+	if (capacity == 0)
+		return EXIT_FAILURE;
+	if (capacity > FILTER_QUEUE_SIZE_MAX)
+		capacity = FILTER_QUEUE_SIZE_MAX;
+
+	queue->slots = malloc(sizeof(struct filter_slot_t) * capacity);
+	if (queue->slots == NULL)
+		return EXIT_FAILURE;
+	queue->filter = filter;
+	queue->ctx = ctx;
+	queue->cfg = cfg;
+	queue->timeout = timeout;
+	queue->capacity = capacity;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Frees the resources of the queue. The queue must not be
+ * in use by the pool anymore.
+ */
+void filter_queue_destroy(struct filter_queue_t * queue)
+{
+	if (queue == NULL)
+		return;
+	if (queue->slots)
+		free(queue->slots);
+	memset(queue, 0, sizeof(struct filter_queue_t));
+}
+
+/**
+ * Creates the pool and starts its worker threads. A pool without
+ * threads accepts messages, but never filters them. The workers
+ * run with all signals blocked, signals are left to the main thread.
+ *
+ * @param[out] pool The pool to create.
+ * @param[in] num_threads Number of worker threads, limited to
+ *   FILTER_POOL_MAX_THREADS.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int filter_pool_create(struct filter_pool_t * pool, size_t num_threads)
+{
+	size_t i;
+	int rc = EXIT_SUCCESS;
+	sigset_t all;
+	sigset_t old;
+
+	if (pool == NULL)
+		return EXIT_FAILURE;
+	if (num_threads > FILTER_POOL_MAX_THREADS)
+		num_threads = FILTER_POOL_MAX_THREADS;
+
+	memset(pool, 0, sizeof(struct filter_pool_t));
+	pool->efd = eventfd(0, EFD_NONBLOCK);
+	if (pool->efd < 0) {
+		syslog(LOG_ERR, "unable to create eventfd: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	for (i = 0; i < num_threads; ++i) {
+		if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+			syslog(LOG_ERR, "unable to create filter worker thread");
+			rc = EXIT_FAILURE;
+			break;
+		}
+		pool->num_threads = i + 1;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (rc != EXIT_SUCCESS)
+		filter_pool_destroy(pool);
+	return rc;
+}
+
+/**
+ * Stops all worker threads and frees the resources of the pool.
+ * Workers currently executing a filter are waited for, messages
+ * not yet filtered are not processed anymore.
+ */
+void filter_pool_destroy(struct filter_pool_t * pool)
+{
+	size_t i;
+
+	if (pool == NULL || pool->efd < 0)
+		return;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->mutex);
+	for (i = 0; i < pool->num_threads; ++i)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->mutex);
+	close(pool->efd);
+	memset(pool, 0, sizeof(struct filter_pool_t));
+	pool->efd = -1;
+}
+
+/**
+ * Submits a message to the queue, to be filtered by a worker.
+ * This function never blocks.
+ *
+ * @param[in] pool The pool executing the filter.
+ * @param[inout] queue The queue to submit the message to.
+ * @param[in] msg The message to filter.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Parameter error or queue full (errno is EAGAIN),
+ *   the message is dropped.
+ */
+int filter_pool_submit(struct filter_pool_t * pool, struct filter_queue_t * queue, const struct message_t * msg)
+{
+	if (pool == NULL || queue == NULL || msg == NULL)
+		return EXIT_FAILURE;
+	if (queue->slots == NULL)
+		return EXIT_FAILURE;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (queue->head - queue->tail >= queue->capacity) {
+		++queue->dropped;
+		pthread_mutex_unlock(&pool->mutex);
+		errno = EAGAIN;
+		return EXIT_FAILURE;
+	}
+	memcpy(&queue->slots[queue->head % queue->capacity].in, msg, sizeof(struct message_t));
+	++queue->head;
+	if (!queue->scheduled)
+		schedule(pool, queue);
+	pthread_mutex_unlock(&pool->mutex);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Acknowledges the notification about available results, to be
+ * called after the eventfd of the pool became readable and before
+ * the results are collected.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int filter_pool_acknowledge(struct filter_pool_t * pool)
+{
+	uint64_t value;
+
+	if (pool == NULL || pool->efd < 0)
+		return EXIT_FAILURE;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->notified = 0;
+	if (read(pool->efd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		syslog(LOG_ERR, "unable to read eventfd: %s", strerror(errno));
+	pthread_mutex_unlock(&pool->mutex);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Collects the next result of the queue, in the order the messages
+ * were submitted.
+ *
+ * @param[in] pool The pool executing the filter.
+ * @param[inout] queue The queue to collect the result from.
+ * @param[out] out The message produced by the filter.
+ * @param[out] result The result of the filter.
+ * @retval  1 A result was collected.
+ * @retval  0 No result available.
+ * @retval -1 Parameter error.
+ */
+int filter_pool_result(struct filter_pool_t * pool, struct filter_queue_t * queue, struct message_t * out, int * result)
+{
+	struct filter_slot_t * slot;
+
+	if (pool == NULL || queue == NULL || out == NULL || result == NULL)
+		return -1;
+	if (queue->slots == NULL)
+		return -1;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (queue->tail == queue->next) {
+		pthread_mutex_unlock(&pool->mutex);
+		return 0;
+	}
+	slot = &queue->slots[queue->tail % queue->capacity];
+	memcpy(out, &slot->out, sizeof(struct message_t));
+	*result = slot->result;
+	++queue->tail;
+	pthread_mutex_unlock(&pool->mutex);
+	return 1;
+}
+
+/**
+ * Reads the counters of the queue, which are updated by the workers
+ * concurrently.
+ *
+ * @param[in] pool The pool executing the filter.
+ * @param[in] queue The queue to read the counters of.
+ * @param[out] dropped Number of messages dropped because the queue was full.
+ * @param[out] timeouts Number of results discarded because of a timeout.
+ * @param[out] exec_time Execution times of the filter.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int filter_pool_stats(
+		struct filter_pool_t * pool,
+		const struct filter_queue_t * queue,
+		unsigned long * dropped,
+		unsigned long * timeouts,
+		struct histogram_t * exec_time)
+{
+	if (pool == NULL || queue == NULL || dropped == NULL || timeouts == NULL || exec_time == NULL)
+		return EXIT_FAILURE;
+
+	pthread_mutex_lock(&pool->mutex);
+	*dropped = queue->dropped;
+	*timeouts = queue->timeouts;
+	memcpy(exec_time, &queue->exec_time, sizeof(struct histogram_t));
+	pthread_mutex_unlock(&pool->mutex);
+	return EXIT_SUCCESS;
+}
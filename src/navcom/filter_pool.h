@@ -0,0 +1,103 @@
+#ifndef __NAVCOM__FILTER_POOL__H__
+#define __NAVCOM__FILTER_POOL__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <navcom/filter.h>
+#include <navcom/metrics.h>
+
+/**
+ * Default and maximum number of messages a filter queue holds.
+ */
+#define FILTER_QUEUE_SIZE_DEFAULT 64
+#define FILTER_QUEUE_SIZE_MAX     4096
+
+/**
+ * Maximum number of worker threads of a pool.
+ */
+#define FILTER_POOL_MAX_THREADS 64
+
+/**
+ * Slot of a filter queue, holds the message to filter and, after
+ * the execution of the filter, the result.
+ */
+struct filter_slot_t
+{
+	struct message_t in;
+	struct message_t out;
+	int result;
+};
+
+/**
+ * Bounded queue of messages for one filter (and its context). The
+ * messages of a queue are filtered by at most one worker at a time,
+ * in the order they were submitted, therefore the filter context does
+ * not have to be thread safe and the order of messages is kept.
+ *
+ * Slots from 'tail' up to 'next' hold results not yet collected, slots
+ * from 'next' up to 'head' hold messages not yet filtered. All members
+ * except the slots are protected by the mutex of the pool.
+ */
+struct filter_queue_t
+{
+	const struct filter_desc_t * filter;
+	struct filter_context_t * ctx;
+	const struct property_list_t * cfg;
+	uint32_t timeout; /* maximum execution time in msec, 0 = unlimited */
+
+	struct filter_slot_t * slots;
+	size_t capacity;
+	size_t head; /* next slot to submit to */
+	size_t next; /* next slot to filter */
+	size_t tail; /* next result to collect */
+	int scheduled; /* queue is in the run queue or being processed */
+	struct filter_queue_t * link; /* next queue within the run queue */
+
+	unsigned long dropped; /* messages dropped because the queue was full */
+	unsigned long timeouts; /* results discarded because of a timeout */
+	struct histogram_t exec_time; /* execution times of the filter in nsec */
+};
+
+/**
+ * Pool of worker threads executing filters. Queues with messages to
+ * filter are kept in a run queue, the workers take them from there.
+ * The eventfd becomes readable if results are available.
+ */
+struct filter_pool_t
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	pthread_t threads[FILTER_POOL_MAX_THREADS];
+	size_t num_threads;
+	struct filter_queue_t * run_first;
+	struct filter_queue_t * run_last;
+	int efd;
+	int notified;
+	int stop;
+};
+
+int filter_queue_init(
+		struct filter_queue_t *,
+		const struct filter_desc_t *,
+		struct filter_context_t *,
+		const struct property_list_t *,
+		size_t,
+		uint32_t);
+
+void filter_queue_destroy(struct filter_queue_t *);
+
+int filter_pool_create(struct filter_pool_t *, size_t);
+void filter_pool_destroy(struct filter_pool_t *);
+int filter_pool_submit(struct filter_pool_t *, struct filter_queue_t *, const struct message_t *);
+int filter_pool_acknowledge(struct filter_pool_t *);
+int filter_pool_result(struct filter_pool_t *, struct filter_queue_t *, struct message_t *, int *);
+
+int filter_pool_stats(
+		struct filter_pool_t *,
+		const struct filter_queue_t *,
+		unsigned long *,
+		unsigned long *,
+		struct histogram_t *);
+
+#endif
@@ -0,0 +1,326 @@
+#include <navcom/lua_alloc.h>
+#include <navcom/property_read.h>
+#include <lua/lua.h>
+#include <syslog.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * Header of a slab, the blocks follow. The size of the header keeps
+ * the blocks aligned like the result of malloc. Slabs are aligned to
+ * their size, the slab of a block is found by its address.
+ */
+struct slab_t
+{
+	struct slab_t * next;
+	size_t reserved;
+};
+
+/**
+ * Returns the size class of an allocation, or LUA_ALLOC_CLASSES
+ * if the size is too large for slabs.
+ */
+static size_t size_class(size_t size)
+{
+	return (size + LUA_ALLOC_GRANULARITY - 1) / LUA_ALLOC_GRANULARITY - 1;
+}
+
+static int is_small(size_t size)
+{
+	return size <= LUA_ALLOC_GRANULARITY * LUA_ALLOC_CLASSES;
+}
+
+/**
+ * Accounts an allocation refused because of the limit.
+ */
+static void limit_reached(struct lua_alloc_t * a)
+{
+	if (a->failures == 0)
+		syslog(LOG_WARNING, "memory limit of Lua state reached: %lu bytes", (unsigned long)a->limit);
+	__atomic_store_n(&a->failures, a->failures + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Initializes the allocator.
+ *
+ * @param[out] a The allocator to initialize.
+ * @param[in] limit Maximum number of bytes the Lua state may allocate,
+ *   0 for unlimited.
+ */
+void luaH_alloc_init(struct lua_alloc_t * a, size_t limit)
+{
+	memset(a, 0, sizeof(struct lua_alloc_t));
+	a->limit = limit;
+}
+
+/**
+ * Releases all memory of the allocator. Must not be called before
+ * the Lua state using this allocator was closed.
+ */
+void luaH_alloc_destroy(struct lua_alloc_t * a)
+{
+	struct slab_t * slab;
+
+	while (a->slab) {
+		slab = a->slab;
+		a->slab = slab->next;
+		free(slab);
+	}
+	if (a->slab_set)
+		free(a->slab_set);
+	a->slab_set = NULL;
+	a->slab_set_size = 0;
+	memset(a->free, 0, sizeof(a->free));
+	a->slabs = 0;
+	a->slab_used = 0;
+	a->foreign = 0;
+}
+
+/**
+ * Returns the position of the slab address within the slab set,
+ * either the slot holding it or the empty slot to insert it into.
+ */
+static size_t slab_set_find(const uintptr_t * set, size_t size, uintptr_t slab)
+{
+	size_t i = (size_t)((slab / LUA_ALLOC_SLAB_SIZE) * 2654435761u) & (size - 1);
+
+	while (set[i] && (set[i] != slab))
+		i = (i + 1) & (size - 1);
+	return i;
+}
+
+/**
+ * Adds a new slab to the slab set, which is enlarged if it would be
+ * more than half full.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Not enough memory to enlarge the set.
+ */
+static int slab_set_insert(struct lua_alloc_t * a, uintptr_t slab)
+{
+	uintptr_t * set;
+	size_t size;
+	size_t i;
+
+	if ((a->slabs / LUA_ALLOC_SLAB_SIZE + 1) * 2 > a->slab_set_size) {
+		size = a->slab_set_size ? a->slab_set_size * 2 : 16;
+		set = calloc(size, sizeof(uintptr_t));
+		if (set == NULL)
+			return EXIT_FAILURE;
+		for (i = 0; i < a->slab_set_size; ++i)
+			if (a->slab_set[i])
+				set[slab_set_find(set, size, a->slab_set[i])] = a->slab_set[i];
+		free(a->slab_set);
+		a->slab_set = set;
+		a->slab_set_size = size;
+	}
+	a->slab_set[slab_set_find(a->slab_set, a->slab_set_size, slab)] = slab;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Takes a block of the specified size class from the free list or
+ * from the current slab. A new slab is allocated if necessary.
+ */
+static void * block_alloc(struct lua_alloc_t * a, size_t cls)
+{
+	void * p;
+	struct slab_t * slab;
+	size_t size = (cls + 1) * LUA_ALLOC_GRANULARITY;
+
+	p = a->free[cls];
+	if (p) {
+		a->free[cls] = *(void **)p;
+		return p;
+	}
+
+	if ((a->slab == NULL) || (a->slab_used + size > LUA_ALLOC_SLAB_SIZE)) {
+		if (a->limit && (a->slabs + LUA_ALLOC_SLAB_SIZE > a->limit)) {
+			limit_reached(a);
+			return NULL;
+		}
+		if (posix_memalign(&p, LUA_ALLOC_SLAB_SIZE, LUA_ALLOC_SLAB_SIZE) != 0)
+			return NULL;
+		slab = (struct slab_t *)p;
+		if (slab_set_insert(a, (uintptr_t)slab) != EXIT_SUCCESS) {
+			free(slab);
+			return NULL;
+		}
+		slab->next = a->slab;
+		a->slab = slab;
+		a->slab_used = sizeof(struct slab_t);
+		__atomic_store_n(&a->slabs, a->slabs + LUA_ALLOC_SLAB_SIZE, __ATOMIC_RELAXED);
+	}
+
+	p = (char *)a->slab + a->slab_used;
+	a->slab_used += size;
+	return p;
+}
+
+static void block_free(struct lua_alloc_t * a, void * p, size_t cls)
+{
+	*(void **)p = a->free[cls];
+	a->free[cls] = p;
+}
+
+static void * alloc(struct lua_alloc_t * a, size_t size)
+{
+	return is_small(size) ? block_alloc(a, size_class(size)) : malloc(size);
+}
+
+/**
+ * Returns 1 if the block is part of a slab.
+ */
+static int in_slab(const struct lua_alloc_t * a, const void * p)
+{
+	uintptr_t slab = (uintptr_t)p & ~(uintptr_t)(LUA_ALLOC_SLAB_SIZE - 1);
+
+	if (a->slab_set == NULL)
+		return 0;
+	return a->slab_set[slab_set_find(a->slab_set, a->slab_set_size, slab)] == slab;
+}
+
+/**
+ * Releases a block. Blocks of small size are part of slabs, except
+ * blocks allocated by malloc and shrunk without a slab block available,
+ * those are released by free.
+ */
+static void release(struct lua_alloc_t * a, void * p, size_t size)
+{
+	if (!is_small(size)) {
+		free(p);
+	} else if (a->foreign && !in_slab(a, p)) {
+		--a->foreign;
+		free(p);
+	} else {
+		block_free(a, p, size_class(size));
+	}
+}
+
+/**
+ * Allocation function for Lua states, see lua_Alloc. Small blocks are
+ * taken from size classes within slabs, larger blocks are allocated
+ * by malloc. Growing allocations beyond the limit fail, Lua reacts
+ * with a full garbage collection and, if still not enough, with a
+ * memory error. Shrinking never fails, as required by Lua.
+ */
+static void * lua_alloc(void * ud, void * ptr, size_t osize, size_t nsize)
+{
+	struct lua_alloc_t * a = (struct lua_alloc_t *)ud;
+	void * p;
+
+	/* for new objects, osize contains the type of the object */
+	if (ptr == NULL)
+		osize = 0;
+
+	if (nsize == 0) {
+		if (ptr) {
+			release(a, ptr, osize);
+			__atomic_store_n(&a->used, a->used - osize, __ATOMIC_RELAXED);
+		}
+		return NULL;
+	}
+
+	if ((nsize > osize) && a->limit && (a->used + (nsize - osize) > a->limit)) {
+		limit_reached(a);
+		return NULL;
+	}
+
+	if (ptr == NULL) {
+		p = alloc(a, nsize);
+	} else if (is_small(osize) && is_small(nsize) && (size_class(osize) == size_class(nsize))) {
+		p = ptr;
+	} else if (!is_small(osize) && !is_small(nsize)) {
+		p = realloc(ptr, nsize);
+	} else {
+		p = alloc(a, nsize);
+		if (p) {
+			memcpy(p, ptr, (osize < nsize) ? osize : nsize);
+			release(a, ptr, osize);
+		} else if (!is_small(osize)) {
+			/* shrinking must not fail, keep the block of malloc */
+			p = realloc(ptr, nsize);
+			if (p == NULL)
+				p = ptr;
+			++a->foreign;
+		} else if (nsize < osize) {
+			/* shrinking must not fail, keep the larger block */
+			p = ptr;
+		}
+	}
+
+	if (p == NULL)
+		return NULL;
+
+	__atomic_store_n(&a->used, a->used + nsize - osize, __ATOMIC_RELAXED);
+	if (a->used > a->peak)
+		__atomic_store_n(&a->peak, a->used, __ATOMIC_RELAXED);
+	return p;
+}
+
+/**
+ * Creates a Lua state which allocates its memory by the specified
+ * allocator. The allocator must be initialized and must live longer
+ * than the Lua state.
+ *
+ * @param[in] a The allocator.
+ * @return The Lua state, NULL on failure.
+ */
+struct lua_State * luaH_newstate(struct lua_alloc_t * a)
+{
+	return lua_newstate(lua_alloc, a);
+}
+
+/**
+ * Reads the optional memory limit of a Lua state from the property
+ * 'memory_limit', in KiB. Without the property there is no limit.
+ *
+ * @param[in] properties The properties to read from.
+ * @param[out] limit The limit in bytes, 0 for unlimited.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Invalid value.
+ */
+int luaH_alloc_limit_from_prop(const struct property_list_t * properties, size_t * limit)
+{
+	uint32_t kib = 0;
+
+	if (property_read_uint32(properties, "memory_limit", &kib) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	*limit = (size_t)kib * 1024;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Writes the statistics of the allocator as key/value pairs, each with
+ * a leading blank, e.g. for the statistics file of the hub:
+ * @code
+ *  lua_used=40960 lua_peak=51200 lua_limit=0 lua_slabs=32768 lua_failures=0
+ * @endcode
+ *
+ * The allocator may be in use by a filter worker, the values are not
+ * necessarily consistent with each other.
+ */
+void luaH_alloc_write_stats(const struct lua_alloc_t * a, FILE * file)
+{
+	fprintf(file, " lua_used=%lu lua_peak=%lu lua_limit=%lu lua_slabs=%lu lua_failures=%" PRIu64,
+		(unsigned long)__atomic_load_n(&a->used, __ATOMIC_RELAXED),
+		(unsigned long)__atomic_load_n(&a->peak, __ATOMIC_RELAXED),
+		(unsigned long)a->limit,
+		(unsigned long)__atomic_load_n(&a->slabs, __ATOMIC_RELAXED),
+		__atomic_load_n(&a->failures, __ATOMIC_RELAXED));
+}
+
+/**
+ * Writes the statistics of the allocator to syslog.
+ *
+ * @param[in] a The allocator.
+ * @param[in] name Name of the owner, e.g. the name of the proc.
+ */
+void luaH_alloc_log_stats(const struct lua_alloc_t * a, const char * name)
+{
+	syslog(LOG_INFO, "%s: lua memory used=%lu peak=%lu limit=%lu slabs=%lu failures=%" PRIu64,
+		name, (unsigned long)a->used, (unsigned long)a->peak, (unsigned long)a->limit,
+		(unsigned long)a->slabs, a->failures);
+}
+
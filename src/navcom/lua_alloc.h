@@ -0,0 +1,53 @@
+#ifndef __NAVCOM__LUA_ALLOC__H__
+#define __NAVCOM__LUA_ALLOC__H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <common/property.h>
+
+struct lua_State;
+
+/**
+ * Granularity and number of the size classes. Blocks up to
+ * LUA_ALLOC_GRANULARITY * LUA_ALLOC_CLASSES bytes are taken from
+ * slabs, larger blocks are allocated with malloc.
+ */
+#define LUA_ALLOC_GRANULARITY 16
+#define LUA_ALLOC_CLASSES     16
+
+/**
+ * Size of a slab in bytes, a power of two.
+ */
+#define LUA_ALLOC_SLAB_SIZE 4096
+
+/**
+ * Allocator for one Lua state, see luaH_newstate. Not thread safe,
+ * like the Lua state itself. The limit applies to the memory in use
+ * as well as to the memory held in slabs. The counters are written
+ * atomically, to be read by other threads, see luaH_alloc_write_stats.
+ */
+struct lua_alloc_t
+{
+	size_t limit; /* maximum of allocated bytes, 0 for unlimited */
+	size_t used; /* currently allocated bytes, as requested by Lua */
+	size_t peak; /* maximum of used bytes */
+	size_t slabs; /* bytes held in slabs */
+	uint64_t failures; /* allocations refused because of the limit */
+	size_t foreign; /* blocks of small size allocated by malloc */
+
+	void * free[LUA_ALLOC_CLASSES]; /* free blocks per size class */
+	void * slab; /* list of all slabs, the first one is the current one */
+	size_t slab_used; /* bytes taken from the current slab */
+	uintptr_t * slab_set; /* addresses of all slabs, open addressing */
+	size_t slab_set_size; /* number of slots of the slab set, a power of two */
+};
+
+void luaH_alloc_init(struct lua_alloc_t *, size_t);
+void luaH_alloc_destroy(struct lua_alloc_t *);
+int luaH_alloc_limit_from_prop(const struct property_list_t *, size_t *);
+void luaH_alloc_write_stats(const struct lua_alloc_t *, FILE *);
+void luaH_alloc_log_stats(const struct lua_alloc_t *, const char *);
+struct lua_State * luaH_newstate(struct lua_alloc_t *);
+
+#endif
@@ -0,0 +1,333 @@
+#include <navcom/lua_cache.h>
+#include <common/macros.h>
+#include <lua/lua.h>
+#include <lua/lualib.h>
+#include <lua/lauxlib.h>
+#include <syslog.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * Identification of cache files, changes whenever the format of the
+ * header changes.
+ */
+#define CACHE_MAGIC "NAVDLC01"
+
+/**
+ * Header of a cache file, followed by the path of the script
+ * (without terminating zero) and the output of lua_dump. The cache
+ * is valid only if all of the header matches the script and the
+ * Lua release.
+ */
+struct cache_header_t
+{
+	char magic[8];
+	char release[32];
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	int64_t size;
+	uint32_t path_len;
+};
+
+/**
+ * Directory for cache files, empty if they are stored next to the scripts.
+ */
+static char cache_dir[PATH_MAX] = "";
+
+struct reader_t
+{
+	FILE * file;
+	char buf[BUFSIZ];
+};
+
+/**
+ * Sets the directory to store the cache files. If this is NULL or
+ * empty, cache files are expected next to the scripts, named like the
+ * script with an appended 'c' (e.g. 'filter.luac'), written only
+ * by luaH_precompile.
+ *
+ * With a directory, missing or outdated cache files are written whenever
+ * a script is loaded. The cache file name within the directory is derived
+ * from the path of the script, every '/' replaced by '_'.
+ *
+ * @param[in] dir The directory.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Path too long.
+ */
+int luaH_set_cache_dir(const char * dir)
+{
+	if (dir == NULL) {
+		cache_dir[0] = '\0';
+		return EXIT_SUCCESS;
+	}
+	if (strlen(dir) >= sizeof(cache_dir))
+		return EXIT_FAILURE;
+	strncpy(cache_dir, dir, sizeof(cache_dir));
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Determines the path of the cache file for the specified script.
+ *
+ * @param[out] path Buffer to contain the path.
+ * @param[in] size Size of the buffer.
+ * @param[in] filename Path of the script.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Path too long.
+ */
+static int cache_path(char * path, size_t size, const char * filename)
+{
+	int rc;
+	char * p;
+
+	if (cache_dir[0] == '\0') {
+		rc = snprintf(path, size, "%sc", filename);
+		return (rc < 0 || (size_t)rc >= size) ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	rc = snprintf(path, size, "%s/", cache_dir);
+	if (rc < 0 || (size_t)rc >= size)
+		return EXIT_FAILURE;
+	p = path + rc;
+	rc = snprintf(p, size - rc, "%sc", filename);
+	if (rc < 0 || (size_t)rc >= size - (p - path))
+		return EXIT_FAILURE;
+	for (; *p; ++p) {
+		if (*p == '/')
+			*p = '_';
+	}
+	return EXIT_SUCCESS;
+}
+
+static void make_header(
+		struct cache_header_t * header,
+		const struct stat * s,
+		const char * filename)
+{
+	memset(header, 0, sizeof(struct cache_header_t));
+	memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+	strncpy(header->release, LUA_RELEASE, sizeof(header->release) - 1);
+	header->mtime_sec = s->st_mtim.tv_sec;
+	header->mtime_nsec = s->st_mtim.tv_nsec;
+	header->size = s->st_size;
+	header->path_len = strlen(filename);
+}
+
+static const char * reader(lua_State * lua, void * data, size_t * size)
+{
+	struct reader_t * r = (struct reader_t *)data;
+
+	UNUSED_ARG(lua);
+
+	if (feof(r->file))
+		return NULL;
+	*size = fread(r->buf, 1, sizeof(r->buf), r->file);
+	return (*size > 0) ? r->buf : NULL;
+}
+
+static int writer(lua_State * lua, const void * p, size_t size, void * data)
+{
+	UNUSED_ARG(lua);
+
+	return fwrite(p, 1, size, (FILE *)data) != size;
+}
+
+/**
+ * Loads the precompiled chunk from the cache file, if the cache
+ * matches the script.
+ *
+ * @retval  1 Chunk loaded and pushed onto the stack.
+ * @retval  0 No valid cache, nothing pushed.
+ */
+static int load_cache(
+		lua_State * lua,
+		const char * path,
+		const char * filename,
+		const char * chunkname,
+		const struct cache_header_t * expected)
+{
+	struct cache_header_t header;
+	struct reader_t * r;
+	char * p;
+	int rc;
+
+	r = malloc(sizeof(struct reader_t));
+	if (r == NULL)
+		return 0;
+	r->file = fopen(path, "rb");
+	if (r->file == NULL) {
+		free(r);
+		return 0;
+	}
+
+	rc = 0;
+	p = malloc(expected->path_len);
+	if ((p != NULL)
+		&& (fread(&header, sizeof(header), 1, r->file) == 1)
+		&& (memcmp(&header, expected, sizeof(header)) == 0)
+		&& (fread(p, 1, header.path_len, r->file) == header.path_len)
+		&& (memcmp(p, filename, header.path_len) == 0)) {
+		if (lua_load(lua, reader, r, chunkname, "b") == LUA_OK) {
+			rc = 1;
+		} else {
+			syslog(LOG_DEBUG, "invalid cache '%s': %s", path, lua_tostring(lua, -1));
+			lua_pop(lua, 1);
+		}
+	}
+
+	free(p);
+	fclose(r->file);
+	free(r);
+	return rc;
+}
+
+/**
+ * Writes the chunk on top of the stack into the cache file. The file
+ * is written under a temporary name first and then renamed, concurrent
+ * readers and writers never see a partially written cache.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int write_cache(
+		lua_State * lua,
+		const char * path,
+		const char * filename,
+		const struct cache_header_t * header)
+{
+	char tmp[PATH_MAX + 8];
+	FILE * file;
+	int fd;
+	int rc;
+
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		syslog(LOG_DEBUG, "unable to write cache '%s': %s", path, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	file = fdopen(fd, "wb");
+	if (file == NULL) {
+		close(fd);
+		unlink(tmp);
+		return EXIT_FAILURE;
+	}
+
+	rc = (fwrite(header, sizeof(struct cache_header_t), 1, file) == 1)
+		&& (fwrite(filename, 1, header->path_len, file) == header->path_len)
+		&& (lua_dump(lua, writer, file) == 0);
+	rc = (fclose(file) == 0) && rc;
+	if (rc && (chmod(tmp, 0644) == 0) && (rename(tmp, path) == 0))
+		return EXIT_SUCCESS;
+
+	syslog(LOG_DEBUG, "unable to write cache '%s'", path);
+	unlink(tmp);
+	return EXIT_FAILURE;
+}
+
+/**
+ * Loads the script as Lua chunk and pushes it onto the stack, like
+ * luaL_loadfile. The precompiled chunk from the cache is used if it
+ * is valid for the script: same path, modification time and size of
+ * the script, and same Lua release. Otherwise the script is compiled.
+ * If there is a cache directory (see luaH_set_cache_dir), the cache is
+ * (re)written, failing to write the cache is not an error.
+ *
+ * @param[in] lua The Lua state.
+ * @param[in] filename Path of the script.
+ * @return Status like luaL_loadfile, LUA_OK on success. In case of
+ *   an error, the error message is pushed instead of the chunk.
+ */
+int luaH_loadfile(lua_State * lua, const char * filename)
+{
+	struct stat s;
+	struct cache_header_t header;
+	char path[PATH_MAX];
+	int rc;
+
+	if (stat(filename, &s) < 0)
+		return luaL_loadfile(lua, filename);
+	if (cache_path(path, sizeof(path), filename) != EXIT_SUCCESS)
+		return luaL_loadfile(lua, filename);
+
+	make_header(&header, &s, filename);
+
+	lua_pushfstring(lua, "@%s", filename);
+	if (load_cache(lua, path, filename, lua_tostring(lua, -1), &header)) {
+		lua_remove(lua, -2);
+		return LUA_OK;
+	}
+	lua_pop(lua, 1);
+
+	rc = luaL_loadfile(lua, filename);
+	if ((rc == LUA_OK) && (cache_dir[0] != '\0'))
+		write_cache(lua, path, filename, &header);
+	return rc;
+}
+
+/**
+ * Loads and executes the script, like luaL_dofile but using the cache
+ * of precompiled chunks, see luaH_loadfile.
+ *
+ * @return Status like luaL_dofile, LUA_OK on success.
+ */
+int luaH_dofile(lua_State * lua, const char * filename)
+{
+	int rc;
+
+	rc = luaH_loadfile(lua, filename);
+	if (rc != LUA_OK)
+		return rc;
+	return lua_pcall(lua, 0, LUA_MULTRET, 0);
+}
+
+/**
+ * Compiles the script and writes the cache, regardless of an already
+ * existing cache. The script is not executed.
+ *
+ * @param[in] filename Path of the script.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Unable to compile the script or to write the cache.
+ */
+int luaH_precompile(const char * filename)
+{
+	lua_State * lua;
+	struct stat s;
+	struct cache_header_t header;
+	char path[PATH_MAX];
+	int rc = EXIT_FAILURE;
+
+	if (stat(filename, &s) < 0) {
+		syslog(LOG_ERR, "unable to access script '%s': %s", filename, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (cache_path(path, sizeof(path), filename) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "path of cache for '%s' too long", filename);
+		return EXIT_FAILURE;
+	}
+
+	lua = luaL_newstate();
+	if (lua == NULL) {
+		syslog(LOG_ERR, "unable to create lua state");
+		return EXIT_FAILURE;
+	}
+
+	if (luaL_loadfile(lua, filename) != LUA_OK) {
+		syslog(LOG_ERR, "unable to compile script '%s': %s", filename, lua_tostring(lua, -1));
+	} else {
+		make_header(&header, &s, filename);
+		rc = write_cache(lua, path, filename, &header);
+		if (rc != EXIT_SUCCESS)
+			syslog(LOG_ERR, "unable to write cache '%s'", path);
+	}
+
+	lua_close(lua);
+	return rc;
+}
+
@@ -0,0 +1,11 @@
+#ifndef __NAVCOM__LUA_CACHE__H__
+#define __NAVCOM__LUA_CACHE__H__
+
+struct lua_State;
+
+int luaH_set_cache_dir(const char *);
+int luaH_loadfile(struct lua_State *, const char *);
+int luaH_dofile(struct lua_State *, const char *);
+int luaH_precompile(const char *);
+
+#endif
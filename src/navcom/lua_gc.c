@@ -0,0 +1,153 @@
+#include <navcom/lua_gc.h>
+#include <navcom/metrics.h>
+#include <navcom/property_read.h>
+#include <lua/lua.h>
+#include <syslog.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * Default amount of work per idle step in KiB.
+ */
+#define GC_STEP_DEFAULT 4
+
+/**
+ * Default pause (percent) of the collector in idle mode. The collector
+ * stays enabled as backstop, if there is not enough idle time, but
+ * starts a cycle only if the memory in use grew a lot.
+ */
+#define GC_PAUSE_IDLE_DEFAULT 400
+
+/**
+ * Sets up the garbage collector of the Lua state according to the
+ * properties:
+ * - 'gc' : 'auto' (default) to leave collecting to Lua, which may collect
+ *   in the middle of a script call, or 'idle' to collect in steps while the
+ *   owner is idle, see luaH_gc_idle
+ * - 'gc_pause' : pause of the collector in percent (see lua_gc, LUA_GCSETPAUSE),
+ *   default is Lua's default in 'auto' mode and 400 in 'idle' mode
+ * - 'gc_stepmul' : step multiplier in percent (see lua_gc, LUA_GCSETSTEPMUL)
+ * - 'gc_step' : amount of work per idle step in KiB, default 4
+ *
+ * @param[out] gc The scheduling data to initialize.
+ * @param[in] lua The Lua state.
+ * @param[in] properties The properties of the script.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Invalid property.
+ */
+int luaH_gc_setup(
+		struct lua_gc_t * gc,
+		struct lua_State * lua,
+		const struct property_list_t * properties)
+{
+	char mode[8];
+	uint32_t pause = 0;
+	uint32_t stepmul = 0;
+	uint32_t step = GC_STEP_DEFAULT;
+
+	memset(gc, 0, sizeof(struct lua_gc_t));
+
+	strncpy(mode, "auto", sizeof(mode));
+	if (property_read_string(properties, "gc", mode, sizeof(mode)) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	mode[sizeof(mode) - 1] = '\0';
+	if (strcmp(mode, "idle") == 0) {
+		gc->idle = 1;
+		pause = GC_PAUSE_IDLE_DEFAULT;
+	} else if (strcmp(mode, "auto") != 0) {
+		syslog(LOG_ERR, "invalid value in 'gc': '%s'", mode);
+		return EXIT_FAILURE;
+	}
+
+	if (property_read_uint32(properties, "gc_pause", &pause) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (property_read_uint32(properties, "gc_stepmul", &stepmul) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (property_read_uint32(properties, "gc_step", &step) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	if (pause > 0)
+		lua_gc(lua, LUA_GCSETPAUSE, pause);
+	if (stepmul > 0)
+		lua_gc(lua, LUA_GCSETSTEPMUL, stepmul);
+	gc->step = step;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Notes a call of the script, the garbage produced by the call is
+ * going to be collected by the next idle steps.
+ */
+void luaH_gc_called(struct lua_gc_t * gc)
+{
+	/* garbage of a call during a cycle may survive the current cycle */
+	if (gc->idle)
+		gc->pending = gc->in_cycle ? 2 : 1;
+}
+
+/**
+ * Performs one step of the garbage collector, if there is work left
+ * since the script was called last. To be called by the owner of the
+ * Lua state while idle, repeatedly as long as it returns non-zero and
+ * there is nothing else to do. The duration of the step is measured.
+ *
+ * @param[in] gc The scheduling data.
+ * @param[in] lua The Lua state.
+ * @return Non-zero if there is still work left.
+ */
+int luaH_gc_idle(struct lua_gc_t * gc, struct lua_State * lua)
+{
+	uint64_t t;
+
+	if (!gc->pending || (lua == NULL))
+		return 0;
+
+	t = metrics_now();
+	if (lua_gc(lua, LUA_GCSTEP, gc->step)) {
+		gc->in_cycle = 0;
+		--gc->pending;
+		__atomic_store_n(&gc->cycles, gc->cycles + 1, __ATOMIC_RELAXED);
+	} else {
+		gc->in_cycle = 1;
+	}
+	t = metrics_now() - t;
+
+	/* the counters may be read concurrently, see luaH_gc_write_stats */
+	__atomic_store_n(&gc->steps, gc->steps + 1, __ATOMIC_RELAXED);
+	if (t > gc->max_pause)
+		__atomic_store_n(&gc->max_pause, t, __ATOMIC_RELAXED);
+	return gc->pending;
+}
+
+/**
+ * Writes the statistics of the idle steps as key/value pairs, each
+ * with a leading blank, e.g. for the statistics file of the hub:
+ * @code
+ *  gc=idle gc_steps=120 gc_cycles=4 gc_max_pause=35000
+ * @endcode
+ *
+ * The Lua state may be in use by a filter worker, the values are not
+ * necessarily consistent with each other.
+ */
+void luaH_gc_write_stats(const struct lua_gc_t * gc, FILE * file)
+{
+	fprintf(file, " gc=%s gc_steps=%" PRIu64 " gc_cycles=%" PRIu64 " gc_max_pause=%" PRIu64,
+		gc->idle ? "idle" : "auto",
+		__atomic_load_n(&gc->steps, __ATOMIC_RELAXED),
+		__atomic_load_n(&gc->cycles, __ATOMIC_RELAXED),
+		__atomic_load_n(&gc->max_pause, __ATOMIC_RELAXED));
+}
+
+/**
+ * Writes the statistics of the idle steps to syslog.
+ *
+ * @param[in] gc The scheduling data.
+ * @param[in] name Name of the owner, e.g. the name of the proc.
+ */
+void luaH_gc_log_stats(const struct lua_gc_t * gc, const char * name)
+{
+	syslog(LOG_INFO, "%s: lua gc=%s steps=%" PRIu64 " cycles=%" PRIu64 " max_pause=%" PRIu64 " nsec",
+		name, gc->idle ? "idle" : "auto", gc->steps, gc->cycles, gc->max_pause);
+}
+
@@ -0,0 +1,32 @@
+#ifndef __NAVCOM__LUA_GC__H__
+#define __NAVCOM__LUA_GC__H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <common/property.h>
+
+struct lua_State;
+
+/**
+ * Scheduling of the garbage collector of a Lua state, see luaH_gc_setup.
+ * The counters are written atomically, to be read by other threads,
+ * see luaH_gc_write_stats.
+ */
+struct lua_gc_t
+{
+	int idle; /* non-zero if the collector is driven by idle steps */
+	int pending; /* number of cycles to complete, to collect the garbage of the last call */
+	int in_cycle; /* non-zero if idle steps started a cycle which is not complete */
+	int step; /* amount of work per idle step in KiB */
+	uint64_t steps; /* number of idle steps */
+	uint64_t cycles; /* number of cycles completed by idle steps */
+	uint64_t max_pause; /* longest idle step in nsec */
+};
+
+int luaH_gc_setup(struct lua_gc_t *, struct lua_State *, const struct property_list_t *);
+void luaH_gc_called(struct lua_gc_t *);
+int luaH_gc_idle(struct lua_gc_t *, struct lua_State *);
+void luaH_gc_write_stats(const struct lua_gc_t *, FILE *);
+void luaH_gc_log_stats(const struct lua_gc_t *, const char *);
+
+#endif
@@ -13,6 +13,47 @@
 	#include <navcom/lua_message_nmea.h>
 #endif
 
+/**
+ * Name of the metatable of message objects within the registry.
+ */
+#define MSG_METATABLE "navd.message"
+
+/**
+ * Message object, a Lua userdata referring to a message owned by
+ * the caller of the script. The object is created once and reused
+ * for every message, see luaH_newmsg and luaH_pushmsg.
+ */
+struct lua_msg_t
+{
+	struct message_t * msg; /* NULL outside of calls of the script */
+	int readonly;
+};
+
+/**
+ * Returns the message at the specified index of the Lua stack, which
+ * may be a message object or a light userdata.
+ *
+ * @param[in] lua The Lua state.
+ * @param[in] index Index of the message on the Lua stack.
+ * @param[in] write Message is going to be modified, read only
+ *   message objects are refused.
+ * @return The message, NULL if there is none.
+ */
+static struct message_t * tomsg(lua_State * lua, int index, int write)
+{
+	struct lua_msg_t * obj;
+
+	if (lua_islightuserdata(lua, index))
+		return lua_touserdata(lua, index);
+
+	obj = luaL_testudata(lua, index, MSG_METATABLE);
+	if (obj == NULL)
+		return NULL;
+	if (write && obj->readonly)
+		return NULL;
+	return obj->msg;
+}
+
 /**
  * Clones the message.
  *
@@ -29,8 +70,8 @@ static int lua__msg_clone(lua_State * lua)
 	struct message_t * msg_out;
 	struct message_t * msg_in;
 
-	msg_out = lua_touserdata(lua, -2);
-	msg_in = lua_touserdata(lua, -1);
+	msg_out = tomsg(lua, -2, 1);
+	msg_in = tomsg(lua, -1, 0);
 
 	if ((msg_out == NULL) || (msg_in == NULL)) {
 		lua_pushinteger(lua, EXIT_FAILURE);
@@ -58,7 +99,7 @@ static int lua__msg_type(lua_State * lua)
 {
 	struct message_t * msg;
 
-	msg = lua_touserdata(lua, -1);
+	msg = tomsg(lua, -1, 0);
 	if (msg == NULL) {
 		lua_pushunsigned(lua, MSG_INVALID);
 		return 1;
@@ -80,12 +121,14 @@ static void msg_to_table_timer(lua_State * lua, const struct message_t * msg)
 }
 
 /**
- * Converts the speficied message to a table.
+ * Converts the speficied message to a table. This creates new tables
+ * for every call, accessing the fields of the message object directly
+ * is cheaper (see lua__msg_index).
  *
  * Currently supported message types:
  * - MSG_SYSTEM
  * - MSG_TIMER
- * - MSG_NMEA (partially)
+ * - MSG_NMEA
  *
  * Lua example:
  * @code
@@ -118,7 +161,7 @@ static int lua__msg_to_table(lua_State * lua)
 	struct message_t * msg;
 	size_t i;
 
-	msg = lua_touserdata(lua, -1);
+	msg = tomsg(lua, -1, 0);
 	if (msg == NULL) {
 		lua_pushnil(lua);
 		return 1;
@@ -200,7 +243,7 @@ static int lua__msg_from_table(lua_State * lua)
 	size_t i;
 	int rc = 0;
 
-	msg = lua_touserdata(lua, -2);
+	msg = tomsg(lua, -2, 1);
 	if (msg == NULL) {
 		lua_pushinteger(lua, 1);
 		return 1;
@@ -226,6 +269,287 @@ static int lua__msg_from_table(lua_State * lua)
 	return 1;
 }
 
+/**
+ * Returns the field of a message object, the fields are read directly
+ * from the message, no tables are created (except for times, dates
+ * and arrays of NMEA sentences).
+ *
+ * Accessible fields:
+ * - msg_type
+ * - system (MSG_SYSTEM)
+ * - timer_id (MSG_TIMER)
+ * - nmea_type, raw and the fields of the sentence (MSG_NMEA),
+ *   named like in the table of msg_to_table
+ *
+ * Unknown fields are nil.
+ *
+ * Lua example:
+ * @code
+ * function filter(msg_out, msg_in)
+ *     if msg_in.msg_type == MSG_NMEA and msg_in.nmea_type == NMEA_RMC then
+ *         if msg_in.sog > 5.0 then
+ *             return FILTER_DISCARD
+ *         end
+ *     end
+ *     msg_clone(msg_out, msg_in)
+ *     return FILTER_SUCCESS
+ * end
+ * @endcode
+ */
+static int lua__msg_index(lua_State * lua)
+{
+	struct lua_msg_t * obj;
+	const char * name;
+
+	obj = luaL_checkudata(lua, 1, MSG_METATABLE);
+	name = luaL_checkstring(lua, 2);
+	if (obj->msg == NULL)
+		return luaL_error(lua, "message not available");
+
+	if (strcmp(name, "msg_type") == 0) {
+		lua_pushunsigned(lua, obj->msg->type);
+		return 1;
+	}
+
+	switch (obj->msg->type) {
+		case MSG_SYSTEM:
+			if (strcmp(name, "system") == 0) {
+				lua_pushunsigned(lua, obj->msg->data.attr.system);
+				return 1;
+			}
+			break;
+		case MSG_TIMER:
+			if (strcmp(name, "timer_id") == 0) {
+				lua_pushunsigned(lua, obj->msg->data.attr.timer_id);
+				return 1;
+			}
+			break;
+#if defined(NEEDS_NMEA)
+		case MSG_NMEA:
+			if (luaH_msg_index_nmea(lua, obj->msg, name))
+				return 1;
+			break;
+#endif
+		default:
+			break;
+	}
+
+	lua_pushnil(lua);
+	return 1;
+}
+
+/**
+ * Sets the field of a message object, see lua__msg_index for the
+ * accessible fields. Fields depend on the message type, the type
+ * has to be set first. Unknown fields and read only messages raise
+ * an error.
+ *
+ * Lua example:
+ * @code
+ * function filter(msg_out, msg_in)
+ *     msg_out.msg_type = MSG_TIMER
+ *     msg_out.timer_id = 2
+ *     return FILTER_SUCCESS
+ * end
+ * @endcode
+ */
+static int lua__msg_newindex(lua_State * lua)
+{
+	struct lua_msg_t * obj;
+	const char * name;
+
+	obj = luaL_checkudata(lua, 1, MSG_METATABLE);
+	name = luaL_checkstring(lua, 2);
+	if (obj->msg == NULL)
+		return luaL_error(lua, "message not available");
+	if (obj->readonly)
+		return luaL_error(lua, "message is read only");
+
+	if (strcmp(name, "msg_type") == 0) {
+		obj->msg->type = luaL_checkunsigned(lua, 3);
+		return 0;
+	}
+
+	switch (obj->msg->type) {
+		case MSG_SYSTEM:
+			if (strcmp(name, "system") == 0) {
+				obj->msg->data.attr.system = luaL_checkunsigned(lua, 3);
+				return 0;
+			}
+			break;
+		case MSG_TIMER:
+			if (strcmp(name, "timer_id") == 0) {
+				obj->msg->data.attr.timer_id = luaL_checkunsigned(lua, 3);
+				return 0;
+			}
+			break;
+#if defined(NEEDS_NMEA)
+		case MSG_NMEA:
+			if (luaH_msg_newindex_nmea(lua, obj->msg, name, 3) == EXIT_SUCCESS)
+				return 0;
+			break;
+#endif
+		default:
+			break;
+	}
+
+	return luaL_error(lua, "unknown field '%s'", name);
+}
+
+/**
+ * Creates a message object and keeps it in the registry. The object
+ * is meant to be reused for all messages passed to the script,
+ * which avoids allocations per message.
+ *
+ * @param[in] lua The Lua state, message handling must be set up.
+ * @param[in] readonly The message must not be modified by the script.
+ * @return Reference of the message object.
+ */
+int luaH_newmsg(lua_State * lua, int readonly)
+{
+	struct lua_msg_t * obj;
+
+	obj = lua_newuserdata(lua, sizeof(struct lua_msg_t));
+	obj->msg = NULL;
+	obj->readonly = readonly;
+	luaL_setmetatable(lua, MSG_METATABLE);
+	return luaL_ref(lua, LUA_REGISTRYINDEX);
+}
+
+/**
+ * Sets the message of the message object and pushes the object
+ * onto the Lua stack.
+ *
+ * @param[in] lua The Lua state.
+ * @param[in] ref Reference of the message object, see luaH_newmsg.
+ * @param[in] msg The message, may be NULL to detach the message
+ *   from the object. This should be done after the script was called,
+ *   to prevent access to the message if the script keeps the object.
+ */
+void luaH_pushmsg(lua_State * lua, int ref, struct message_t * msg)
+{
+	struct lua_msg_t * obj;
+
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, ref);
+	obj = lua_touserdata(lua, -1);
+	obj->msg = msg;
+}
+
+/**
+ * Detaches the message from the message object.
+ */
+void luaH_clearmsg(lua_State * lua, int ref)
+{
+	luaH_pushmsg(lua, ref, NULL);
+	lua_pop(lua, 1);
+}
+
+/**
+ * Prepares the passing of batches of messages to scripts, see
+ * luaH_pushmsgarray. The table of message objects passed to the script
+ * is kept in the registry and reused for all batches, message objects
+ * are created on demand.
+ *
+ * @param[in] lua The Lua state.
+ * @param[out] array The array to initialize.
+ * @param[in] readonly Non-zero if the messages must not be modified
+ *   by the script.
+ */
+void luaH_newmsgarray(lua_State * lua, struct lua_msg_array_t * array, int readonly)
+{
+	array->readonly = readonly;
+	array->n = 0;
+	array->size = 0;
+	array->objs = NULL;
+
+	/* all message objects, the table passed to the script may be shorter */
+	lua_newtable(lua);
+	array->cache = luaL_ref(lua, LUA_REGISTRYINDEX);
+	lua_newtable(lua);
+	array->ref = luaL_ref(lua, LUA_REGISTRYINDEX);
+}
+
+/**
+ * Releases the resources of the array. The message objects are
+ * released with the Lua state.
+ */
+void luaH_freemsgarray(struct lua_msg_array_t * array)
+{
+	free(array->objs);
+	array->objs = NULL;
+	array->size = 0;
+	array->n = 0;
+}
+
+/**
+ * Sets the messages of the message objects and pushes the table
+ * containing the objects (index 1 to n) onto the Lua stack. The table
+ * is reused but refilled for every batch, changes of the script to
+ * the table do not affect the next batch.
+ *
+ * @param[in] lua The Lua state.
+ * @param[in] array The array, see luaH_newmsgarray.
+ * @param[in] msgs The messages.
+ * @param[in] n Number of messages.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Unable to allocate memory, nothing is pushed.
+ */
+int luaH_pushmsgarray(
+		lua_State * lua,
+		struct lua_msg_array_t * array,
+		struct message_t * msgs,
+		size_t n)
+{
+	size_t i;
+	struct lua_msg_t ** objs;
+
+	if (n > array->size) {
+		objs = realloc(array->objs, sizeof(struct lua_msg_t *) * n);
+		if (objs == NULL)
+			return EXIT_FAILURE;
+		array->objs = objs;
+
+		lua_rawgeti(lua, LUA_REGISTRYINDEX, array->cache);
+		for (i = array->size; i < n; ++i) {
+			array->objs[i] = lua_newuserdata(lua, sizeof(struct lua_msg_t));
+			array->objs[i]->msg = NULL;
+			array->objs[i]->readonly = array->readonly;
+			luaL_setmetatable(lua, MSG_METATABLE);
+			lua_rawseti(lua, -2, (int)(i + 1));
+		}
+		lua_pop(lua, 1);
+		array->size = n;
+	}
+
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, array->ref);
+	lua_rawgeti(lua, LUA_REGISTRYINDEX, array->cache);
+	for (i = n; i < array->n; ++i) {
+		lua_pushnil(lua);
+		lua_rawseti(lua, -3, (int)(i + 1));
+	}
+	for (i = 0; i < n; ++i) {
+		lua_rawgeti(lua, -1, (int)(i + 1));
+		lua_rawseti(lua, -3, (int)(i + 1));
+	}
+	lua_pop(lua, 1);
+	array->n = n;
+
+	for (i = 0; i < n; ++i)
+		array->objs[i]->msg = &msgs[i];
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Detaches the messages from the message objects of the array.
+ */
+void luaH_clearmsgarray(struct lua_msg_array_t * array)
+{
+	size_t i;
+
+	for (i = 0; i < array->n; ++i)
+		array->objs[i]->msg = NULL;
+}
+
 void luaH_setup_message_handling(lua_State * lua)
 {
 	/* message types */
@@ -236,6 +560,7 @@ void luaH_setup_message_handling(lua_State * lua)
 
 	/* system message types */
 	luaH_define_unsigned_const(lua, "SYSTEM_TERMINATE", SYSTEM_TERMINATE);
+	luaH_define_unsigned_const(lua, "SYSTEM_REOPEN", SYSTEM_REOPEN);
 
 	/* message functions */
 	lua_register(lua, "msg_clone", lua__msg_clone);
@@ -243,6 +568,14 @@ void luaH_setup_message_handling(lua_State * lua)
 	lua_register(lua, "msg_to_table", lua__msg_to_table);
 	lua_register(lua, "msg_from_table", lua__msg_from_table);
 
+	/* message objects */
+	luaL_newmetatable(lua, MSG_METATABLE);
+	lua_pushcfunction(lua, lua__msg_index);
+	lua_setfield(lua, -2, "__index");
+	lua_pushcfunction(lua, lua__msg_newindex);
+	lua_setfield(lua, -2, "__newindex");
+	lua_pop(lua, 1);
+
 	luaH_setup_message_nmea_handling(lua);
 }
 
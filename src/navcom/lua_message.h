@@ -1,8 +1,32 @@
 #ifndef __NAVCOM__LUA_MESSAGE__H__
 #define __NAVCOM__LUA_MESSAGE__H__
 
+#include <stddef.h>
 #include <lua/lua.h>
 
+struct message_t;
+struct lua_msg_t;
+
+/**
+ * Message objects to pass batches of messages to scripts.
+ */
+struct lua_msg_array_t
+{
+	int ref; /* reference of the table passed to the script */
+	int cache; /* reference of the table keeping all message objects */
+	int readonly;
+	size_t n; /* number of messages within the table passed to the script */
+	size_t size; /* number of message objects */
+	struct lua_msg_t ** objs;
+};
+
 void luaH_setup_message_handling(lua_State *);
+int luaH_newmsg(lua_State *, int);
+void luaH_pushmsg(lua_State *, int, struct message_t *);
+void luaH_clearmsg(lua_State *, int);
+void luaH_newmsgarray(lua_State *, struct lua_msg_array_t *, int);
+void luaH_freemsgarray(struct lua_msg_array_t *);
+int luaH_pushmsgarray(lua_State *, struct lua_msg_array_t *, struct message_t *, size_t);
+void luaH_clearmsgarray(struct lua_msg_array_t *);
 
 #endif
@@ -3,163 +3,561 @@
 #include <navcom/lua_helper.h>
 #include <navcom/message.h>
 #include <nmea/nmea.h>
+#include <nmea/nmea_schema.h>
 #include <lua/lua.h>
 #include <lua/lualib.h>
 #include <lua/lauxlib.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void msg_to_table_nmea_rmc(
-		lua_State * lua,
-		const struct nmea_t * nmea)
+/**
+ * Kind of field in addition to NMEA_KIND_..., only used by Lua.
+ */
+#define KIND_SATELITE 16 /* struct nmea_satelite_t */
+
+/**
+ * Description of a field of a sentence, accessible by its name from Lua.
+ * Arrays have more than one element, each of the specified size.
+ */
+struct lua_field_t
 {
-	const struct nmea_rmc_t * s = &nmea->sentence.rmc;
+	const char * name;
+	uint8_t kind; /* NMEA_KIND_... or KIND_SATELITE */
+	uint8_t count; /* number of elements */
+	uint16_t offset; /* position of the data within struct nmea_t */
+	uint16_t size; /* size of one element */
+};
 
-	luaH_pushnmeatime(lua, &s->time);
-	lua_setfield(lua, -2, "time");
+/**
+ * Field descriptors, the name within Lua is the name of the member
+ * of the sentence structure 's'.
+ */
+#define FIELD(s, m, kind) \
+	{ #m, kind, 1, NMEA_OFFSET(s.m), NMEA_SIZE(s.m) }
+#define FIELD_ARRAY(s, m, kind) \
+	{ #m, kind, NMEA_SIZE(s.m) / NMEA_SIZE(s.m[0]), NMEA_OFFSET(s.m), NMEA_SIZE(s.m[0]) }
 
-	luaH_pushchar(lua, s->status);
-	lua_setfield(lua, -2, "status");
+static const struct lua_field_t FIELDS_RMB[] =
+{
+	FIELD(rmb, status,            NMEA_KIND_CHAR),
+	FIELD(rmb, cross_track_error, NMEA_KIND_FIX),
+	FIELD(rmb, steer_dir,         NMEA_KIND_CHAR),
+	FIELD(rmb, waypoint_to,       NMEA_KIND_UINT),
+	FIELD(rmb, waypoint_from,     NMEA_KIND_UINT),
+	FIELD(rmb, lat,               NMEA_KIND_LAT),
+	FIELD(rmb, lat_dir,           NMEA_KIND_CHAR),
+	FIELD(rmb, lon,               NMEA_KIND_LON),
+	FIELD(rmb, lon_dir,           NMEA_KIND_CHAR),
+	FIELD(rmb, range,             NMEA_KIND_FIX),
+	FIELD(rmb, bearing,           NMEA_KIND_FIX),
+	FIELD(rmb, dst_velocity,      NMEA_KIND_FIX),
+	FIELD(rmb, arrival_status,    NMEA_KIND_CHAR),
+	FIELD(rmb, sig_integrity,     NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_RMC[] =
+{
+	FIELD(rmc, time,          NMEA_KIND_TIME),
+	FIELD(rmc, status,        NMEA_KIND_CHAR),
+	FIELD(rmc, lat,           NMEA_KIND_LAT),
+	FIELD(rmc, lat_dir,       NMEA_KIND_CHAR),
+	FIELD(rmc, lon,           NMEA_KIND_LON),
+	FIELD(rmc, lon_dir,       NMEA_KIND_CHAR),
+	FIELD(rmc, sog,           NMEA_KIND_FIX),
+	FIELD(rmc, head,          NMEA_KIND_FIX),
+	FIELD(rmc, date,          NMEA_KIND_DATE),
+	FIELD(rmc, m,             NMEA_KIND_FIX),
+	FIELD(rmc, m_dir,         NMEA_KIND_CHAR),
+	FIELD(rmc, sig_integrity, NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_GGA[] =
+{
+	FIELD(gga, time,                    NMEA_KIND_TIME),
+	FIELD(gga, lat,                     NMEA_KIND_LAT),
+	FIELD(gga, lat_dir,                 NMEA_KIND_CHAR),
+	FIELD(gga, lon,                     NMEA_KIND_LON),
+	FIELD(gga, lon_dir,                 NMEA_KIND_CHAR),
+	FIELD(gga, quality,                 NMEA_KIND_UINT),
+	FIELD(gga, n_satelites,             NMEA_KIND_UINT),
+	FIELD(gga, hor_dilution,            NMEA_KIND_FIX),
+	FIELD(gga, height_antenna,          NMEA_KIND_FIX),
+	FIELD(gga, unit_antenna,            NMEA_KIND_CHAR),
+	FIELD(gga, geodial_separation,      NMEA_KIND_FIX),
+	FIELD(gga, unit_geodial_separation, NMEA_KIND_CHAR),
+	FIELD(gga, dgps_age,                NMEA_KIND_FIX),
+	FIELD(gga, dgps_ref,                NMEA_KIND_UINT),
+};
+
+static const struct lua_field_t FIELDS_GSA[] =
+{
+	FIELD(gsa, selection_mode, NMEA_KIND_CHAR),
+	FIELD(gsa, mode,           NMEA_KIND_UINT),
+	FIELD_ARRAY(gsa, id,       NMEA_KIND_UINT),
+	FIELD(gsa, pdop,           NMEA_KIND_FIX),
+	FIELD(gsa, hdop,           NMEA_KIND_FIX),
+	FIELD(gsa, vdop,           NMEA_KIND_FIX),
+};
+
+static const struct lua_field_t FIELDS_GSV[] =
+{
+	FIELD(gsv, n_messages,     NMEA_KIND_UINT),
+	FIELD(gsv, message_number, NMEA_KIND_UINT),
+	FIELD(gsv, n_satelites,    NMEA_KIND_UINT),
+	FIELD_ARRAY(gsv, sat,      KIND_SATELITE),
+};
 
-	luaH_pushnmeaangle(lua, &s->lat);
-	lua_setfield(lua, -2, "lat");
+static const struct lua_field_t FIELDS_GLL[] =
+{
+	FIELD(gll, lat,           NMEA_KIND_LAT),
+	FIELD(gll, lat_dir,       NMEA_KIND_CHAR),
+	FIELD(gll, lon,           NMEA_KIND_LON),
+	FIELD(gll, lon_dir,       NMEA_KIND_CHAR),
+	FIELD(gll, time,          NMEA_KIND_TIME),
+	FIELD(gll, status,        NMEA_KIND_CHAR),
+	FIELD(gll, sig_integrity, NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_RTE[] =
+{
+	FIELD(rte, n_messages,          NMEA_KIND_UINT),
+	FIELD(rte, message_number,      NMEA_KIND_UINT),
+	FIELD(rte, message_mode,        NMEA_KIND_CHAR),
+	FIELD_ARRAY(rte, waypoint_id,   NMEA_KIND_STRING),
+};
 
-	luaH_pushchar(lua, s->lat_dir);
-	lua_setfield(lua, -2, "lat_dir");
+static const struct lua_field_t FIELDS_VTG[] =
+{
+	FIELD(vtg, track_true,     NMEA_KIND_FIX),
+	FIELD(vtg, type_true,      NMEA_KIND_CHAR),
+	FIELD(vtg, track_magn,     NMEA_KIND_FIX),
+	FIELD(vtg, type_magn,      NMEA_KIND_CHAR),
+	FIELD(vtg, speed_kn,       NMEA_KIND_FIX),
+	FIELD(vtg, unit_speed_kn,  NMEA_KIND_CHAR),
+	FIELD(vtg, speed_kmh,      NMEA_KIND_FIX),
+	FIELD(vtg, unit_speed_kmh, NMEA_KIND_CHAR),
+	FIELD(vtg, sig_integrity,  NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_BOD[] =
+{
+	FIELD(bod, bearing_true,  NMEA_KIND_FIX),
+	FIELD(bod, type_true,     NMEA_KIND_CHAR),
+	FIELD(bod, bearing_magn,  NMEA_KIND_FIX),
+	FIELD(bod, type_magn,     NMEA_KIND_CHAR),
+	FIELD(bod, waypoint_to,   NMEA_KIND_UINT),
+	FIELD(bod, waypoint_from, NMEA_KIND_UINT),
+};
+
+static const struct lua_field_t FIELDS_GARMIN_RME[] =
+{
+	FIELD(garmin_rme, hpe,       NMEA_KIND_FIX),
+	FIELD(garmin_rme, unit_hpe,  NMEA_KIND_CHAR),
+	FIELD(garmin_rme, vpe,       NMEA_KIND_FIX),
+	FIELD(garmin_rme, unit_vpe,  NMEA_KIND_CHAR),
+	FIELD(garmin_rme, sepe,      NMEA_KIND_FIX),
+	FIELD(garmin_rme, unit_sepe, NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_GARMIN_RMM[] =
+{
+	FIELD(garmin_rmm, map_datum, NMEA_KIND_STRING),
+};
 
-	luaH_pushnmeaangle(lua, &s->lon);
-	lua_setfield(lua, -2, "lon");
+static const struct lua_field_t FIELDS_GARMIN_RMZ[] =
+{
+	FIELD(garmin_rmz, alt,         NMEA_KIND_FIX),
+	FIELD(garmin_rmz, unit_alt,    NMEA_KIND_CHAR),
+	FIELD(garmin_rmz, pos_fix_dim, NMEA_KIND_UINT),
+};
 
-	luaH_pushchar(lua, s->lon_dir);
-	lua_setfield(lua, -2, "lon_dir");
+static const struct lua_field_t FIELDS_HC_HDG[] =
+{
+	FIELD(hc_hdg, heading,      NMEA_KIND_FIX),
+	FIELD(hc_hdg, magn_dev,     NMEA_KIND_FIX),
+	FIELD(hc_hdg, magn_dev_dir, NMEA_KIND_CHAR),
+	FIELD(hc_hdg, magn_var,     NMEA_KIND_FIX),
+	FIELD(hc_hdg, magn_var_dir, NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_MWV[] =
+{
+	FIELD(ii_mwv, angle,      NMEA_KIND_FIX),
+	FIELD(ii_mwv, type,       NMEA_KIND_CHAR),
+	FIELD(ii_mwv, speed,      NMEA_KIND_FIX),
+	FIELD(ii_mwv, speed_unit, NMEA_KIND_CHAR),
+	FIELD(ii_mwv, status,     NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_VWR[] =
+{
+	FIELD(ii_vwr, angle,            NMEA_KIND_FIX),
+	FIELD(ii_vwr, side,             NMEA_KIND_CHAR),
+	FIELD(ii_vwr, speed_knots,      NMEA_KIND_FIX),
+	FIELD(ii_vwr, speed_knots_unit, NMEA_KIND_CHAR),
+	FIELD(ii_vwr, speed_mps,        NMEA_KIND_FIX),
+	FIELD(ii_vwr, speed_mps_unit,   NMEA_KIND_CHAR),
+	FIELD(ii_vwr, speed_kmh,        NMEA_KIND_FIX),
+	FIELD(ii_vwr, speed_kmh_unit,   NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_VWT[] =
+{
+	FIELD(ii_vwt, angle,            NMEA_KIND_FIX),
+	FIELD(ii_vwt, side,             NMEA_KIND_CHAR),
+	FIELD(ii_vwt, speed_knots,      NMEA_KIND_FIX),
+	FIELD(ii_vwt, speed_knots_unit, NMEA_KIND_CHAR),
+	FIELD(ii_vwt, speed_mps,        NMEA_KIND_FIX),
+	FIELD(ii_vwt, speed_mps_unit,   NMEA_KIND_CHAR),
+	FIELD(ii_vwt, speed_kmh,        NMEA_KIND_FIX),
+	FIELD(ii_vwt, speed_kmh_unit,   NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_DBT[] =
+{
+	FIELD(ii_dbt, depth_feet,        NMEA_KIND_FIX),
+	FIELD(ii_dbt, depth_unit_feet,   NMEA_KIND_CHAR),
+	FIELD(ii_dbt, depth_meter,       NMEA_KIND_FIX),
+	FIELD(ii_dbt, depth_unit_meter,  NMEA_KIND_CHAR),
+	FIELD(ii_dbt, depth_fathom,      NMEA_KIND_FIX),
+	FIELD(ii_dbt, depth_unit_fathom, NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_VLW[] =
+{
+	FIELD(ii_vlw, distance_cum,        NMEA_KIND_FIX),
+	FIELD(ii_vlw, distance_cum_unit,   NMEA_KIND_CHAR),
+	FIELD(ii_vlw, distance_reset,      NMEA_KIND_FIX),
+	FIELD(ii_vlw, distance_reset_unit, NMEA_KIND_CHAR),
+};
 
-	luaH_pushnmeafix(lua, &s->sog);
-	lua_setfield(lua, -2, "sog");
+static const struct lua_field_t FIELDS_II_VHW[] =
+{
+	FIELD(ii_vhw, heading_empty,    NMEA_KIND_CHAR),
+	FIELD(ii_vhw, degrees_true,     NMEA_KIND_CHAR),
+	FIELD(ii_vhw, heading,          NMEA_KIND_FIX),
+	FIELD(ii_vhw, degrees_mag,      NMEA_KIND_CHAR),
+	FIELD(ii_vhw, speed_knots,      NMEA_KIND_FIX),
+	FIELD(ii_vhw, speed_knots_unit, NMEA_KIND_CHAR),
+	FIELD(ii_vhw, speed_kmh,        NMEA_KIND_FIX),
+	FIELD(ii_vhw, speed_kmh_unit,   NMEA_KIND_CHAR),
+};
+
+static const struct lua_field_t FIELDS_II_MTW[] =
+{
+	FIELD(ii_mtw, temperature, NMEA_KIND_FIX),
+	FIELD(ii_mtw, unit,        NMEA_KIND_CHAR),
+};
 
-	luaH_pushnmeafix(lua, &s->head);
-	lua_setfield(lua, -2, "head");
+#define SENTENCE(t, fields) { t, fields, sizeof(fields) / sizeof(fields[0]) }
 
-	luaH_pushnmeadate(lua, &s->date);
-	lua_setfield(lua, -2, "date");
+static const struct lua_sentence_t
+{
+	uint32_t type;
+	const struct lua_field_t * fields;
+	size_t num_fields;
+} SENTENCES[] =
+{
+	SENTENCE(NMEA_RMB,        FIELDS_RMB),
+	SENTENCE(NMEA_RMC,        FIELDS_RMC),
+	SENTENCE(NMEA_GGA,        FIELDS_GGA),
+	SENTENCE(NMEA_GSA,        FIELDS_GSA),
+	SENTENCE(NMEA_GSV,        FIELDS_GSV),
+	SENTENCE(NMEA_GLL,        FIELDS_GLL),
+	SENTENCE(NMEA_RTE,        FIELDS_RTE),
+	SENTENCE(NMEA_VTG,        FIELDS_VTG),
+	SENTENCE(NMEA_BOD,        FIELDS_BOD),
+	SENTENCE(NMEA_GARMIN_RME, FIELDS_GARMIN_RME),
+	SENTENCE(NMEA_GARMIN_RMM, FIELDS_GARMIN_RMM),
+	SENTENCE(NMEA_GARMIN_RMZ, FIELDS_GARMIN_RMZ),
+	SENTENCE(NMEA_HC_HDG,     FIELDS_HC_HDG),
+	SENTENCE(NMEA_II_MWV,     FIELDS_II_MWV),
+	SENTENCE(NMEA_II_VWR,     FIELDS_II_VWR),
+	SENTENCE(NMEA_II_VWT,     FIELDS_II_VWT),
+	SENTENCE(NMEA_II_DBT,     FIELDS_II_DBT),
+	SENTENCE(NMEA_II_VLW,     FIELDS_II_VLW),
+	SENTENCE(NMEA_II_VHW,     FIELDS_II_VHW),
+	SENTENCE(NMEA_II_MTW,     FIELDS_II_MTW),
+};
+
+static const struct lua_sentence_t * find_sentence(uint32_t type)
+{
+	size_t i;
 
-	luaH_pushnmeafix(lua, &s->m);
-	lua_setfield(lua, -2, "m");
+	for (i = 0; i < sizeof(SENTENCES) / sizeof(SENTENCES[0]); ++i) {
+		if (SENTENCES[i].type == type)
+			return &SENTENCES[i];
+	}
+	return NULL;
+}
 
-	luaH_pushchar(lua, s->m_dir);
-	lua_setfield(lua, -2, "m_dir");
+static const struct lua_field_t * find_field(uint32_t type, const char * name)
+{
+	const struct lua_sentence_t * sentence;
+	size_t i;
 
-	luaH_pushchar(lua, s->sig_integrity);
-	lua_setfield(lua, -2, "sig_integrity");
+	sentence = find_sentence(type);
+	if (sentence == NULL)
+		return NULL;
+	for (i = 0; i < sentence->num_fields; ++i) {
+		if (strcmp(sentence->fields[i].name, name) == 0)
+			return &sentence->fields[i];
+	}
+	return NULL;
 }
 
-/**
- * Fills the table within the Lua state with the NMEA data.
- * Supported NMEA sentences are:
- * - RMC
- */
-void luaH_msg_to_table_nmea(lua_State * lua, const struct message_t * msg)
+static void push_uint(lua_State * lua, const char * p)
+{
+	uint32_t t;
+
+	memcpy(&t, p, sizeof(t));
+	lua_pushunsigned(lua, t);
+}
+
+static void check_uint(lua_State * lua, int index, char * p)
 {
-	struct msg_nmea_t
-	{
-		uint32_t type;
-		void (*func)(lua_State *, const struct nmea_t *);
-	};
+	uint32_t t;
 
-	static const struct msg_nmea_t CONV[] =
-	{
-		{ NMEA_RMC, msg_to_table_nmea_rmc },
-	};
+	t = luaL_checkunsigned(lua, index);
+	memcpy(p, &t, sizeof(t));
+}
 
-	const struct nmea_t * nmea = &msg->data.attr.nmea;
-	size_t i;
+static void push_satelite(lua_State * lua, const char * p)
+{
+	struct nmea_satelite_t t;
+
+	memcpy(&t, p, sizeof(t));
+	lua_createtable(lua, 0, 4);
+	lua_pushunsigned(lua, t.id);
+	lua_setfield(lua, -2, "id");
+	lua_pushunsigned(lua, t.elevation);
+	lua_setfield(lua, -2, "elevation");
+	lua_pushunsigned(lua, t.azimuth);
+	lua_setfield(lua, -2, "azimuth");
+	lua_pushunsigned(lua, t.snr);
+	lua_setfield(lua, -2, "snr");
+}
 
-	lua_newtable(lua);
+static void check_satelite(lua_State * lua, int index, char * p)
+{
+	struct nmea_satelite_t t;
+
+	index = lua_absindex(lua, index);
+	luaL_checktype(lua, index, LUA_TTABLE);
+	lua_getfield(lua, index, "id");
+	t.id = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "elevation");
+	t.elevation = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "azimuth");
+	t.azimuth = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "snr");
+	t.snr = luaL_checkunsigned(lua, -1);
+	lua_pop(lua, 4);
+	memcpy(p, &t, sizeof(t));
+}
 
-	lua_pushunsigned(lua, nmea->type);
-	lua_setfield(lua, -2, "nmea_type");
+static void check_time(lua_State * lua, int index, char * p)
+{
+	struct nmea_time_t t;
+
+	index = lua_absindex(lua, index);
+	luaL_checktype(lua, index, LUA_TTABLE);
+	lua_getfield(lua, index, "h");
+	t.h = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "m");
+	t.m = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "s");
+	t.s = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "ms");
+	t.ms = luaL_optunsigned(lua, -1, 0);
+	lua_pop(lua, 4);
+	memcpy(p, &t, sizeof(t));
+}
 
-	lua_pushstring(lua, nmea->raw);
-	lua_setfield(lua, -2, "raw");
+static void check_date(lua_State * lua, int index, char * p)
+{
+	struct nmea_date_t t;
+
+	index = lua_absindex(lua, index);
+	luaL_checktype(lua, index, LUA_TTABLE);
+	lua_getfield(lua, index, "y");
+	t.y = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "m");
+	t.m = luaL_checkunsigned(lua, -1);
+	lua_getfield(lua, index, "d");
+	t.d = luaL_checkunsigned(lua, -1);
+	lua_pop(lua, 3);
+	memcpy(p, &t, sizeof(t));
+}
 
-	lua_newtable(lua);
-	for (i = 0; i < sizeof(CONV) / sizeof(CONV[0]); ++i) {
-		if ((CONV[i].type == nmea->type) && CONV[i].func) {
-			CONV[i].func(lua, nmea);
+/**
+ * Pushes the value of one element of a field onto the Lua stack.
+ * Characters become strings, fix numbers and angles become numbers,
+ * times, dates and satelites become tables.
+ */
+static void push_value(lua_State * lua, const char * p, const struct lua_field_t * field)
+{
+	struct nmea_fix_t fix;
+	struct nmea_angle_t angle;
+	struct nmea_time_t time;
+	struct nmea_date_t date;
+
+	switch (field->kind) {
+		case NMEA_KIND_CHAR:
+			luaH_pushchar(lua, *p);
+			break;
+		case NMEA_KIND_UINT:
+			push_uint(lua, p);
+			break;
+		case NMEA_KIND_FIX:
+			memcpy(&fix, p, sizeof(fix));
+			luaH_pushnmeafix(lua, &fix);
+			break;
+		case NMEA_KIND_LAT:
+		case NMEA_KIND_LON:
+			memcpy(&angle, p, sizeof(angle));
+			luaH_pushnmeaangle(lua, &angle);
+			break;
+		case NMEA_KIND_TIME:
+			memcpy(&time, p, sizeof(time));
+			luaH_pushnmeatime(lua, &time);
+			break;
+		case NMEA_KIND_DATE:
+			memcpy(&date, p, sizeof(date));
+			luaH_pushnmeadate(lua, &date);
+			break;
+		case NMEA_KIND_STRING:
+			lua_pushlstring(lua, p, strnlen(p, field->size));
+			break;
+		case KIND_SATELITE:
+			push_satelite(lua, p);
+			break;
+		default:
+			lua_pushnil(lua);
 			break;
-		}
 	}
-	lua_setfield(lua, -2, "sentence");
-
-	lua_setfield(lua, -2, "nmea");
 }
 
-static void msg_from_table_nmea_rmc(lua_State * lua, struct nmea_t * nmea)
+/**
+ * Reads the value of one element of a field from the Lua stack.
+ * Raises a Lua error if the value does not fit the field.
+ */
+static void check_value(lua_State * lua, int index, char * p, const struct lua_field_t * field)
 {
-	struct nmea_rmc_t * s = &nmea->sentence.rmc;
+	struct nmea_fix_t fix;
+	struct nmea_angle_t angle;
 
-	lua_getfield(lua, -1, "time");
-	lua_getfield(lua, -1, "h");
-	s->time.h = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_getfield(lua, -1, "m");
-	s->time.m = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_getfield(lua, -1, "s");
-	s->time.s = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_pop(lua, 1);
+	switch (field->kind) {
+		case NMEA_KIND_CHAR:
+			*p = luaH_checkchar(lua, index);
+			break;
+		case NMEA_KIND_UINT:
+			check_uint(lua, index, p);
+			break;
+		case NMEA_KIND_FIX:
+			luaH_checknmeafix(lua, index, &fix);
+			memcpy(p, &fix, sizeof(fix));
+			break;
+		case NMEA_KIND_LAT:
+		case NMEA_KIND_LON:
+			luaH_checknmeaangle(lua, index, &angle);
+			memcpy(p, &angle, sizeof(angle));
+			break;
+		case NMEA_KIND_TIME:
+			check_time(lua, index, p);
+			break;
+		case NMEA_KIND_DATE:
+			check_date(lua, index, p);
+			break;
+		case NMEA_KIND_STRING:
+			memset(p, 0, field->size);
+			strncpy(p, luaL_checkstring(lua, index), field->size - 1);
+			break;
+		case KIND_SATELITE:
+			check_satelite(lua, index, p);
+			break;
+		default:
+			break;
+	}
+}
 
-	lua_getfield(lua, -1, "status");
-	s->status = luaH_checkchar(lua, -1);
-	lua_pop(lua, 1);
+/**
+ * Pushes the field onto the Lua stack, arrays become tables.
+ */
+static void push_field(lua_State * lua, const struct nmea_t * nmea, const struct lua_field_t * field)
+{
+	const char * p = (const char *)nmea + field->offset;
+	unsigned int i;
 
-	lua_getfield(lua, -1, "lat");
-	luaH_checknmeaangle(lua, -1, &s->lat);
-	lua_pop(lua, 1);
+	if (field->count <= 1) {
+		push_value(lua, p, field);
+		return;
+	}
 
-	lua_getfield(lua, -1, "lat_dir");
-	s->lat_dir = luaH_checkchar(lua, -1);
-	lua_pop(lua, 1);
+	lua_createtable(lua, field->count, 0);
+	for (i = 0; i < field->count; ++i) {
+		push_value(lua, p + i * field->size, field);
+		lua_rawseti(lua, -2, i + 1);
+	}
+}
 
-	lua_getfield(lua, -1, "lon");
-	luaH_checknmeaangle(lua, -1, &s->lon);
-	lua_pop(lua, 1);
+/**
+ * Reads the field from the Lua stack, arrays are read from tables.
+ * Missing elements of arrays are set to zero.
+ */
+static void check_field(lua_State * lua, int index, struct nmea_t * nmea, const struct lua_field_t * field)
+{
+	char * p = (char *)nmea + field->offset;
+	unsigned int i;
 
-	lua_getfield(lua, -1, "lon_dir");
-	s->lon_dir = luaH_checkchar(lua, -1);
-	lua_pop(lua, 1);
+	if (field->count <= 1) {
+		check_value(lua, index, p, field);
+		return;
+	}
 
-	lua_getfield(lua, -1, "sog");
-	luaH_checknmeafix(lua, -1, &s->sog);
-	lua_pop(lua, 1);
+	index = lua_absindex(lua, index);
+	luaL_checktype(lua, index, LUA_TTABLE);
+	for (i = 0; i < field->count; ++i) {
+		lua_rawgeti(lua, index, i + 1);
+		if (lua_isnil(lua, -1)) {
+			memset(p + i * field->size, 0, field->size);
+		} else {
+			check_value(lua, -1, p + i * field->size, field);
+		}
+		lua_pop(lua, 1);
+	}
+}
 
-	lua_getfield(lua, -1, "head");
-	luaH_checknmeafix(lua, -1, &s->head);
-	lua_pop(lua, 1);
+/**
+ * Fills the table within the Lua state with the NMEA data.
+ * All sentences known by the NMEA library are supported, the
+ * fields are named like the members of the sentence structures.
+ */
+void luaH_msg_to_table_nmea(lua_State * lua, const struct message_t * msg)
+{
+	const struct nmea_t * nmea = &msg->data.attr.nmea;
+	const struct lua_sentence_t * sentence;
+	size_t i;
 
-	lua_getfield(lua, -1, "date");
-	lua_getfield(lua, -1, "y");
-	s->date.y = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_getfield(lua, -1, "m");
-	s->date.m = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_getfield(lua, -1, "d");
-	s->date.d = luaL_checkunsigned(lua, -1);
-	lua_pop(lua, 1);
-	lua_pop(lua, 1);
+	lua_newtable(lua);
 
-	lua_getfield(lua, -1, "m");
-	luaH_checknmeafix(lua, -1, &s->m);
-	lua_pop(lua, 1);
+	lua_pushunsigned(lua, nmea->type);
+	lua_setfield(lua, -2, "nmea_type");
 
-	lua_getfield(lua, -1, "m_dir");
-	s->m_dir = luaH_checkchar(lua, -1);
-	lua_pop(lua, 1);
+	lua_pushstring(lua, nmea->raw);
+	lua_setfield(lua, -2, "raw");
 
-	lua_getfield(lua, -1, "sig_integrity");
-	s->sig_integrity = luaH_checkchar(lua, -1);
-	lua_pop(lua, 1);
+	sentence = find_sentence(nmea->type);
+	lua_createtable(lua, 0, sentence ? sentence->num_fields : 0);
+	if (sentence) {
+		for (i = 0; i < sentence->num_fields; ++i) {
+			push_field(lua, nmea, &sentence->fields[i]);
+			lua_setfield(lua, -2, sentence->fields[i].name);
+		}
+	}
+	lua_setfield(lua, -2, "sentence");
+
+	lua_setfield(lua, -2, "nmea");
 }
 
 /**
@@ -169,18 +567,8 @@ static void msg_from_table_nmea_rmc(lua_State * lua, struct nmea_t * nmea)
  */
 int luaH_msg_from_table_nmea(lua_State * lua, struct message_t * msg)
 {
-	struct msg_nmea_t
-	{
-		uint32_t type;
-		void (*func)(lua_State *, struct nmea_t *);
-	};
-
-	static const struct msg_nmea_t CONV[] =
-	{
-		{ NMEA_RMC, msg_from_table_nmea_rmc },
-	};
-
 	struct nmea_t * nmea = &msg->data.attr.nmea;
+	const struct lua_sentence_t * sentence;
 	size_t i;
 
 	lua_getfield(lua, -1, "nmea");
@@ -194,16 +582,77 @@ int luaH_msg_from_table_nmea(lua_State * lua, struct message_t * msg)
 	lua_pop(lua, 1);
 
 	lua_getfield(lua, -1, "sentence");
-	for (i = 0; i < sizeof(CONV) / sizeof(CONV[0]); ++i) {
-		if ((CONV[i].type == nmea->type) && CONV[i].func) {
-			CONV[i].func(lua, nmea);
-			break;
+	sentence = find_sentence(nmea->type);
+	if (sentence) {
+		for (i = 0; i < sentence->num_fields; ++i) {
+			lua_getfield(lua, -1, sentence->fields[i].name);
+			check_field(lua, -1, nmea, &sentence->fields[i]);
+			lua_pop(lua, 1);
 		}
 	}
 	lua_pop(lua, 2);
 	return EXIT_SUCCESS;
 }
 
+/**
+ * Pushes the value of the field with the specified name of the
+ * NMEA message onto the Lua stack. Besides the fields of the sentence,
+ * the fields 'nmea_type' and 'raw' are accessible.
+ *
+ * @retval 1 The value was pushed.
+ * @retval 0 The field is unknown, nothing was pushed.
+ */
+int luaH_msg_index_nmea(lua_State * lua, const struct message_t * msg, const char * name)
+{
+	const struct nmea_t * nmea = &msg->data.attr.nmea;
+	const struct lua_field_t * field;
+
+	if (strcmp(name, "nmea_type") == 0) {
+		lua_pushunsigned(lua, nmea->type);
+		return 1;
+	}
+	if (strcmp(name, "raw") == 0) {
+		lua_pushlstring(lua, nmea->raw, strnlen(nmea->raw, sizeof(nmea->raw)));
+		return 1;
+	}
+
+	field = find_field(nmea->type, name);
+	if (field == NULL)
+		return 0;
+	push_field(lua, nmea, field);
+	return 1;
+}
+
+/**
+ * Sets the field with the specified name of the NMEA message to the
+ * value at the index of the Lua stack. Raises a Lua error if the
+ * value does not fit the field.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE The field is unknown.
+ */
+int luaH_msg_newindex_nmea(lua_State * lua, struct message_t * msg, const char * name, int index)
+{
+	struct nmea_t * nmea = &msg->data.attr.nmea;
+	const struct lua_field_t * field;
+
+	if (strcmp(name, "nmea_type") == 0) {
+		nmea->type = luaL_checkunsigned(lua, index);
+		return EXIT_SUCCESS;
+	}
+	if (strcmp(name, "raw") == 0) {
+		memset(nmea->raw, 0, sizeof(nmea->raw));
+		strncpy(nmea->raw, luaL_checkstring(lua, index), sizeof(nmea->raw) - 1);
+		return EXIT_SUCCESS;
+	}
+
+	field = find_field(nmea->type, name);
+	if (field == NULL)
+		return EXIT_FAILURE;
+	check_field(lua, index, nmea, field);
+	return EXIT_SUCCESS;
+}
+
 void luaH_setup_message_nmea_handling(lua_State * lua)
 {
 	luaH_define_unsigned_const(lua, "NMEA_NONE",       NMEA_NONE);
@@ -220,6 +669,13 @@ void luaH_setup_message_nmea_handling(lua_State * lua)
 	luaH_define_unsigned_const(lua, "NMEA_GARMIN_RMM", NMEA_GARMIN_RMM);
 	luaH_define_unsigned_const(lua, "NMEA_GARMIN_RMZ", NMEA_GARMIN_RMZ);
 	luaH_define_unsigned_const(lua, "NMEA_HC_HDG",     NMEA_HC_HDG);
+	luaH_define_unsigned_const(lua, "NMEA_II_MWV",     NMEA_II_MWV);
+	luaH_define_unsigned_const(lua, "NMEA_II_VWR",     NMEA_II_VWR);
+	luaH_define_unsigned_const(lua, "NMEA_II_VWT",     NMEA_II_VWT);
+	luaH_define_unsigned_const(lua, "NMEA_II_DBT",     NMEA_II_DBT);
+	luaH_define_unsigned_const(lua, "NMEA_II_VLW",     NMEA_II_VLW);
+	luaH_define_unsigned_const(lua, "NMEA_II_VHW",     NMEA_II_VHW);
+	luaH_define_unsigned_const(lua, "NMEA_II_MTW",     NMEA_II_MTW);
 
 	/* nmea directions */
 	luaH_define_char_const(lua, "NMEA_EAST",  NMEA_EAST);
@@ -8,5 +8,7 @@ struct message_t;
 void luaH_setup_message_nmea_handling(lua_State *);
 void luaH_msg_to_table_nmea(lua_State *, const struct message_t *);
 int luaH_msg_from_table_nmea(lua_State *, struct message_t *);
+int luaH_msg_index_nmea(lua_State *, const struct message_t *, const char *);
+int luaH_msg_newindex_nmea(lua_State *, struct message_t *, const char *, int);
 
 #endif
@@ -40,7 +40,10 @@ enum MessageType {
  */
 enum System {
 	/** Graceful termination of the system */
-	SYSTEM_TERMINATE = 0x00000001
+	 SYSTEM_TERMINATE = 0x00000001
+
+	/** Files are to be reopened, e.g. after log rotation */
+	,SYSTEM_REOPEN    = 0x00000002
 };
 
 /**
@@ -1,10 +1,275 @@
 #include <navcom/message_comm.h>
 #include <syslog.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
 
+/**
+ * Determines the part of the message data which is relevant for the
+ * specified message type. Only this part is transmitted. Unknown
+ * message types use the entire message data.
+ *
+ * @param[in] type The message type.
+ * @param[out] offset Offset of the payload within the message data.
+ * @param[out] size Size of the payload.
+ */
+static void message_payload(uint32_t type, uint32_t * offset, uint32_t * size)
+{
+	switch (type) {
+		case MSG_SYSTEM:
+			*offset = offsetof(struct message_data_t, system);
+			*size = sizeof(((struct message_data_t *)0)->system);
+			break;
+
+		case MSG_TIMER:
+			*offset = offsetof(struct message_data_t, timer_id);
+			*size = sizeof(((struct message_data_t *)0)->timer_id);
+			break;
+
+#if defined(NEEDS_NMEA)
+		case MSG_NMEA:
+			*offset = offsetof(struct message_data_t, nmea);
+			*size = sizeof(struct nmea_t);
+			break;
+#endif
+
+#if defined(NEEDS_SEATALK)
+		case MSG_SEATALK:
+			*offset = offsetof(struct message_data_t, seatalk);
+			*size = sizeof(struct seatalk_t);
+			break;
+#endif
+
+		default:
+			*offset = 0;
+			*size = sizeof(struct message_data_t);
+			break;
+	}
+}
+
+/**
+ * Reads exactly the specified number of bytes.
+ *
+ * @param[in] fd File descriptor to read from.
+ * @param[out] buf Buffer to hold the data.
+ * @param[in] size Number of bytes to read.
+ * @retval >0 Number of bytes read, always the specified size.
+ * @retval  0 End of file, no data read.
+ * @retval -1 Error, or end of file in the middle of the data.
+ */
+static int read_all(int fd, void * buf, size_t size)
+{
+	size_t n = 0;
+	int rc;
+
+	while (n < size) {
+		rc = read(fd, (char *)buf + n, size - n);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (rc == 0) {
+			if (n == 0)
+				return 0;
+			errno = EPIPE;
+			return -1;
+		}
+		n += rc;
+	}
+	return (int)n;
+}
+
+/**
+ * Returns the number of bytes the specified message occupies on the wire,
+ * including the header. Trailing zero bytes of the payload are not
+ * transmitted, the receiver restores them.
+ *
+ * @param[in] msg The message to determine the frame size for.
+ * @return The frame size in bytes.
+ */
+uint32_t message_frame_size(const struct message_t * msg)
+{
+	uint32_t offset;
+	uint32_t size;
+
+	message_payload(msg->type, &offset, &size);
+	while ((size > 0) && (msg->data.buf[offset + size - 1] == 0))
+		--size;
+	return sizeof(struct message_header_t) + size;
+}
+
+/**
+ * Encodes the message into the specified frame buffer.
+ *
+ * @param[out] frame Buffer to hold the frame, must be able to hold
+ *   at least MESSAGE_FRAME_MAX bytes.
+ * @param[in] msg The message to encode.
+ * @return The number of bytes used within the frame buffer.
+ */
+uint32_t message_encode(uint8_t * frame, const struct message_t * msg)
+{
+	struct message_header_t header;
+	uint32_t offset;
+	uint32_t size;
+
+	message_payload(msg->type, &offset, &size);
+	header.type = msg->type;
+	header.size = message_frame_size(msg) - sizeof(header);
+
+	memcpy(frame, &header, sizeof(header));
+	memcpy(frame + sizeof(header), msg->data.buf + offset, header.size);
+	return sizeof(header) + header.size;
+}
+
+/**
+ * Decodes the payload of a frame into the message. The header must
+ * already be validated by message_header_valid.
+ *
+ * @param[out] msg The message to decode into.
+ * @param[in] header The header of the frame.
+ * @param[in] payload The payload of the frame, containing header->size bytes.
+ */
+void message_decode(
+		struct message_t * msg,
+		const struct message_header_t * header,
+		const uint8_t * payload)
+{
+	uint32_t offset;
+	uint32_t size;
+
+	message_payload(header->type, &offset, &size);
+	memset(msg, 0, sizeof(struct message_t));
+	msg->type = header->type;
+	memcpy(msg->data.buf + offset, payload, header->size);
+}
+
+/**
+ * Checks whether or not the frame header is plausible.
+ *
+ * @param[in] header The header to check.
+ * @retval 1 Header is valid.
+ * @retval 0 Header is not valid.
+ */
+int message_header_valid(const struct message_header_t * header)
+{
+	uint32_t offset;
+	uint32_t size;
+
+	message_payload(header->type, &offset, &size);
+	return header->size <= size;
+}
+
+/**
+ * Initializes the message reader.
+ *
+ * @param[out] reader The reader to initialize.
+ */
+void message_reader_init(struct message_reader_t * reader)
+{
+	reader->pos = 0;
+	reader->len = 0;
+}
+
+/**
+ * Reads as much data as possible from the file descriptor into the
+ * buffer of the reader. Already decoded data is being discarded.
+ *
+ * @param[inout] reader The reader.
+ * @param[in] fd File descriptor to read from.
+ * @retval >0 Number of bytes read.
+ * @retval  0 End of file.
+ * @retval -1 Failure, see errno. For non-blocking file descriptors
+ *   this may be EAGAIN, if no data is available.
+ */
+int message_reader_fill(struct message_reader_t * reader, int fd)
+{
+	int rc;
+
+	if (reader->pos > 0) {
+		reader->len -= reader->pos;
+		memmove(reader->buf, reader->buf + reader->pos, reader->len);
+		reader->pos = 0;
+	}
+
+	do {
+		rc = read(fd, reader->buf + reader->len, sizeof(reader->buf) - reader->len);
+	} while (rc < 0 && errno == EINTR);
+
+	if (rc > 0)
+		reader->len += rc;
+	return rc;
+}
+
+/**
+ * Decodes the next message from the buffer of the reader.
+ *
+ * @param[inout] reader The reader.
+ * @param[out] msg The decoded message.
+ * @retval  1 A message was decoded.
+ * @retval  0 No complete message available, more data has to be read.
+ * @retval -1 Invalid frame, the buffered data is discarded.
+ */
+int message_reader_next(struct message_reader_t * reader, struct message_t * msg)
+{
+	struct message_header_t header;
+	uint32_t avail = reader->len - reader->pos;
+
+	if (avail < sizeof(header))
+		return 0;
+	memcpy(&header, reader->buf + reader->pos, sizeof(header));
+	if (!message_header_valid(&header)) {
+		syslog(LOG_ERR, "invalid message header, type=%08x size=%u", header.type, header.size);
+		message_reader_init(reader);
+		return -1;
+	}
+	if (avail < sizeof(header) + header.size)
+		return 0;
+	message_decode(msg, &header, reader->buf + reader->pos + sizeof(header));
+	reader->pos += sizeof(header) + header.size;
+	return 1;
+}
+
+/**
+ * Receives a message from the specified file descriptor. In contrast to
+ * message_read, this function distinguishes the end of file from
+ * other errors.
+ *
+ * @param[in] fd File descriptor to read from.
+ * @param[out] msg The message which is received.
+ * @retval >0 Success, number of bytes of the received frame.
+ * @retval  0 End of file, the other side has closed the connection.
+ * @retval -1 Failure
+ */
+int message_recv(int fd, struct message_t * msg)
+{
+	struct message_header_t header;
+	uint8_t payload[sizeof(struct message_data_t)];
+	int rc;
+
+	if (fd < 0)
+		return -1;
+	if (!msg)
+		return -1;
+
+	rc = read_all(fd, &header, sizeof(header));
+	if (rc <= 0)
+		return rc;
+	if (!message_header_valid(&header)) {
+		syslog(LOG_ERR, "invalid message header, type=%08x size=%u", header.type, header.size);
+		return -1;
+	}
+	if (header.size > 0) {
+		rc = read_all(fd, payload, header.size);
+		if (rc <= 0)
+			return -1;
+	}
+	message_decode(msg, &header, payload);
+	return (int)(sizeof(header) + header.size);
+}
+
 /**
  * Reads the message from the specified file descriptor.
  *
@@ -21,12 +286,12 @@ int message_read(int fd, struct message_t * msg)
 		return EXIT_FAILURE;
 	if (!msg)
 		return EXIT_FAILURE;
-	rc = read(fd, msg, sizeof(struct message_t));
+	rc = message_recv(fd, msg);
 	if (rc < 0) {
 		syslog(LOG_ERR, "unable to read message: %s", strerror(errno));
 		return EXIT_FAILURE;
 	}
-	if (rc != (int)sizeof(struct message_t) || rc == 0) {
+	if (rc == 0) {
 		syslog(LOG_ERR, "cannot read message, rc=%d", rc);
 		return EXIT_FAILURE;
 	}
@@ -36,6 +301,9 @@ int message_read(int fd, struct message_t * msg)
 /**
  * Writes the message to the file descriptor.
  *
+ * The message is written as one frame (header and payload), which is
+ * smaller than PIPE_BUF, therefore the write is atomic on pipes.
+ *
  * @param[in] fd File descriptor to write to.
  * @param[in] msg Message to write.
  * @retval EXIT_SUCCESS
@@ -44,14 +312,19 @@ int message_read(int fd, struct message_t * msg)
 int message_write(int fd, const struct message_t * msg)
 {
 	int rc;
+	uint8_t frame[MESSAGE_FRAME_MAX];
+	uint32_t size;
 
 	if (fd < 0)
 		return EXIT_FAILURE;
 	if (!msg)
 		return EXIT_FAILURE;
-	rc = write(fd, msg, sizeof(struct message_t));
+	size = message_encode(frame, msg);
+	rc = write(fd, frame, size);
 	if (rc < 0) {
-		syslog(LOG_DEBUG, "unable to write message: %s", strerror(errno));
+		rc = errno; /* preserved for the caller, e.g. EAGAIN */
+		syslog(LOG_DEBUG, "unable to write message: %s", strerror(rc));
+		errno = rc;
 		return EXIT_FAILURE;
 	}
 	return EXIT_SUCCESS;
@@ -3,6 +3,50 @@
 
 #include <navcom/message.h>
 
+/**
+ * Header of a message on the wire. It is followed by 'size' bytes
+ * of payload, which is the part of the message data relevant to the
+ * message type.
+ */
+struct message_header_t
+{
+	uint32_t type; /* see enum MessageType */
+	uint32_t size; /* size of the payload in bytes */
+} __attribute__((packed));
+
+/**
+ * Maximum size of a message on the wire.
+ */
+#define MESSAGE_FRAME_MAX (sizeof(struct message_header_t) + sizeof(struct message_data_t))
+
+/**
+ * Size of the receive buffer of a message reader. A pipe delivers at
+ * most PIPE_BUF bytes atomically, this is the natural chunk size.
+ */
+#define MESSAGE_READER_SIZE 4096
+
+/**
+ * Buffered reader, receives as many messages as possible with one
+ * read operation. Incomplete frames remain in the buffer until
+ * the rest is being received.
+ */
+struct message_reader_t
+{
+	uint32_t pos; /* start of the next frame to decode */
+	uint32_t len; /* number of valid bytes in the buffer */
+	uint8_t buf[MESSAGE_READER_SIZE];
+};
+
+uint32_t message_frame_size(const struct message_t *);
+uint32_t message_encode(uint8_t *, const struct message_t *);
+void message_decode(struct message_t *, const struct message_header_t *, const uint8_t *);
+int message_header_valid(const struct message_header_t *);
+
+void message_reader_init(struct message_reader_t *);
+int message_reader_fill(struct message_reader_t *, int);
+int message_reader_next(struct message_reader_t *, struct message_t *);
+
+int message_recv(int, struct message_t *);
 int message_read(int, struct message_t *);
 int message_write(int, const struct message_t *);
 
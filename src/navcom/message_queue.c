@@ -0,0 +1,208 @@
+#include <navcom/message_queue.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * Names of the policies, the index is the policy.
+ */
+static const char * POLICY_NAMES[] = {
+	"block",
+	"drop-oldest",
+	"drop-newest",
+	"coalesce",
+};
+
+/**
+ * Checks whether or not both messages are of the same kind, which
+ * means the newer message may replace the older one. NMEA sentences
+ * are of the same kind if they are the same sentence (by type, or by
+ * the tag for sentences not parsed), SeaTalk sentences if they have
+ * the same type and timer messages if they are of the same timer.
+ */
+static int same_kind(const struct message_t * a, const struct message_t * b)
+{
+	if (a->type != b->type)
+		return 0;
+	switch (a->type) {
+		case MSG_TIMER:
+			return a->data.attr.timer_id == b->data.attr.timer_id;
+#if defined(NEEDS_NMEA)
+		case MSG_NMEA:
+			if (a->data.attr.nmea.type != b->data.attr.nmea.type)
+				return 0;
+			if (a->data.attr.nmea.type != NMEA_NONE)
+				return 1;
+			return strncmp(a->data.attr.nmea.raw, b->data.attr.nmea.raw,
+				strcspn(a->data.attr.nmea.raw, ",")) == 0;
+#endif
+#if defined(NEEDS_SEATALK)
+		case MSG_SEATALK:
+			return a->data.attr.seatalk.type == b->data.attr.seatalk.type;
+#endif
+		default:
+			break;
+	}
+	return 0;
+}
+
+static struct message_t * at(const struct message_queue_t * queue, uint32_t i)
+{
+	return &queue->msgs[(queue->first + i) % queue->capacity];
+}
+
+/**
+ * Returns the policy for the specified name.
+ *
+ * @param[in] name Name of the policy: 'block', 'drop-oldest',
+ *   'drop-newest' or 'coalesce'.
+ * @return The policy, -1 if the name is unknown.
+ */
+int message_queue_policy(const char * name)
+{
+	size_t i;
+
+	if (name == NULL)
+		return -1;
+	for (i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); ++i) {
+		if (strcmp(name, POLICY_NAMES[i]) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+/**
+ * Initializes the queue.
+ *
+ * @param[out] queue The queue to initialize.
+ * @param[in] capacity Maximum number of messages, limited to MESSAGE_QUEUE_SIZE_MAX.
+ * @param[in] policy The policy if the queue is full.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int message_queue_init(struct message_queue_t * queue, uint32_t capacity, int policy)
+{
+	if (queue == NULL)
+		return EXIT_FAILURE;
+	memset(queue, 0, sizeof(struct message_queue_t));
+	if (capacity == 0)
+		return EXIT_FAILURE;
+	if (policy < MESSAGE_QUEUE_BLOCK || policy > MESSAGE_QUEUE_COALESCE)
+		return EXIT_FAILURE;
+	if (capacity > MESSAGE_QUEUE_SIZE_MAX)
+		capacity = MESSAGE_QUEUE_SIZE_MAX;
+
+	queue->msgs = malloc(sizeof(struct message_t) * capacity);
+	if (queue->msgs == NULL)
+		return EXIT_FAILURE;
+	queue->capacity = capacity;
+	queue->policy = policy;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Frees the resources of the queue.
+ */
+void message_queue_destroy(struct message_queue_t * queue)
+{
+	if (queue == NULL)
+		return;
+	if (queue->msgs)
+		free(queue->msgs);
+	memset(queue, 0, sizeof(struct message_queue_t));
+}
+
+/**
+ * Returns whether or not the queue is empty.
+ *
+ * @retval 1 The queue is empty, or does not exist.
+ * @retval 0 Messages are queued.
+ */
+int message_queue_empty(const struct message_queue_t * queue)
+{
+	return (queue == NULL) || (queue->count == 0);
+}
+
+/**
+ * Returns the number of messages lost by the queue, dropped or replaced
+ * by newer ones, 0 if the queue does not exist.
+ */
+unsigned long message_queue_lost(const struct message_queue_t * queue)
+{
+	if (queue == NULL)
+		return 0;
+	return queue->dropped + queue->coalesced;
+}
+
+/**
+ * Appends the message to the queue, according to the policy of the queue.
+ *
+ * @param[inout] queue The queue.
+ * @param[in] msg The message to append.
+ * @retval EXIT_SUCCESS The message was queued, coalesced or dropped
+ *   according to the policy.
+ * @retval EXIT_FAILURE Parameter error or the queue is full and the
+ *   message has to be queued later (errno is EAGAIN).
+ */
+int message_queue_push(struct message_queue_t * queue, const struct message_t * msg)
+{
+	uint32_t i;
+
+	if (queue == NULL || queue->msgs == NULL || msg == NULL)
+		return EXIT_FAILURE;
+
+	if (msg->type != MSG_SYSTEM && queue->policy == MESSAGE_QUEUE_COALESCE) {
+		for (i = 0; i < queue->count; ++i) {
+			if (same_kind(at(queue, i), msg)) {
+				memcpy(at(queue, i), msg, sizeof(struct message_t));
+				++queue->coalesced;
+				return EXIT_SUCCESS;
+			}
+		}
+	}
+
+	if (queue->count == queue->capacity) {
+		if (msg->type == MSG_SYSTEM || queue->policy == MESSAGE_QUEUE_BLOCK) {
+			++queue->blocked;
+			errno = EAGAIN;
+			return EXIT_FAILURE;
+		}
+		if (queue->policy == MESSAGE_QUEUE_DROP_NEWEST) {
+			++queue->dropped;
+			return EXIT_SUCCESS;
+		}
+		/* drop oldest, system messages are kept */
+		if (at(queue, 0)->type == MSG_SYSTEM) {
+			++queue->blocked;
+			errno = EAGAIN;
+			return EXIT_FAILURE;
+		}
+		++queue->dropped;
+		message_queue_pop(queue);
+	}
+
+	memcpy(at(queue, queue->count), msg, sizeof(struct message_t));
+	++queue->count;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Returns the oldest message of the queue, NULL if the queue is empty.
+ */
+const struct message_t * message_queue_front(const struct message_queue_t * queue)
+{
+	if (message_queue_empty(queue))
+		return NULL;
+	return at(queue, 0);
+}
+
+/**
+ * Removes the oldest message from the queue.
+ */
+void message_queue_pop(struct message_queue_t * queue)
+{
+	if (message_queue_empty(queue))
+		return;
+	queue->first = (queue->first + 1) % queue->capacity;
+	--queue->count;
+}
@@ -0,0 +1,52 @@
+#ifndef __NAVCOM__MESSAGE_QUEUE__H__
+#define __NAVCOM__MESSAGE_QUEUE__H__
+
+#include <stdint.h>
+#include <navcom/message.h>
+
+/**
+ * Policies of a queue, they define what happens to messages if
+ * the queue is full.
+ */
+#define MESSAGE_QUEUE_BLOCK       0 /* the message is not queued, the caller has to wait */
+#define MESSAGE_QUEUE_DROP_OLDEST 1 /* the oldest message is dropped */
+#define MESSAGE_QUEUE_DROP_NEWEST 2 /* the new message is dropped */
+#define MESSAGE_QUEUE_COALESCE    3 /* a queued message of the same kind is replaced,
+                                       the oldest message is dropped if there is none */
+
+/**
+ * Default and maximum number of messages within a queue.
+ */
+#define MESSAGE_QUEUE_SIZE_DEFAULT 64
+#define MESSAGE_QUEUE_SIZE_MAX     4096
+
+/**
+ * Bounded FIFO of messages, used by the hub for every destination
+ * to hold messages the destination is not able to receive yet.
+ *
+ * System messages are never dropped or replaced, if the queue is full
+ * they are treated as with MESSAGE_QUEUE_BLOCK.
+ */
+struct message_queue_t
+{
+	struct message_t * msgs;
+	uint32_t capacity;
+	uint32_t first; /* index of the oldest message */
+	uint32_t count; /* number of messages within the queue */
+	int policy;
+
+	unsigned long dropped; /* number of dropped messages */
+	unsigned long coalesced; /* number of messages replaced by newer ones */
+	unsigned long blocked; /* number of times the queue was full with MESSAGE_QUEUE_BLOCK */
+};
+
+int message_queue_policy(const char *);
+int message_queue_init(struct message_queue_t *, uint32_t, int);
+void message_queue_destroy(struct message_queue_t *);
+int message_queue_empty(const struct message_queue_t *);
+unsigned long message_queue_lost(const struct message_queue_t *);
+int message_queue_push(struct message_queue_t *, const struct message_t *);
+const struct message_t * message_queue_front(const struct message_queue_t *);
+void message_queue_pop(struct message_queue_t *);
+
+#endif
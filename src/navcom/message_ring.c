@@ -0,0 +1,327 @@
+#include <navcom/message_ring.h>
+#include <navcom/message_comm.h>
+#include <syslog.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+/**
+ * Positions within the ring are counted modulo 2^31, the highest bit
+ * of the idle word marks the consumer as idle.
+ */
+#define INDEX_MASK 0x7fffffffu
+#define IDLE       0x80000000u
+
+/**
+ * Control block at the start of the shared memory. The members are
+ * on separate cache lines, because they are written by different
+ * processes.
+ */
+struct ring_control_t
+{
+	/**
+	 * Position after the last frame, written by the producer only.
+	 */
+	uint32_t head __attribute__((aligned(64)));
+
+	/**
+	 * Position of the next frame to read, written by the consumer only.
+	 */
+	uint32_t tail __attribute__((aligned(64)));
+
+	/**
+	 * IDLE combined with the tail at the time the consumer became idle,
+	 * zero while the consumer is busy. Whoever resets this from idle
+	 * to zero has to wake up the consumer.
+	 */
+	uint32_t idle __attribute__((aligned(64)));
+};
+
+static struct ring_control_t * control(const struct message_ring_t * ring)
+{
+	return (struct ring_control_t *)ring->shm;
+}
+
+static uint8_t * data(const struct message_ring_t * ring)
+{
+	return (uint8_t *)ring->shm + sizeof(struct ring_control_t);
+}
+
+/**
+ * Copies data into the ring, wraps around at the end of the ring.
+ */
+static void copy_in(struct message_ring_t * ring, uint32_t pos, const void * buf, uint32_t size)
+{
+	uint32_t ofs = pos & (ring->size - 1);
+	uint32_t n = ring->size - ofs;
+
+	if (n > size)
+		n = size;
+	memcpy(data(ring) + ofs, buf, n);
+	memcpy(data(ring), (const uint8_t *)buf + n, size - n);
+}
+
+/**
+ * Copies data out of the ring, wraps around at the end of the ring.
+ */
+static void copy_out(const struct message_ring_t * ring, void * buf, uint32_t pos, uint32_t size)
+{
+	uint32_t ofs = pos & (ring->size - 1);
+	uint32_t n = ring->size - ofs;
+
+	if (n > size)
+		n = size;
+	memcpy(buf, data(ring) + ofs, n);
+	memcpy((uint8_t *)buf + n, data(ring), size - n);
+}
+
+/**
+ * Wakes up the consumer.
+ */
+static void wakeup(struct message_ring_t * ring)
+{
+	uint64_t value = 1;
+
+	if (write(ring->efd, &value, sizeof(value)) < 0)
+		syslog(LOG_ERR, "unable to wake up consumer: %s", strerror(errno));
+}
+
+/**
+ * Marks the consumer as idle, called by the consumer after the ring
+ * was found empty. If the producer has written a frame in the meantime
+ * without noticing the idle consumer, the consumer wakes up itself,
+ * this keeps the eventfd readable as long as frames are available.
+ */
+static void idle(struct message_ring_t * ring)
+{
+	struct ring_control_t * c = control(ring);
+	uint32_t tail = __atomic_load_n(&c->tail, __ATOMIC_RELAXED);
+	uint32_t expected = IDLE | tail;
+	uint64_t value;
+
+	/* consume the pending wakeup, the eventfd is non-blocking */
+	if (read(ring->efd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		syslog(LOG_ERR, "unable to read eventfd: %s", strerror(errno));
+
+	__atomic_store_n(&c->idle, expected, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&c->head, __ATOMIC_SEQ_CST) == tail)
+		return;
+	if (__atomic_compare_exchange_n(&c->idle, &expected, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		wakeup(ring);
+}
+
+/**
+ * Takes the next frame out of the ring.
+ *
+ * @retval  1 A message was read.
+ * @retval  0 The ring is empty.
+ * @retval -1 Invalid frame, all data within the ring is discarded.
+ */
+static int pop(struct message_ring_t * ring, struct message_t * msg)
+{
+	struct ring_control_t * c = control(ring);
+	struct message_header_t header;
+	uint8_t payload[sizeof(struct message_data_t)];
+	uint32_t tail = __atomic_load_n(&c->tail, __ATOMIC_RELAXED);
+	uint32_t head = __atomic_load_n(&c->head, __ATOMIC_ACQUIRE);
+	uint32_t avail = (head - tail) & INDEX_MASK;
+
+	if (avail == 0)
+		return 0;
+	if (avail >= sizeof(header))
+		copy_out(ring, &header, tail, sizeof(header));
+	if ((avail < sizeof(header)) || !message_header_valid(&header)
+		|| (avail < sizeof(header) + header.size)) {
+		syslog(LOG_ERR, "invalid frame in ring, %u bytes discarded", avail);
+		__atomic_store_n(&c->tail, head, __ATOMIC_RELEASE);
+		return -1;
+	}
+	copy_out(ring, payload, tail + sizeof(header), header.size);
+	__atomic_store_n(&c->tail, (tail + sizeof(header) + header.size) & INDEX_MASK, __ATOMIC_RELEASE);
+	message_decode(msg, &header, payload);
+	return 1;
+}
+
+/**
+ * Initializes the ring structure, without creating the ring.
+ *
+ * @param[out] ring The ring to initialize.
+ */
+void message_ring_init(struct message_ring_t * ring)
+{
+	ring->shm = NULL;
+	ring->size = 0;
+	ring->efd = -1;
+}
+
+/**
+ * Creates the shared memory and the eventfd of the ring. This has
+ * to be done before the producer or consumer process is forked.
+ *
+ * @param[out] ring The ring to create.
+ * @param[in] size Capacity in bytes, rounded up to the next power of two
+ *   and limited to MESSAGE_RING_SIZE_MIN and MESSAGE_RING_SIZE_MAX.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int message_ring_create(struct message_ring_t * ring, uint32_t size)
+{
+	struct ring_control_t * c;
+	uint32_t n = MESSAGE_RING_SIZE_MIN;
+
+	if (ring == NULL)
+		return EXIT_FAILURE;
+	message_ring_init(ring);
+	if (size > MESSAGE_RING_SIZE_MAX)
+		size = MESSAGE_RING_SIZE_MAX;
+	while (n < size)
+		n <<= 1;
+
+	ring->efd = eventfd(0, EFD_NONBLOCK);
+	if (ring->efd < 0) {
+		syslog(LOG_ERR, "unable to create eventfd: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	ring->shm = mmap(NULL, sizeof(struct ring_control_t) + n,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (ring->shm == MAP_FAILED) {
+		syslog(LOG_ERR, "unable to map shared memory: %s", strerror(errno));
+		ring->shm = NULL;
+		message_ring_destroy(ring);
+		return EXIT_FAILURE;
+	}
+	ring->size = n;
+
+	c = control(ring);
+	c->head = 0;
+	c->tail = 0;
+	c->idle = IDLE;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Releases all resources of the ring. Both processes have to do this.
+ *
+ * @param[inout] ring The ring to destroy.
+ */
+void message_ring_destroy(struct message_ring_t * ring)
+{
+	if (ring == NULL)
+		return;
+	if (ring->shm)
+		munmap(ring->shm, sizeof(struct ring_control_t) + ring->size);
+	if (ring->efd >= 0)
+		close(ring->efd);
+	message_ring_init(ring);
+}
+
+/**
+ * Returns whether or not the ring is empty.
+ *
+ * @param[in] ring The ring to check.
+ * @retval 1 The ring is empty, or does not exist.
+ * @retval 0 Frames are available.
+ */
+int message_ring_empty(const struct message_ring_t * ring)
+{
+	const struct ring_control_t * c;
+
+	if (ring == NULL || ring->shm == NULL)
+		return 1;
+	c = control(ring);
+	return __atomic_load_n(&c->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&c->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Writes the message as frame into the ring, to be called by the
+ * producer. The consumer is woken up only if it is idle. This function
+ * never blocks, if the ring has not enough free space the message
+ * is not written.
+ *
+ * @param[in] ring The ring to write to.
+ * @param[in] msg The message to write.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Parameter error or ring full (errno is EAGAIN).
+ */
+int message_ring_write(struct message_ring_t * ring, const struct message_t * msg)
+{
+	struct ring_control_t * c;
+	uint8_t frame[MESSAGE_FRAME_MAX];
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t state;
+
+	if (ring == NULL || ring->shm == NULL)
+		return EXIT_FAILURE;
+	if (msg == NULL)
+		return EXIT_FAILURE;
+
+	c = control(ring);
+	size = message_encode(frame, msg);
+	head = __atomic_load_n(&c->head, __ATOMIC_RELAXED);
+	tail = __atomic_load_n(&c->tail, __ATOMIC_ACQUIRE);
+	if (ring->size - ((head - tail) & INDEX_MASK) < size) {
+		errno = EAGAIN;
+		return EXIT_FAILURE;
+	}
+	copy_in(ring, head, frame, size);
+	head = (head + size) & INDEX_MASK;
+	__atomic_store_n(&c->head, head, __ATOMIC_SEQ_CST);
+
+	/* wake up the consumer only if it became idle before reading this frame */
+	state = __atomic_load_n(&c->idle, __ATOMIC_SEQ_CST);
+	if ((state & IDLE) && ((state & INDEX_MASK) != head)) {
+		if (__atomic_compare_exchange_n(&c->idle, &state, 0, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+			wakeup(ring);
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Reads the next message from the ring, to be called by the consumer.
+ * If no message is available, this function blocks until one arrives.
+ *
+ * @param[in] ring The ring to read from.
+ * @param[out] msg The message which is received.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int message_ring_read(struct message_ring_t * ring, struct message_t * msg)
+{
+	struct pollfd pfd;
+	int rc;
+
+	if (ring == NULL || ring->shm == NULL)
+		return EXIT_FAILURE;
+	if (msg == NULL)
+		return EXIT_FAILURE;
+
+	for (;;) {
+		rc = pop(ring, msg);
+		if (rc > 0) {
+			if (message_ring_empty(ring))
+				idle(ring);
+			return EXIT_SUCCESS;
+		}
+		if (rc < 0)
+			return EXIT_FAILURE;
+
+		idle(ring);
+		if (!message_ring_empty(ring))
+			continue;
+
+		pfd.fd = ring->efd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		rc = poll(&pfd, 1, -1);
+		if (rc < 0 && errno != EINTR) {
+			syslog(LOG_ERR, "unable to wait for messages: %s", strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+}
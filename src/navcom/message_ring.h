@@ -0,0 +1,37 @@
+#ifndef __MESSAGE_RING__H__
+#define __MESSAGE_RING__H__
+
+#include <navcom/message.h>
+
+/**
+ * Default, minimum and maximum capacity of a ring in bytes.
+ */
+#define MESSAGE_RING_SIZE_DEFAULT (64 * 1024)
+#define MESSAGE_RING_SIZE_MIN     4096
+#define MESSAGE_RING_SIZE_MAX     (16 * 1024 * 1024)
+
+/**
+ * Single producer, single consumer ring buffer of message frames in
+ * shared memory. It is created before forking, the producer and the
+ * consumer live in different processes afterwards.
+ *
+ * The consumer is woken up through the eventfd only if it is idle,
+ * as long as it is busy no system calls are necessary at all. The
+ * eventfd is readable while messages are available for the consumer,
+ * it may be used with select/poll like a pipe.
+ */
+struct message_ring_t
+{
+	void * shm; /* shared memory, control block followed by the data */
+	uint32_t size; /* capacity of the data in bytes, power of two */
+	int efd; /* eventfd to wake up the consumer */
+};
+
+void message_ring_init(struct message_ring_t *);
+int message_ring_create(struct message_ring_t *, uint32_t);
+void message_ring_destroy(struct message_ring_t *);
+int message_ring_empty(const struct message_ring_t *);
+int message_ring_write(struct message_ring_t *, const struct message_t *);
+int message_ring_read(struct message_ring_t *, struct message_t *);
+
+#endif
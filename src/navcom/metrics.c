@@ -0,0 +1,153 @@
+#include <navcom/metrics.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+/**
+ * Returns the index of the bucket for the specified value, which
+ * is the number of significant bits, limited to the last bucket.
+ */
+static unsigned int bucket(uint64_t value)
+{
+	unsigned int i = 0;
+
+	while (value && (i < HISTOGRAM_BUCKETS - 1)) {
+		value >>= 1;
+		++i;
+	}
+	return i;
+}
+
+/**
+ * Returns the largest value the bucket is able to hold, the last
+ * bucket is unlimited.
+ */
+static uint64_t bucket_limit(unsigned int i)
+{
+	if (i >= HISTOGRAM_BUCKETS - 1)
+		return UINT64_MAX;
+	return ((uint64_t)1 << i) - 1;
+}
+
+/**
+ * Returns the current time of the monotonic clock in nsec, to
+ * measure durations.
+ */
+uint64_t metrics_now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000 + (uint64_t)t.tv_nsec;
+}
+
+/**
+ * Initializes the histogram, all buckets are empty.
+ */
+void histogram_init(struct histogram_t * histogram)
+{
+	if (histogram == NULL)
+		return;
+	memset(histogram, 0, sizeof(struct histogram_t));
+}
+
+/**
+ * Adds a value to the histogram.
+ *
+ * @param[inout] histogram The histogram to add the value to.
+ * @param[in] value The value, usually a duration in nsec.
+ */
+void histogram_add(struct histogram_t * histogram, uint64_t value)
+{
+	if (histogram == NULL)
+		return;
+	++histogram->count;
+	histogram->sum += value;
+	if (value > histogram->max)
+		histogram->max = value;
+	++histogram->buckets[bucket(value)];
+}
+
+/**
+ * Returns an estimation of the percentile, which is the upper limit
+ * of the bucket containing the percentile, but not more than the
+ * largest value seen.
+ *
+ * @param[in] histogram The histogram.
+ * @param[in] percent The percentile, 0..100.
+ * @return The estimated percentile, 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(const struct histogram_t * histogram, unsigned int percent)
+{
+	unsigned int i;
+	uint64_t rank;
+	uint64_t n = 0;
+
+	if (histogram == NULL || histogram->count == 0)
+		return 0;
+	if (percent > 100)
+		percent = 100;
+
+	/* number of values up to and including the percentile, at least one */
+	rank = (histogram->count * percent + 99) / 100;
+	if (rank == 0)
+		rank = 1;
+
+	for (i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		n += histogram->buckets[i];
+		if (n >= rank)
+			break;
+	}
+	if (bucket_limit(i) < histogram->max)
+		return bucket_limit(i);
+	return histogram->max;
+}
+
+/**
+ * Writes the histogram as one line of text: summary values, some
+ * percentiles and the buckets up to the last used one.
+ *
+ * Example:
+ * @code
+ * histogram dispatch count=3 sum=1400 avg=466 max=800 p50=511 p90=800 p99=800 buckets=0,0,0,0,0,0,0,0,0,2,1
+ * @endcode
+ *
+ * @param[in] file The file to write to.
+ * @param[in] name Name of the histogram.
+ * @param[in] histogram The histogram to write.
+ */
+void histogram_write(FILE * file, const char * name, const struct histogram_t * histogram)
+{
+	unsigned int i;
+	unsigned int last = 0;
+
+	if (file == NULL || name == NULL || histogram == NULL)
+		return;
+
+	for (i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		if (histogram->buckets[i])
+			last = i;
+	}
+
+	fprintf(file, "histogram %s count=%" PRIu64 " sum=%" PRIu64 " avg=%" PRIu64 " max=%" PRIu64
+		" p50=%" PRIu64 " p90=%" PRIu64 " p99=%" PRIu64 " buckets=",
+		name, histogram->count, histogram->sum,
+		histogram->count ? histogram->sum / histogram->count : 0,
+		histogram->max,
+		histogram_percentile(histogram, 50),
+		histogram_percentile(histogram, 90),
+		histogram_percentile(histogram, 99));
+	for (i = 0; i <= last; ++i)
+		fprintf(file, "%s%" PRIu64, i ? "," : "", histogram->buckets[i]);
+	fprintf(file, "\n");
+}
+
+/**
+ * Initializes the counters of a proc.
+ */
+void proc_metrics_init(struct proc_metrics_t * metrics)
+{
+	if (metrics == NULL)
+		return;
+	memset(metrics, 0, sizeof(struct proc_metrics_t));
+}
@@ -0,0 +1,50 @@
+#ifndef __NAVCOM__METRICS__H__
+#define __NAVCOM__METRICS__H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Number of buckets of a histogram.
+ */
+#define HISTOGRAM_BUCKETS 32
+
+/**
+ * Histogram of durations in nsec with logarithmic buckets. Bucket 0
+ * holds the value 0, bucket i holds values from 2^(i-1) up to 2^i - 1.
+ * The last bucket holds all values from 2^(HISTOGRAM_BUCKETS-2) on
+ * (about one second).
+ */
+struct histogram_t
+{
+	uint64_t count; /* number of values */
+	uint64_t sum; /* sum of all values */
+	uint64_t max; /* largest value */
+	uint64_t buckets[HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Counters of the hub about a proc. Messages received from the proc
+ * count as 'in', messages written to the transport of the proc count
+ * as 'out', messages still queued or lost in the queue do not.
+ * Bytes are counted as on the wire, including the frame headers.
+ */
+struct proc_metrics_t
+{
+	uint64_t msgs_in;
+	uint64_t bytes_in;
+	uint64_t msgs_out;
+	uint64_t bytes_out;
+	uint64_t write_failures;
+};
+
+uint64_t metrics_now(void);
+
+void histogram_init(struct histogram_t *);
+void histogram_add(struct histogram_t *, uint64_t);
+uint64_t histogram_percentile(const struct histogram_t *, unsigned int);
+void histogram_write(FILE *, const char *, const struct histogram_t *);
+
+void proc_metrics_init(struct proc_metrics_t *);
+
+#endif
@@ -1,12 +1,267 @@
 #include <navcom/proc.h>
+#include <navcom/message_comm.h>
+#include <navcom/message_ring.h>
+#include <navcom/message_queue.h>
+#include <navcom/metrics.h>
 #include <common/macros.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
 
 void proc_config_init(struct proc_config_t * ptr)
 {
 	ptr->pid = -1;
 	ptr->rfd = -1;
 	ptr->wfd = -1;
+	ptr->ring = NULL;
+	ptr->queue = NULL;
+	ptr->metrics = NULL;
 	ptr->cfg = NULL;
 	ptr->data = NULL;
 }
 
+/**
+ * Reads a message sent by the hub, to be used by the proc. The
+ * message is read from the transport the proc is configured with,
+ * in both cases 'rfd' may be used to wait for messages.
+ *
+ * @param[in] config The configuration of the proc.
+ * @param[out] msg The message which is received.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int proc_read(const struct proc_config_t * config, struct message_t * msg)
+{
+	if (config == NULL)
+		return EXIT_FAILURE;
+	if (config->ring)
+		return message_ring_read(config->ring, msg);
+	return message_read(config->rfd, msg);
+}
+
+/**
+ * Checks without waiting whether there is something to read for the
+ * proc, a message sent by the hub or a signal. Procs use this to do
+ * work of low priority as long as they are otherwise idle.
+ *
+ * @param[in] config The configuration of the proc.
+ * @retval 1 Message or signal pending (or error).
+ * @retval 0 Nothing to read.
+ */
+int proc_input_pending(const struct proc_config_t * config)
+{
+	struct pollfd pfd[2];
+
+	if (config == NULL)
+		return 1;
+
+	pfd[0].fd = config->rfd;
+	pfd[0].events = POLLIN;
+	pfd[0].revents = 0;
+	pfd[1].fd = config->signal_fd;
+	pfd[1].events = POLLIN;
+	pfd[1].revents = 0;
+	return poll(pfd, 2, 0) != 0;
+}
+
+/**
+ * Writes the message to the transport of the proc. Only messages
+ * written to the transport are counted as sent, messages lost in the
+ * queue are counted by the queue.
+ */
+static int transport_write(const struct proc_config_t * config, const struct message_t * msg)
+{
+	int rc;
+
+	if (config->ring)
+		rc = message_ring_write(config->ring, msg);
+	else
+		rc = message_write(config->wfd, msg);
+	if ((rc == EXIT_SUCCESS) && config->metrics) {
+		++config->metrics->msgs_out;
+		config->metrics->bytes_out += message_frame_size(msg);
+	}
+	return rc;
+}
+
+/**
+ * Waits until the transport of the proc is able to take more data.
+ * The ring does not notify the producer, it is polled.
+ */
+static void transport_wait(const struct proc_config_t * config)
+{
+	struct pollfd pfd;
+
+	if (config->ring) {
+		usleep(1000);
+		return;
+	}
+	pfd.fd = config->wfd;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	poll(&pfd, 1, -1);
+}
+
+/**
+ * Writes queued messages to the proc, as many as the transport
+ * is able to take without blocking, to be used by the hub.
+ *
+ * @param[in] config The configuration of the proc.
+ * @param[in] wait If not zero, this function waits until all
+ *   queued messages are written.
+ * @retval  0 All queued messages were written, or there is no queue.
+ * @retval  1 There are still messages queued.
+ * @retval -1 Failure, the transport is not able to take messages anymore.
+ */
+int proc_flush(const struct proc_config_t * config, int wait)
+{
+	const struct message_t * msg;
+
+	if (config == NULL)
+		return -1;
+	while ((msg = message_queue_front(config->queue)) != NULL) {
+		if (transport_write(config, msg) == EXIT_SUCCESS) {
+			message_queue_pop(config->queue);
+			continue;
+		}
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			return -1;
+		if (!wait)
+			return 1;
+		transport_wait(config);
+	}
+	return 0;
+}
+
+/**
+ * Writes the message to the transport, or queues it if the transport
+ * is not able to take it.
+ */
+static int send_or_queue(const struct proc_config_t * config, const struct message_t * msg)
+{
+	if (config->queue == NULL)
+		return transport_write(config, msg);
+
+	if (proc_flush(config, 0) < 0)
+		return EXIT_FAILURE;
+	if (message_queue_empty(config->queue)) {
+		if (transport_write(config, msg) == EXIT_SUCCESS)
+			return EXIT_SUCCESS;
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			return EXIT_FAILURE;
+	}
+	while (message_queue_push(config->queue, msg) != EXIT_SUCCESS) {
+		if (errno != EAGAIN)
+			return EXIT_FAILURE;
+		if (proc_flush(config, 1) < 0)
+			return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Sends a message to the proc, to be used by the hub.
+ *
+ * If the proc has a queue, the transport is expected to be non-blocking.
+ * Messages the transport is not able to take are queued according to
+ * the policy of the queue, only with MESSAGE_QUEUE_BLOCK this function
+ * waits for the proc if the queue is full. The queue must be flushed
+ * regularly, see proc_flush.
+ *
+ * If the proc has metrics, the message is counted as soon as it is
+ * written to the transport, see transport_write.
+ *
+ * @param[in] config The configuration of the proc.
+ * @param[in] msg The message to send.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int proc_send(const struct proc_config_t * config, const struct message_t * msg)
+{
+	int rc;
+
+	if (config == NULL)
+		return EXIT_FAILURE;
+	rc = send_or_queue(config, msg);
+	if ((rc != EXIT_SUCCESS) && config->metrics)
+		++config->metrics->write_failures;
+	return rc;
+}
+
+/**
+ * Executes the proc: initialization, the actual procedure and clean up.
+ * This is the same for child processes and threads.
+ *
+ * Threads do not handle signals, this is done by the hub. Their signal
+ * file descriptor is valid but never becomes readable, they terminate
+ * upon the termination message.
+ *
+ * @param[inout] proc The proc to execute.
+ * @param[in] desc The descriptor of the proc.
+ * @param[in] threaded Non-zero if the proc is executed as thread.
+ * @return The exit code of the proc.
+ */
+int proc_run(
+		struct proc_config_t * proc,
+		const struct proc_desc_t * desc,
+		int threaded)
+{
+	int rc_func;
+	int rc;
+
+	syslog(LOG_INFO, "start proc '%s' (type: '%s'%s)", proc->cfg->name, proc->cfg->type,
+		threaded ? ", thread" : "");
+
+	/* setup signal handling */
+	sigemptyset(&proc->signal_mask);
+	if (!threaded) {
+		sigaddset(&proc->signal_mask, SIGINT);
+		sigaddset(&proc->signal_mask, SIGTERM);
+		if (sigprocmask(SIG_BLOCK, &proc->signal_mask, NULL) < 0) {
+			syslog(LOG_ERR, "unable to initialize signal handling");
+			return EXIT_FAILURE;
+		}
+
+		/* handled by the hub, see send_reopen */
+		signal(SIGHUP, SIG_IGN);
+	}
+	proc->signal_fd = signalfd(-1, &proc->signal_mask, 0);
+	if (proc->signal_fd < 0) {
+		syslog(LOG_ERR, "unable to obtain file descriptor for signal handling");
+		return EXIT_FAILURE;
+	}
+
+	/* initialize procedure */
+	if (desc->init) {
+		rc = desc->init(proc, &proc->cfg->properties);
+		if (rc != EXIT_SUCCESS) {
+			syslog(LOG_ERR, "initialization failure for proc type: '%s', stop proc '%s', rc=%d",
+				proc->cfg->type, proc->cfg->name, rc);
+
+			/* try to clean up if init was not completely successful */
+			if (desc->exit)
+				if (desc->exit(proc) != EXIT_SUCCESS)
+					syslog(LOG_ERR, "proc short exit '%s'", proc->cfg->name);
+
+			close(proc->signal_fd);
+			return rc;
+		}
+	}
+
+	/* execute actual procedure */
+	rc_func = desc->func(proc);
+	syslog(LOG_INFO, "stop proc '%s', rc=%d", proc->cfg->name, rc_func);
+
+	/* clean up */
+	if (desc->exit) {
+		if (desc->exit(proc) != EXIT_SUCCESS)
+			syslog(LOG_ERR, "proc exit '%s', rc=%d", proc->cfg->name, rc_func);
+	}
+	close(proc->signal_fd);
+	return rc_func;
+}
+
@@ -3,13 +3,27 @@
 
 #include <config/config.h>
 #include <common/property.h>
+#include <navcom/message.h>
 #include <signal.h>
 
+struct message_ring_t;
+struct message_queue_t;
+struct proc_metrics_t;
+
 struct proc_config_t {
 	int pid; /* process id */
 	int rfd; /* pipe file descriptor to read */
 	int wfd; /* pipe file descriptor to write */
 
+	/* shared memory transport from the hub to the proc, NULL if the pipe is used */
+	struct message_ring_t * ring;
+
+	/* messages the proc was not able to receive yet, used by the hub only, may be NULL */
+	struct message_queue_t * queue;
+
+	/* counters about the proc, used by the hub only, may be NULL */
+	struct proc_metrics_t * metrics;
+
 	/* signal handling using file descriptors (see signalfd) */
 	int signal_fd;
 	sigset_t signal_mask;
@@ -19,6 +33,10 @@ struct proc_config_t {
 };
 
 void proc_config_init(struct proc_config_t *);
+int proc_read(const struct proc_config_t *, struct message_t *);
+int proc_input_pending(const struct proc_config_t *);
+int proc_send(const struct proc_config_t *, const struct message_t *);
+int proc_flush(const struct proc_config_t *, int);
 
 typedef int (*prop_function)(struct proc_config_t *, const struct property_list_t *);
 typedef int (*proc_function)(struct proc_config_t *);
@@ -32,4 +50,6 @@ struct proc_desc_t {
 	help_function help;
 };
 
+int proc_run(struct proc_config_t *, const struct proc_desc_t *, int);
+
 #endif
@@ -0,0 +1,94 @@
+#include <navcom/proc_thread.h>
+#include <navcom/message_ring.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+void proc_thread_init(struct proc_thread_t * thread)
+{
+	proc_config_init(&thread->cfg);
+	thread->desc = NULL;
+	thread->running = 0;
+}
+
+/**
+ * Thread function of procs executed as threads.
+ */
+static void * run(void * arg)
+{
+	struct proc_thread_t * thread = arg;
+
+	proc_run(&thread->cfg, thread->desc, 1);
+
+	/* end of file for the hub, like a terminated process */
+	close(thread->cfg.wfd);
+	thread->cfg.wfd = -1;
+	return NULL;
+}
+
+/**
+ * Starts the thread to execute the proc. The thread gets its own
+ * configuration, holding the other ends of the transport. The thread
+ * is started with all signals blocked, they are handled by the hub.
+ *
+ * On success, the configuration of the proc holds the ends of the
+ * transport to be used by the hub, like for a forked process.
+ *
+ * @param[out] thread The thread to start.
+ * @param[inout] proc The proc to execute, its transport to the proc
+ *   (ring or pipe) must be set up.
+ * @param[in] desc The descriptor of the proc.
+ * @param[in] rfd Pipe from the hub to the proc, both -1 if the ring is used.
+ * @param[in] wfd Pipe from the proc to the hub.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Unable to start the thread, the pipes are
+ *   left untouched.
+ */
+int proc_thread_start(
+		struct proc_thread_t * thread,
+		struct proc_config_t * proc,
+		const struct proc_desc_t * desc,
+		int rfd[2],
+		int wfd[2])
+{
+	sigset_t mask;
+	sigset_t old_mask;
+	int rc;
+
+	thread->cfg = *proc;
+	thread->cfg.pid = getpid();
+	thread->cfg.rfd = proc->ring ? proc->ring->efd : rfd[0];
+	thread->cfg.wfd = wfd[1];
+	thread->desc = desc;
+
+	/* the thread inherits the signal mask */
+	sigfillset(&mask);
+	pthread_sigmask(SIG_SETMASK, &mask, &old_mask);
+	rc = pthread_create(&thread->thread, NULL, run, thread);
+	pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+	if (rc != 0) {
+		proc_thread_init(thread);
+		return EXIT_FAILURE;
+	}
+	thread->running = 1;
+
+	proc->pid = getpid();
+	proc->rfd = wfd[0];
+	proc->wfd = rfd[1];
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Waits for the termination of the thread and closes the ends of the
+ * transport held by the thread. The thread uses the transport until
+ * it terminates, the hub must not close its own ends before.
+ */
+void proc_thread_join(struct proc_thread_t * thread)
+{
+	if (!thread->running)
+		return;
+	pthread_join(thread->thread, NULL);
+	if (thread->cfg.rfd >= 0 && thread->cfg.ring == NULL)
+		close(thread->cfg.rfd);
+	proc_thread_init(thread);
+}
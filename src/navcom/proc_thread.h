@@ -0,0 +1,23 @@
+#ifndef __NAVCOM__PROC_THREAD__H__
+#define __NAVCOM__PROC_THREAD__H__
+
+#include <pthread.h>
+#include <navcom/proc.h>
+
+/**
+ * Thread executing a proc within the hub process, instead of its
+ * own process. See proc_thread_start.
+ */
+struct proc_thread_t
+{
+	struct proc_config_t cfg; /* configuration as seen by the thread, holding the other ends of the transport */
+	const struct proc_desc_t * desc; /* descriptor of the executed proc */
+	pthread_t thread;
+	int running; /* non-zero if the thread was started and is not joined yet */
+};
+
+void proc_thread_init(struct proc_thread_t *);
+int proc_thread_start(struct proc_thread_t *, struct proc_config_t *, const struct proc_desc_t *, int [2], int [2]);
+void proc_thread_join(struct proc_thread_t *);
+
+#endif
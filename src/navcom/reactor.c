@@ -0,0 +1,152 @@
+#include <navcom/reactor.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+/**
+ * Initializes the reactor.
+ *
+ * @param[out] reactor The reactor to initialize.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int reactor_init(struct reactor_t * reactor)
+{
+	if (reactor == NULL)
+		return EXIT_FAILURE;
+
+	reactor->fd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor->fd < 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Frees all resources held by the reactor. The monitored file
+ * descriptors are not being closed.
+ *
+ * @param[out] reactor The reactor to free.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int reactor_exit(struct reactor_t * reactor)
+{
+	if (reactor == NULL)
+		return EXIT_FAILURE;
+
+	if (reactor->fd >= 0) {
+		close(reactor->fd);
+		reactor->fd = -1;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Adds a file descriptor to be monitored for reading.
+ *
+ * @param[out] reactor The reactor.
+ * @param[in] fd The file descriptor to monitor.
+ * @param[in] flags Flags, see REACTOR_EDGE.
+ * @param[in] data User data which is delivered by reactor_wait, if
+ *   the file descriptor becomes readable.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int reactor_add(struct reactor_t * reactor, int fd, int flags, void * data)
+{
+	struct epoll_event event;
+
+	if (reactor == NULL)
+		return EXIT_FAILURE;
+	if (fd < 0)
+		return EXIT_FAILURE;
+
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	if (flags & REACTOR_EDGE)
+		event.events |= EPOLLET;
+	event.data.ptr = data;
+
+	if (epoll_ctl(reactor->fd, EPOLL_CTL_ADD, fd, &event) < 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Removes the file descriptor from the reactor. This must be done
+ * before the file descriptor is being closed.
+ *
+ * @param[out] reactor The reactor.
+ * @param[in] fd The file descriptor to remove.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int reactor_remove(struct reactor_t * reactor, int fd)
+{
+	struct epoll_event event;
+
+	if (reactor == NULL)
+		return EXIT_FAILURE;
+	if (fd < 0)
+		return EXIT_FAILURE;
+
+	memset(&event, 0, sizeof(event));
+	if (epoll_ctl(reactor->fd, EPOLL_CTL_DEL, fd, &event) < 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Waits for file descriptors to become readable.
+ *
+ * @param[in] reactor The reactor.
+ * @param[out] data Array to hold the user data of all readable
+ *   file descriptors.
+ * @param[in] max Size of the data array. At most REACTOR_MAX_EVENTS
+ *   are delivered at once.
+ * @param[in] timeout Timeout in milliseconds, -1 to wait infinitely.
+ * @retval >0 Number of readable file descriptors.
+ * @retval  0 Timeout
+ * @retval -1 Failure, see errno. EINTR is a possible error.
+ */
+int reactor_wait(struct reactor_t * reactor, void ** data, int max, int timeout)
+{
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	int rc;
+	int i;
+
+	if (reactor == NULL || data == NULL || max <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (max > REACTOR_MAX_EVENTS)
+		max = REACTOR_MAX_EVENTS;
+
+	rc = epoll_wait(reactor->fd, events, max, timeout);
+	for (i = 0; i < rc; ++i)
+		data[i] = events[i].data.ptr;
+	return rc;
+}
+
+/**
+ * Sets the specified file descriptor to non-blocking mode.
+ *
+ * @param[in] fd The file descriptor.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int fd_set_nonblocking(int fd)
+{
+	int flags;
+
+	flags = fcntl(fd, F_GETFL);
+	if (flags < 0)
+		return EXIT_FAILURE;
+	if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
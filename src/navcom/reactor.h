@@ -0,0 +1,32 @@
+#ifndef __NAVCOM__REACTOR__H__
+#define __NAVCOM__REACTOR__H__
+
+/**
+ * Maximum number of events delivered by one call of reactor_wait.
+ */
+#define REACTOR_MAX_EVENTS 64
+
+/**
+ * File descriptor is being monitored edge triggered. The owner
+ * must consume all data (until EAGAIN) after each notification.
+ * Without this flag, the file descriptor is level triggered.
+ */
+#define REACTOR_EDGE 0x01
+
+/**
+ * Event reactor, waits for readable file descriptors.
+ */
+struct reactor_t
+{
+	int fd; /* epoll file descriptor */
+};
+
+int reactor_init(struct reactor_t *);
+int reactor_exit(struct reactor_t *);
+int reactor_add(struct reactor_t *, int, int, void *);
+int reactor_remove(struct reactor_t *, int);
+int reactor_wait(struct reactor_t *, void **, int, int);
+
+int fd_set_nonblocking(int);
+
+#endif
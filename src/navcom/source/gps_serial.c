@@ -5,6 +5,7 @@
 #include <navcom/message.h>
 #include <navcom/message_comm.h>
 #include <device/simulator_serial_gps.h>
+#include <nmea/nmea_stream.h>
 #include <common/macros.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -16,9 +17,9 @@
 
 struct read_buffer_t
 {
-	int index;
-	char raw;
-	char data[NMEA_MAX_SENTENCE + 1];
+	uint32_t size;
+	char raw[NMEA_STREAM_CHUNK];
+	struct nmea_stream_t stream;
 	struct message_t msg;
 };
 
@@ -100,7 +101,8 @@ static int exit_proc(struct proc_config_t * config)
 }
 
 /**
- * Processes NMEA data read from the device.
+ * Processes NMEA data read from the device. All complete sentences
+ * contained in the data are sent.
  *
  * @param[in] config Process configuration
  * @param[out] buf Working context.
@@ -112,43 +114,42 @@ static int process_nmea(
 		struct read_buffer_t * buf)
 {
 	int rc;
+	const char * p = buf->raw;
+	uint32_t size = buf->size;
 
-	nmea_init(&buf->msg.data.attr.nmea);
-	switch (buf->raw) {
-		case '\r':
-			break;
-		case '\n':
-			rc = nmea_read(&buf->msg.data.attr.nmea, buf->data);
-			if (rc == 0) {
-				rc = message_write(config->wfd, &buf->msg);
-				if (rc != EXIT_SUCCESS)
-					syslog(LOG_ERR, "unable to write NMEA data: %s", strerror(errno));
-			} else if (rc == 1) {
-				syslog(LOG_ERR, "unknown sentence: '%s'", buf->data);
-			} else if (rc == -2) {
-				syslog(LOG_ERR, "checksum error: '%s'", buf->data);
-			} else {
-				syslog(LOG_ERR, "parameter error");
-				return EXIT_FAILURE;
-			}
-			buf->index = 0;
-			buf->data[buf->index] = 0;
-			break;
-		default:
-			if (buf->index < NMEA_MAX_SENTENCE) {
-				buf->data[buf->index++] = buf->raw;
-			} else {
-				syslog(LOG_ERR, "sentence too long, discarding");
-				buf->index = 0;
-			}
-			buf->data[buf->index] = 0;
+	while (size > 0) {
+		rc = nmea_stream_next(&buf->stream, &p, &size);
+		if (rc == 0) {
 			break;
+		} else if (rc == -2) {
+			syslog(LOG_ERR, "sentence too long, discarding");
+			continue;
+		} else if (rc < 0) {
+			syslog(LOG_ERR, "parameter error");
+			return EXIT_FAILURE;
+		}
+
+		nmea_init(&buf->msg.data.attr.nmea);
+		rc = nmea_read(&buf->msg.data.attr.nmea, buf->stream.data);
+		if (rc == 0) {
+			rc = message_write(config->wfd, &buf->msg);
+			if (rc != EXIT_SUCCESS)
+				syslog(LOG_ERR, "unable to write NMEA data: %s", strerror(errno));
+		} else if (rc == 1) {
+			syslog(LOG_ERR, "unknown sentence: '%s'", buf->stream.data);
+		} else if (rc == -2) {
+			syslog(LOG_ERR, "checksum error: '%s'", buf->stream.data);
+		} else {
+			syslog(LOG_ERR, "parameter error");
+			return EXIT_FAILURE;
+		}
 	}
 	return EXIT_SUCCESS;
 }
 
 /**
- * Reads data from the device.
+ * Reads data from the device, as much as available up to the
+ * size of the buffer.
  *
  * @param[in] ops Device operations
  * @param[in] device Device to operate on
@@ -163,15 +164,17 @@ static int read_data(
 {
 	int rc;
 
-	rc = ops->read(device, &buf->raw, sizeof(buf->raw));
+	buf->size = 0;
+	rc = ops->read(device, buf->raw, sizeof(buf->raw));
 	if (rc < 0) {
 		syslog(LOG_ERR, "unable to read from device: %s", strerror(errno));
 		return EXIT_FAILURE;
 	}
-	if (rc != sizeof(buf->raw)) {
-		syslog(LOG_ERR, "invalid size read from device: %s", strerror(errno));
+	if (rc == 0) {
+		syslog(LOG_ERR, "no data read from device");
 		return EXIT_FAILURE;
 	}
+	buf->size = (uint32_t)rc;
 
 	return EXIT_SUCCESS;
 }
@@ -236,6 +239,7 @@ static int proc(struct proc_config_t * config)
 	}
 
 	memset(&readbuf, 0, sizeof(readbuf));
+	nmea_stream_init(&readbuf.stream);
 	readbuf.msg.type = MSG_NMEA;
 
 	device_init(&device);
@@ -288,7 +292,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
@@ -324,7 +328,7 @@ static void help(void)
 	printf("  device : the device to read data from\n");
 	printf("  baud   : baud rate to operate on, valid values:\n");
 	printf("           300, 600, 1200, 2400, 4800, 9600, 19200\n");
-	printf("           34800, 57600, 115200, 230400\n");
+	printf("           38400, 57600, 115200, 230400\n");
 	printf("  parity : parity check to use, valid values:\n");
 	printf("           none, even, odd, mark\n");
 	printf("  data   : number of data bits, valid values:\n");
@@ -202,7 +202,7 @@ static int proc(struct proc_config_t * config)
 		FD_ZERO(&rfds);
 		FD_SET(config->rfd, &rfds);
 		if (config->rfd > fd_max)
-			fd_max = -1;
+			fd_max = config->rfd;
 		FD_SET(config->signal_fd, &rfds);
 		if (config->signal_fd > fd_max)
 			fd_max = config->signal_fd;
@@ -210,7 +210,7 @@ static int proc(struct proc_config_t * config)
 		tm.tv_sec = data->period;
 		tm.tv_usec = 0;
 
-		rc = select(fd_max, &rfds, NULL, NULL, &tm);
+		rc = select(fd_max + 1, &rfds, NULL, NULL, &tm);
 		if (rc < 0 && errno != EINTR) {
 			syslog(LOG_ERR, "error in 'select': %s", strerror(errno));
 			return EXIT_FAILURE;
@@ -234,7 +234,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
@@ -4,6 +4,7 @@
 #include <navcom/property_read.h>
 #include <navcom/message.h>
 #include <navcom/message_comm.h>
+#include <navcom/trace.h>
 #include <device/simulator_serial_seatalk.h>
 #include <common/macros.h>
 #include <errno.h>
@@ -29,7 +30,7 @@ struct seatalk_context_t
 	struct message_t msg;
 };
 
-const char * state_name(int state) /* TODO: used temporarily*/
+static const char * state_name(int state)
 {
 	switch (state) {
 		case STATE_READ:   return "READ";
@@ -40,15 +41,15 @@ const char * state_name(int state) /* TODO: used temporarily*/
 	return "<unknown>";
 }
 
-static void dump( /* TODO: used temporarily*/
+static void dump(
 		struct seatalk_context_t * ctx,
 		uint8_t c,
 		const char * type)
 {
-	printf("%-6s : %-4s : %3u : 0x%02x\n", state_name(ctx->state), type, ctx->remaining, c);
+	TRACE(TRACE_DEVICE, "%-6s : %-4s : %3u : 0x%02x", state_name(ctx->state), type, ctx->remaining, c);
 }
 
-static void dump_sentence(struct seatalk_context_t * ctx) /* TODO: used temporarily*/
+static void dump_sentence(struct seatalk_context_t * ctx)
 {
 	const char * title;
 
@@ -66,7 +67,7 @@ static void dump_sentence(struct seatalk_context_t * ctx) /* TODO: used temporar
 		default:   title = "unknown"; break;
 	}
 
-	printf("========================== sentence: %s\n", title);
+	TRACE(TRACE_SOURCE, "sentence: %s", title);
 }
 
 static void seatalk_context_init(struct seatalk_context_t * ctx)
@@ -444,7 +445,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
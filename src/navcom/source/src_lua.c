@@ -1,6 +1,9 @@
 #include <navcom/source/src_lua.h>
 #include <navcom/source/src_lua_private.h>
 #include <navcom/lua_helper.h>
+#include <navcom/lua_cache.h>
+#include <navcom/lua_alloc.h>
+#include <navcom/lua_gc.h>
 #include <navcom/lua_syslog.h>
 #include <navcom/lua_debug.h>
 #include <navcom/lua_message.h>
@@ -79,8 +82,10 @@ static int handle_script(const struct proc_config_t * config)
 
 	if (setjmp(data->env) == 0) {
 		lua_getglobal(data->lua, "handle");
-		lua_pushlightuserdata(data->lua, (void*)&msg);
+		luaH_pushmsg(data->lua, data->msg, &msg);
 		rc = luaH_check_error(data->lua, lua_pcall(data->lua, 1, 1, 0));
+		luaH_clearmsg(data->lua, data->msg);
+		luaH_gc_called(&data->gc);
 		if (rc == EXIT_SUCCESS) {
 			rc = luaL_checkinteger(data->lua, -1);
 			lua_pop(data->lua, 1);
@@ -128,6 +133,7 @@ static int init_proc(
 		const struct property_list_t * properties)
 {
 	lua_State * lua = NULL;
+	size_t limit = 0;
 	const struct property_t * prop_script = NULL;
 	const struct property_t * prop_period = NULL;
 	const struct property_t * prop_debug = NULL;
@@ -155,7 +161,10 @@ static int init_proc(
 		return EXIT_FAILURE;
 
 	/* setup lua state */
-	lua = luaL_newstate();
+	if (luaH_alloc_limit_from_prop(properties, &limit) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	luaH_alloc_init(&data->alloc, limit);
+	lua = luaH_newstate(&data->alloc);
 	if (!lua) {
 		syslog(LOG_ERR, "unable to create lua state");
 		return EXIT_FAILURE;
@@ -171,13 +180,18 @@ static int init_proc(
 			syslog(LOG_ERR, "unable to setup lua state");
 			return EXIT_FAILURE;
 		}
+		data->msg = luaH_newmsg(lua, 0);
 
 		/* load/execute script */
-		if (luaL_dofile(lua, prop_script->value) != LUA_OK) {
+		if (luaH_dofile(lua, prop_script->value) != LUA_OK) {
 			syslog(LOG_ERR, "unable to load and execute script: '%s'", prop_script->value);
 			lua_close(lua);
 			return EXIT_FAILURE;
 		}
+		if (luaH_gc_setup(&data->gc, lua, properties) != EXIT_SUCCESS) {
+			lua_close(lua);
+			return EXIT_FAILURE;
+		}
 
 		data->lua = lua;
 		return EXIT_SUCCESS;
@@ -207,9 +221,12 @@ static int exit_proc(struct proc_config_t * config)
 
 	data = (struct src_lua_data_t *)config->data;
 	if (data->lua) {
+		luaH_alloc_log_stats(&data->alloc, config->cfg ? config->cfg->name : "src_lua");
+		luaH_gc_log_stats(&data->gc, config->cfg ? config->cfg->name : "src_lua");
 		lua_close(data->lua);
 		data->lua = NULL;
 	}
+	luaH_alloc_destroy(&data->alloc);
 
 	free(config->data);
 	config->data = NULL;
@@ -258,6 +275,10 @@ static int proc(struct proc_config_t * config)
 		if (rc == 0) { /* timerout */
 			if (handle_script(config) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
+
+			/* collect garbage while idle */
+			while (!proc_input_pending(config) && luaH_gc_idle(&data->gc, data->lua))
+				;
 			continue;
 		}
 
@@ -273,7 +294,7 @@ static int proc(struct proc_config_t * config)
 		}
 
 		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
+			if (proc_read(config, &msg) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 			switch (msg.type) {
 				case MSG_SYSTEM:
@@ -304,6 +325,12 @@ static void help(void)
 	printf("  script : filename of the Lua script to execute.\n");
 	printf("  period : time period in msec in which the scripts 'handle' function\n");
 	printf("           will be executed.\n");
+	printf("  memory_limit : [optional] maximum memory of the Lua state in KiB, default: unlimited\n");
+	printf("  gc : [optional] 'auto' or 'idle', default: 'auto'. With 'idle' the garbage is\n");
+	printf("       collected in small steps between periods instead of during script calls.\n");
+	printf("  gc_pause : [optional] pause of the garbage collector in percent, default: 400 with 'idle'\n");
+	printf("  gc_stepmul : [optional] step multiplier of the garbage collector in percent\n");
+	printf("  gc_step : [optional] work per idle step of the garbage collector in KiB, default: 4\n");
 	printf("  DEBUG  : [optional] a combination of 'c', 'r' and 'l' for debugging purposes.\n");
 	printf("           c : call, traces function calls\n");
 	printf("           r : return, traces function returns\n");
@@ -1,6 +1,8 @@
 #ifndef __NAVCOM__SRC_LUA_PRIVATE__H__
 #define __NAVCOM__SRC_LUA_PRIVATE__H__
 
+#include <navcom/lua_alloc.h>
+#include <navcom/lua_gc.h>
 #include <lua/lua.h>
 #include <setjmp.h>
 #include <sys/time.h>
@@ -9,6 +11,9 @@ struct src_lua_data_t
 {
 	lua_State * lua;
 	jmp_buf env;
+	int msg; /* reference of the message object */
+	struct lua_alloc_t alloc; /* allocator of the Lua state */
+	struct lua_gc_t gc; /* scheduling of the garbage collector */
 	int initialized;
 	struct timeval tm_cfg;
 };
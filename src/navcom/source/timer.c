@@ -1,13 +1,13 @@
 #include <navcom/source/timer.h>
 #include <navcom/message.h>
 #include <navcom/message_comm.h>
+#include <navcom/reactor.h>
 #include <common/macros.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
 #include <unistd.h>
-#include <sys/select.h>
 #include <sys/signalfd.h>
 
 static void init_data(struct timer_data_t * data)
@@ -85,89 +85,115 @@ static int exit_proc(struct proc_config_t * config)
 	return EXIT_SUCCESS;
 }
 
-static int proc(struct proc_config_t * config)
+/**
+ * Executes the timer, until termination.
+ *
+ * @param[in] config The proc configuration.
+ * @param[in] reactor The reactor, monitoring the pipe and the
+ *   signal file descriptor.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int run(const struct proc_config_t * config, struct reactor_t * reactor)
 {
 	int rc;
-	fd_set rfds;
-	int fd_max;
+	int i;
+	int num;
+	int timeout;
+	void * ready[2];
 	struct message_t msg;
-	struct timeval tm;
-	struct timer_data_t * data;
 	struct message_t timer_message;
 	struct signalfd_siginfo signal_info;
+	const struct timer_data_t * data = (const struct timer_data_t *)config->data;
 
-	if (!config)
-		return EXIT_FAILURE;
-
-	data = (struct timer_data_t *)config->data;
-	if (!data)
-		return EXIT_FAILURE;
-
-	if (!data->initialized) {
-		syslog(LOG_ERR, "uninitialized");
-		return EXIT_FAILURE;
-	}
-
-	/* setup signal handling */
+	memset(&timer_message, 0, sizeof(timer_message));
 	timer_message.type = MSG_TIMER;
 	timer_message.data.attr.timer_id = data->timer_id;
 
+	timeout = data->tm_cfg.tv_sec * 1000 + data->tm_cfg.tv_usec / 1000;
+
 	while (1) {
-		fd_max = -1;
-		FD_ZERO(&rfds);
-		FD_SET(config->rfd, &rfds);
-		if (config->rfd > fd_max)
-			fd_max = config->rfd;
-		FD_SET(config->signal_fd, &rfds);
-		if (config->signal_fd > fd_max)
-			fd_max = config->signal_fd;
-
-		tm = data->tm_cfg;
-
-		rc = select(fd_max + 1, &rfds, NULL, NULL, &tm);
-		if (rc < 0 && errno != EINTR) {
-			syslog(LOG_ERR, "error in 'select': %s", strerror(errno));
+		num = reactor_wait(reactor, ready, 2, timeout);
+		if (num < 0 && errno != EINTR) {
+			syslog(LOG_ERR, "error in 'reactor_wait': %s", strerror(errno));
 			return EXIT_FAILURE;
-		} else if (rc < 0 && errno == EINTR) {
+		} else if (num < 0 && errno == EINTR) {
 			break;
 		}
 
-		if (rc == 0) /* timeout */
+		if (num == 0) /* timeout */
 			if (message_write(config->wfd, &timer_message) != EXIT_SUCCESS)
 				return EXIT_FAILURE;
 
-		if (FD_ISSET(config->signal_fd, &rfds)) {
-			rc = read(config->signal_fd, &signal_info, sizeof(signal_info));
-			if (rc < 0 || rc != sizeof(signal_info)) {
-				syslog(LOG_ERR, "cannot read singal info");
-				return EXIT_FAILURE;
-			}
+		for (i = 0; i < num; ++i) {
+			if (ready[i] == &config->signal_fd) {
+				rc = read(config->signal_fd, &signal_info, sizeof(signal_info));
+				if (rc < 0 || rc != sizeof(signal_info)) {
+					syslog(LOG_ERR, "cannot read singal info");
+					return EXIT_FAILURE;
+				}
 
-			if (signal_info.ssi_signo == SIGTERM)
-				break;
-		}
+				if (signal_info.ssi_signo == SIGTERM)
+					return EXIT_SUCCESS;
+			}
 
-		if (FD_ISSET(config->rfd, &rfds)) {
-			if (message_read(config->rfd, &msg) != EXIT_SUCCESS)
-				return EXIT_FAILURE;
-			switch (msg.type) {
-				case MSG_SYSTEM:
-					switch (msg.data.attr.system) {
-						case SYSTEM_TERMINATE:
-							return EXIT_SUCCESS;
-						default:
-							break;
-					}
-				default:
-					break;
+			if (ready[i] == &config->rfd) {
+				if (proc_read(config, &msg) != EXIT_SUCCESS)
+					return EXIT_FAILURE;
+				switch (msg.type) {
+					case MSG_SYSTEM:
+						switch (msg.data.attr.system) {
+							case SYSTEM_TERMINATE:
+								return EXIT_SUCCESS;
+							default:
+								break;
+						}
+					default:
+						break;
+				}
 			}
-			continue;
 		}
 	}
 
 	return EXIT_SUCCESS;
 }
 
+static int proc(struct proc_config_t * config)
+{
+	int rc;
+	struct reactor_t reactor;
+	struct timer_data_t * data;
+
+	if (!config)
+		return EXIT_FAILURE;
+
+	data = (struct timer_data_t *)config->data;
+	if (!data)
+		return EXIT_FAILURE;
+
+	if (!data->initialized) {
+		syslog(LOG_ERR, "uninitialized");
+		return EXIT_FAILURE;
+	}
+
+	/* setup event handling, the file descriptors itself are the user data */
+	if (reactor_init(&reactor) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "unable to initialize reactor: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if ((reactor_add(&reactor, config->rfd, 0, &config->rfd) != EXIT_SUCCESS)
+		|| (reactor_add(&reactor, config->signal_fd, 0, &config->signal_fd) != EXIT_SUCCESS)) {
+		syslog(LOG_ERR, "unable to register file descriptors: %s", strerror(errno));
+		reactor_exit(&reactor);
+		return EXIT_FAILURE;
+	}
+
+	rc = run(config, &reactor);
+
+	reactor_exit(&reactor);
+	return rc;
+}
+
 static void help(void)
 {
 	printf("\n");
@@ -0,0 +1,237 @@
+#include <navcom/trace.h>
+#include <navcom/metrics.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+ * Entry of the trace buffer. The sequence number is written last,
+ * an entry is complete only if it matches the position of the entry.
+ */
+struct trace_entry_t
+{
+	uint32_t seq; /* position + 1, 0 while being written */
+	uint32_t category;
+	int32_t pid;
+	uint64_t time; /* nsec, see metrics_now */
+	char text[TRACE_TEXT_SIZE];
+};
+
+/**
+ * Trace buffer in shared memory, created by the hub before the procs
+ * are forked. All processes and threads write into the same buffer,
+ * the position is reserved atomically. Older entries are overwritten.
+ */
+struct trace_buffer_t
+{
+	uint32_t head; /* position of the next entry */
+	uint32_t size; /* number of entries, power of two */
+	struct trace_entry_t entries[];
+};
+
+static const struct {
+	const char * name;
+	uint32_t category;
+} CATEGORIES[] = {
+	{ "hub",         TRACE_HUB         },
+	{ "route",       TRACE_ROUTE       },
+	{ "filter",      TRACE_FILTER      },
+	{ "source",      TRACE_SOURCE      },
+	{ "destination", TRACE_DESTINATION },
+	{ "device",      TRACE_DEVICE      },
+	{ "all",         TRACE_ALL         },
+};
+
+uint32_t trace_mask = 0;
+
+static struct trace_buffer_t * trace_buffer = NULL;
+static size_t trace_buffer_size = 0;
+
+/**
+ * Process id of the writer, getpid is a system call.
+ */
+static pid_t trace_pid = 0;
+
+static void update_pid(void)
+{
+	trace_pid = getpid();
+}
+
+static const char * category_name(uint32_t category)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(CATEGORIES) / sizeof(CATEGORIES[0]); ++i) {
+		if (CATEGORIES[i].category == category)
+			return CATEGORIES[i].name;
+	}
+	return "-";
+}
+
+/**
+ * Creates the trace buffer and enables the specified categories.
+ * This has to be done before any proc is forked, to share the
+ * buffer with all procs.
+ *
+ * @param[in] categories Categories to record.
+ * @param[in] size Number of entries, rounded up to the next power of two.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+int trace_init(uint32_t categories, uint32_t size)
+{
+	static int atfork = 0;
+	uint32_t n = 1;
+
+	trace_exit();
+	if (size == 0)
+		return EXIT_FAILURE;
+	while (n < size)
+		n <<= 1;
+
+	trace_buffer_size = sizeof(struct trace_buffer_t) + n * sizeof(struct trace_entry_t);
+	trace_buffer = mmap(NULL, trace_buffer_size,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (trace_buffer == MAP_FAILED) {
+		syslog(LOG_ERR, "unable to map trace buffer: %s", strerror(errno));
+		trace_buffer = NULL;
+		trace_buffer_size = 0;
+		return EXIT_FAILURE;
+	}
+	trace_buffer->head = 0;
+	trace_buffer->size = n;
+
+	update_pid();
+	if (!atfork) {
+		pthread_atfork(NULL, NULL, update_pid);
+		atfork = 1;
+	}
+	trace_mask = categories;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Disables tracing and releases the trace buffer.
+ */
+void trace_exit(void)
+{
+	trace_mask = 0;
+	if (trace_buffer) {
+		munmap(trace_buffer, trace_buffer_size);
+		trace_buffer = NULL;
+		trace_buffer_size = 0;
+	}
+}
+
+/**
+ * Parses a comma separated list of category names, e.g. 'route,filter'
+ * or 'all'.
+ *
+ * @param[in] s The list of categories.
+ * @param[out] categories The parsed categories.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE Unknown category.
+ */
+int trace_categories(const char * s, uint32_t * categories)
+{
+	size_t i;
+	size_t len;
+
+	if (s == NULL || categories == NULL)
+		return EXIT_FAILURE;
+
+	*categories = 0;
+	while (*s) {
+		len = strcspn(s, ",");
+		for (i = 0; i < sizeof(CATEGORIES) / sizeof(CATEGORIES[0]); ++i) {
+			if ((strlen(CATEGORIES[i].name) == len) && (strncmp(CATEGORIES[i].name, s, len) == 0))
+				break;
+		}
+		if (i >= sizeof(CATEGORIES) / sizeof(CATEGORIES[0]))
+			return EXIT_FAILURE;
+		*categories |= CATEGORIES[i].category;
+		s += len;
+		if (*s == ',')
+			++s;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Records an entry, use the macro TRACE instead of calling this
+ * function directly. Texts longer than TRACE_TEXT_SIZE are truncated.
+ * Does nothing if there is no trace buffer.
+ */
+void trace_write(uint32_t category, const char * fmt, ...)
+{
+	uint32_t pos;
+	struct trace_entry_t * entry;
+	va_list args;
+
+	if (trace_buffer == NULL)
+		return;
+
+	pos = __atomic_fetch_add(&trace_buffer->head, 1, __ATOMIC_RELAXED);
+	entry = &trace_buffer->entries[pos & (trace_buffer->size - 1)];
+	__atomic_store_n(&entry->seq, 0, __ATOMIC_RELAXED);
+
+	entry->category = category;
+	entry->pid = trace_pid;
+	entry->time = metrics_now();
+	va_start(args, fmt);
+	vsnprintf(entry->text, sizeof(entry->text), fmt, args);
+	va_end(args);
+
+	__atomic_store_n(&entry->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Writes all complete entries of the trace buffer, oldest first,
+ * one line per entry: time (sec.usec, monotonic), process id,
+ * category and text. The buffer is not cleared. Entries written
+ * concurrently may be missing.
+ *
+ * @param[in] file The file to write to. If this is NULL, the entries
+ *   are written to syslog.
+ * @return Number of written entries.
+ */
+uint32_t trace_dump(FILE * file)
+{
+	uint32_t head;
+	uint32_t pos;
+	uint32_t n = 0;
+	const struct trace_entry_t * entry;
+	struct trace_entry_t copy;
+
+	if (trace_buffer == NULL)
+		return 0;
+
+	head = __atomic_load_n(&trace_buffer->head, __ATOMIC_ACQUIRE);
+	pos = (head > trace_buffer->size) ? head - trace_buffer->size : 0;
+	for (; pos != head; ++pos) {
+		entry = &trace_buffer->entries[pos & (trace_buffer->size - 1)];
+		if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != pos + 1)
+			continue;
+		memcpy(&copy, entry, sizeof(copy));
+		if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != pos + 1)
+			continue;
+		copy.text[sizeof(copy.text) - 1] = '\0';
+
+		if (file) {
+			fprintf(file, "%5lu.%06lu %5d %-11s %s\n",
+				(unsigned long)(copy.time / 1000000000), (unsigned long)(copy.time % 1000000000) / 1000,
+				copy.pid, category_name(copy.category), copy.text);
+		} else {
+			syslog(LOG_INFO, "trace: %5lu.%06lu %5d %-11s %s",
+				(unsigned long)(copy.time / 1000000000), (unsigned long)(copy.time % 1000000000) / 1000,
+				copy.pid, category_name(copy.category), copy.text);
+		}
+		++n;
+	}
+	return n;
+}
@@ -0,0 +1,51 @@
+#ifndef __NAVCOM__TRACE__H__
+#define __NAVCOM__TRACE__H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <global_config.h>
+
+/**
+ * Categories of trace entries, may be combined.
+ */
+#define TRACE_HUB         0x0001 /* main loop of the hub */
+#define TRACE_ROUTE       0x0002 /* routing of messages */
+#define TRACE_FILTER      0x0004 /* filters */
+#define TRACE_SOURCE      0x0008 /* sources */
+#define TRACE_DESTINATION 0x0010 /* destinations */
+#define TRACE_DEVICE      0x0020 /* data on the wire of devices, byte level */
+#define TRACE_ALL         0xffff
+
+/**
+ * Default number of entries within the trace buffer, and maximum
+ * size of the text of an entry (including the terminating zero).
+ */
+#define TRACE_SIZE_DEFAULT 1024
+#define TRACE_TEXT_SIZE    96
+
+/**
+ * Categories being recorded, set by trace_init.
+ */
+extern uint32_t trace_mask;
+
+/**
+ * Records an entry in the trace buffer, with printf like formatting.
+ * If the category is not enabled, this costs one comparison.
+ * Without ENABLE_TRACE (release builds) this compiles to nothing,
+ * the arguments are still checked by the compiler.
+ */
+#if defined(ENABLE_TRACE)
+	#define TRACE(category, ...) \
+		do { if (trace_mask & (category)) trace_write((category), __VA_ARGS__); } while (0)
+#else
+	#define TRACE(category, ...) \
+		do { if (0) trace_write((category), __VA_ARGS__); } while (0)
+#endif
+
+int trace_init(uint32_t, uint32_t);
+void trace_exit(void);
+int trace_categories(const char *, uint32_t *);
+void trace_write(uint32_t, const char *, ...) __attribute__((format(printf, 2, 3)));
+uint32_t trace_dump(FILE *);
+
+#endif
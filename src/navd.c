@@ -6,7 +6,18 @@
 #include <common/macros.h>
 #include <config/config.h>
 #include <navcom/message.h>
+#include <navcom/message_comm.h>
+#include <navcom/message_ring.h>
+#include <navcom/message_queue.h>
+#include <navcom/metrics.h>
+#include <navcom/trace.h>
+#include <navcom/property_read.h>
 #include <navcom/proc_list.h>
+#include <navcom/proc_thread.h>
+#include <navcom/reactor.h>
+#if defined(NEEDS_LUA)
+	#include <navcom/lua_cache.h>
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,8 +25,9 @@
 #include <errno.h>
 #include <limits.h>
 #include <syslog.h>
-#include <sys/select.h>
+#include <inttypes.h>
 #include <sys/signalfd.h>
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <libgen.h>
@@ -47,12 +59,99 @@ static size_t proc_cfg_base_src = 0;
  */
 static size_t proc_cfg_base_dst = 0;
 
+/**
+ * Runtime information of the hub about a procedure. The array
+ * hub_procs is parallel to proc_cfg.
+ */
+struct hub_proc_t {
+	/**
+	 * Buffered reader for messages sent by the proc.
+	 */
+	struct message_reader_t reader;
+
+	/**
+	 * Indicates that the pipe of the proc was not drained
+	 * completely, more messages may be available.
+	 */
+	int pending;
+
+	/**
+	 * Shared memory transport from the hub to the proc, if configured.
+	 */
+	struct message_ring_t ring;
+
+	/**
+	 * Messages the destination was not able to receive yet.
+	 */
+	struct message_queue_t queue;
+
+	/**
+	 * Counters about the messages received from and sent to the proc.
+	 */
+	struct proc_metrics_t metrics;
+
+	/**
+	 * The thread executing the proc, if the proc is executed as thread
+	 * within the hub process instead of its own process.
+	 */
+	struct proc_thread_t thread;
+};
+
+/**
+ * Array containing the hub runtime information of all procedures.
+ */
+static struct hub_proc_t * hub_procs = NULL;
+
+/**
+ * List of all procs with pending messages, in the order they will
+ * be served.
+ */
+static struct proc_config_t ** pending_procs = NULL;
+
+/**
+ * Number of entries within pending_procs.
+ */
+static size_t num_pending_procs = 0;
+
+/**
+ * Interval in msec to write messages queued for destinations.
+ */
+#define FLUSH_INTERVAL 10
+
+/**
+ * Marker for the reactor, results of filters executed by
+ * the worker pool are available.
+ */
+static int filter_results;
+
+/**
+ * Marker for the reactor, the statistics are to be written.
+ */
+static int stats_timer;
+
+/**
+ * Time the hub needs to route a batch of messages from a source, in
+ * nsec, see route_msg_batch. One sample per batch, the tails are not
+ * flattened by averaging. Filters executed by the worker pool are not
+ * included.
+ */
+static struct histogram_t dispatch_time;
+
 static void destroy_proc_configs(void)
 {
 	if (proc_cfg) {
 		free(proc_cfg);
 		proc_cfg = NULL;
 	}
+	if (hub_procs) {
+		free(hub_procs);
+		hub_procs = NULL;
+	}
+	if (pending_procs) {
+		free(pending_procs);
+		pending_procs = NULL;
+	}
+	num_pending_procs = 0;
 }
 
 static void prepare_proc_configs(const struct config_t * config)
@@ -63,8 +162,16 @@ static void prepare_proc_configs(const struct config_t * config)
 
 	destroy_proc_configs();
 	proc_cfg = malloc(sizeof(struct proc_config_t) * num);
+	hub_procs = malloc(sizeof(struct hub_proc_t) * num);
+	pending_procs = malloc(sizeof(struct proc_config_t *) * num);
 	for (i = 0; i < num; ++i) {
 		proc_config_init(&proc_cfg[i]);
+		message_reader_init(&hub_procs[i].reader);
+		hub_procs[i].pending = 0;
+		message_ring_init(&hub_procs[i].ring);
+		memset(&hub_procs[i].queue, 0, sizeof(hub_procs[i].queue));
+		proc_thread_init(&hub_procs[i].thread);
+		proc_metrics_init(&hub_procs[i].metrics);
 	}
 	proc_cfg_base_src = 0;
 	proc_cfg_base_dst = config->num_sources;
@@ -89,23 +196,199 @@ static int proc_close(struct proc_config_t * proc)
 		close(proc->wfd);
 		proc->wfd = -1;
 	}
+	if (proc->ring) {
+		message_ring_destroy(proc->ring);
+		proc->ring = NULL;
+	}
+	if (proc->queue) {
+		if (proc->queue->dropped || proc->queue->coalesced || proc->queue->blocked) {
+			syslog(LOG_NOTICE, "destination '%s': %lu dropped, %lu coalesced, %lu blocked",
+				proc->cfg->name, proc->queue->dropped, proc->queue->coalesced, proc->queue->blocked);
+		}
+		message_queue_destroy(proc->queue);
+		proc->queue = NULL;
+	}
 	return 0;
 }
 
 static int proc_close_wait(struct proc_config_t * proc)
 {
-	proc_close(proc);
-	waitpid(proc->pid, NULL, 0);
+	struct hub_proc_t * hub = &hub_procs[proc - proc_cfg];
+
+	if (hub->thread.running) {
+		/* the thread uses the transport until it terminates */
+		proc_thread_join(&hub->thread);
+		proc_close(proc);
+	} else {
+		proc_close(proc);
+		waitpid(proc->pid, NULL, 0);
+	}
 	proc->pid = -1;
 	return 0;
 }
 
+/**
+ * Determines whether or not the proc is to be executed as thread
+ * within the hub process. It is configured by the proc property
+ * '_exec_' : 'process' or 'thread', default defined by the program
+ * option '--threads'.
+ *
+ * Procs executing untrusted scripts, or depending on signals
+ * (e.g. simulated devices using timers), should be executed as
+ * processes.
+ *
+ * @param[in] proc The proc.
+ * @param[in] threads Default execution, non-zero for threads.
+ * @retval  1 Thread
+ * @retval  0 Process
+ * @retval -1 Invalid configuration
+ */
+static int exec_threaded(const struct proc_config_t * proc, int threads)
+{
+	const char * exec = proplist_value(&proc->cfg->properties, "_exec_");
+
+	if (exec == NULL)
+		return threads ? 1 : 0;
+	if (strcmp(exec, "process") == 0)
+		return 0;
+	if (strcmp(exec, "thread") == 0)
+		return 1;
+	syslog(LOG_CRIT, "unknown execution for proc '%s': '%s'", proc->cfg->name, exec);
+	return -1;
+}
+
+/**
+ * Sets up the transport of messages from the hub to the proc. It is
+ * configured by the proc properties:
+ * - '_transport_' : 'pipe' or 'ring' (shared memory ring buffer),
+ *   default is 'pipe' for processes and 'ring' for threads
+ * - '_ring_size_' : capacity of the ring in bytes
+ *
+ * The transport from the proc to the hub is always a pipe, the hub
+ * detects the termination of the proc by the end of file.
+ *
+ * @param[out] proc The proc to set up.
+ * @param[out] rfd Pipe from the hub to the proc, both set to -1 if the
+ *   ring is used.
+ * @param[in] threaded Non-zero if the proc is executed as thread.
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+static int setup_transport(struct proc_config_t * proc, int rfd[2], int threaded)
+{
+	const char * transport;
+	uint32_t size = MESSAGE_RING_SIZE_DEFAULT;
+	struct message_ring_t * ring;
+
+	rfd[0] = -1;
+	rfd[1] = -1;
+	transport = proplist_value(&proc->cfg->properties, "_transport_");
+	if (transport == NULL)
+		transport = threaded ? "ring" : "pipe";
+	if (strcmp(transport, "pipe") == 0) {
+		if (pipe(rfd) < 0) {
+			syslog(LOG_CRIT, "unable to create pipe for reading");
+			return -1;
+		}
+		return 0;
+	}
+	if (strcmp(transport, "ring") != 0) {
+		syslog(LOG_CRIT, "unknown transport for proc '%s': '%s'", proc->cfg->name, transport);
+		return -1;
+	}
+	if (property_read_uint32(&proc->cfg->properties, "_ring_size_", &size) != EXIT_SUCCESS)
+		return -1;
+	ring = &hub_procs[proc - proc_cfg].ring;
+	if (message_ring_create(ring, size) != EXIT_SUCCESS) {
+		syslog(LOG_CRIT, "unable to create ring for proc '%s'", proc->cfg->name);
+		return -1;
+	}
+	proc->ring = ring;
+	return 0;
+}
+
+/**
+ * Sets up the queue of the hub for messages the destination is not able
+ * to receive yet, the hub never blocks on a destination except the policy
+ * says so. It is configured by the proc properties:
+ * - '_queue_' : maximum number of queued messages
+ * - '_policy_' : what to do if the queue is full, 'block' (default),
+ *   'drop-oldest', 'drop-newest' or 'coalesce' (replace queued messages
+ *   of the same kind, e.g. the same NMEA sentence, by the latest one)
+ *
+ * @param[inout] proc The destination to set up the queue for.
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+static int setup_queue(struct proc_config_t * proc)
+{
+	struct message_queue_t * queue = &hub_procs[proc - proc_cfg].queue;
+	uint32_t size = MESSAGE_QUEUE_SIZE_DEFAULT;
+	const char * name;
+	int policy = MESSAGE_QUEUE_BLOCK;
+
+	name = proplist_value(&proc->cfg->properties, "_policy_");
+	if (name) {
+		policy = message_queue_policy(name);
+		if (policy < 0) {
+			syslog(LOG_CRIT, "unknown queue policy for proc '%s': '%s'", proc->cfg->name, name);
+			return -1;
+		}
+	}
+	if (property_read_uint32(&proc->cfg->properties, "_queue_", &size) != EXIT_SUCCESS)
+		return -1;
+	if (message_queue_init(queue, size, policy) != EXIT_SUCCESS) {
+		syslog(LOG_CRIT, "unable to create queue for proc '%s'", proc->cfg->name);
+		return -1;
+	}
+	if ((proc->ring == NULL) && (fd_set_nonblocking(proc->wfd) != EXIT_SUCCESS)) {
+		syslog(LOG_CRIT, "unable to set pipe of '%s' non-blocking", proc->cfg->name);
+		message_queue_destroy(queue);
+		return -1;
+	}
+	proc->queue = queue;
+	return 0;
+}
+
+static void close_pipe(int fd[2])
+{
+	if (fd[0] >= 0)
+		close(fd[0]);
+	if (fd[1] >= 0)
+		close(fd[1]);
+}
+
+/**
+ * Starts the thread to execute the proc, see proc_thread_start.
+ *
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+static int thread_start(
+		struct proc_config_t * proc,
+		const struct proc_desc_t const * desc,
+		int rfd[2],
+		int wfd[2])
+{
+	struct hub_proc_t * hub = &hub_procs[proc - proc_cfg];
+
+	if (proc_thread_start(&hub->thread, proc, desc, rfd, wfd) != EXIT_SUCCESS) {
+		close_pipe(rfd);
+		close_pipe(wfd);
+		proc_close(proc);
+		syslog(LOG_CRIT, "cannot start thread for proc '%s' (type: '%s')", proc->cfg->name, proc->cfg->type);
+		return -1;
+	}
+	return 0;
+}
+
 static int proc_start(
 		struct proc_config_t * proc,
-		const struct proc_desc_t const * desc)
+		const struct proc_desc_t const * desc,
+		int threads)
 {
-	int rc_func;
 	int rc;
+	int threaded;
 	int rfd[2]; /* hub -> proc */
 	int wfd[2]; /* proc -> hub */
 
@@ -118,86 +401,48 @@ static int proc_start(
 	if (desc->func == NULL)
 		return -1;
 
-	rc = pipe(rfd);
-	if (rc < 0) {
-		syslog(LOG_CRIT, "unable to create pipe for reading");
+	threaded = exec_threaded(proc, threads);
+	if (threaded < 0)
+		return -1;
+	if (setup_transport(proc, rfd, threaded) < 0)
 		return -1;
-	}
 	rc = pipe(wfd);
 	if (rc < 0) {
-		close(rfd[0]);
-		close(rfd[1]);
+		close_pipe(rfd);
+		proc_close(proc);
 		syslog(LOG_CRIT, "unable to create pipe for writing");
 		return -1;
 	}
 
+	if (threaded)
+		return thread_start(proc, desc, rfd, wfd);
+
 	rc = fork();
 	if (rc < 0) {
-		close(rfd[0]);
-		close(rfd[1]);
-		close(wfd[0]);
-		close(wfd[1]);
+		close_pipe(rfd);
+		close_pipe(wfd);
+		proc_close(proc);
 		syslog(LOG_CRIT, "cannot start proc '%s' (type: '%s')", proc->cfg->name, proc->cfg->type);
 		return -1;
 	}
 
 	if (rc == 0) {
 		/* child code */
-		syslog(LOG_INFO, "start proc '%s' (type: '%s')", proc->cfg->name, proc->cfg->type);
 		proc->pid = getpid();
-		proc->rfd = rfd[0];
+		proc->rfd = proc->ring ? proc->ring->efd : rfd[0];
 		proc->wfd = wfd[1];
-		close(rfd[1]);
+		if (rfd[1] >= 0)
+			close(rfd[1]);
 		close(wfd[0]);
-
-		/* setup signal handling for child process */
-		sigemptyset(&proc->signal_mask);
-		sigaddset(&proc->signal_mask, SIGINT);
-		sigaddset(&proc->signal_mask, SIGTERM);
-		if (sigprocmask(SIG_BLOCK, &proc->signal_mask, NULL) < 0) {
-			syslog(LOG_ERR, "unable to initialize signal handling");
-			return EXIT_FAILURE;
-		}
-		proc->signal_fd = signalfd(-1, &proc->signal_mask, 0);
-		if (proc->signal_fd < 0) {
-			syslog(LOG_ERR, "unable to obtain file descriptor for signal handling");
-			return EXIT_FAILURE;
-		}
-
-		/* initialize procedure */
-		if (desc->init) {
-			rc = desc->init(proc, &proc->cfg->properties);
-			if (rc != EXIT_SUCCESS) {
-				syslog(LOG_ERR, "initialization failure for proc type: '%s', stop proc '%s', rc=%d",
-					proc->cfg->type, proc->cfg->name, rc);
-
-				/* try to clean up if init was not completely successful */
-				if (desc->exit)
-					if (desc->exit(proc) != EXIT_SUCCESS)
-						syslog(LOG_ERR, "proc short exit '%s'", proc->cfg->name);
-
-				exit(rc);
-			}
-		}
-
-		/* execute actual procedure */
-		rc_func = desc->func(proc);
-		syslog(LOG_INFO, "stop proc '%s', rc=%d", proc->cfg->name, rc_func);
-
-		/* clean up */
-		if (desc->exit) {
-			if (desc->exit(proc) != EXIT_SUCCESS)
-				syslog(LOG_ERR, "proc exit '%s', rc=%d", proc->cfg->name, rc);
-		}
-		close(proc->signal_fd);
-		exit(rc_func);
+		exit(proc_run(proc, desc, 0));
 	}
 
 	/* parent code */
 	proc->pid = rc;
 	proc->rfd = wfd[0];
 	proc->wfd = rfd[1];
-	close(rfd[0]);
+	if (rfd[0] >= 0)
+		close(rfd[0]);
 	close(wfd[1]);
 	return rc;
 }
@@ -255,6 +500,67 @@ static void config_dump(const struct config_t const * config)
 	}
 }
 
+#if defined(NEEDS_LUA)
+/**
+ * Precompiles the script of a source, destination or filter, if it
+ * is one of the Lua scripted types.
+ *
+ * @retval EXIT_SUCCESS Script compiled or not scripted in Lua.
+ * @retval EXIT_FAILURE
+ */
+static int precompile_script(
+		const char * name,
+		const char * type,
+		const struct property_list_t * properties)
+{
+	const struct property_t * prop;
+
+	if (strcmp(type, "src_lua") && strcmp(type, "dst_lua") && strcmp(type, "filter_lua"))
+		return EXIT_SUCCESS;
+
+	prop = proplist_find(properties, "script");
+	if ((prop == NULL) || (prop->value == NULL)) {
+		syslog(LOG_ERR, "no script defined for '%s'", name);
+		return EXIT_FAILURE;
+	}
+	if (luaH_precompile(prop->value) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	syslog(LOG_INFO, "precompiled '%s' of '%s'", prop->value, name);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Precompiles the Lua scripts of all sources, destinations and
+ * filters of the configuration into the cache.
+ *
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE At least one script failed to compile.
+ */
+static int precompile_scripts(const struct config_t * config)
+{
+	size_t i;
+	int rc = EXIT_SUCCESS;
+
+	for (i = 0; i < config->num_sources; ++i) {
+		const struct proc_t * p = &config->sources[i];
+		if (precompile_script(p->name, p->type, &p->properties) != EXIT_SUCCESS)
+			rc = EXIT_FAILURE;
+	}
+	for (i = 0; i < config->num_destinations; ++i) {
+		const struct proc_t * p = &config->destinations[i];
+		if (precompile_script(p->name, p->type, &p->properties) != EXIT_SUCCESS)
+			rc = EXIT_FAILURE;
+	}
+	for (i = 0; i < config->num_filters; ++i) {
+		const struct filter_t * p = &config->filters[i];
+		if (precompile_script(p->name, p->type, &p->properties) != EXIT_SUCCESS)
+			rc = EXIT_FAILURE;
+	}
+	return rc;
+}
+#endif
+
 /**
  * Reads the configuration and stores the valid information in the specified
  * structure.
@@ -295,36 +601,86 @@ static int config_read(
 
 static int send_terminate(const struct proc_config_t * proc)
 {
-	int rc;
 	struct message_t msg;
+	int retry;
+	int rc;
 
 	if (proc == NULL || proc->pid <= 0)
 		return 0;
 	memset(&msg, 0, sizeof(msg));
 	msg.type = MSG_SYSTEM;
 	msg.data.attr.system = SYSTEM_TERMINATE;
-	rc = write(proc->wfd, &msg, sizeof(msg));
-	if (rc < 0) {
-		syslog(LOG_CRIT, "unable to send termination message");
+
+	/* queued messages are delivered before the termination, for a while */
+	for (retry = 0; (proc_flush(proc, 0) > 0) && (retry < 100); ++retry)
+		usleep(1000);
+	rc = proc_send(proc, &msg);
+	if ((rc == EXIT_SUCCESS) && (proc_flush(proc, 1) < 0))
+		rc = EXIT_FAILURE;
+
+	/* a full ring is being drained by the proc, try again for a while */
+	for (retry = 0; (rc != EXIT_SUCCESS) && proc->ring && (retry < 100); ++retry) {
+		usleep(1000);
+		rc = proc_send(proc, &msg);
+	}
+	if (rc != EXIT_SUCCESS) {
+		syslog(LOG_CRIT, "unable to send termination message to '%s'", proc->cfg->name);
+		if (proc->ring && !hub_procs[proc - proc_cfg].thread.running) {
+			/* the proc handles the signal as well */
+			kill(proc->pid, SIGTERM);
+			return 0;
+		}
 		return -1;
 	}
 	return 0;
 }
 
 /**
- * Sets up the procedures (sources and destinations) and starts them.
+ * Requests all procs to reopen their files, e.g. after log rotation.
+ * Messages are queued like all others, procs executed as threads
+ * receive them as well as processes.
+ */
+static void send_reopen(const struct config_t * config)
+{
+	struct message_t msg;
+	size_t i;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = SYSTEM_REOPEN;
+	for (i = 0; i < config->num_sources + config->num_destinations; ++i) {
+		if (proc_cfg[i].pid <= 0)
+			continue;
+		if (proc_send(&proc_cfg[i], &msg) != EXIT_SUCCESS)
+			syslog(LOG_ERR, "unable to send reopen message to '%s'", proc_cfg[i].cfg->name);
+	}
+}
+
+/**
+ * Sets up the procedures (sources and destinations) and starts either
+ * those executed as processes or those executed as threads.
+ *
+ * The processes have to be forked before any thread is running, a thread
+ * may hold a lock (syslog, malloc) at the time of the fork, which would
+ * never be released within the child. Therefore this function is called
+ * twice, first for the processes, then for the threads.
  *
  * @param[in] num Number of procedures to process.
  * @param[in] base Starting index within the proc_cfg array, holding
  *   information about procedures.
  * @param[in] list List of procedure descriptors.
+ * @param[in] threads Default execution of procs, non-zero for threads.
+ * @param[in] threaded Non-zero to start only the procs executed as
+ *   threads, zero to start only those executed as processes.
  * @retval  0 Success
  * @retval -1 Failure
  */
 static int setup_procs(
 		size_t num,
 		size_t base,
-		const struct proc_desc_list_t const * list)
+		const struct proc_desc_list_t const * list,
+		int threads,
+		int threaded)
 {
 	size_t i;
 	int rc;
@@ -332,12 +688,17 @@ static int setup_procs(
 
 	for (i = 0; i < num; ++i) {
 		struct proc_config_t * ptr = &proc_cfg[i + base];
+		rc = exec_threaded(ptr, threads);
+		if (rc < 0)
+			return -1;
+		if (rc != threaded)
+			continue;
 		desc = pdlist_find(list, ptr->cfg->type);
 		if (desc == NULL) {
 			syslog(LOG_ERR, "unknown proc type: '%s'", ptr->cfg->type);
 			return -1;
 		}
-		rc = proc_start(ptr, desc);
+		rc = proc_start(ptr, desc, threads);
 		if (rc < 0)
 			return -1;
 	}
@@ -362,27 +723,46 @@ static void terminate_graceful(const struct config_t const * config)
 	registry_free();
 }
 
-static int setup_subprocesses(struct config_t * config)
+static int setup_subprocesses(struct config_t * config, int threads)
 {
+	size_t i;
+	int threaded;
+
 	prepare_proc_configs(config);
-	if (setup_procs(config->num_destinations, proc_cfg_base_dst, registry_destinations()) < 0) {
-		terminate_graceful(config);
-		return EXIT_FAILURE;
+	for (threaded = 0; threaded <= 1; ++threaded) {
+		if (setup_procs(config->num_destinations, proc_cfg_base_dst, registry_destinations(), threads, threaded) < 0) {
+			terminate_graceful(config);
+			return EXIT_FAILURE;
+		}
+		if (setup_procs(config->num_sources, proc_cfg_base_src, registry_sources(), threads, threaded) < 0) {
+			terminate_graceful(config);
+			return EXIT_FAILURE;
+		}
 	}
-	if (setup_procs(config->num_sources, proc_cfg_base_src, registry_sources()) < 0) {
-		terminate_graceful(config);
-		return EXIT_FAILURE;
+	for (i = 0; i < config->num_destinations; ++i) {
+		if (setup_queue(&proc_cfg[proc_cfg_base_dst + i]) < 0) {
+			terminate_graceful(config);
+			return EXIT_FAILURE;
+		}
 	}
+
+	/* not before all procs are started, threads must not see the counters of the hub */
+	for (i = 0; i < config->num_sources + config->num_destinations; ++i)
+		proc_cfg[i].metrics = &hub_procs[i].metrics;
 	return EXIT_SUCCESS;
 }
 
-static int setup_routes(struct config_t * config)
+static int setup_routes(struct config_t * config, size_t filter_workers)
 {
 	route_init(config);
 	if (route_setup(config, proc_cfg, proc_cfg_base_src, proc_cfg_base_dst) < 0) {
 		terminate_graceful(config);
 		return EXIT_FAILURE;
 	}
+	if (route_setup_workers(config, filter_workers) < 0) {
+		terminate_graceful(config);
+		return EXIT_FAILURE;
+	}
 	return EXIT_SUCCESS;
 }
 
@@ -392,6 +772,8 @@ static int setup_signal_handling(sigset_t * signal_mask, int * signal_fd)
 	sigaddset(signal_mask, SIGINT);
 	sigaddset(signal_mask, SIGTERM);
 	sigaddset(signal_mask, SIGALRM);
+	sigaddset(signal_mask, SIGUSR1);
+	sigaddset(signal_mask, SIGHUP);
 	if (sigprocmask(SIG_BLOCK, signal_mask, NULL) < 0) {
 		syslog(LOG_ERR, "unable to initialize signal handling");
 		return EXIT_FAILURE;
@@ -404,6 +786,285 @@ static int setup_signal_handling(sigset_t * signal_mask, int * signal_fd)
 	return EXIT_SUCCESS;
 }
 
+/**
+ * Registers the signal file descriptor and the pipes of all procs
+ * at the reactor. The pipes are monitored edge triggered, therefore
+ * they are set to non-blocking mode and have to be drained after each
+ * notification. The signal file descriptor is registered without
+ * user data.
+ *
+ * @param[out] reactor The reactor to set up.
+ * @param[in] config The configuration.
+ * @param[in] signal_fd The file descriptor for signal handling.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int setup_reactor(
+		struct reactor_t * reactor,
+		const struct config_t * config,
+		int signal_fd)
+{
+	size_t i;
+
+	if (reactor_init(reactor) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "unable to initialize reactor: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (reactor_add(reactor, signal_fd, 0, NULL) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "unable to register signal handling: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if ((route_fd() >= 0) && (reactor_add(reactor, route_fd(), 0, &filter_results) != EXIT_SUCCESS)) {
+		syslog(LOG_ERR, "unable to register filter results: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < config->num_sources + config->num_destinations; ++i) {
+		struct proc_config_t * proc = &proc_cfg[i];
+		if (proc->rfd < 0)
+			continue;
+		if (fd_set_nonblocking(proc->rfd) != EXIT_SUCCESS) {
+			syslog(LOG_ERR, "unable to set pipe of '%s' non-blocking", proc->cfg->name);
+			return EXIT_FAILURE;
+		}
+		if (reactor_add(reactor, proc->rfd, REACTOR_EDGE, proc) != EXIT_SUCCESS) {
+			syslog(LOG_ERR, "unable to register proc '%s': %s", proc->cfg->name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Writes messages queued by the hub to the destinations, as many as
+ * possible without blocking. There is no notification about destinations
+ * able to receive more messages (the ring is polled by the producer),
+ * therefore this is done periodically while messages are queued.
+ *
+ * @param[in] config The configuration.
+ * @return Number of destinations with messages still queued.
+ */
+static size_t flush_destinations(const struct config_t * config)
+{
+	size_t i;
+	size_t num = 0;
+	struct proc_config_t * proc;
+
+	for (i = 0; i < config->num_destinations; ++i) {
+		proc = &proc_cfg[proc_cfg_base_dst + i];
+		if (message_queue_empty(proc->queue))
+			continue;
+		if (proc_flush(proc, 0) > 0)
+			++num;
+	}
+	return num;
+}
+
+/**
+ * Marks the proc to have pending messages, if not already done.
+ *
+ * @param[in] proc The proc to mark.
+ */
+static void mark_pending(struct proc_config_t * proc)
+{
+	struct hub_proc_t * hub = &hub_procs[proc - proc_cfg];
+
+	if (hub->pending)
+		return;
+	hub->pending = 1;
+	pending_procs[num_pending_procs++] = proc;
+}
+
+/**
+ * Reads a batch of messages from the specified proc and routes them.
+ * The pipe is read in chunks as large as possible, all messages
+ * contained in one chunk are decoded without further system calls.
+ *
+ * To be fair to other procs, at most the specified number of messages
+ * are being read. If this number is reached, the pipe is not drained
+ * completely and the proc has to be served again.
+ *
+ * @param[in] config The configuration.
+ * @param[in] reactor The reactor the proc is registered at.
+ * @param[in] proc The proc to read messages from.
+ * @param[out] batch Buffer to hold the received messages.
+ * @param[in] max Size of the buffer, maximum number of messages to read.
+ * @param[out] received Number of messages received.
+ * @retval  1 Success, more messages may be pending.
+ * @retval  0 Success, all pending messages processed.
+ * @retval -1 The proc has terminated.
+ */
+static int drain_proc(
+		const struct config_t * config,
+		struct reactor_t * reactor,
+		struct proc_config_t * proc,
+		struct message_t * batch,
+		size_t max,
+		size_t * received)
+{
+	int rc;
+	int result = 1;
+	size_t i;
+	size_t n = 0;
+	uint64_t t;
+	struct message_reader_t * reader;
+	struct proc_metrics_t * metrics;
+
+	i = proc - proc_cfg;
+	reader = &hub_procs[i].reader;
+	metrics = &hub_procs[i].metrics;
+
+	while (n < max) {
+		rc = message_reader_next(reader, &batch[n]);
+		if (rc > 0) {
+			++n;
+			continue;
+		}
+		if (rc < 0)
+			continue;
+
+		rc = message_reader_fill(reader, proc->rfd);
+		if (rc > 0) {
+			metrics->bytes_in += rc;
+			continue;
+		}
+		if (rc == 0) {
+			syslog(LOG_WARNING, "process '%s' has given up.", proc->cfg->name);
+			reactor_remove(reactor, proc->rfd);
+			proc_close_wait(proc);
+			result = -1;
+		} else {
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				syslog(LOG_CRIT, "error in read: %s", strerror(errno));
+			result = 0;
+		}
+		break;
+	}
+
+	*received = n;
+	metrics->msgs_in += n;
+	if ((i >= proc_cfg_base_src) && (i < proc_cfg_base_dst)) {
+		if (n > 0) {
+			t = metrics_now();
+			if (route_msg_batch(config, proc, batch, n) < 0) {
+				syslog(LOG_DEBUG, "route error: %lu messages from '%s'", (unsigned long)n, proc->cfg->name);
+				/* TODO: escalate error, terminate? */
+			}
+			histogram_add(&dispatch_time, metrics_now() - t);
+		}
+	} else if (n > 0) {
+		syslog(LOG_DEBUG, "messages from destinations not supported yet.");
+	}
+	return result;
+}
+
+/**
+ * Writes the statistics of the hub into the specified file. The
+ * statistics are written into a temporary file first, which then
+ * replaces the file, readers never see a partially written file.
+ *
+ * The file contains one line per source, destination, route and
+ * filter, followed by the histograms of the dispatch and filter
+ * execution times (in nsec):
+ * @code
+ * uptime 60
+ * source gps in=120 bytes_in=9600
+ * destination log out=120 bytes_out=9600 write_failures=0 queued=0 dropped=0 coalesced=0 blocked=0
+ * route gps --> log in=120 out=120 discarded=0 filter_failures=0 write_failures=0
+ * histogram dispatch count=120 ...
+ * @endcode
+ *
+ * @param[in] config The configuration.
+ * @param[in] filename The file to write.
+ * @param[in] start Start time of the hub, see metrics_now.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int write_stats(
+		const struct config_t * config,
+		const char * filename,
+		uint64_t start)
+{
+	size_t i;
+	FILE * file;
+	char tmp[PATH_MAX + 8];
+	const struct proc_config_t * proc;
+	const struct proc_metrics_t * metrics;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+	file = fopen(tmp, "w");
+	if (file == NULL) {
+		syslog(LOG_ERR, "unable to write statistics to '%s': %s", tmp, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	fprintf(file, "uptime %" PRIu64 "\n", (metrics_now() - start) / 1000000000);
+	for (i = 0; i < config->num_sources; ++i) {
+		proc = &proc_cfg[proc_cfg_base_src + i];
+		metrics = &hub_procs[proc_cfg_base_src + i].metrics;
+		fprintf(file, "source %s in=%" PRIu64 " bytes_in=%" PRIu64 "\n",
+			proc->cfg->name, metrics->msgs_in, metrics->bytes_in);
+	}
+	for (i = 0; i < config->num_destinations; ++i) {
+		proc = &proc_cfg[proc_cfg_base_dst + i];
+		metrics = &hub_procs[proc_cfg_base_dst + i].metrics;
+		fprintf(file, "destination %s out=%" PRIu64 " bytes_out=%" PRIu64 " write_failures=%" PRIu64,
+			proc->cfg->name, metrics->msgs_out, metrics->bytes_out, metrics->write_failures);
+		if (proc->queue) {
+			fprintf(file, " queued=%u dropped=%lu coalesced=%lu blocked=%lu",
+				proc->queue->count, proc->queue->dropped, proc->queue->coalesced,
+				proc->queue->blocked);
+		}
+		fprintf(file, "\n");
+	}
+	route_write_metrics(config, file);
+	histogram_write(file, "dispatch", &dispatch_time);
+
+	if (fclose(file) != 0) {
+		syslog(LOG_ERR, "unable to write statistics to '%s': %s", tmp, strerror(errno));
+		unlink(tmp);
+		return EXIT_FAILURE;
+	}
+	if (rename(tmp, filename) < 0) {
+		syslog(LOG_ERR, "unable to write statistics to '%s': %s", filename, strerror(errno));
+		unlink(tmp);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Sets up the timer to write the statistics periodically and registers
+ * it at the reactor.
+ *
+ * @param[inout] reactor The reactor to register the timer at.
+ * @param[in] interval Interval in seconds.
+ * @param[out] timer_fd The file descriptor of the timer.
+ * @retval EXIT_SUCCESS
+ * @retval EXIT_FAILURE
+ */
+static int setup_stats(struct reactor_t * reactor, unsigned int interval, int * timer_fd)
+{
+	struct itimerspec t;
+
+	*timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	if (*timer_fd < 0) {
+		syslog(LOG_ERR, "unable to create timer for statistics: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	t.it_interval.tv_sec = interval;
+	t.it_interval.tv_nsec = 0;
+	t.it_value = t.it_interval;
+	if (timerfd_settime(*timer_fd, 0, &t, NULL) < 0) {
+		syslog(LOG_ERR, "unable to set timer for statistics: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (reactor_add(reactor, *timer_fd, 0, &stats_timer) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "unable to register timer for statistics: %s", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 static int handle_common_options(int argc, char ** argv, struct options_data_t * option)
 {
 	if (parse_options(argc, argv, option) < 0)
@@ -425,16 +1086,22 @@ static int handle_common_options(int argc, char ** argv, struct options_data_t *
 	return EXIT_SUCCESS;
 }
 
-/* TODO: move filters to their own process like sources and destinations? */
 /* TODO: treat sources, filters and destinations the same (as their own processes), implicit routing through pipes */
 int main(int argc, char ** argv)
 {
 	size_t i;
 	int graceful_termination = 0;
-	struct message_t msg;
 	int rc;
-	fd_set rfds;
-	int fd_max;
+	struct reactor_t reactor;
+	void * ready[REACTOR_MAX_EVENTS];
+	int num_ready;
+	size_t num_pending;
+	size_t num_queued = 0;
+	int num_idle = 0;
+	struct message_t * batch;
+	int stats_fd = -1;
+	uint64_t start = metrics_now();
+	uint64_t expirations;
 	struct config_t config;
 	struct options_data_t option;
 
@@ -467,16 +1134,50 @@ int main(int argc, char ** argv)
 		return EXIT_SUCCESS;
 	}
 
+	/* cache of precompiled Lua scripts */
+	if (strlen(option.lua_cache) > 0) {
+#if defined(NEEDS_LUA)
+		if (luaH_set_cache_dir(option.lua_cache) != EXIT_SUCCESS) {
+			syslog(LOG_CRIT, "invalid directory for the Lua cache: '%s'", option.lua_cache);
+			config_free(&config);
+			return EXIT_FAILURE;
+		}
+#else
+		syslog(LOG_WARNING, "Lua not available, option lua-cache ignored");
+#endif
+	}
+
+	/* precompile Lua scripts */
+	if (option.precompile) {
+#if defined(NEEDS_LUA)
+		rc = precompile_scripts(&config);
+#else
+		syslog(LOG_ERR, "Lua not available, nothing to precompile");
+		rc = EXIT_FAILURE;
+#endif
+		config_free(&config);
+		return rc;
+	}
+
 	/* daemonize process */
 	if (option.daemonize)
 		daemonize();
 
+	/* setup trace buffer, shared with all procs */
+	if (option.trace) {
+#if !defined(ENABLE_TRACE)
+		syslog(LOG_WARNING, "trace not available, disabled at compile time");
+#endif
+		if (trace_init(option.trace, TRACE_SIZE_DEFAULT) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+
 	/* setup subprocesses */
-	if (setup_subprocesses(&config) != EXIT_SUCCESS)
+	if (setup_subprocesses(&config, option.threads) != EXIT_SUCCESS)
 		return EXIT_FAILURE;
 
 	/* setup routes */
-	if (setup_routes(&config) != EXIT_SUCCESS)
+	if (setup_routes(&config, option.filter_workers) != EXIT_SUCCESS)
 		return EXIT_FAILURE;
 
 	/* setup signal handling */
@@ -484,87 +1185,112 @@ int main(int argc, char ** argv)
 	if (setup_signal_handling(&signal_mask, &signal_fd) != EXIT_SUCCESS)
 		return EXIT_FAILURE;
 
+	/* setup reactor */
+	if (setup_reactor(&reactor, &config, signal_fd) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	/* setup statistics */
+	histogram_init(&dispatch_time);
+	if (option.stats && (setup_stats(&reactor, option.stats_interval, &stats_fd) != EXIT_SUCCESS))
+		return EXIT_FAILURE;
+
 	/* main / hub process */
+	batch = malloc(sizeof(struct message_t) * option.batch);
+	if (batch == NULL) {
+		syslog(LOG_CRIT, "unable to allocate batch of %lu messages", (unsigned long)option.batch);
+		return EXIT_FAILURE;
+	}
 	while (!graceful_termination) {
-		FD_ZERO(&rfds);
-		fd_max = 0;
-		for (i = 0; i < config.num_sources + config.num_destinations; ++i) {
-			int fd = proc_cfg[i].rfd;
-			if (fd <= 0)
-				continue;
-			FD_SET(fd, &rfds);
-			if (fd > fd_max)
-				fd_max = fd;
-		}
-		FD_SET(signal_fd, &rfds);
-		if (signal_fd > fd_max)
-			fd_max = signal_fd;
-
-		rc = select(fd_max + 1, &rfds, NULL, NULL, NULL);
+		rc = reactor_wait(&reactor, ready, REACTOR_MAX_EVENTS,
+			((num_pending_procs > 0) || (num_idle > 0)) ? 0 : (num_queued > 0) ? FLUSH_INTERVAL : -1);
 		if (rc < 0 && errno != EINTR) {
-			syslog(LOG_CRIT, "error in select: %s", strerror(errno));
+			syslog(LOG_CRIT, "error in reactor: %s", strerror(errno));
 			return EXIT_FAILURE;
-		} else if (rc == 0) {
+		} else if (rc < 0) {
 			continue;
 		}
+		num_ready = rc;
+		TRACE(TRACE_HUB, "ready: %d, pending: %lu, queued: %lu", num_ready,
+			(unsigned long)num_pending_procs, (unsigned long)num_queued);
+
+		for (i = 0; i < (size_t)num_ready; ++i) {
+			struct proc_config_t * proc = ready[i];
+
+			if (proc == NULL) {
+				rc = read(signal_fd, &signal_info, sizeof(signal_info));
+				if (rc < 0 || rc != sizeof(signal_info)) {
+					syslog(LOG_ERR, "cannot read singal info");
+					return EXIT_FAILURE;
+				}
 
-		if (FD_ISSET(signal_fd, &rfds)) {
-			rc = read(signal_fd, &signal_info, sizeof(signal_info));
-			if (rc < 0 || rc != sizeof(signal_info)) {
-				syslog(LOG_ERR, "cannot read singal info");
-				return EXIT_FAILURE;
+				if (signal_info.ssi_signo == SIGTERM)
+					graceful_termination = 1;
+				if (signal_info.ssi_signo == SIGINT)
+					graceful_termination = 1;
+				if (signal_info.ssi_signo == SIGUSR1)
+					trace_dump(NULL);
+				if (signal_info.ssi_signo == SIGHUP)
+					send_reopen(&config);
+				continue;
 			}
 
-			if (signal_info.ssi_signo == SIGTERM)
-				break;
-			if (signal_info.ssi_signo == SIGINT)
-				break;
-		}
-
-		for (i = 0; i < config.num_sources + config.num_destinations; ++i) {
-			int fd = proc_cfg[i].rfd;
-			if (fd <= 0)
-				continue;
-			if (!FD_ISSET(fd, &rfds))
+			if (ready[i] == &filter_results) {
+				if (route_collect(&config) < 0)
+					syslog(LOG_DEBUG, "route error of filter results");
 				continue;
+			}
 
-			rc = read(fd, &msg, sizeof(msg));
-			if (rc < 0) {
-				syslog(LOG_CRIT, "error in read: %s", strerror(errno));
+			if (ready[i] == &stats_timer) {
+				if (read(stats_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+					syslog(LOG_ERR, "unable to read timer: %s", strerror(errno));
+				write_stats(&config, option.stats_filename, start);
 				continue;
 			}
-			if (rc == 0) {
-				syslog(LOG_WARNING, "process '%s' has given up.", proc_cfg[i].cfg->name);
-				proc_close_wait(&proc_cfg[i]);
-				graceful_termination = 1;
-				break;
-			}
-			if (rc != (int)sizeof(msg)) {
-				syslog(LOG_ERR, "cannot read message, rc=%d", rc);
-				return EXIT_FAILURE;
-			}
 
-			if ((i >= proc_cfg_base_src) && (i < proc_cfg_base_dst)) {
-				if (route_msg(&config, &proc_cfg[i], &msg) < 0) {
-					syslog(LOG_DEBUG, "route error: type=%08x", msg.type);
-					/* TODO: escalate error, terminate? */
-				}
-			} else {
-				syslog(LOG_DEBUG, "messages from destinations not supported yet.");
-			}
+			mark_pending(proc);
 		}
 
-		/* terminate after max_msg */
-		if (option.max_msg > 0) {
-			--option.max_msg;
-			if (option.max_msg == 0) {
-				break;
+		/* serve all procs with pending messages, one batch each */
+		num_pending = num_pending_procs;
+		num_pending_procs = 0;
+		for (i = 0; i < num_pending && !graceful_termination; ++i) {
+			struct proc_config_t * proc = pending_procs[i];
+			size_t max = option.batch;
+			size_t received = 0;
+
+			if ((option.max_msg > 0) && (option.max_msg < max))
+				max = option.max_msg;
+
+			hub_procs[proc - proc_cfg].pending = 0;
+			rc = drain_proc(&config, &reactor, proc, batch, max, &received);
+			if (rc < 0)
+				graceful_termination = 1;
+			else if (rc > 0)
+				mark_pending(proc);
+
+			/* terminate after max_msg */
+			if (option.max_msg > 0) {
+				option.max_msg -= received;
+				if (option.max_msg == 0)
+					graceful_termination = 1;
 			}
 		}
+
+		num_queued = flush_destinations(&config);
+
+		/* let filters work in small portions while idle, checking for messages in between */
+		num_idle = (num_pending_procs == 0) ? route_idle(&config) : 0;
 	}
 
+	free(batch);
+	if (option.stats) {
+		write_stats(&config, option.stats_filename, start);
+		close(stats_fd);
+	}
+	reactor_exit(&reactor);
 	close(signal_fd);
 	terminate_graceful(&config);
+	trace_exit();
 
 	return EXIT_SUCCESS;
 }
@@ -22,29 +22,64 @@
 #include <nmea/nmea_sentence_iivlw.h>
 #include <nmea/nmea_sentence_iivhw.h>
 
-static const struct nmea_sentence_t * SENTENCES[] = {
-	&sentence_gprmb,
-	&sentence_gprmc,
-	&sentence_gpgga,
-	&sentence_gpgsv,
-	&sentence_gpgsa,
-	&sentence_gpgll,
-	&sentence_gpbod,
-	&sentence_gpvtg,
-	&sentence_gprte,
-	&sentence_pgrme,
-	&sentence_pgrmm,
-	&sentence_pgrmz,
-	&sentence_hchdg,
-	&sentence_iimtw,
-	&sentence_iimwv,
-	&sentence_iivwr,
-	&sentence_iivwt,
-	&sentence_iidbt,
-	&sentence_iivlw,
-	&sentence_iivhw,
+#define SENTENCE_TAG(a, b, c, d, e, sentence) [NMEA_TAG_HASH(a, b, c, d, e)] = &sentence
+#define SENTENCE_TYPE(t, sentence) [NMEA_TYPE_INDEX(t)] = &sentence
+
+/**
+ * All known sentences, indexed by tag and type. The table is set
+ * up at compile time, a collision of tags or types results in a
+ * warning about overridden initializers.
+ */
+static const struct nmea_sentence_tab_t SENTENCES = {
+	.tag = {
+		SENTENCE_TAG('G','P','R','M','B', sentence_gprmb),
+		SENTENCE_TAG('G','P','R','M','C', sentence_gprmc),
+		SENTENCE_TAG('G','P','G','G','A', sentence_gpgga),
+		SENTENCE_TAG('G','P','G','S','V', sentence_gpgsv),
+		SENTENCE_TAG('G','P','G','S','A', sentence_gpgsa),
+		SENTENCE_TAG('G','P','G','L','L', sentence_gpgll),
+		SENTENCE_TAG('G','P','B','O','D', sentence_gpbod),
+		SENTENCE_TAG('G','P','V','T','G', sentence_gpvtg),
+		SENTENCE_TAG('G','P','R','T','E', sentence_gprte),
+		SENTENCE_TAG('P','G','R','M','E', sentence_pgrme),
+		SENTENCE_TAG('P','G','R','M','M', sentence_pgrmm),
+		SENTENCE_TAG('P','G','R','M','Z', sentence_pgrmz),
+		SENTENCE_TAG('H','C','H','D','G', sentence_hchdg),
+		SENTENCE_TAG('I','I','M','T','W', sentence_iimtw),
+		SENTENCE_TAG('I','I','M','W','V', sentence_iimwv),
+		SENTENCE_TAG('I','I','V','W','R', sentence_iivwr),
+		SENTENCE_TAG('I','I','V','W','T', sentence_iivwt),
+		SENTENCE_TAG('I','I','D','B','T', sentence_iidbt),
+		SENTENCE_TAG('I','I','V','L','W', sentence_iivlw),
+		SENTENCE_TAG('I','I','V','H','W', sentence_iivhw),
+	},
+	.type = {
+		SENTENCE_TYPE(NMEA_RMB, sentence_gprmb),
+		SENTENCE_TYPE(NMEA_RMC, sentence_gprmc),
+		SENTENCE_TYPE(NMEA_GGA, sentence_gpgga),
+		SENTENCE_TYPE(NMEA_GSV, sentence_gpgsv),
+		SENTENCE_TYPE(NMEA_GSA, sentence_gpgsa),
+		SENTENCE_TYPE(NMEA_GLL, sentence_gpgll),
+		SENTENCE_TYPE(NMEA_BOD, sentence_gpbod),
+		SENTENCE_TYPE(NMEA_VTG, sentence_gpvtg),
+		SENTENCE_TYPE(NMEA_RTE, sentence_gprte),
+		SENTENCE_TYPE(NMEA_GARMIN_RME, sentence_pgrme),
+		SENTENCE_TYPE(NMEA_GARMIN_RMM, sentence_pgrmm),
+		SENTENCE_TYPE(NMEA_GARMIN_RMZ, sentence_pgrmz),
+		SENTENCE_TYPE(NMEA_HC_HDG, sentence_hchdg),
+		SENTENCE_TYPE(NMEA_II_MTW, sentence_iimtw),
+		SENTENCE_TYPE(NMEA_II_MWV, sentence_iimwv),
+		SENTENCE_TYPE(NMEA_II_VWR, sentence_iivwr),
+		SENTENCE_TYPE(NMEA_II_VWT, sentence_iivwt),
+		SENTENCE_TYPE(NMEA_II_DBT, sentence_iidbt),
+		SENTENCE_TYPE(NMEA_II_VLW, sentence_iivlw),
+		SENTENCE_TYPE(NMEA_II_VHW, sentence_iivhw),
+	},
 };
 
+#undef SENTENCE_TAG
+#undef SENTENCE_TYPE
+
 /**
  * Reads all known NMEA sentences.
  *
@@ -62,7 +97,7 @@ int nmea_read(struct nmea_t * nmea, const char * s)
 	return nmea_read_tab(
 		nmea,
 		s,
-		SENTENCES, sizeof(SENTENCES)/sizeof(struct nmea_sentence_t *));
+		&SENTENCES);
 }
 
 /**
@@ -75,7 +110,6 @@ int nmea_read(struct nmea_t * nmea, const char * s)
  * @retval >= 0 Success, number of bytes written to buffer.
  * @retval -1 Invalid parameters.
  * @retval -2 Unknown NMEA sentence.
- * @retval -3 Sentence does not support writing.
  */
 int nmea_write(char * buf, uint32_t size, const struct nmea_t * nmea)
 {
@@ -89,7 +123,7 @@ int nmea_write(char * buf, uint32_t size, const struct nmea_t * nmea)
 		buf,
 		size,
 		nmea,
-		SENTENCES, sizeof(SENTENCES)/sizeof(struct nmea_sentence_t *));
+		&SENTENCES);
 }
 
 /**
@@ -99,7 +133,6 @@ int nmea_write(char * buf, uint32_t size, const struct nmea_t * nmea)
  * @retval  0 success
  * @retval -1 parameter faile
  * @retval -2 NMEA sentence not supported
- * @retval -3 conversion not supported
  */
 int nmea_hton(struct nmea_t * nmea)
 {
@@ -107,7 +140,7 @@ int nmea_hton(struct nmea_t * nmea)
 		return -1;
 	return nmea_hton_tab(
 		nmea,
-		SENTENCES, sizeof(SENTENCES)/sizeof(struct nmea_sentence_t *));
+		&SENTENCES);
 }
 
 /**
@@ -117,7 +150,6 @@ int nmea_hton(struct nmea_t * nmea)
  * @retval  0 success
  * @retval -1 parameter faile
  * @retval -2 NMEA sentence not supported
- * @retval -3 conversion not supported
  */
 int nmea_ntoh(struct nmea_t * nmea)
 {
@@ -125,7 +157,7 @@ int nmea_ntoh(struct nmea_t * nmea)
 		return -1;
 	return nmea_ntoh_tab(
 		nmea,
-		SENTENCES, sizeof(SENTENCES)/sizeof(struct nmea_sentence_t *));
+		&SENTENCES);
 }
 
 /**
@@ -138,13 +170,6 @@ int nmea_ntoh(struct nmea_t * nmea)
  */
 const struct nmea_sentence_t * nmea_sentence(uint32_t type)
 {
-	size_t i;
-
-	for (i = 0; i < sizeof(SENTENCES)/sizeof(struct nmea_sentence_t *); ++i) {
-		if (type == SENTENCES[i]->type) {
-			return SENTENCES[i];
-		}
-	}
-	return NULL;
+	return nmea_sentence_tab_type(&SENTENCES, type);
 }
 
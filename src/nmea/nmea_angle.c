@@ -1,6 +1,7 @@
 #include <nmea/nmea_angle.h>
+#include <nmea/nmea_int.h>
 #include <common/endian.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <math.h>
 
 /**
@@ -118,8 +119,13 @@ int nmea_write_latitude(char * buf, uint32_t size, const struct nmea_angle_t * v
 	if (nmea_check_latitude(v))
 		return -1;
 
-	/* division by 100 is to achieve 4 decimal digits, maybe it would be better to use write_fix() */
-	return snprintf(buf, size, "%02u%02u.%04u", v->d, v->m, (v->s.i * NMEA_FIX_DECIMALS + v->s.d) / 60 / 100);
+	/* division by 100 is to achieve 4 decimal digits */
+	nmea_uint_write(buf, 2, v->d, 2, '0');
+	nmea_uint_write(buf + 2, 2, v->m, 2, '0');
+	buf[4] = '.';
+	nmea_uint_write(buf + 5, 4, (v->s.i * NMEA_FIX_DECIMALS + v->s.d) / 60 / 100, 4, '0');
+	if (size > 9) buf[9] = '\0';
+	return 9;
 }
 
 /**
@@ -143,8 +149,13 @@ int nmea_write_lonitude(char * buf, uint32_t size, const struct nmea_angle_t * v
 	if (nmea_check_longitude(v))
 		return -1;
 
-	/* division by 100 is to achieve 4 decimal digits, maybe it would be better to use write_fix() */
-	return snprintf(buf, size, "%03u%02u.%04u", v->d, v->m, (v->s.i * NMEA_FIX_DECIMALS + v->s.d) / 60 / 100);
+	/* division by 100 is to achieve 4 decimal digits */
+	nmea_uint_write(buf, 3, v->d, 3, '0');
+	nmea_uint_write(buf + 3, 2, v->m, 2, '0');
+	buf[5] = '.';
+	nmea_uint_write(buf + 6, 4, (v->s.i * NMEA_FIX_DECIMALS + v->s.d) / 60 / 100, 4, '0');
+	if (size > 10) buf[10] = '\0';
+	return 10;
 }
 
 /**
@@ -194,6 +205,27 @@ int nmea_angle_to_double(double * v, const struct nmea_angle_t * angle)
 	return 0;
 }
 
+/**
+ * Converts an angle to micro degrees, without floating point operations.
+ *
+ * @param[out] v converted number, in units of 1e-6 degrees
+ * @param[in] angle the angle to convert
+ * @retval  0 success
+ * @retval -1 failure
+ */
+int nmea_angle_to_microdeg(uint32_t * v, const struct nmea_angle_t * angle)
+{
+	uint64_t sec;
+
+	if (!v || !angle)
+		return -1;
+
+	/* minutes and seconds in units of 1e-6 seconds, rounded to 1e-6 degrees */
+	sec = ((uint64_t)angle->m * 60 + angle->s.i) * NMEA_FIX_DECIMALS + angle->s.d;
+	*v = angle->d * 1000000u + (uint32_t)((sec + 1800) / 3600);
+	return 0;
+}
+
 /**
  * Converts the double to angle.
  *
@@ -26,6 +26,7 @@ void nmea_angle_hton(struct nmea_angle_t * v);
 void nmea_angle_ntoh(struct nmea_angle_t * v);
 
 int nmea_angle_to_double(double *, const struct nmea_angle_t *);
+int nmea_angle_to_microdeg(uint32_t *, const struct nmea_angle_t *);
 
 int nmea_double_to_angle(struct nmea_angle_t *, double);
 
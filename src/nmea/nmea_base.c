@@ -1,6 +1,7 @@
 #include <nmea/nmea_base.h>
 #include <nmea/nmea_util.h>
 #include <nmea/nmea_checksum.h>
+#include <nmea/nmea_schema.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -19,13 +20,53 @@ int nmea_init(struct nmea_t * nmea)
 	return 0;
 }
 
+/**
+ * Looks up the sentence with the specified tag.
+ *
+ * @param[in] tab Table of sentences.
+ * @param[in] s The tag, does not have to be zero terminated.
+ * @param[in] len Length of the tag.
+ * @retval NULL Unknown tag.
+ * @retval other The sentence.
+ */
+const struct nmea_sentence_t * nmea_sentence_tab_tag(
+		const struct nmea_sentence_tab_t * tab,
+		const char * s,
+		uint32_t len)
+{
+	const struct nmea_sentence_t * entry;
+
+	if (tab == NULL || s == NULL || len != NMEA_TAG_LEN)
+		return NULL;
+	entry = tab->tag[NMEA_TAG_HASH(s[0], s[1], s[2], s[3], s[4])];
+	if (entry == NULL || strncmp(s, entry->tag, NMEA_TAG_LEN) != 0)
+		return NULL;
+	return entry;
+}
+
+/**
+ * Looks up the sentence of the specified type.
+ *
+ * @param[in] tab Table of sentences.
+ * @param[in] type The sentence type.
+ * @retval NULL Unknown type.
+ * @retval other The sentence.
+ */
+const struct nmea_sentence_t * nmea_sentence_tab_type(
+		const struct nmea_sentence_tab_t * tab,
+		uint32_t type)
+{
+	if (tab == NULL || !NMEA_TYPE_VALID(type))
+		return NULL;
+	return tab->type[NMEA_TYPE_INDEX(type)];
+}
+
 /**
  * Reads all NMEA senteces defined in the specified table.
  *
  * @param[out] nmea data of the parsed structure
  * @param[in] s read sentence
  * @param[in] tab table of sentences to parse
- * @param[in] tab_size size of the table of sentences to parse
  * @retval  0 success
  * @retval -1 parameter error
  * @retval -2 nmea_checksum error
@@ -35,33 +76,27 @@ int nmea_init(struct nmea_t * nmea)
 int nmea_read_tab(
 		struct nmea_t * nmea,
 		const char * s,
-		const struct nmea_sentence_t ** tab,
-		uint32_t tab_size)
+		const struct nmea_sentence_tab_t * tab)
 {
-	const char * p = s;
+	struct nmea_fields_t f;
 	const struct nmea_sentence_t * entry = NULL;
-	uint32_t i;
 	int rc;
 
-	if (s == NULL || nmea == NULL || tab == NULL || tab_size == 0)
+	if (s == NULL || nmea == NULL || tab == NULL)
 		return -1;
-	if (nmea_checksum_check(s, START_TOKEN_NMEA))
-		return -2;
-	if (*s != START_TOKEN_NMEA)
-		return -3;
-	p = find_token_end(s+1);
-	for (i = 0; i < tab_size; ++i) {
-		entry = tab[i];
-		if (entry->read && strncmp(s+1, entry->tag, p-s-1) == 0) {
-			nmea_init(nmea);
-			rc = entry->read(nmea, s+1, find_sentence_end(s+1));
-			if (rc >= 0) {
-				strncpy(nmea->raw, s, NMEA_MAX_SENTENCE);
-			}
-			return rc;
-		}
+	rc = nmea_tokenize(&f, s, START_TOKEN_NMEA);
+	if (rc < 0)
+		return rc;
+	entry = nmea_sentence_tab_tag(tab, NMEA_FIELD_BEGIN(&f, 0),
+		NMEA_FIELD_END(&f, 0) - NMEA_FIELD_BEGIN(&f, 0));
+	if (entry == NULL)
+		return -4;
+	nmea_init(nmea);
+	rc = nmea_schema_read(nmea, entry, &f);
+	if (rc >= 0) {
+		memcpy(nmea->raw, s, (f.len < NMEA_MAX_SENTENCE) ? f.len : NMEA_MAX_SENTENCE);
 	}
-	return -4;
+	return rc;
 }
 
 /**
@@ -73,29 +108,18 @@ int nmea_read_tab(
  * @param[in] size Size of the buffer to hold the data.
  * @param[in] nmea The NMEA data.
  * @param[in] tab Table containing all known or valid NMEA sentences.
- * @param[in] tab_size The size of the sentence table.
  * @retval >= 0 Success, number of bytes written to buffer.
  * @retval -1 Invalid parameters.
  * @retval -2 Unknown NMEA sentence.
- * @retval -3 Sentence does not support writing.
  */
-int nmea_write_tab(char * buf, uint32_t size, const struct nmea_t * nmea, const struct nmea_sentence_t ** tab, uint32_t tab_size)
+int nmea_write_tab(char * buf, uint32_t size, const struct nmea_t * nmea, const struct nmea_sentence_tab_t * tab)
 {
 	const struct nmea_sentence_t * entry;
-	uint32_t i;
-
-	if (buf == NULL || size == 0 || nmea == NULL || tab == NULL || tab_size == 0) return -1;
-	for (i = 0; i < tab_size; ++i) {
-		entry = tab[i];
-		if (entry->type == nmea->type) {
-			if (!entry->write) {
-				return -3;
-			}
-			return entry->write(buf, size, nmea);
-		}
-	}
 
-	return -2;
+	if (buf == NULL || size == 0 || nmea == NULL || tab == NULL) return -1;
+	entry = nmea_sentence_tab_type(tab, nmea->type);
+	if (entry == NULL) return -2;
+	return nmea_schema_write(buf, size, nmea, entry);
 }
 
 /**
@@ -124,27 +148,19 @@ int nmea_write_raw(char * buf, uint32_t size, const struct nmea_t * nmea)
  *
  * @param[inout] nmea The data to convert.
  * @param[in] tab Table containing all known or valid NMEA sentences.
- * @param[in] tab_size The size of the sentence table.
  * @retval  0 success
  * @retval -1 parameter failure
  * @retval -2 NMEA sentence not supported
- * @retval -3 conversion not supported
  */
-int nmea_hton_tab(struct nmea_t * nmea, const struct nmea_sentence_t ** tab, uint32_t tab_size)
+int nmea_hton_tab(struct nmea_t * nmea, const struct nmea_sentence_tab_t * tab)
 {
-	uint32_t i;
 	const struct nmea_sentence_t * entry;
 
-	if (nmea == NULL || tab == NULL || tab_size == 0) return -1;
-	for (i = 0; i < tab_size; ++i) {
-		entry = tab[i];
-		if (entry->type == nmea->type) {
-			if (entry->hton == NULL) return -3;
-			entry->hton(nmea);
-			return 0;
-		}
-	}
-	return -2;
+	if (nmea == NULL || tab == NULL) return -1;
+	entry = nmea_sentence_tab_type(tab, nmea->type);
+	if (entry == NULL) return -2;
+	nmea_schema_hton(nmea, entry);
+	return 0;
 }
 
 /**
@@ -152,26 +168,18 @@ int nmea_hton_tab(struct nmea_t * nmea, const struct nmea_sentence_t ** tab, uin
  *
  * @param[inout] nmea The data to convert.
  * @param[in] tab Table containing all known or valid NMEA sentences.
- * @param[in] tab_size The size of the sentence table.
  * @retval  0 success
  * @retval -1 parameter failure
  * @retval -2 NMEA sentence not supported
- * @retval -3 conversion not supported
  */
-int nmea_ntoh_tab(struct nmea_t * nmea, const struct nmea_sentence_t ** tab, uint32_t tab_size)
+int nmea_ntoh_tab(struct nmea_t * nmea, const struct nmea_sentence_tab_t * tab)
 {
-	uint32_t i;
 	const struct nmea_sentence_t * entry;
 
-	if (nmea == NULL || tab == NULL || tab_size == 0) return -1;
-	for (i = 0; i < tab_size; ++i) {
-		entry = tab[i];
-		if (entry->type == nmea->type) {
-			if (entry->ntoh == NULL) return -3;
-			entry->ntoh(nmea);
-			return 0;
-		}
-	}
-	return -2;
+	if (nmea == NULL || tab == NULL) return -1;
+	entry = nmea_sentence_tab_type(tab, nmea->type);
+	if (entry == NULL) return -2;
+	nmea_schema_ntoh(nmea, entry);
+	return 0;
 }
 
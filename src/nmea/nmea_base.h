@@ -40,26 +40,76 @@ struct nmea_t {
 	} sentence;
 } __attribute((packed));
 
+struct nmea_field_t;
+
 /**
  * Base structure for all implmentations of NMEA sentences.
+ *
+ * Sentences are described by their fields (see nmea_schema.h), they
+ * are read, written and converted by the generic implementation.
  */
 struct nmea_sentence_t {
 	const uint32_t type;
 	const char * tag;
-	int (*read)(struct nmea_t *, const char *, const char *);
-	int (*write)(char *, uint32_t, const struct nmea_t *);
-	void (*hton)(struct nmea_t *);
-	void (*ntoh)(struct nmea_t *);
+	const struct nmea_field_t * fields;
+	uint32_t num_fields;
+};
+
+/**
+ * Number of characters of a sentence tag (talker and sentence).
+ */
+#define NMEA_TAG_LEN 5
+
+/**
+ * Perfect hash over the five characters of a sentence tag, used as index
+ * into the tag table of struct nmea_sentence_tab_t. The multiplier is
+ * chosen to be collision free for all known tags, it has to be adjusted
+ * if a new tag collides (the compiler warns about overridden initializers
+ * of the sentence table in this case).
+ */
+#define NMEA_TAG_HASH_BITS 7
+#define NMEA_TAG_HASH_SIZE (1 << NMEA_TAG_HASH_BITS)
+#define NMEA_TAG_HASH_MUL 0x552b82f7u
+#define NMEA_TAG_KEY(a, b, c, d, e) \
+	( (((uint32_t)(a) & 0x1f) << 20) \
+	| (((uint32_t)(b) & 0x1f) << 15) \
+	| (((uint32_t)(c) & 0x1f) << 10) \
+	| (((uint32_t)(d) & 0x1f) <<  5) \
+	| (((uint32_t)(e) & 0x1f) <<  0))
+#define NMEA_TAG_HASH(a, b, c, d, e) \
+	((uint32_t)(NMEA_TAG_KEY(a, b, c, d, e) * NMEA_TAG_HASH_MUL) >> (32 - NMEA_TAG_HASH_BITS))
+
+/**
+ * Direct index of sentence types into the type table of struct nmea_sentence_tab_t.
+ * Sentence types are organized in groups (bits 12..15), each group contains
+ * up to 32 types (bits 0..4).
+ */
+#define NMEA_TYPE_GROUP_BITS 5
+#define NMEA_TYPE_INDEX_SIZE (16 << NMEA_TYPE_GROUP_BITS)
+#define NMEA_TYPE_VALID(t) \
+	(((t) & ~(0xf000u | ((1u << NMEA_TYPE_GROUP_BITS) - 1))) == 0)
+#define NMEA_TYPE_INDEX(t) \
+	(((((t) >> 12) & 0xf) << NMEA_TYPE_GROUP_BITS) | ((t) & ((1u << NMEA_TYPE_GROUP_BITS) - 1)))
+
+/**
+ * Table of sentences, indexed by tag hash and by type.
+ */
+struct nmea_sentence_tab_t {
+	const struct nmea_sentence_t * tag[NMEA_TAG_HASH_SIZE];
+	const struct nmea_sentence_t * type[NMEA_TYPE_INDEX_SIZE];
 };
 
 int nmea_init(struct nmea_t *);
 
-int nmea_read_tab(struct nmea_t *, const char *, const struct nmea_sentence_t **, uint32_t);
+const struct nmea_sentence_t * nmea_sentence_tab_tag(const struct nmea_sentence_tab_t *, const char *, uint32_t);
+const struct nmea_sentence_t * nmea_sentence_tab_type(const struct nmea_sentence_tab_t *, uint32_t);
+
+int nmea_read_tab(struct nmea_t *, const char *, const struct nmea_sentence_tab_t *);
 
-int nmea_write_tab(char *, uint32_t, const struct nmea_t *, const struct nmea_sentence_t **, uint32_t);
+int nmea_write_tab(char *, uint32_t, const struct nmea_t *, const struct nmea_sentence_tab_t *);
 int nmea_write_raw(char *, uint32_t, const struct nmea_t *);
 
-int nmea_hton_tab(struct nmea_t *, const struct nmea_sentence_t **, uint32_t);
-int nmea_ntoh_tab(struct nmea_t *, const struct nmea_sentence_t **, uint32_t);
+int nmea_hton_tab(struct nmea_t *, const struct nmea_sentence_tab_t *);
+int nmea_ntoh_tab(struct nmea_t *, const struct nmea_sentence_tab_t *);
 
 #endif
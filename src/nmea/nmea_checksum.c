@@ -1,5 +1,6 @@
 #include <nmea/nmea_checksum.h>
-#include <stdio.h>
+#include <nmea/nmea_scan.h>
+#include <string.h>
 
 /**
  * Converts the specified hexadecimal character to its numerical representation.
@@ -37,7 +38,8 @@ uint8_t nmea_checksum(const char * s, const char * e)
 }
 
 /**
- * Checks the nmea_checksum of the sentence.
+ * Checks the nmea_checksum of the sentence. Sentences longer than
+ * NMEA_SCAN_MAX characters are not accepted.
  *
  * @param[in] s sentence to check
  * @param[in] start_token The start token to check.
@@ -46,14 +48,17 @@ uint8_t nmea_checksum(const char * s, const char * e)
  */
 int nmea_checksum_check(const char * s, char start_token)
 {
-	uint8_t chk = 0;
+	struct nmea_scan_t scan;
+	uint32_t len;
+
 	if (!s || !(*s) || *s != start_token) return -1;
 	++s; /* skip start token */
-	for (; *s && *s != '*'; ++s) {
-		chk ^= *s;
-	}
-	++s; /* skip '*' */
-	return chk == hex2i(s[0]) * 16 + hex2i(s[1]) ? 0 : -1;
+	len = strnlen(s, NMEA_SCAN_MAX);
+	if (nmea_scan(&scan, s, len) < 0) return -1;
+	if (scan.end >= len) return -1;
+	s += scan.end + 1; /* skip '*' */
+	if (!s[0]) return -1;
+	return scan.checksum == hex2i(s[0]) * 16 + hex2i(s[1]) ? 0 : -1;
 }
 
 /**
@@ -71,14 +76,13 @@ int nmea_checksum_check(const char * s, char start_token)
 int nmea_checksum_write(char * buf, uint32_t size, const char * s, const char * e)
 {
 	uint8_t sum;
-	char str[3];
 
 	if (buf == NULL || size == 0 || s == NULL || e == NULL) return -1;
 	if (size < 3) return -1;
 	sum = nmea_checksum(s, e);
-	str[0] = i2hex((sum >> 4) & 0x0f);
-	str[1] = i2hex((sum >> 0) & 0x0f);
-	str[2] = '\0';
-	return snprintf(buf, size, "%s", str);
+	buf[0] = i2hex((sum >> 4) & 0x0f);
+	buf[1] = i2hex((sum >> 0) & 0x0f);
+	buf[2] = '\0';
+	return 2;
 }
 
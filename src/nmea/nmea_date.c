@@ -1,7 +1,7 @@
 #include <nmea/nmea_date.h>
 #include <nmea/nmea_int.h>
 #include <common/endian.h>
-#include <stdio.h>
+#include <stddef.h>
 
 /**
  * Checks whether all members of the date information are zero.
@@ -93,7 +93,11 @@ int nmea_date_write(char * buf, uint32_t size, const struct nmea_date_t * v)
 	if (buf == NULL || size == 0 || v == NULL) return -1;
 	if (size < 6) return -1;
 	if (nmea_date_check(v)) return -2;
-	return snprintf(buf, size, "%02u%02u%02u", v->d, v->m, v->y % 100);
+	nmea_uint_write(buf + 0, 2, v->d, 2, '0');
+	nmea_uint_write(buf + 2, 2, v->m, 2, '0');
+	nmea_uint_write(buf + 4, 2, v->y % 100, 2, '0');
+	if (size > 6) buf[6] = '\0';
+	return 6;
 }
 
 /**
@@ -98,6 +98,7 @@ struct nmea_rmb_t {
 	struct nmea_fix_t bearing; /* bearing to destination in degrees to true */
 	struct nmea_fix_t dst_velocity; /* destination closing velocity in knots */
 	char arrival_status; /* arrival status, A:arrival circle entered */
+	char sig_integrity; /* signal integrity mode (NMEA 2.3), see RMC, zero if not available */
 } __attribute__((packed));
 
 /**
@@ -156,6 +157,7 @@ struct nmea_gsa_t {
 struct nmea_gsv_t {
 	uint32_t n_messages;
 	uint32_t message_number;
+	uint32_t n_satelites; /* number of satelites in view */
 	struct nmea_satelite_t sat[4]; /* max satelites per message */
 } __attribute__((packed));
 
@@ -169,6 +171,7 @@ struct nmea_gll_t {
 	char lon_dir;
 	struct nmea_time_t time; /* utc */
 	char status;
+	char sig_integrity; /* signal integrity mode (NMEA 2.3), see RMC, zero if not available */
 } __attribute__((packed));
 
 /**
@@ -193,6 +196,7 @@ struct nmea_vtg_t {
 	char unit_speed_kn; /* N:knots */
 	struct nmea_fix_t speed_kmh;
 	char unit_speed_kmh; /* K:kilometers per hour */
+	char sig_integrity; /* signal integrity mode (NMEA 2.3), see RMC, zero if not available */
 } __attribute__((packed));
 
 /**
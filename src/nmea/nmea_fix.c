@@ -1,7 +1,7 @@
 #include <nmea/nmea_fix.h>
+#include <nmea/nmea_int.h>
 #include <common/endian.h>
-#include <stdio.h>
-#include <ctype.h>
+#include <stddef.h>
 #include <math.h>
 
 /**
@@ -37,64 +37,77 @@ int nmea_fix_check_zero(const struct nmea_fix_t * v)
  */
 const char * nmea_fix_parse(const char * s, const char * e, struct nmea_fix_t * v)
 {
-	uint32_t f = NMEA_FIX_DECIMALS;
-	int state = 0;
+	const char * p;
+	const char * end;
+	uint32_t n;
 
 	if (s == NULL || e == NULL || v == NULL)
 		return NULL;
 	v->i = 0;
 	v->d = 0;
-	for (; *s && s < e && f > 0; ++s) {
-		switch (state) {
-			case 0:
-				if (*s == '.') {
-					state = 1;
-				} else if (isdigit((int)*s)) {
-					v->i *= 10;
-					v->i += *s - '0';
-				} else return s;
-				break;
-			case 1:
-				if (!isdigit((int)*s)) return s;
-				f /= 10;
-				v->d += f * (*s - '0');
-				break;
-		}
+
+	s = parse_int(s, e, &v->i);
+	if (s >= e || *s == '\0')
+		return e;
+	if (*s != '.')
+		return s;
+
+	/* decimal part, one digit more than NMEA_FIX_DECIMAL_DIGITS is accepted
+	 * without contributing, all characters after it are ignored */
+	++s;
+	end = (e - s > NMEA_FIX_DECIMAL_DIGITS + 1) ? s + NMEA_FIX_DECIMAL_DIGITS + 1 : e;
+	p = parse_int(s, end, &v->d);
+	n = (uint32_t)(p - s);
+	if (n > NMEA_FIX_DECIMAL_DIGITS) {
+		v->d /= 10;
+	} else {
+		v->d *= nmea_digits_pow10(NMEA_FIX_DECIMAL_DIGITS - n);
 	}
-	return e;
+	if (p >= end || *p == '\0')
+		return e;
+	return p;
 }
 
 /**
- * Writes a fix number to the specified buffer.
+ * Writes a fix number to the specified buffer, without any format parsing.
+ * A terminating zero is added if there is room left in the buffer.
  *
  * @param[out] buf The buffer to hold the data.
  * @param[in] size Remaining space in bytes within the buffer.
  * @param[in] v The fixed size number to write into the buffer.
- * @param[in] ni Minimum number of integer digits to write number. Maximum will be NMEA_FIX_DECIMAL_DIGITS.
+ * @param[in] ni Minimum number of integer digits to write number, padded with spaces.
  *    If the integer part uses more digits than stated, more bytes will be written.
- *    More digits than NMEA_FIX_DECIMAL_DIGITS is not possible.
- * @param[in] nd Minimum number of decimal digits to write number. Maximum will be NMEA_FIX_DECIMAL_DIGITS.
- * @return The number of characters written into the buffer.
+ * @param[in] nd Number of decimal digits to write number. Maximum will be NMEA_FIX_DECIMAL_DIGITS.
+ *    If zero, only the integer part is written, without decimal point.
+ * @retval >= 0 The number of characters written into the buffer.
+ * @retval -1 Parameter error or buffer too small.
  */
 int nmea_fix_write(char * buf, uint32_t size, const struct nmea_fix_t * v, uint32_t ni, uint32_t nd)
 {
-	char fmt[16];
-	uint32_t d = 1;
-	uint32_t i;
+	int n;
+	int k;
 
 	if (buf == NULL || size == 0 || v == NULL)
 		return -1;
-	if (size < 13)
-		return -1;
-	if (nd > NMEA_FIX_DECIMAL_DIGITS) {
+	if (nd > NMEA_FIX_DECIMAL_DIGITS)
 		nd = NMEA_FIX_DECIMAL_DIGITS;
-	} else if (nd > 0) {
-		for (i = nd; i < NMEA_FIX_DECIMAL_DIGITS; ++i) {
-			d *= 10;
-		}
+
+	n = nmea_uint_write(buf, size, v->i, ni, ' ');
+	if (n < 0)
+		return -1;
+	if (nd > 0) {
+		if ((uint32_t)n + 1 + nd > size)
+			return -1;
+		buf[n++] = '.';
+		k = nmea_uint_write(buf + n, nd,
+			(v->d % NMEA_FIX_DECIMALS) / nmea_digits_pow10(NMEA_FIX_DECIMAL_DIGITS - nd), nd, '0');
+		if (k < 0)
+			return -1;
+		n += k;
 	}
-	snprintf(fmt, sizeof(fmt), "%%%uu.%%0%uu", ni, nd);
-	return snprintf(buf, size, fmt, v->i, v->d / d);
+	if ((uint32_t)n < size)
+		buf[n] = '\0';
+	return n;
 }
 
 /**
@@ -1,6 +1,88 @@
 #include <nmea/nmea_int.h>
 #include <stdio.h>
-#include <ctype.h>
+#include <string.h>
+
+#define ONES 0x0101010101010101ull
+
+static const uint32_t POW10[10] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/**
+ * All two digit numbers in ASCII, the number n at position 2*n.
+ */
+static const char DIGITS2[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/**
+ * Loads 8 characters into an integer, the first character in the
+ * least significant byte, independent of the byte order of the machine.
+ */
+static uint64_t load8(const char * s)
+{
+	uint64_t x;
+
+	memcpy(&x, s, sizeof(x));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	x = __builtin_bswap64(x);
+#endif
+	return x;
+}
+
+/**
+ * Returns the number of leading decimal digits of 8 characters,
+ * all of them are checked at once.
+ *
+ * @param[in] x The characters, loaded by load8, with '0' subtracted
+ *    from every character (XOR).
+ * @return number of leading decimal digits, 0..8
+ */
+static uint32_t digits_count8(uint64_t x)
+{
+	uint64_t m;
+
+	/* the high bit of a byte is set, if the character is not a digit,
+	   the addition does not carry into the next byte */
+	m = (((x & (ONES * 0x7f)) + (ONES * 0x76)) | x) & (ONES * 0x80);
+	return m ? (uint32_t)(__builtin_ctzll(m) / 8) : 8;
+}
+
+/**
+ * Returns the value of the leading decimal digits of 8 characters,
+ * all digits are converted at once.
+ *
+ * @param[in] x The characters, see digits_count8.
+ * @param[in] n Number of leading digits, 1..8
+ * @return the value of the digits
+ */
+static uint32_t digits_value8(uint64_t x, uint32_t n)
+{
+	/* drop the non digits, the value is aligned to the last byte */
+	x <<= 8 * (8 - n);
+	x = (x * 10 + (x >> 8)) & 0x00ff00ff00ff00ffull;
+	x = (x * 100 + (x >> 16)) & 0x0000ffff0000ffffull;
+	x = (x * 10000 + (x >> 32)) & 0x00000000ffffffffull;
+	return (uint32_t)x;
+}
+
+/**
+ * Returns the power of ten for the specified number of digits.
+ *
+ * @param[in] n number of digits, at most 8
+ */
+uint32_t nmea_digits_pow10(uint32_t n)
+{
+	return POW10[(n > 8) ? 8 : n];
+}
 
 /**
  * Parses an unsigned integer value from a specified string. The string
@@ -14,13 +96,85 @@
  */
 const char * parse_int(const char * s, const char * e, uint32_t * v)
 {
+	uint64_t x;
+	uint32_t n;
+	uint32_t d;
+
 	if (s == NULL || e == NULL || v == NULL) return NULL;
 	*v = 0;
-	for (; *s && s < e; ++s) {
-		if (!isdigit((int)*s)) return s;
-		*v *= 10;
-		*v += *s - '0';
+
+	/* chunks of 8 characters, as long as there are enough of them */
+	while (e - s >= 8) {
+		x = load8(s) ^ (ONES * '0');
+		n = digits_count8(x);
+		if (n == 0)
+			return s;
+		*v = *v * POW10[n] + digits_value8(x, n);
+		s += n;
+		if (n < 8)
+			return s;
+	}
+
+	for (; s < e; ++s) {
+		d = (uint8_t)(*s - '0');
+		if (d > 9) return s;
+		*v = *v * 10 + d;
 	}
 	return s;
 }
 
+/**
+ * Returns the number of decimal digits of the specified value,
+ * at least one.
+ *
+ * @param[in] v the value
+ * @return number of digits, 1..NMEA_UINT_MAX_DIGITS
+ */
+uint32_t nmea_uint_digits(uint32_t v)
+{
+	uint32_t n = 1;
+
+	while (n < NMEA_UINT_MAX_DIGITS && v >= POW10[n])
+		++n;
+	return n;
+}
+
+/**
+ * Writes an unsigned integer in decimal form into the buffer, two digits
+ * at a time and without any format parsing. The number is padded at the
+ * front to the specified width. No terminating zero is written.
+ *
+ * @param[out] buf The buffer to hold the data.
+ * @param[in] size Number of bytes free in buffer.
+ * @param[in] v The value to write.
+ * @param[in] width Minimum number of characters to write.
+ * @param[in] pad The character to pad the number with, usually '0' or ' '.
+ * @retval >= 0 Number of characters written into the buffer.
+ * @retval -1 Parameter error
+ * @retval -2 Buffer too small
+ */
+int nmea_uint_write(char * buf, uint32_t size, uint32_t v, uint32_t width, char pad)
+{
+	uint32_t n;
+	uint32_t len;
+	char * p;
+
+	if (buf == NULL) return -1;
+	n = nmea_uint_digits(v);
+	len = (width > n) ? width : n;
+	if (len > size) return -2;
+
+	memset(buf, pad, len - n);
+	p = buf + len;
+	for (; v >= 100; v /= 100) {
+		p -= 2;
+		memcpy(p, DIGITS2 + 2 * (v % 100), 2);
+	}
+	if (v >= 10) {
+		p -= 2;
+		memcpy(p, DIGITS2 + 2 * v, 2);
+	} else {
+		*--p = (char)('0' + v);
+	}
+	return (int)len;
+}
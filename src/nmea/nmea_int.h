@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 
+/**
+ * Maximum number of decimal digits of an unsigned 32 bit integer.
+ */
+#define NMEA_UINT_MAX_DIGITS 10
+
+uint32_t nmea_digits_pow10(uint32_t n);
+uint32_t nmea_uint_digits(uint32_t v);
+int nmea_uint_write(char * buf, uint32_t size, uint32_t v, uint32_t width, char pad);
+
 const char * parse_int(const char * s, const char * e, uint32_t * v);
 
 #endif
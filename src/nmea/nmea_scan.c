@@ -0,0 +1,341 @@
+#include <nmea/nmea_scan.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define NMEA_SCAN_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__ARM_NEON)
+	#define NMEA_SCAN_NEON
+	#include <arm_neon.h>
+#endif
+
+/**
+ * Scans the data character by character, usable on all platforms.
+ *
+ * @param[out] result The result of the scan.
+ * @param[in] s The data to scan.
+ * @param[in] len Number of characters to scan, at most NMEA_SCAN_MAX.
+ * @retval  0 Success
+ * @retval -1 Parameter error
+ */
+static int scan_scalar(struct nmea_scan_t * result, const char * s, uint32_t len)
+{
+	uint32_t i;
+	uint8_t chk = 0;
+
+	if (result == NULL || s == NULL || len > NMEA_SCAN_MAX) return -1;
+	memset(result->commas, 0, sizeof(result->commas));
+	for (i = 0; i < len && s[i] != '*'; ++i) {
+		chk ^= s[i];
+		if (s[i] == ',')
+			result->commas[i / 64] |= (uint64_t)1 << (i % 64);
+	}
+	result->end = i;
+	result->checksum = chk;
+	return 0;
+}
+
+static int supported_scalar(void)
+{
+	return 1;
+}
+
+#if defined(NMEA_SCAN_X86) || defined(NMEA_SCAN_NEON)
+
+/**
+ * Masks for partial chunks, 32 bytes starting at MASK + 32 - n
+ * contain n leading bytes of 0xff, followed by zeros.
+ */
+static const uint8_t MASK[64] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+#endif
+
+#if defined(NMEA_SCAN_X86)
+
+/**
+ * Reduces the XOR of all bytes of the vector to one byte.
+ */
+__attribute__((target("sse2")))
+static uint8_t fold_sse2(__m128i v)
+{
+	v = _mm_xor_si128(v, _mm_srli_si128(v, 8));
+	v = _mm_xor_si128(v, _mm_srli_si128(v, 4));
+	v = _mm_xor_si128(v, _mm_srli_si128(v, 2));
+	v = _mm_xor_si128(v, _mm_srli_si128(v, 1));
+	return (uint8_t)_mm_cvtsi128_si32(v);
+}
+
+/**
+ * Scans the data in chunks of 16 characters, see scan_scalar.
+ * The data is never read beyond its length.
+ */
+__attribute__((target("sse2")))
+static int scan_sse2(struct nmea_scan_t * result, const char * s, uint32_t len)
+{
+	uint8_t tail[16];
+	__m128i acc = _mm_setzero_si128();
+	__m128i v;
+	__m128i valid;
+	uint32_t k;
+	uint32_t n;
+	uint32_t star;
+
+	if (result == NULL || s == NULL || len > NMEA_SCAN_MAX) return -1;
+	memset(result->commas, 0, sizeof(result->commas));
+	result->end = len;
+	for (k = 0; k < len; k += 16) {
+		n = len - k;
+		if (n >= 16) {
+			n = 16;
+			v = _mm_loadu_si128((const __m128i *)(s + k));
+		} else {
+			memset(tail, 0, sizeof(tail));
+			memcpy(tail, s + k, n);
+			v = _mm_loadu_si128((const __m128i *)tail);
+		}
+		valid = _mm_loadu_si128((const __m128i *)(MASK + 32 - n));
+		star = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('*')), valid));
+		if (star) {
+			n = __builtin_ctz(star);
+			valid = _mm_loadu_si128((const __m128i *)(MASK + 32 - n));
+		}
+		v = _mm_and_si128(v, valid);
+		acc = _mm_xor_si128(acc, v);
+		result->commas[k / 64] |= (uint64_t)(uint32_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8(','))) << (k % 64);
+		if (star) {
+			result->end = k + n;
+			break;
+		}
+	}
+	result->checksum = fold_sse2(acc);
+	return 0;
+}
+
+static int supported_sse2(void)
+{
+	return __builtin_cpu_supports("sse2");
+}
+
+/**
+ * Scans the data in chunks of 32 characters, see scan_scalar.
+ * The data is never read beyond its length.
+ */
+__attribute__((target("avx2")))
+static int scan_avx2(struct nmea_scan_t * result, const char * s, uint32_t len)
+{
+	uint8_t tail[32];
+	__m256i acc = _mm256_setzero_si256();
+	__m256i v;
+	__m256i valid;
+	uint32_t k;
+	uint32_t n;
+	uint32_t star;
+
+	if (result == NULL || s == NULL || len > NMEA_SCAN_MAX) return -1;
+	memset(result->commas, 0, sizeof(result->commas));
+	result->end = len;
+	for (k = 0; k < len; k += 32) {
+		n = len - k;
+		if (n >= 32) {
+			n = 32;
+			v = _mm256_loadu_si256((const __m256i *)(s + k));
+		} else {
+			memset(tail, 0, sizeof(tail));
+			memcpy(tail, s + k, n);
+			v = _mm256_loadu_si256((const __m256i *)tail);
+		}
+		valid = _mm256_loadu_si256((const __m256i *)(MASK + 32 - n));
+		star = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')), valid));
+		if (star) {
+			n = __builtin_ctz(star);
+			valid = _mm256_loadu_si256((const __m256i *)(MASK + 32 - n));
+		}
+		v = _mm256_and_si256(v, valid);
+		acc = _mm256_xor_si256(acc, v);
+		result->commas[k / 64] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))) << (k % 64);
+		if (star) {
+			result->end = k + n;
+			break;
+		}
+	}
+	result->checksum = fold_sse2(_mm_xor_si128(
+		_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)));
+	return 0;
+}
+
+static int supported_avx2(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+#if defined(NMEA_SCAN_NEON)
+
+/**
+ * Value of every byte within its half of the vector, see movemask_neon.
+ */
+static const uint8_t BITS[16] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+};
+
+/**
+ * Returns the bit mask of a vector of bytes which are either 0x00 or 0xff,
+ * bit i is set if byte i is 0xff, like _mm_movemask_epi8. Both halves are
+ * added pairwise until one byte per half is left.
+ */
+static uint32_t movemask_neon(uint8x16_t v)
+{
+	uint8x8_t m;
+
+	v = vandq_u8(v, vld1q_u8(BITS));
+	m = vpadd_u8(vget_low_u8(v), vget_high_u8(v));
+	m = vpadd_u8(m, m);
+	m = vpadd_u8(m, m);
+	return (uint32_t)vget_lane_u8(m, 0) | ((uint32_t)vget_lane_u8(m, 1) << 8);
+}
+
+/**
+ * Reduces the XOR of all bytes of the vector to one byte.
+ */
+static uint8_t fold_neon(uint8x16_t v)
+{
+	uint64_t x;
+
+	x = vget_lane_u64(vreinterpret_u64_u8(veor_u8(vget_low_u8(v), vget_high_u8(v))), 0);
+	x ^= x >> 32;
+	x ^= x >> 16;
+	x ^= x >> 8;
+	return (uint8_t)x;
+}
+
+/**
+ * Scans the data in chunks of 16 characters, see scan_scalar.
+ * The data is never read beyond its length.
+ */
+static int scan_neon(struct nmea_scan_t * result, const char * s, uint32_t len)
+{
+	uint8_t tail[16];
+	uint8x16_t acc = vdupq_n_u8(0);
+	uint8x16_t v;
+	uint8x16_t valid;
+	uint32_t k;
+	uint32_t n;
+	uint32_t star;
+
+	if (result == NULL || s == NULL || len > NMEA_SCAN_MAX) return -1;
+	memset(result->commas, 0, sizeof(result->commas));
+	result->end = len;
+	for (k = 0; k < len; k += 16) {
+		n = len - k;
+		if (n >= 16) {
+			n = 16;
+			v = vld1q_u8((const uint8_t *)(s + k));
+		} else {
+			memset(tail, 0, sizeof(tail));
+			memcpy(tail, s + k, n);
+			v = vld1q_u8(tail);
+		}
+		valid = vld1q_u8(MASK + 32 - n);
+		star = movemask_neon(vandq_u8(vceqq_u8(v, vdupq_n_u8('*')), valid));
+		if (star) {
+			n = __builtin_ctz(star);
+			valid = vld1q_u8(MASK + 32 - n);
+		}
+		v = vandq_u8(v, valid);
+		acc = veorq_u8(acc, v);
+		result->commas[k / 64] |= (uint64_t)movemask_neon(
+			vceqq_u8(v, vdupq_n_u8(','))) << (k % 64);
+		if (star) {
+			result->end = k + n;
+			break;
+		}
+	}
+	result->checksum = fold_neon(acc);
+	return 0;
+}
+
+/**
+ * NEON is available on all machines the kernel was compiled for.
+ */
+static int supported_neon(void)
+{
+	return 1;
+}
+
+#endif
+
+/**
+ * All kernels, the most efficient one first. The list is terminated
+ * by an entry without name.
+ */
+const struct nmea_scan_kernel_t nmea_scan_kernels[] =
+{
+#if defined(NMEA_SCAN_X86)
+	{ "avx2",   supported_avx2,   scan_avx2   },
+	{ "sse2",   supported_sse2,   scan_sse2   },
+#endif
+#if defined(NMEA_SCAN_NEON)
+	{ "neon",   supported_neon,   scan_neon   },
+#endif
+	{ "scalar", supported_scalar, scan_scalar },
+	{ NULL,     NULL,             NULL        },
+};
+
+/**
+ * The kernel used by nmea_scan, selected once, see select_kernel.
+ */
+static const struct nmea_scan_kernel_t * kernel = NULL;
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_kernel(void)
+{
+	const struct nmea_scan_kernel_t * k;
+
+	for (k = nmea_scan_kernels; k->name; ++k) {
+		if (k->supported()) {
+			kernel = k;
+			return;
+		}
+	}
+}
+
+/**
+ * Returns the most efficient kernel supported by the running machine.
+ * The kernel is selected by the first call, which may happen on any
+ * thread (procs and filters may be executed as threads).
+ */
+const struct nmea_scan_kernel_t * nmea_scan_kernel(void)
+{
+	pthread_once(&kernel_once, select_kernel);
+	return kernel;
+}
+
+/**
+ * Scans the data for the checksum delimiter '*', computes the checksum
+ * of all characters before the delimiter and determines the positions
+ * of all commas, in one pass over the data.
+ *
+ * @param[out] result The result of the scan.
+ * @param[in] s The data to scan.
+ * @param[in] len Number of characters to scan, at most NMEA_SCAN_MAX.
+ * @retval  0 Success
+ * @retval -1 Parameter error
+ */
+int nmea_scan(struct nmea_scan_t * result, const char * s, uint32_t len)
+{
+	return nmea_scan_kernel()->scan(result, s, len);
+}
+
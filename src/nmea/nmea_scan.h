@@ -0,0 +1,34 @@
+#ifndef __NMEA_SCAN__H__
+#define __NMEA_SCAN__H__
+
+#include <stdint.h>
+
+/**
+ * Maximum number of characters to be scanned at once.
+ */
+#define NMEA_SCAN_MAX 128
+
+/**
+ * Result of scanning a sentence.
+ */
+struct nmea_scan_t {
+	uint32_t end; /* position of the first '*', length of the data if none */
+	uint8_t checksum; /* XOR of all characters before 'end' */
+	uint64_t commas[NMEA_SCAN_MAX / 64]; /* bit i set: ',' at position i, only before 'end' */
+};
+
+/**
+ * Implementation of the scan, possibly using instruction set extensions.
+ */
+struct nmea_scan_kernel_t {
+	const char * name;
+	int (*supported)(void);
+	int (*scan)(struct nmea_scan_t *, const char *, uint32_t);
+};
+
+extern const struct nmea_scan_kernel_t nmea_scan_kernels[];
+
+const struct nmea_scan_kernel_t * nmea_scan_kernel(void);
+int nmea_scan(struct nmea_scan_t *, const char *, uint32_t);
+
+#endif
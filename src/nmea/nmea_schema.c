@@ -0,0 +1,283 @@
+#include <nmea/nmea_schema.h>
+#include <nmea/nmea_int.h>
+#include <common/endian.h>
+#include <string.h>
+
+/**
+ * Returns a pointer to the data of the field.
+ */
+static char * field_data(const struct nmea_t * nmea, const struct nmea_field_t * field)
+{
+	return (char *)nmea + field->offset;
+}
+
+/**
+ * Checks whether the data of the field is not zero.
+ *
+ * @retval 1 The data is not zero.
+ * @retval 0 The data is zero.
+ */
+static int field_nonzero(const struct nmea_t * nmea, const struct nmea_field_t * field)
+{
+	const char * p = field_data(nmea, field);
+	uint32_t v;
+
+	switch (field->kind) {
+		case NMEA_KIND_CHAR:
+			return *p != '\0';
+		case NMEA_KIND_UINT:
+			memcpy(&v, p, sizeof(v));
+			return v != 0;
+		case NMEA_KIND_FIX:
+			return nmea_fix_check_zero((const struct nmea_fix_t *)p) != 0;
+		case NMEA_KIND_LAT:
+		case NMEA_KIND_LON:
+			return nmea_angle_check_zero((const struct nmea_angle_t *)p) != 0;
+		case NMEA_KIND_TIME:
+			return nmea_time_check_zero((const struct nmea_time_t *)p) != 0;
+		case NMEA_KIND_DATE:
+			return nmea_date_check_zero((const struct nmea_date_t *)p) != 0;
+		case NMEA_KIND_STRING:
+			return *p != '\0';
+		default:
+			break;
+	}
+	return 0;
+}
+
+/**
+ * Evaluates the presence rule of the field.
+ *
+ * @retval 1 The field is to be written with its value.
+ * @retval 0 The field is to be written empty.
+ */
+static int field_present(
+		const struct nmea_t * nmea,
+		const struct nmea_sentence_t * sentence,
+		const struct nmea_field_t * field)
+{
+	uint32_t ref;
+
+	switch (NMEA_PRESENCE_RULE(field->presence)) {
+		case NMEA_ALWAYS:
+			return field->kind != NMEA_KIND_SKIP;
+		case NMEA_NONZERO:
+			return field_nonzero(nmea, field);
+		case NMEA_REF:
+			ref = NMEA_PRESENCE_REF(field->presence);
+			return (ref < sentence->num_fields)
+				&& field_nonzero(nmea, &sentence->fields[ref]);
+		default:
+			break;
+	}
+	return 0;
+}
+
+/**
+ * Reads one field.
+ *
+ * @param[out] nmea The data.
+ * @param[in] field Description of the field.
+ * @param[in] s start of the field (inclusive)
+ * @param[in] p end of the field (exclusive)
+ * @retval  0 Success
+ * @retval -1 Parsing error
+ */
+static int read_field(struct nmea_t * nmea, const struct nmea_field_t * field, const char * s, const char * p)
+{
+	char * v = field_data(nmea, field);
+
+	switch (field->kind) {
+		case NMEA_KIND_SKIP:
+			break;
+		case NMEA_KIND_CHAR:
+			*v = (s == p) ? field->def : *s;
+			break;
+		case NMEA_KIND_UINT:
+			if (parse_int(s, p, (uint32_t *)v) != p) return -1;
+			break;
+		case NMEA_KIND_FIX:
+			if (nmea_fix_parse(s, p, (struct nmea_fix_t *)v) != p) return -1;
+			break;
+		case NMEA_KIND_LAT:
+			if (nmea_angle_parse(s, p, (struct nmea_angle_t *)v) != p
+				&& nmea_check_latitude((struct nmea_angle_t *)v)) return -1;
+			break;
+		case NMEA_KIND_LON:
+			if (nmea_angle_parse(s, p, (struct nmea_angle_t *)v) != p
+				&& nmea_check_longitude((struct nmea_angle_t *)v)) return -1;
+			break;
+		case NMEA_KIND_TIME:
+			if (nmea_time_parse(s, p, (struct nmea_time_t *)v) != p
+				&& nmea_time_check((struct nmea_time_t *)v)) return -1;
+			break;
+		case NMEA_KIND_DATE:
+			if (nmea_date_parse(s, p, (struct nmea_date_t *)v) != p
+				&& nmea_date_check((struct nmea_date_t *)v)) return -1;
+			break;
+		case NMEA_KIND_STRING:
+			/* strings too long are ignored */
+			if ((uint32_t)(p - s) < field->size) {
+				memcpy(v, s, p - s);
+				v[p - s] = '\0';
+			}
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Writes the value of one field.
+ */
+static void write_field(struct nmea_writer_t * w, const struct nmea_t * nmea, const struct nmea_field_t * field)
+{
+	const char * v = field_data(nmea, field);
+	uint32_t u;
+
+	switch (field->kind) {
+		case NMEA_KIND_CHAR:
+			nmea_writer_char(w, *v);
+			break;
+		case NMEA_KIND_UINT:
+			memcpy(&u, v, sizeof(u));
+			nmea_writer_uint(w, u, field->ni);
+			break;
+		case NMEA_KIND_FIX:
+			nmea_writer_fix(w, (const struct nmea_fix_t *)v, field->ni, field->nd);
+			break;
+		case NMEA_KIND_LAT:
+			nmea_writer_latitude(w, (const struct nmea_angle_t *)v);
+			break;
+		case NMEA_KIND_LON:
+			nmea_writer_longitude(w, (const struct nmea_angle_t *)v);
+			break;
+		case NMEA_KIND_TIME:
+			nmea_writer_time(w, (const struct nmea_time_t *)v, field->nd);
+			break;
+		case NMEA_KIND_DATE:
+			nmea_writer_date(w, (const struct nmea_date_t *)v);
+			break;
+		case NMEA_KIND_STRING:
+			nmea_writer_data(w, v, strnlen(v, field->size));
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Reads the sentence into the specified structure, according to
+ * the fields of the sentence. Fields missing in the sentence are
+ * left untouched.
+ *
+ * @param[out] nmea Structure to hold the parsed data.
+ * @param[in] sentence Description of the sentence.
+ * @param[in] f Fields of the sentence, field 0 is the tag.
+ * @retval -1 Parameter failure, parsing error.
+ * @retval  0 Success
+ */
+int nmea_schema_read(struct nmea_t * nmea, const struct nmea_sentence_t * sentence, const struct nmea_fields_t * f)
+{
+	uint32_t i;
+
+	if (nmea == NULL || sentence == NULL || sentence->fields == NULL || f == NULL) return -1;
+	nmea->type = sentence->type;
+	for (i = 0; i < sentence->num_fields && i + 1 < f->num; ++i) {
+		if (read_field(nmea, &sentence->fields[i],
+			NMEA_FIELD_BEGIN(f, i + 1), NMEA_FIELD_END(f, i + 1)) < 0) return -1;
+	}
+	return 0;
+}
+
+/**
+ * Writes the sentence according to the fields of the sentence. The checksum
+ * is computed while writing, see struct nmea_writer_t.
+ *
+ * @param[out] buf The buffer to contain the resulting NMEA sentence.
+ * @param[in] size The size of the buffer.
+ * @param[in] nmea The NMEA data to write to the buffer.
+ * @param[in] sentence Description of the sentence.
+ * @retval -1 Parameter failure, buffer too small or invalid data.
+ * @return Number of characters written to the buffer.
+ */
+int nmea_schema_write(char * buf, uint32_t size, const struct nmea_t * nmea, const struct nmea_sentence_t * sentence)
+{
+	struct nmea_writer_t w;
+	const struct nmea_field_t * field;
+	uint32_t i;
+	int present;
+
+	if (buf == NULL || size == 0 || nmea == NULL) return -1;
+	if (sentence == NULL || sentence->fields == NULL) return -1;
+	if (nmea->type != sentence->type) return -1;
+
+	nmea_writer_start(&w, buf, size, START_TOKEN_NMEA, sentence->tag);
+	for (i = 0; i < sentence->num_fields; ++i) {
+		field = &sentence->fields[i];
+		present = field_present(nmea, sentence, field);
+		if (!present && (field->presence & NMEA_OPTIONAL))
+			break;
+		nmea_writer_char(&w, ',');
+		if (present)
+			write_field(&w, nmea, field);
+	}
+	return nmea_writer_end(&w);
+}
+
+/**
+ * Converts the byte order of all fields of the sentence, the conversion
+ * is symmetric.
+ */
+static void convert(struct nmea_t * nmea, const struct nmea_sentence_t * sentence)
+{
+	const struct nmea_field_t * field;
+	char * v;
+	uint32_t u;
+	uint32_t i;
+
+	if (nmea == NULL || sentence == NULL || sentence->fields == NULL) return;
+	for (i = 0; i < sentence->num_fields; ++i) {
+		field = &sentence->fields[i];
+		v = field_data(nmea, field);
+		switch (field->kind) {
+			case NMEA_KIND_UINT:
+				memcpy(&u, v, sizeof(u));
+				u = endian_hton_32(u);
+				memcpy(v, &u, sizeof(u));
+				break;
+			case NMEA_KIND_FIX:
+				nmea_fix_hton((struct nmea_fix_t *)v);
+				break;
+			case NMEA_KIND_LAT:
+			case NMEA_KIND_LON:
+				nmea_angle_hton((struct nmea_angle_t *)v);
+				break;
+			case NMEA_KIND_TIME:
+				nmea_time_hton((struct nmea_time_t *)v);
+				break;
+			case NMEA_KIND_DATE:
+				nmea_date_hton((struct nmea_date_t *)v);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+/**
+ * Byte order conversion of the data from host to network byte order.
+ */
+void nmea_schema_hton(struct nmea_t * nmea, const struct nmea_sentence_t * sentence)
+{
+	convert(nmea, sentence);
+}
+
+/**
+ * Byte order conversion of the data from network to host byte order.
+ */
+void nmea_schema_ntoh(struct nmea_t * nmea, const struct nmea_sentence_t * sentence)
+{
+	convert(nmea, sentence);
+}
@@ -0,0 +1,77 @@
+#ifndef __NMEA_SCHEMA__H__
+#define __NMEA_SCHEMA__H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <nmea/nmea_base.h>
+#include <nmea/nmea_util.h>
+
+/**
+ * Kinds of fields.
+ */
+#define NMEA_KIND_SKIP   0 /* ignored while reading, written empty */
+#define NMEA_KIND_CHAR   1 /* char */
+#define NMEA_KIND_UINT   2 /* uint32_t */
+#define NMEA_KIND_FIX    3 /* struct nmea_fix_t */
+#define NMEA_KIND_LAT    4 /* struct nmea_angle_t, latitude */
+#define NMEA_KIND_LON    5 /* struct nmea_angle_t, longitude */
+#define NMEA_KIND_TIME   6 /* struct nmea_time_t */
+#define NMEA_KIND_DATE   7 /* struct nmea_date_t */
+#define NMEA_KIND_STRING 8 /* char array, zero terminated */
+
+/**
+ * Presence rules, they determine whether a field is written with its
+ * value or written empty. The data structures do not know about empty
+ * fields, an empty field is read as zero (or the default character).
+ *
+ * NMEA_OPTIONAL may be combined with the rules: the sentence ends before
+ * the first optional field which is not present (variable length sentences).
+ */
+#define NMEA_ALWAYS   0x0000 /* value is always written */
+#define NMEA_NONZERO  0x0001 /* value is written if not zero */
+#define NMEA_REF      0x0002 /* value is written if the referenced field is not zero */
+#define NMEA_OPTIONAL 0x0080
+
+#define NMEA_IF(i) (NMEA_REF | ((i) << 8)) /* value is written if field i is not zero */
+
+#define NMEA_PRESENCE_RULE(p) ((p) & 0x007f)
+#define NMEA_PRESENCE_REF(p)  (((p) >> 8) & 0xff)
+
+/**
+ * Description of one field of a sentence.
+ */
+struct nmea_field_t {
+	uint8_t kind; /* NMEA_KIND_... */
+	uint8_t ni; /* minimum number of integer digits, zero padded */
+	uint8_t nd; /* number of decimals of fix numbers and times */
+	char def; /* value of a character field, if empty */
+	uint16_t presence; /* presence rule */
+	uint16_t offset; /* position of the data within struct nmea_t */
+	uint16_t size; /* size of a string field, including terminating zero */
+};
+
+#define NMEA_OFFSET(m) offsetof(struct nmea_t, sentence.m)
+#define NMEA_SIZE(m) sizeof(((struct nmea_t *)0)->sentence.m)
+
+/**
+ * Field descriptors, 'm' is the member within the union of sentences
+ * of struct nmea_t, for example 'rmc.time'.
+ */
+#define NMEA_FIELD_SKIP()            { NMEA_KIND_SKIP,   0,  0,  0,   NMEA_ALWAYS, 0, 0 }
+#define NMEA_FIELD_CHAR(m, def, p)   { NMEA_KIND_CHAR,   0,  0,  def, p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_UINT(m, ni, p)    { NMEA_KIND_UINT,   ni, 0,  0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_FIX(m, ni, nd, p) { NMEA_KIND_FIX,    ni, nd, 0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_LAT(m, p)         { NMEA_KIND_LAT,    0,  0,  0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_LON(m, p)         { NMEA_KIND_LON,    0,  0,  0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_TIME(m, nd, p)    { NMEA_KIND_TIME,   0,  nd, 0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_DATE(m, p)        { NMEA_KIND_DATE,   0,  0,  0,   p, NMEA_OFFSET(m), 0 }
+#define NMEA_FIELD_STRING(m, p)      { NMEA_KIND_STRING, 0,  0,  0,   p, NMEA_OFFSET(m), NMEA_SIZE(m) }
+
+#define NMEA_NUM_FIELDS(fields) (sizeof(fields) / sizeof(fields[0]))
+
+int nmea_schema_read(struct nmea_t *, const struct nmea_sentence_t *, const struct nmea_fields_t *);
+int nmea_schema_write(char *, uint32_t, const struct nmea_t *, const struct nmea_sentence_t *);
+void nmea_schema_hton(struct nmea_t *, const struct nmea_sentence_t *);
+void nmea_schema_ntoh(struct nmea_t *, const struct nmea_sentence_t *);
+
+#endif
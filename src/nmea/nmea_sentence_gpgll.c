@@ -1,41 +1,19 @@
 #include <nmea/nmea_sentence_gpgll.h>
-#include <nmea/nmea_util.h>
-#include <stdio.h>
+#include <nmea/nmea_schema.h>
 
 /**
- * Reads the NMEA sentence into the specified structure.
- *
- * @param[out] nmea Structure to hold the parsed data.
- * @param[in] s Start of the string to parse (inclusive).
- * @param[in] e End of the string to parse (exclusive).
- * @retval -1 Parameter failure, parsing error.
- * @retval  0 Success
+ * Fields of the sentence, in order of appearance.
  */
-static int read(struct nmea_t * nmea, const char * s, const char * e)
+static const struct nmea_field_t FIELDS[] =
 {
-	struct nmea_gll_t * v;
-	int state = 0;
-	const char * p;
-
-	if (nmea == NULL || s == NULL || e == NULL) return -1;
-	nmea->type = NMEA_GLL;
-	v = &nmea->sentence.gll;
-	p = find_token_end(s);
-	for (state = -1; state < 6 && s < e; ++state) {
-		switch (state) {
-			case  0: if (nmea_angle_parse(s, p, &v->lat) != p && nmea_check_latitude(&v->lat)) return -1; break;
-			case  1: v->lat_dir = (s == p) ? NMEA_NORTH : *s; break;
-			case  2: if (nmea_angle_parse(s, p, &v->lon) != p && nmea_check_longitude(&v->lon)) return -1; break;
-			case  3: v->lon_dir = (s == p) ? NMEA_EAST : *s; break;
-			case  4: if (nmea_time_parse(s, p, &v->time) != p && nmea_time_check(&v->time)) return -1; break;
-			case  5: v->status = (s == p) ? NMEA_STATUS_WARNING : *s; break;
-			default: break;
-		}
-		s = p + 1;
-		p = find_token_end(s);
-	}
-	return 0;
-}
+	/*  0 */ NMEA_FIELD_LAT(gll.lat, NMEA_NONZERO),
+	/*  1 */ NMEA_FIELD_CHAR(gll.lat_dir, NMEA_NORTH, NMEA_IF(0)),
+	/*  2 */ NMEA_FIELD_LON(gll.lon, NMEA_NONZERO),
+	/*  3 */ NMEA_FIELD_CHAR(gll.lon_dir, NMEA_EAST, NMEA_IF(2)),
+	/*  4 */ NMEA_FIELD_TIME(gll.time, 0, NMEA_NONZERO),
+	/*  5 */ NMEA_FIELD_CHAR(gll.status, NMEA_STATUS_WARNING, NMEA_ALWAYS),
+	/*  6 */ NMEA_FIELD_CHAR(gll.sig_integrity, NMEA_SIG_INT_DATANOTVALID, NMEA_NONZERO | NMEA_OPTIONAL),
+};
 
 /**
  * Description of the NMEA sentence.
@@ -44,9 +22,6 @@ const struct nmea_sentence_t sentence_gpgll =
 {
 	.type = NMEA_GLL,
 	.tag = "GPGLL",
-	.read = read,
-	.write = NULL,
-	.hton = NULL,
-	.ntoh = NULL,
+	.fields = FIELDS,
+	.num_fields = NMEA_NUM_FIELDS(FIELDS),
 };
-
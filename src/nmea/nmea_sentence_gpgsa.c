@@ -1,53 +1,29 @@
 #include <nmea/nmea_sentence_gpgsa.h>
-#include <nmea/nmea_util.h>
-#include <nmea/nmea_int.h>
-#include <stdio.h>
+#include <nmea/nmea_schema.h>
 
 /**
- * Reads the NMEA sentence into the specified structure.
- *
- * @param[out] nmea Structure to hold the parsed data.
- * @param[in] s Start of the string to parse (inclusive).
- * @param[in] e End of the string to parse (exclusive).
- * @retval -1 Parameter failure, parsing error.
- * @retval  0 Success
+ * Fields of the sentence, in order of appearance.
  */
-static int read(struct nmea_t * nmea, const char * s, const char * e)
+static const struct nmea_field_t FIELDS[] =
 {
-	struct nmea_gsa_t * v;
-	int state = 0;
-	const char * p;
-
-	if (nmea == NULL || s == NULL || e == NULL) return -1;
-	nmea->type = NMEA_GSA;
-	v = &nmea->sentence.gsa;
-	p = find_token_end(s);
-	for (state = -1; state < 17 && s < e; ++state) {
-		switch (state) {
-			case  0: v->selection_mode = (s == p) ? NMEA_SELECTIONMODE_AUTOMATIC : *s; break;
-			case  1: if (parse_int(s, p, &v->mode) != p) return -1; break;
-			case  2:
-			case  3:
-			case  4:
-			case  5:
-			case  6:
-			case  7:
-			case  8:
-			case  9:
-			case 10:
-			case 11:
-			case 12:
-			case 13: if (parse_int(s, p, &v->id[state-2]) != p) return -1; break;
-			case 14: if (nmea_fix_parse(s, p, &v->pdop) != p) return -1; break;
-			case 15: if (nmea_fix_parse(s, p, &v->hdop) != p) return -1; break;
-			case 16: if (nmea_fix_parse(s, p, &v->vdop) != p) return -1; break;
-			default: break;
-		}
-		s = p + 1;
-		p = find_token_end(s);
-	}
-	return 0;
-}
+	/*  0 */ NMEA_FIELD_CHAR(gsa.selection_mode, NMEA_SELECTIONMODE_AUTOMATIC, NMEA_ALWAYS),
+	/*  1 */ NMEA_FIELD_UINT(gsa.mode, 1, NMEA_ALWAYS),
+	/*  2 */ NMEA_FIELD_UINT(gsa.id[0], 2, NMEA_NONZERO),
+	/*  3 */ NMEA_FIELD_UINT(gsa.id[1], 2, NMEA_NONZERO),
+	/*  4 */ NMEA_FIELD_UINT(gsa.id[2], 2, NMEA_NONZERO),
+	/*  5 */ NMEA_FIELD_UINT(gsa.id[3], 2, NMEA_NONZERO),
+	/*  6 */ NMEA_FIELD_UINT(gsa.id[4], 2, NMEA_NONZERO),
+	/*  7 */ NMEA_FIELD_UINT(gsa.id[5], 2, NMEA_NONZERO),
+	/*  8 */ NMEA_FIELD_UINT(gsa.id[6], 2, NMEA_NONZERO),
+	/*  9 */ NMEA_FIELD_UINT(gsa.id[7], 2, NMEA_NONZERO),
+	/* 10 */ NMEA_FIELD_UINT(gsa.id[8], 2, NMEA_NONZERO),
+	/* 11 */ NMEA_FIELD_UINT(gsa.id[9], 2, NMEA_NONZERO),
+	/* 12 */ NMEA_FIELD_UINT(gsa.id[10], 2, NMEA_NONZERO),
+	/* 13 */ NMEA_FIELD_UINT(gsa.id[11], 2, NMEA_NONZERO),
+	/* 14 */ NMEA_FIELD_FIX(gsa.pdop, 1, 1, NMEA_NONZERO),
+	/* 15 */ NMEA_FIELD_FIX(gsa.hdop, 1, 1, NMEA_NONZERO),
+	/* 16 */ NMEA_FIELD_FIX(gsa.vdop, 1, 1, NMEA_NONZERO),
+};
 
 /**
  * Description of the NMEA sentence.
@@ -56,9 +32,6 @@ const struct nmea_sentence_t sentence_gpgsa =
 {
 	.type = NMEA_GSA,
 	.tag = "GPGSA",
-	.read = read,
-	.write = NULL,
-	.hton = NULL,
-	.ntoh = NULL,
+	.fields = FIELDS,
+	.num_fields = NMEA_NUM_FIELDS(FIELDS),
 };
-
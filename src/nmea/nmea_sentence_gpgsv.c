@@ -1,54 +1,31 @@
 #include <nmea/nmea_sentence_gpgsv.h>
-#include <nmea/nmea_util.h>
-#include <nmea/nmea_int.h>
-#include <stdio.h>
+#include <nmea/nmea_schema.h>
 
 /**
- * Reads the NMEA sentence into the specified structure.
- *
- * @param[out] nmea Structure to hold the parsed data.
- * @param[in] s Start of the string to parse (inclusive).
- * @param[in] e End of the string to parse (exclusive).
- * @retval -1 Parameter failure, parsing error.
- * @retval  0 Success
+ * Fields of the sentence, in order of appearance.
  */
-static int read(struct nmea_t * nmea, const char * s, const char * e)
+static const struct nmea_field_t FIELDS[] =
 {
-	struct nmea_gsv_t * v;
-	int state = 0;
-	const char * p;
-
-	if (nmea == NULL || s == NULL || e == NULL) return -1;
-	nmea->type = NMEA_GSV;
-	v = &nmea->sentence.gsv;
-	p = find_token_end(s);
-	for (state = -1; state < 18 && s < e; ++state) {
-		switch (state) {
-			case  0: if (parse_int(s, p, &v->n_messages) != p) return -1; break;
-			case  1: if (parse_int(s, p, &v->message_number) != p) return -1; break;
-			case  2: if (parse_int(s, p, &v->sat[0].id) != p) return -1; break;
-			case  3: if (parse_int(s, p, &v->sat[0].elevation) != p) return -1; break;
-			case  4: if (parse_int(s, p, &v->sat[0].azimuth) != p) return -1; break;
-			case  5: if (parse_int(s, p, &v->sat[0].snr) != p) return -1; break;
-			case  6: if (parse_int(s, p, &v->sat[1].id) != p) return -1; break;
-			case  7: if (parse_int(s, p, &v->sat[1].elevation) != p) return -1; break;
-			case  8: if (parse_int(s, p, &v->sat[1].azimuth) != p) return -1; break;
-			case  9: if (parse_int(s, p, &v->sat[1].snr) != p) return -1; break;
-			case 10: if (parse_int(s, p, &v->sat[2].id) != p) return -1; break;
-			case 11: if (parse_int(s, p, &v->sat[2].elevation) != p) return -1; break;
-			case 12: if (parse_int(s, p, &v->sat[2].azimuth) != p) return -1; break;
-			case 13: if (parse_int(s, p, &v->sat[2].snr) != p) return -1; break;
-			case 14: if (parse_int(s, p, &v->sat[3].id) != p) return -1; break;
-			case 15: if (parse_int(s, p, &v->sat[3].elevation) != p) return -1; break;
-			case 16: if (parse_int(s, p, &v->sat[3].azimuth) != p) return -1; break;
-			case 17: if (parse_int(s, p, &v->sat[3].snr) != p) return -1; break;
-			default: break;
-		}
-		s = p + 1;
-		p = find_token_end(s);
-	}
-	return 0;
-}
+	/*  0 */ NMEA_FIELD_UINT(gsv.n_messages, 1, NMEA_ALWAYS),
+	/*  1 */ NMEA_FIELD_UINT(gsv.message_number, 1, NMEA_ALWAYS),
+	/*  2 */ NMEA_FIELD_UINT(gsv.n_satelites, 2, NMEA_ALWAYS),
+	/*  3 */ NMEA_FIELD_UINT(gsv.sat[0].id, 2, NMEA_NONZERO | NMEA_OPTIONAL),
+	/*  4 */ NMEA_FIELD_UINT(gsv.sat[0].elevation, 2, NMEA_IF(3)),
+	/*  5 */ NMEA_FIELD_UINT(gsv.sat[0].azimuth, 3, NMEA_IF(3)),
+	/*  6 */ NMEA_FIELD_UINT(gsv.sat[0].snr, 2, NMEA_IF(3)),
+	/*  7 */ NMEA_FIELD_UINT(gsv.sat[1].id, 2, NMEA_NONZERO | NMEA_OPTIONAL),
+	/*  8 */ NMEA_FIELD_UINT(gsv.sat[1].elevation, 2, NMEA_IF(7)),
+	/*  9 */ NMEA_FIELD_UINT(gsv.sat[1].azimuth, 3, NMEA_IF(7)),
+	/* 10 */ NMEA_FIELD_UINT(gsv.sat[1].snr, 2, NMEA_IF(7)),
+	/* 11 */ NMEA_FIELD_UINT(gsv.sat[2].id, 2, NMEA_NONZERO | NMEA_OPTIONAL),
+	/* 12 */ NMEA_FIELD_UINT(gsv.sat[2].elevation, 2, NMEA_IF(11)),
+	/* 13 */ NMEA_FIELD_UINT(gsv.sat[2].azimuth, 3, NMEA_IF(11)),
+	/* 14 */ NMEA_FIELD_UINT(gsv.sat[2].snr, 2, NMEA_IF(11)),
+	/* 15 */ NMEA_FIELD_UINT(gsv.sat[3].id, 2, NMEA_NONZERO | NMEA_OPTIONAL),
+	/* 16 */ NMEA_FIELD_UINT(gsv.sat[3].elevation, 2, NMEA_IF(15)),
+	/* 17 */ NMEA_FIELD_UINT(gsv.sat[3].azimuth, 3, NMEA_IF(15)),
+	/* 18 */ NMEA_FIELD_UINT(gsv.sat[3].snr, 2, NMEA_IF(15)),
+};
 
 /**
  * Description of the NMEA sentence.
@@ -57,9 +34,6 @@ const struct nmea_sentence_t sentence_gpgsv =
 {
 	.type = NMEA_GSV,
 	.tag = "GPGSV",
-	.read = read,
-	.write = NULL,
-	.hton = NULL,
-	.ntoh = NULL,
+	.fields = FIELDS,
+	.num_fields = NMEA_NUM_FIELDS(FIELDS),
 };
-
@@ -1,49 +1,26 @@
 #include <nmea/nmea_sentence_gprmb.h>
-#include <nmea/nmea_util.h>
-#include <nmea/nmea_int.h>
-#include <stdio.h>
+#include <nmea/nmea_schema.h>
 
 /**
- * Reads the NMEA sentence into the specified structure.
- *
- * @param[out] nmea Structure to hold the parsed data.
- * @param[in] s Start of the string to parse (inclusive).
- * @param[in] e End of the string to parse (exclusive).
- * @retval -1 Parameter failure, parsing error.
- * @retval  0 Success
+ * Fields of the sentence, in order of appearance.
  */
-static int read(struct nmea_t * nmea, const char * s, const char * e)
+static const struct nmea_field_t FIELDS[] =
 {
-	struct nmea_rmb_t * v;
-	int state = 0;
-	const char * p;
-
-	if (nmea == NULL || s == NULL || e == NULL) return -1;
-	nmea->type = NMEA_RMB;
-	v = &nmea->sentence.rmb;
-	p = find_token_end(s);
-	for (state = -1; state < 13 && s < e; ++state) {
-		switch (state) {
-			case  0: v->status = (s == p) ? NMEA_STATUS_WARNING : *s; break;
-			case  1: if (nmea_fix_parse(s, p, &v->cross_track_error) != p) return -1; break;
-			case  2: v->steer_dir = (s == p) ? NMEA_LEFT : *s; break;
-			case  3: if (parse_int(s, p, &v->waypoint_to) != p) return -1; break;
-			case  4: if (parse_int(s, p, &v->waypoint_from) != p) return -1; break;
-			case  5: if (nmea_angle_parse(s, p, &v->lat) != p && nmea_check_latitude(&v->lat)) return -1; break;
-			case  6: v->lat_dir = (s == p) ? NMEA_NORTH : *s; break;
-			case  7: if (nmea_angle_parse(s, p, &v->lon) != p && nmea_check_longitude(&v->lon)) return -1; break;
-			case  8: v->lon_dir = (s == p) ? NMEA_EAST : *s; break;
-			case  9: if (nmea_fix_parse(s, p, &v->range) != p) return -1; break;
-			case 10: if (nmea_fix_parse(s, p, &v->bearing) != p) return -1; break;
-			case 11: if (nmea_fix_parse(s, p, &v->dst_velocity) != p) return -1; break;
-			case 12: v->arrival_status = (s == p) ? NMEA_STATUS_WARNING : *s; break;
-			default: break;
-		}
-		s = p + 1;
-		p = find_token_end(s);
-	}
-	return 0;
-}
+	/*  0 */ NMEA_FIELD_CHAR(rmb.status, NMEA_STATUS_WARNING, NMEA_ALWAYS),
+	/*  1 */ NMEA_FIELD_FIX(rmb.cross_track_error, 1, 2, NMEA_NONZERO),
+	/*  2 */ NMEA_FIELD_CHAR(rmb.steer_dir, NMEA_LEFT, NMEA_IF(1)),
+	/*  3 */ NMEA_FIELD_UINT(rmb.waypoint_to, 3, NMEA_NONZERO),
+	/*  4 */ NMEA_FIELD_UINT(rmb.waypoint_from, 3, NMEA_NONZERO),
+	/*  5 */ NMEA_FIELD_LAT(rmb.lat, NMEA_NONZERO),
+	/*  6 */ NMEA_FIELD_CHAR(rmb.lat_dir, NMEA_NORTH, NMEA_IF(5)),
+	/*  7 */ NMEA_FIELD_LON(rmb.lon, NMEA_NONZERO),
+	/*  8 */ NMEA_FIELD_CHAR(rmb.lon_dir, NMEA_EAST, NMEA_IF(7)),
+	/*  9 */ NMEA_FIELD_FIX(rmb.range, 3, 1, NMEA_NONZERO),
+	/* 10 */ NMEA_FIELD_FIX(rmb.bearing, 3, 1, NMEA_NONZERO),
+	/* 11 */ NMEA_FIELD_FIX(rmb.dst_velocity, 3, 1, NMEA_NONZERO),
+	/* 12 */ NMEA_FIELD_CHAR(rmb.arrival_status, NMEA_STATUS_WARNING, NMEA_ALWAYS),
+	/* 13 */ NMEA_FIELD_CHAR(rmb.sig_integrity, NMEA_SIG_INT_DATANOTVALID, NMEA_NONZERO | NMEA_OPTIONAL),
+};
 
 /**
  * Description of the NMEA sentence.
@@ -52,9 +29,6 @@ const struct nmea_sentence_t sentence_gprmb =
 {
 	.type = NMEA_RMB,
 	.tag = "GPRMB",
-	.read= read,
-	.write = NULL,
-	.hton = NULL,
-	.ntoh = NULL,
+	.fields = FIELDS,
+	.num_fields = NMEA_NUM_FIELDS(FIELDS),
 };
-
@@ -1,41 +1,18 @@
 #include <nmea/nmea_sentence_pgrme.h>
-#include <nmea/nmea_util.h>
-#include <stdio.h>
+#include <nmea/nmea_schema.h>
 
 /**
- * Reads the NMEA sentence into the specified structure.
- *
- * @param[out] nmea Structure to hold the parsed data.
- * @param[in] s Start of the string to parse (inclusive).
- * @param[in] e End of the string to parse (exclusive).
- * @retval -1 Parameter failure, parsing error.
- * @retval  0 Success
+ * Fields of the sentence, in order of appearance.
  */
-static int read(struct nmea_t * nmea, const char * s, const char * e)
+static const struct nmea_field_t FIELDS[] =
 {
-	struct nmea_garmin_rme_t * v;
-	int state = 0;
-	const char * p;
-
-	if (nmea == NULL || s == NULL || e == NULL) return -1;
-	nmea->type = NMEA_GARMIN_RME;
-	v = &nmea->sentence.garmin_rme;
-	p = find_token_end(s);
-	for (state = -1; state < 6 && s < e; ++state) {
-		switch (state) {
-			case 0: if (nmea_fix_parse(s, p, &v->hpe) != p) return -1; break;
-			case 1: v->unit_hpe = (s == p) ? NMEA_UNIT_METER : *s; break;
-			case 2: if (nmea_fix_parse(s, p, &v->vpe) != p) return -1; break;
-			case 3: v->unit_vpe = (s == p) ? NMEA_UNIT_METER : *s; break;
-			case 4: if (nmea_fix_parse(s, p, &v->sepe) != p) return -1; break;
-			case 5: v->unit_sepe= (s == p) ? NMEA_UNIT_METER : *s; break;
-			default: break;
-		}
-		s = p + 1;
-		p = find_token_end(s);
-	}
-	return 0;
-}
+	/*  0 */ NMEA_FIELD_FIX(garmin_rme.hpe, 1, 1, NMEA_NONZERO),
+	/*  1 */ NMEA_FIELD_CHAR(garmin_rme.unit_hpe, NMEA_UNIT_METER, NMEA_ALWAYS),
+	/*  2 */ NMEA_FIELD_FIX(garmin_rme.vpe, 1, 1, NMEA_NONZERO),
+	/*  3 */ NMEA_FIELD_CHAR(garmin_rme.unit_vpe, NMEA_UNIT_METER, NMEA_ALWAYS),
+	/*  4 */ NMEA_FIELD_FIX(garmin_rme.sepe, 1, 1, NMEA_NONZERO),
+	/*  5 */ NMEA_FIELD_CHAR(garmin_rme.unit_sepe, NMEA_UNIT_METER, NMEA_ALWAYS),
+};
 
 /**
  * Description of the NMEA sentence.
@@ -44,9 +21,6 @@ const struct nmea_sentence_t sentence_pgrme =
 {
 	.type = NMEA_GARMIN_RME,
 	.tag = "PGRME",
-	.read = read,
-	.write = NULL,
-	.hton = NULL,
-	.ntoh = NULL,
+	.fields = FIELDS,
+	.num_fields = NMEA_NUM_FIELDS(FIELDS),
 };
-
@@ -0,0 +1,105 @@
+#include <nmea/nmea_stream.h>
+#include <string.h>
+
+/**
+ * Searches the first occurrence of one of the two specified characters.
+ *
+ * @param[in] s The data to search.
+ * @param[in] n Number of characters to search.
+ * @param[in] a First character to search for.
+ * @param[in] b Second character to search for.
+ * @return Pointer to the first occurrence, NULL if none of them was found.
+ */
+static const char * find_any(const char * s, uint32_t n, char a, char b)
+{
+	const char * pa;
+	const char * pb;
+
+	pa = (const char *)memchr(s, a, n);
+	pb = (const char *)memchr(s, b, pa ? (uint32_t)(pa - s) : n);
+	return pb ? pb : pa;
+}
+
+/**
+ * Initializes the stream.
+ *
+ * @param[out] stream The stream to initialize.
+ */
+void nmea_stream_init(struct nmea_stream_t * stream)
+{
+	if (stream == NULL)
+		return;
+	memset(stream, 0, sizeof(struct nmea_stream_t));
+}
+
+/**
+ * Consumes data until a complete sentence is found or all data is consumed.
+ * A found sentence is available in stream->data, without the end of line
+ * characters, until the next call of this function.
+ *
+ * The data pointer and size are advanced by the consumed characters,
+ * the function has to be called until all data is consumed.
+ *
+ * @code
+ * while (nmea_stream_next(&stream, &p, &size) != 0) { ... }
+ * @endcode
+ *
+ * @param[inout] stream The stream.
+ * @param[inout] buf The data to consume.
+ * @param[inout] size Number of characters of the data.
+ * @retval  1 A complete sentence is available.
+ * @retval  0 All data consumed, no complete sentence available.
+ * @retval -1 Parameter error.
+ * @retval -2 Sentence too long, it is discarded.
+ */
+int nmea_stream_next(struct nmea_stream_t * stream, const char ** buf, uint32_t * size)
+{
+	const char * p;
+	uint32_t n;
+
+	if (stream == NULL || buf == NULL || *buf == NULL || size == NULL)
+		return -1;
+
+	while (*size > 0) {
+		if (stream->state == 0) {
+			p = find_any(*buf, *size, START_TOKEN_NMEA, START_TOKEN_AIVDM);
+			if (p == NULL) {
+				*buf += *size;
+				*size = 0;
+				break;
+			}
+			*size -= p - *buf;
+			*buf = p;
+			stream->state = 1;
+			stream->len = 0;
+		}
+
+		p = find_any(*buf, *size, '\r', '\n');
+		n = p ? (uint32_t)(p - *buf) : *size;
+		if (stream->len + n > NMEA_MAX_SENTENCE) {
+			*buf += n;
+			*size -= n;
+			stream->state = 0;
+			stream->len = 0;
+			stream->data[0] = 0;
+			return -2;
+		}
+
+		memcpy(stream->data + stream->len, *buf, n);
+		stream->len += n;
+		stream->data[stream->len] = 0;
+		*buf += n;
+		*size -= n;
+		if (p == NULL)
+			break;
+
+		/* skip end of line, remaining end of line characters are skipped
+		 * while searching the next start token */
+		++*buf;
+		--*size;
+		stream->state = 0;
+		return 1;
+	}
+	return 0;
+}
+
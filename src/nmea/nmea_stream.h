@@ -0,0 +1,28 @@
+#ifndef __NMEA_STREAM__H__
+#define __NMEA_STREAM__H__
+
+#include <stdint.h>
+#include <nmea/nmea_base.h>
+
+/**
+ * Recommended size of chunks to read from a device and to feed
+ * into the stream.
+ */
+#define NMEA_STREAM_CHUNK 4096
+
+/**
+ * Streaming sentence framer. Consumes data of arbitrary size and
+ * yields complete sentences, starting with a start token ('$' or '!')
+ * and terminated by CR and/or LF. Data outside of sentences is ignored.
+ */
+struct nmea_stream_t
+{
+	int state; /* 0: searching start token, 1: within sentence */
+	uint32_t len; /* number of characters of the current sentence */
+	char data[NMEA_MAX_SENTENCE + 1]; /* current sentence, zero terminated */
+};
+
+void nmea_stream_init(struct nmea_stream_t *);
+int nmea_stream_next(struct nmea_stream_t *, const char **, uint32_t *);
+
+#endif
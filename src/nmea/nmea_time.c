@@ -1,7 +1,8 @@
 #include <nmea/nmea_time.h>
 #include <nmea/nmea_fix.h>
+#include <nmea/nmea_int.h>
 #include <common/endian.h>
-#include <stdio.h>
+#include <stddef.h>
 
 /**
  * Checks whether all members of the time information are zero.
@@ -100,7 +101,11 @@ int nmea_time_write(char * buf, uint32_t size, const struct nmea_time_t * v)
 	if (buf == NULL || size == 0 || v == NULL) return -1;
 	if (size < 6) return -1;
 	if (nmea_time_check(v)) return -2;
-	return snprintf(buf, size, "%02u%02u%02u", v->h, v->m, v->s);
+	nmea_uint_write(buf + 0, 2, v->h, 2, '0');
+	nmea_uint_write(buf + 2, 2, v->m, 2, '0');
+	nmea_uint_write(buf + 4, 2, v->s, 2, '0');
+	if (size > 6) buf[6] = '\0';
+	return 6;
 }
 
 /**
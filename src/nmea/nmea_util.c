@@ -1,87 +1,256 @@
 #include <nmea/nmea_util.h>
-#include <stdio.h>
+#include <nmea/nmea_base.h>
+#include <nmea/nmea_scan.h>
+#include <nmea/nmea_int.h>
 #include <string.h>
 
 /**
- * Copies the string between [s,e) into v, the user has to make
- * sure there is enough room within v.
- *
- * @param[in] s start of string to parse (inclusive)
- * @param[in] e end of string to parse (exclusive)
- * @param[out] v parsed value
- * @return position of the last valid character
+ * Converts the specified hexadecimal character to its numerical representation.
+ * If the character does not match a hexadecimal digit, 0xff will return.
  */
-const char * parse_str(const char * s, const char * e, char * v)
+static uint8_t hex2i(char c)
 {
-	if (v == NULL) return e;
-	if (s < e) {
-		memcpy(v, s, e-s);
-	}
-	return e;
+	if ((c >= '0') && (c <= '9')) return c - '0';
+	if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+	if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+	return 0xff;
 }
 
 /**
- * Writes a string into the buffer if there is enough room within the buffer.
+ * Checks the checksum and determines the fields of the sentence, all
+ * in one pass over the sentence, see nmea_scan.
  *
- * @param[out] buf The buffer to hold the data.
- * @param[in] size Number of bytes free in buffer.
- * @param[in] s String to write into the buffer.
- * @retval >= 0 Number of bytes written into the buffer.
+ * Fields are counted as long as they start before the checksum delimiter
+ * '*', an empty last field is therefore not counted.
+ *
+ * @param[out] f The fields of the sentence.
+ * @param[in] s The sentence to tokenize, starting with the start token.
+ * @param[in] start_token The start token of the sentence.
+ * @retval  0 Success
  * @retval -1 Parameter error
- * @retval -2 Buffer too small
+ * @retval -2 Checksum error
+ * @retval -3 Format error, sentence too long or too many fields
  */
-int write_string(char * buf, uint32_t size, const char * s)
+int nmea_tokenize(struct nmea_fields_t * f, const char * s, char start_token)
 {
+	struct nmea_scan_t scan;
 	uint32_t len;
+	uint32_t star;
+	uint32_t i;
+	uint32_t n = 0;
+	uint64_t bits;
+
+	if (f == NULL || s == NULL) return -1;
+	if (*s != start_token) return -2;
 
-	if (buf == NULL || size == 0 || s == NULL) return -1;
-	len = strlen(s);
-	if (len > size) return -2;
-	strncat(buf, s, len);
-	return (int)len;
+	len = strnlen(s + 1, NMEA_MAX_SENTENCE);
+	if (nmea_scan(&scan, s + 1, len) < 0) return -1;
+	if (scan.end >= len) return (len >= NMEA_MAX_SENTENCE) ? -3 : -2;
+
+	star = scan.end + 1;
+	if (s[star + 1] == '\0') return -2;
+	if (scan.checksum != hex2i(s[star + 1]) * 16 + hex2i(s[star + 2])) return -2;
+
+	f->s = s;
+	f->pos[0] = 1;
+	for (i = 0; i < NMEA_SCAN_MAX / 64; ++i) {
+		for (bits = scan.commas[i]; bits; bits &= bits - 1) {
+			if (++n >= NMEA_MAX_FIELDS) return -3;
+			f->pos[n] = i * 64 + __builtin_ctzll(bits) + 2;
+		}
+	}
+	f->pos[n + 1] = star + 1;
+	f->num = (f->pos[n] < star) ? n + 1 : n;
+	f->len = star + 3;
+	return 0;
 }
 
 /**
- * Writes a character into the buffer if there is enough room within the buffer.
+ * Accounts the specified number of characters, written by one of the
+ * field writers at the current position, to the sentence and its checksum.
  *
- * @param[out] buf The buffer to hold the data.
- * @param[in] size Number of bytes free in buffer.
- * @param[in] c Character to write.
- * @retval >= 0 Number of bytes written into the buffer.
- * @retval -1 Parameter error
+ * @param[inout] w The writer.
+ * @param[in] rc Result of the field writer, number of written characters
+ *    or negative in case of an error.
  */
-int write_char(char * buf, uint32_t size, const char c)
+static void writer_advance(struct nmea_writer_t * w, int rc)
 {
-	if (buf == NULL || size == 0) return -1;
-	*buf++ = c;
-	*buf = '\0';
-	return 1;
+	const char * p;
+	const char * e;
+
+	if (rc < 0) {
+		w->error = rc;
+		return;
+	}
+	p = w->buf + w->len;
+	e = p + rc;
+	for (; p < e; ++p)
+		w->checksum ^= *p;
+	w->len += rc;
 }
 
 /**
- * Returns a pointer to the position of the next comma within the
- * specified string.
+ * Starts a sentence, writes the start token and the tag.
  *
- * @param[in] s the string to parse
- * @return the position of the next comma or, if none found, the end of the string
+ * @param[out] w The writer to initialize.
+ * @param[out] buf The buffer to contain the sentence.
+ * @param[in] size Size of the buffer.
+ * @param[in] start_token The start token of the sentence.
+ * @param[in] tag The tag of the sentence.
  */
-const char * find_token_end(const char * s)
+void nmea_writer_start(struct nmea_writer_t * w, char * buf, uint32_t size, char start_token, const char * tag)
 {
-	while (s && *s && *s != ',' && *s != '*') ++s;
-	return s;
+	if (w == NULL) return;
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+	w->checksum = 0;
+	w->error = 0;
+	if (buf == NULL || size == 0) {
+		w->error = -1;
+		return;
+	}
+	w->buf[w->len++] = start_token;
+	nmea_writer_string(w, tag);
 }
 
 /**
- * Searches for the end of the NMEA sentence, the character '*'.
+ * Finishes the sentence, writes the checksum and a terminating zero.
  *
- * @param[in] s The string to search for the end.
- * @return Points to the end of the sentence. If the string has ended
- *   before, the result points to the end of the string.
+ * @param[inout] w The writer.
+ * @retval >= 0 Number of characters of the sentence, without terminating zero.
+ * @retval -1 Parameter error, buffer too small or a field could not be written.
+ */
+int nmea_writer_end(struct nmea_writer_t * w)
+{
+	static const char HEX[] = "0123456789ABCDEF";
+
+	if (w == NULL || w->error) return -1;
+	if (w->len + 4 > w->size) return -1;
+	w->buf[w->len++] = '*';
+	w->buf[w->len++] = HEX[(w->checksum >> 4) & 0x0f];
+	w->buf[w->len++] = HEX[(w->checksum >> 0) & 0x0f];
+	w->buf[w->len] = '\0';
+	return (int)w->len;
+}
+
+/**
+ * Writes a character.
+ */
+void nmea_writer_char(struct nmea_writer_t * w, char c)
+{
+	if (w == NULL || w->error) return;
+	if (w->len >= w->size) {
+		w->error = -2;
+		return;
+	}
+	w->buf[w->len++] = c;
+	w->checksum ^= c;
+}
+
+/**
+ * Writes the specified number of characters.
+ */
+void nmea_writer_data(struct nmea_writer_t * w, const char * s, uint32_t len)
+{
+	if (w == NULL || w->error) return;
+	if (s == NULL) {
+		w->error = -1;
+		return;
+	}
+	if (w->len + len > w->size) {
+		w->error = -2;
+		return;
+	}
+	memcpy(w->buf + w->len, s, len);
+	writer_advance(w, (int)len);
+}
+
+/**
+ * Writes a string.
+ */
+void nmea_writer_string(struct nmea_writer_t * w, const char * s)
+{
+	if (w == NULL || w->error) return;
+	if (s == NULL) {
+		w->error = -1;
+		return;
+	}
+	nmea_writer_data(w, s, strlen(s));
+}
+
+/**
+ * Writes an unsigned integer, zero padded to the specified width.
+ */
+void nmea_writer_uint(struct nmea_writer_t * w, uint32_t v, uint32_t width)
+{
+	if (w == NULL || w->error) return;
+	writer_advance(w, nmea_uint_write(w->buf + w->len, w->size - w->len, v, width, '0'));
+}
+
+/**
+ * Writes a fix number, the integer part zero padded to at least 'ni'
+ * digits, followed by 'nd' decimals. Without decimals, the decimal point
+ * is omitted.
+ */
+void nmea_writer_fix(struct nmea_writer_t * w, const struct nmea_fix_t * v, uint32_t ni, uint32_t nd)
+{
+	if (w == NULL || w->error) return;
+	if (v == NULL) {
+		w->error = -1;
+		return;
+	}
+	if (nd > NMEA_FIX_DECIMAL_DIGITS)
+		nd = NMEA_FIX_DECIMAL_DIGITS;
+	nmea_writer_uint(w, v->i, ni);
+	if (nd > 0) {
+		nmea_writer_char(w, '.');
+		nmea_writer_uint(w, (v->d % NMEA_FIX_DECIMALS)
+			/ nmea_digits_pow10(NMEA_FIX_DECIMAL_DIGITS - nd), nd);
+	}
+}
+
+/**
+ * Writes a time, see nmea_time_write, followed by 'nd' (at most 3)
+ * decimals of the seconds.
+ */
+void nmea_writer_time(struct nmea_writer_t * w, const struct nmea_time_t * v, uint32_t nd)
+{
+	if (w == NULL || w->error) return;
+	writer_advance(w, nmea_time_write(w->buf + w->len, w->size - w->len, v));
+	if (nd > 0) {
+		if (nd > 3)
+			nd = 3;
+		nmea_writer_char(w, '.');
+		nmea_writer_uint(w, (v->ms % 1000) / nmea_digits_pow10(3 - nd), nd);
+	}
+}
+
+/**
+ * Writes a date, see nmea_date_write.
+ */
+void nmea_writer_date(struct nmea_writer_t * w, const struct nmea_date_t * v)
+{
+	if (w == NULL || w->error) return;
+	writer_advance(w, nmea_date_write(w->buf + w->len, w->size - w->len, v));
+}
+
+/**
+ * Writes a latitude, see nmea_write_latitude.
+ */
+void nmea_writer_latitude(struct nmea_writer_t * w, const struct nmea_angle_t * v)
+{
+	if (w == NULL || w->error) return;
+	writer_advance(w, nmea_write_latitude(w->buf + w->len, w->size - w->len, v));
+}
+
+/**
+ * Writes a longitude, see nmea_write_lonitude.
  */
-const char * find_sentence_end(const char * s)
+void nmea_writer_longitude(struct nmea_writer_t * w, const struct nmea_angle_t * v)
 {
-	while (s && *s && *s != '*') ++s;
-	return s;
+	if (w == NULL || w->error) return;
+	writer_advance(w, nmea_write_lonitude(w->buf + w->len, w->size - w->len, v));
 }
 
 /**
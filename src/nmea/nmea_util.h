@@ -2,13 +2,54 @@
 #define __NMEA_UTIL__H__
 
 #include <stdint.h>
+#include <nmea/nmea_defs.h>
 
-const char * parse_str(const char * s, const char * e, char * v);
-int write_string(char * buf, uint32_t size, const char * s);
-int write_char(char * buf, uint32_t size, const char c);
+/**
+ * Maximum number of fields of a sentence, including the tag.
+ */
+#define NMEA_MAX_FIELDS 80
+
+/**
+ * Fields of a sentence, determined by nmea_tokenize. Field 0 is the tag,
+ * the field i spans the range [NMEA_FIELD_BEGIN(f,i), NMEA_FIELD_END(f,i)).
+ */
+struct nmea_fields_t {
+	const char * s; /* the sentence, including start token */
+	uint32_t len; /* length of the sentence, including checksum */
+	uint32_t num; /* number of fields */
+	uint8_t pos[NMEA_MAX_FIELDS + 1]; /* offsets of the fields within the sentence */
+};
+
+#define NMEA_FIELD_BEGIN(f, i) ((f)->s + (f)->pos[(i)])
+#define NMEA_FIELD_END(f, i)   ((f)->s + (f)->pos[(i) + 1] - 1)
+
+/**
+ * Serializer of a sentence into a buffer. The checksum is computed while
+ * writing. After an error, all further writes are ignored and the error
+ * is reported by nmea_writer_end.
+ */
+struct nmea_writer_t {
+	char * buf; /* the buffer */
+	uint32_t size; /* size of the buffer */
+	uint32_t len; /* number of characters written */
+	uint8_t checksum; /* XOR of all characters after the start token */
+	int error; /* zero if no error occurred */
+};
+
+int nmea_tokenize(struct nmea_fields_t * f, const char * s, char start_token);
+
+void nmea_writer_start(struct nmea_writer_t * w, char * buf, uint32_t size, char start_token, const char * tag);
+int nmea_writer_end(struct nmea_writer_t * w);
+void nmea_writer_char(struct nmea_writer_t * w, char c);
+void nmea_writer_data(struct nmea_writer_t * w, const char * s, uint32_t len);
+void nmea_writer_string(struct nmea_writer_t * w, const char * s);
+void nmea_writer_uint(struct nmea_writer_t * w, uint32_t v, uint32_t width);
+void nmea_writer_fix(struct nmea_writer_t * w, const struct nmea_fix_t * v, uint32_t ni, uint32_t nd);
+void nmea_writer_time(struct nmea_writer_t * w, const struct nmea_time_t * v, uint32_t nd);
+void nmea_writer_date(struct nmea_writer_t * w, const struct nmea_date_t * v);
+void nmea_writer_latitude(struct nmea_writer_t * w, const struct nmea_angle_t * v);
+void nmea_writer_longitude(struct nmea_writer_t * w, const struct nmea_angle_t * v);
 
-const char * find_token_end(const char * s);
-const char * find_sentence_end(const char * s);
 int token_valid(const char * s, const char * p);
 
 #endif
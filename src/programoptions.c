@@ -1,6 +1,7 @@
 #include <global_config.h>
 #include <programoptions.h>
 #include <common/macros.h>
+#include <navcom/trace.h>
 #include <getopt.h>
 #include <string.h>
 #include <stdlib.h>
@@ -30,9 +31,28 @@ enum {
 	,OPTION_LIST_COMPACT
 	,OPTION_DUMP_CONFIG
 	,OPTION_MAX_MSG
+	,OPTION_BATCH
 	,OPTION_LOG
+	,OPTION_THREADS
+	,OPTION_FILTER_WORKERS
+	,OPTION_STATS
+	,OPTION_STATS_INTERVAL
+	,OPTION_TRACE
+	,OPTION_PRECOMPILE
+	,OPTION_LUA_CACHE
 };
 
+/**
+ * Default value for the maximum number of messages read from one
+ * source at once.
+ */
+#define DEFAULT_BATCH 16
+
+/**
+ * Default interval in seconds to write the statistics.
+ */
+#define DEFAULT_STATS_INTERVAL 10
+
 static const struct option OPTIONS_LONG[] =
 {
 	{ "help",         optional_argument, 0, OPTION_HELP         },
@@ -43,7 +63,16 @@ static const struct option OPTIONS_LONG[] =
 	{ "list-compact", no_argument,       0, OPTION_LIST_COMPACT },
 	{ "dump-config",  no_argument,       0, OPTION_DUMP_CONFIG  },
 	{ "max-msg",      required_argument, 0, OPTION_MAX_MSG      },
+	{ "batch",        required_argument, 0, OPTION_BATCH        },
 	{ "log",          required_argument, 0, OPTION_LOG          },
+	{ "threads",      no_argument,       0, OPTION_THREADS      },
+	{ "filter-workers", required_argument, 0, OPTION_FILTER_WORKERS },
+	{ "stats",        required_argument, 0, OPTION_STATS        },
+	{ "stats-interval", required_argument, 0, OPTION_STATS_INTERVAL },
+	{ "trace",        required_argument, 0, OPTION_TRACE        },
+	{ "precompile",   no_argument,       0, OPTION_PRECOMPILE   },
+	{ "lua-cache",    required_argument, 0, OPTION_LUA_CACHE    },
+	{ 0,              0,                 0, 0                   },
 };
 
 static void print_version(void)
@@ -97,6 +126,10 @@ static void print_config(const char * prefix, const char * suffix)
 	printf("%snmea_serial%s", prefix, suffix);
 #endif
 
+#if defined(ENABLE_TRACE)
+	printf("%strace%s", prefix, suffix);
+#endif
+
 	/* in case all options are turned off */
 	UNUSED_ARG(prefix);
 	UNUSED_ARG(suffix);
@@ -122,7 +155,21 @@ void print_usage(const char * name)
 	printf("  --list-compact  : lists all sources, destinations and filters on one compact line\n");
 	printf("  --dump-config   : dumps the configuration and exit\n");
 	printf("  --max-msg n     : routes n number of messages before terminating\n");
+	printf("  --batch n       : maximum number of messages read from one source at once (default: %d)\n", DEFAULT_BATCH);
 	printf("  --log n         : defines log level on syslog (0..7)\n");
+	printf("  --threads       : executes sources and destinations as threads instead of processes,\n");
+	printf("                    except those with the property _exec_:'process'\n");
+	printf("  --filter-workers n : executes filters by n worker threads instead of the hub (default: 0),\n");
+	printf("                    except those with the property _exec_:'inline'\n");
+	printf("  --stats file    : writes statistics (counters and latencies) periodically into the file\n");
+	printf("  --stats-interval n : interval in seconds to write the statistics (default: %d)\n", DEFAULT_STATS_INTERVAL);
+	printf("  --trace list    : records traces of the comma separated categories in memory,\n");
+	printf("                    dumped to syslog upon SIGUSR1. Categories: hub, route, filter,\n");
+	printf("                    source, destination, device, all\n");
+	printf("  --precompile    : compiles the Lua scripts of the configuration and writes\n");
+	printf("                    the precompiled scripts into the cache, then exits\n");
+	printf("  --lua-cache dir : directory for precompiled Lua scripts, written if missing or\n");
+	printf("                    outdated (default: next to the scripts, written only by --precompile)\n");
 	printf("\n");
 }
 
@@ -138,6 +185,8 @@ int parse_options(
 	/* default values */
 	memset(options, 0, sizeof(struct options_data_t));
 	options->log_mask = LOG_DEBUG;
+	options->batch = DEFAULT_BATCH;
+	options->stats_interval = DEFAULT_STATS_INTERVAL;
 
 	while (1) {
 		rc = getopt_long(argc, argv, "", OPTIONS_LONG, &index);
@@ -175,6 +224,46 @@ int parse_options(
 					return -1;
 				}
 				break;
+			case OPTION_BATCH:
+				options->batch = strtoul(optarg, &endptr, 0);
+				if (*endptr != '\0' || options->batch == 0) {
+					syslog(LOG_ERR, "invalid value for parameter '%s': '%s'", OPTIONS_LONG[index].name, optarg);
+					return -1;
+				}
+				break;
+			case OPTION_THREADS:
+				options->threads = 1;
+				break;
+			case OPTION_FILTER_WORKERS:
+				options->filter_workers = strtoul(optarg, &endptr, 0);
+				if (*endptr != '\0') {
+					syslog(LOG_ERR, "invalid value for parameter '%s': '%s'", OPTIONS_LONG[index].name, optarg);
+					return -1;
+				}
+				break;
+			case OPTION_STATS:
+				options->stats = 1;
+				strncpy(options->stats_filename, optarg, sizeof(options->stats_filename)-1);
+				break;
+			case OPTION_STATS_INTERVAL:
+				options->stats_interval = strtoul(optarg, &endptr, 0);
+				if (*endptr != '\0' || options->stats_interval == 0) {
+					syslog(LOG_ERR, "invalid value for parameter '%s': '%s'", OPTIONS_LONG[index].name, optarg);
+					return -1;
+				}
+				break;
+			case OPTION_TRACE:
+				if (trace_categories(optarg, &options->trace) != EXIT_SUCCESS) {
+					syslog(LOG_ERR, "invalid value for parameter '%s': '%s'", OPTIONS_LONG[index].name, optarg);
+					return -1;
+				}
+				break;
+			case OPTION_PRECOMPILE:
+				options->precompile = 1;
+				break;
+			case OPTION_LUA_CACHE:
+				strncpy(options->lua_cache, optarg, sizeof(options->lua_cache)-1);
+				break;
 			case OPTION_LOG:
 				options->log_mask = strtoul(optarg, &endptr, 0);
 				if (*endptr != '\0') {
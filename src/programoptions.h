@@ -2,6 +2,7 @@
 #define __PROGRAMOPTIONS__H__
 
 #include <limits.h>
+#include <stdint.h>
 
 /**
  * This structure contains all possible options the program provides.
@@ -15,6 +16,15 @@ struct options_data_t {
 	int list;
 	int list_compact;
 	unsigned int max_msg;
+	unsigned int batch;
+	int threads;
+	unsigned int filter_workers;
+	int stats;
+	unsigned int stats_interval;
+	char stats_filename[PATH_MAX+1];
+	uint32_t trace;
+	int precompile;
+	char lua_cache[PATH_MAX+1];
 	int log_mask;
 	char config_filename[PATH_MAX+1];
 };
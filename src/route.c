@@ -6,7 +6,13 @@
 #include <navcom/proc.h>
 #include <navcom/filter.h>
 #include <navcom/filter_list.h>
+#include <navcom/filter_pool.h>
+#include <navcom/message_queue.h>
+#include <navcom/property_read.h>
+#include <navcom/metrics.h>
+#include <navcom/trace.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <string.h>
 #include <syslog.h>
 
@@ -15,6 +21,11 @@
  * for messages from sources through filters to destinations.
  */
 struct msg_route_t {
+	/**
+	 * Configuration of the route.
+	 */
+	const struct route_t * cfg;
+
 	/**
 	 * Source of a message. This information is mandatory.
 	 */
@@ -39,19 +50,126 @@ struct msg_route_t {
 
 	/**
 	 * Runtime information of the filter. This context
-	 * may hold any information the filter sees fit and is
-	 * unique to the route. This means the same filter may
-	 * be applied to different routes, the context however
-	 * is unique to the route.
+	 * may hold any information the filter sees fit. Routes
+	 * of the same source with the same filter and configuration
+	 * share one context, only the route which is its own
+	 * 'filter_route' (the owner) initializes and uses it,
+	 * the context of the other routes stays unused.
+	 * See 'filter_route'.
 	 */
 	struct filter_context_t filter_ctx;
+
+	/**
+	 * Route which executes the filter on behalf of this route.
+	 * Routes of the same source with the same filter (and therefore
+	 * the same configuration) share the result, the filter is executed
+	 * only once per message using the context of the route referred to.
+	 * Routes which execute the filter themselves refer to themselves,
+	 * only those have an initialized filter context.
+	 */
+	struct msg_route_t * filter_route;
+
+	/**
+	 * Messages and results produced by the last execution of the filter
+	 * for a batch of messages, see route_msg_batch. Valid only for
+	 * routes which execute the filter themselves, allocated on demand.
+	 */
+	struct message_t * batch_out;
+	int * batch_result;
+	size_t batch_size;
+
+	/**
+	 * Non-zero if the filter is executed by the worker pool, valid
+	 * only for routes which execute the filter themselves.
+	 */
+	int worker;
+
+	/**
+	 * Queue of messages to be filtered by the worker pool, valid
+	 * only if the filter is executed by the worker pool.
+	 */
+	struct filter_queue_t queue;
+
+	/**
+	 * Counters of the route: messages of the source, messages sent
+	 * to the destination, messages discarded by the filter, failures
+	 * of the filter and failures to send to the destination.
+	 * Messages dropped by the queue of the worker pool are counted
+	 * by the queue. If the queue of the destination loses a message
+	 * while taking one of the route, this message is not counted as
+	 * sent, see forward.
+	 */
+	uint64_t msgs_in;
+	uint64_t msgs_out;
+	uint64_t discarded;
+	uint64_t filter_failures;
+	uint64_t write_failures;
+
+	/**
+	 * Execution times of the filter in nsec, valid only for routes
+	 * which execute the filter themselves and not by the worker pool.
+	 * One sample per message, or per batch for filters with a batch
+	 * function.
+	 */
+	struct histogram_t filter_time;
 };
 
 /**
  * Array of runtime information of all configured routes.
+ *
+ * The routes are grouped by their source, all routes of the same source
+ * are stored consecutively, in the order of the configuration.
  */
 static struct msg_route_t * msg_routes = NULL;
 
+/**
+ * Index into msg_routes per source. The routes of the source with the
+ * index i are stored in msg_routes from msg_route_index[i] up to
+ * (excluding) msg_route_index[i+1]. The array contains one entry more
+ * than there are sources.
+ */
+static size_t * msg_route_index = NULL;
+
+/**
+ * The proc configuration of the first source. Used to determine the
+ * index of a source.
+ */
+static const struct proc_config_t * msg_route_sources = NULL;
+
+/**
+ * Pool of worker threads to execute filters, valid only if
+ * filter_pool_active is non-zero.
+ */
+static struct filter_pool_t filter_pool;
+static int filter_pool_active = 0;
+
+/**
+ * Stops the worker pool and frees the queues of all routes.
+ */
+static void destroy_workers(const struct config_t * config)
+{
+	size_t i;
+	struct msg_route_t * route;
+
+	if (!filter_pool_active)
+		return;
+	filter_pool_destroy(&filter_pool);
+	filter_pool_active = 0;
+
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (!route->worker)
+			continue;
+		if (route->queue.dropped || route->queue.timeouts) {
+			syslog(LOG_NOTICE, "filter '%s' of route from '%s': %lu dropped, %lu timeouts",
+				route->filter->name, route->source->cfg->name,
+				route->queue.dropped, route->queue.timeouts);
+		}
+		filter_queue_destroy(&route->queue);
+		route->worker = 0;
+	}
+}
+
 /**
  * Frees all resources held by all routes.
  */
@@ -60,14 +178,23 @@ void route_destroy(const struct config_t * config)
 	size_t i;
 	struct msg_route_t * route;
 
+	if (msg_route_index) {
+		free(msg_route_index);
+		msg_route_index = NULL;
+	}
+	msg_route_sources = NULL;
+
 	if (msg_routes == NULL)
 		return;
 
+	destroy_workers(config);
 	for (i = 0; i < config->num_routes; ++i) {
 		route = &msg_routes[i];
-		if (route->filter && route->filter->exit) {
+		if (route->filter && route->filter->exit && (route->filter_route == route)) {
 			route->filter->exit(&route->filter_ctx);
 		}
+		free(route->batch_out);
+		free(route->batch_result);
 	}
 	free(msg_routes);
 	msg_routes = NULL;
@@ -83,47 +210,127 @@ void route_init(const struct config_t * config)
 
 	route_destroy(config);
 	msg_routes = malloc(sizeof(struct msg_route_t) * config->num_routes);
+	msg_route_index = malloc(sizeof(size_t) * (config->num_sources + 1));
+	for (i = 0; i <= config->num_sources; ++i) {
+		msg_route_index[i] = 0;
+	}
 	for (i = 0; i < config->num_routes; ++i) {
 		route = &msg_routes[i];
+		route->cfg = NULL;
 		route->source = NULL;
 		route->destination = NULL;
 		route->filter = NULL;
 		route->filter_cfg = NULL;
+		route->filter_ctx.data = NULL;
+		route->filter_route = NULL;
+		route->batch_out = NULL;
+		route->batch_result = NULL;
+		route->batch_size = 0;
+		route->worker = 0;
+		route->msgs_in = 0;
+		route->msgs_out = 0;
+		route->discarded = 0;
+		route->filter_failures = 0;
+		route->write_failures = 0;
+		histogram_init(&route->filter_time);
 	}
 }
 
-static void link_route_sources(
-		struct msg_route_t * route,
-		const struct config_t * config,
-		size_t route_config_index,
-		const struct proc_config_t * proc_conf,
-		size_t proc_conf_base)
+/**
+ * Builds the index of routes per source. After this, msg_route_index[i]
+ * contains the position within msg_routes for the first route of the
+ * source i.
+ *
+ * @param[in] config The configuration data.
+ * @retval  0 Success
+ * @retval -1 Failure, a route refers to an unknown source.
+ */
+static int build_route_index(const struct config_t * config)
 {
-	size_t j;
+	size_t i;
+	size_t src;
+	size_t pos;
+	size_t num;
 
-	for (j = 0; j < config->num_sources; ++j) {
-		if (proc_conf[j + proc_conf_base].cfg == config->routes[route_config_index].source) {
-			route->source = &proc_conf[j + proc_conf_base];
-			break;
+	/* number of routes per source */
+	for (i = 0; i < config->num_routes; ++i) {
+		src = config->routes[i].source - config->sources;
+		if (src >= config->num_sources) {
+			syslog(LOG_ERR, "%s:unknown source: '%s'", __FUNCTION__,
+					config->routes[i].name_source);
+			return -1;
 		}
+		++msg_route_index[src];
+	}
+
+	/* start position of routes per source */
+	pos = 0;
+	for (i = 0; i <= config->num_sources; ++i) {
+		num = msg_route_index[i];
+		msg_route_index[i] = pos;
+		pos += num;
 	}
+
+	return 0;
 }
 
-static void link_route_destinations(
+/**
+ * Determines the route which executes the filter for the specified route,
+ * which is the first route of the same source using the same filter.
+ *
+ * @param[in] route The route to determine the filter executing route for.
+ * @param[in] first The first route of the same source.
+ * @return The filter executing route, may be the route itself.
+ */
+static struct msg_route_t * find_filter_route(
 		struct msg_route_t * route,
-		const struct config_t * config,
-		size_t route_config_index,
-		const struct proc_config_t * proc_conf,
-		size_t proc_conf_base)
+		struct msg_route_t * first)
 {
+	for (; first != route; ++first) {
+		if ((first->filter == route->filter) && (first->filter_cfg == route->filter_cfg))
+			return first;
+	}
+	return route;
+}
+
+/**
+ * Initializes the filters of all routes. Filters shared among routes
+ * of the same source are initialized only once.
+ *
+ * @param[in] config The configuration data.
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+static int init_route_filters(const struct config_t * config)
+{
+	size_t i;
 	size_t j;
+	struct msg_route_t * route;
 
-	for (j = 0; j < config->num_destinations; ++j) {
-		if (proc_conf[j + proc_conf_base].cfg == config->routes[route_config_index].destination) {
-			route->destination = &proc_conf[j + proc_conf_base];
-			break;
+	for (i = 0; i < config->num_sources; ++i) {
+		for (j = msg_route_index[i]; j < msg_route_index[i + 1]; ++j) {
+			route = &msg_routes[j];
+			if (route->filter == NULL)
+				continue;
+
+			route->filter_route = find_filter_route(route, &msg_routes[msg_route_index[i]]);
+			if (route->filter_route != route)
+				continue;
+
+			if (route->filter->init) {
+				if (route->filter->init(&route->filter_ctx, route->filter_cfg) != EXIT_SUCCESS) {
+					syslog(LOG_ERR, "%s:filter configuration failure for route from '%s' to '%s'",
+							__FUNCTION__, route->source->cfg->name, route->destination->cfg->name);
+					if (route->filter->exit) {
+						route->filter->exit(&route->filter_ctx);
+					}
+					route->filter_route = NULL;
+					return -1;
+				}
+			}
 		}
 	}
+	return 0;
 }
 
 /**
@@ -141,19 +348,34 @@ int route_setup(
 		size_t proc_conf_base_dst)
 {
 	size_t i;
+	size_t src;
+	size_t dst;
 	struct msg_route_t * route;
 
+	if (build_route_index(config) < 0)
+		return -1;
+	msg_route_sources = &proc_conf[proc_conf_base_src];
+
 	for (i = 0; i < config->num_routes; ++i) {
-		route = &msg_routes[i];
-		route->source = NULL;
-		route->destination = NULL;
+		src = config->routes[i].source - config->sources;
+		dst = config->routes[i].destination - config->destinations;
+		if (dst >= config->num_destinations) {
+			syslog(LOG_ERR, "%s:unknown destination: '%s'", __FUNCTION__,
+					config->routes[i].name_destination);
+			return -1;
+		}
+
+		/* place route after all previously set up routes of the same source,
+		 * msg_route_index[src] is used as insert position and restored
+		 * after all routes are set up. */
+		route = &msg_routes[msg_route_index[src]++];
+		route->cfg = &config->routes[i];
+		route->source = &proc_conf[proc_conf_base_src + src];
+		route->destination = &proc_conf[proc_conf_base_dst + dst];
 		route->filter = NULL;
 		route->filter_cfg = NULL;
 
-		link_route_sources(route, config, i, proc_conf, proc_conf_base_src);
-		link_route_destinations(route, config, i, proc_conf, proc_conf_base_dst);
-
-		/* link initialized filter */
+		/* link filter */
 		if (config->routes[i].filter == NULL)
 			continue;
 
@@ -163,84 +385,465 @@ int route_setup(
 					config->routes[i].name_filter);
 			return -1;
 		}
-
 		route->filter_cfg = &config->routes[i].filter->properties;
-		if (route->filter->init) {
-			if (route->filter->init(&route->filter_ctx, route->filter_cfg) != EXIT_SUCCESS) {
-				syslog(LOG_ERR, "%s:filter configuration failure: '%s'",
-						__FUNCTION__, config->routes[i].name_filter);
-				if (route->filter->exit) {
-					route->filter->exit(&route->filter_ctx);
-				}
-				return -1;
-			}
+	}
+
+	/* restore index, every insert position now points to the start of the next source */
+	for (i = config->num_sources; i > 0; --i) {
+		msg_route_index[i] = msg_route_index[i - 1];
+	}
+	msg_route_index[0] = 0;
+
+	return init_route_filters(config);
+}
+
+/**
+ * Executes the filter of the route for a batch of messages, or takes
+ * the results of the route which already executed the same filter for
+ * the current batch. Filters without batch function are executed for
+ * every message.
+ *
+ * @param[in] route The route to execute the filter for.
+ * @param[in] msgs The messages to filter.
+ * @param[in] n Number of messages.
+ * @retval  0 Success, the filtered messages and their results are
+ *   stored in the filter executing route.
+ * @retval -1 Failure, unable to allocate the buffers.
+ */
+static int execute_filter_batch(
+		struct msg_route_t * route,
+		const struct message_t * msgs,
+		size_t n)
+{
+	struct msg_route_t * exec = route->filter_route;
+	struct message_t * out;
+	int * result;
+	uint64_t t;
+	size_t i;
+
+	if (exec != route)
+		return (exec->batch_size >= n) ? 0 : -1;
+
+	if (exec->batch_size < n) {
+		out = realloc(exec->batch_out, sizeof(struct message_t) * n);
+		if (out == NULL)
+			return -1;
+		exec->batch_out = out;
+		result = realloc(exec->batch_result, sizeof(int) * n);
+		if (result == NULL)
+			return -1;
+		exec->batch_result = result;
+		exec->batch_size = n;
+	}
+
+	memset(exec->batch_out, 0, sizeof(struct message_t) * n);
+	if (exec->filter->batch) {
+		t = metrics_now();
+		if (exec->filter->batch(exec->batch_out, msgs, exec->batch_result, n,
+			&exec->filter_ctx, exec->filter_cfg) != EXIT_SUCCESS) {
+			for (i = 0; i < n; ++i)
+				exec->batch_result[i] = FILTER_FAILURE;
+		}
+		histogram_add(&exec->filter_time, metrics_now() - t);
+	} else {
+		for (i = 0; i < n; ++i) {
+			t = metrics_now();
+			exec->batch_result[i] = exec->filter->func(&exec->batch_out[i], &msgs[i],
+				&exec->filter_ctx, exec->filter_cfg);
+			histogram_add(&exec->filter_time, metrics_now() - t);
 		}
 	}
+	return 0;
+}
+
+/**
+ * Sends the message to the destination of the route, according
+ * to the result of the filter, and counts the outcome.
+ *
+ * @param[in] route The route to send the message along.
+ * @param[in] out The message to send.
+ * @param[in] filter_result The result of the filter, FILTER_SUCCESS
+ *   for routes without filter.
+ * @retval  0 Success, the message was sent or discarded.
+ * @retval -1 Failure of the filter or of sending the message.
+ */
+static int forward(
+		struct msg_route_t * route,
+		const struct message_t * out,
+		int filter_result)
+{
+	unsigned long lost;
+
+	switch (filter_result) {
+		case FILTER_SUCCESS:
+			break;
+		case FILTER_DISCARD:
+			++route->discarded;
+			return 0;
+		default:
+		case FILTER_FAILURE:
+			++route->filter_failures;
+			syslog(LOG_ERR, "filter error");
+			return -1;
+	}
+
+	TRACE(TRACE_ROUTE, "%s -> %s: %08x", route->source->cfg->name,
+		route->destination->cfg->name, out->type);
+	lost = message_queue_lost(route->destination->queue);
+	if (proc_send(route->destination, out) != EXIT_SUCCESS) {
+		++route->write_failures;
+		syslog(LOG_CRIT, "unable to route message");
+		return -1;
+	}
 
+	/* dropped or replaced messages are counted by the queue of the destination */
+	if (message_queue_lost(route->destination->queue) == lost)
+		++route->msgs_out;
 	return 0;
 }
 
 /**
- * Routes a message sent by a source to a destination using an optional filter.
- * The routes are processed sequentially, using a filter in this context.
+ * Routes a message sent by a source to all of its destinations using optional
+ * filters. The routes of the source are processed sequentially, using a filter
+ * in this context. Routes of other sources are not being looked at.
  *
- * @note Filters are running in the context of the main process, therefore
- *   it has to kept in mind to implement them in a manner as efficient as possible.
- *   Theoretically a filter does not consume any resources (especially time).
+ * All routes of the source are processed, independent of the outcome of
+ * other routes. Routes without filter send the original message.
+ * Routes of the same source with the same filter execute the filter
+ * only once and share the result.
+ *
+ * Filters executed by the worker pool are not executed here, the message
+ * is submitted to the queue of the filter instead. If the queue is full,
+ * the message is dropped for all routes sharing the filter. The results
+ * are routed by route_collect.
+ *
+ * @note Filters not executed by the worker pool are running in the context
+ *   of the main process, therefore it has to kept in mind to implement them
+ *   in a manner as efficient as possible. Theoretically a filter does not
+ *   consume any resources (especially time).
+ *
+ * This is the same as route_msg_batch with a batch of one message.
  *
  * @param[in] config The system configuration.
  * @param[in] source The source of the message.
  * @param[in] msg The message to send.
  * @retval  0 Success
- * @retval -1 Failure
+ * @retval -1 Failure, at least one route failed.
  */
 int route_msg(
 		const struct config_t * config,
 		const struct proc_config_t * source,
 		const struct message_t * msg)
+{
+	return route_msg_batch(config, source, msg, 1);
+}
+
+/**
+ * Routes a batch of messages sent by a source, like route_msg does for
+ * every single message. Filters are executed once for the whole batch,
+ * using their batch function if they provide one. The order of messages
+ * is kept for every destination.
+ *
+ * @param[in] config The system configuration.
+ * @param[in] source The source of the messages.
+ * @param[in] msgs The messages to send.
+ * @param[in] n Number of messages.
+ * @retval  0 Success
+ * @retval -1 Failure, at least one route failed for at least one message.
+ */
+int route_msg_batch(
+		const struct config_t * config,
+		const struct proc_config_t * source,
+		const struct message_t * msgs,
+		size_t n)
 {
 	size_t i;
-	int rc;
+	size_t j;
+	size_t src;
+	int result = 0;
 	struct msg_route_t * route;
-	struct message_t out;
+	struct msg_route_t * exec;
 
 	if (config == NULL)
 		return -1;
 	if (source == NULL)
 		return -1;
-	if (msg == NULL)
+	if (msgs == NULL)
+		return -1;
+	if (n == 0)
+		return 0;
+	if (msg_route_sources == NULL)
+		return -1;
+	if (source < msg_route_sources)
 		return -1;
 
-	for (i = 0; i < config->num_routes; ++i) {
+	src = source - msg_route_sources;
+	if (src >= config->num_sources)
+		return -1;
+
+	for (i = msg_route_index[src]; i < msg_route_index[src + 1]; ++i) {
 		route = &msg_routes[i];
-		if (route->source != source)
-			continue;
+		route->msgs_in += n;
 
 		/* execute filter if configured */
+		if (route->filter && route->filter_route->worker) {
+			if (route->filter_route != route)
+				continue;
+			for (j = 0; j < n; ++j) {
+				if (filter_pool_submit(&filter_pool, &route->queue, &msgs[j]) != EXIT_SUCCESS) {
+					TRACE(TRACE_FILTER, "queue of filter '%s' full, message dropped", route->filter->name);
+				}
+			}
+			continue;
+		}
 		if (route->filter) {
-			memset(&out, 0, sizeof(out));
-			rc = route->filter->func(&out, msg, &route->filter_ctx, route->filter_cfg);
-			switch (rc) {
-				case FILTER_SUCCESS:
-					break;
-				case FILTER_DISCARD:
-					return 0;
-				default:
-				case FILTER_FAILURE:
-					syslog(LOG_ERR, "filter error");
-					return -1;
+			if (execute_filter_batch(route, msgs, n) < 0) {
+				syslog(LOG_CRIT, "unable to allocate filter results");
+				route->filter_failures += n;
+				result = -1;
+				continue;
 			}
-		} else {
-			memcpy(&out, msg, sizeof(out));
+			exec = route->filter_route;
+			for (j = 0; j < n; ++j) {
+				if (forward(route, &exec->batch_out[j], exec->batch_result[j]) < 0)
+					result = -1;
+			}
+			continue;
+		}
+
+		/* send original messages to destination */
+		for (j = 0; j < n; ++j) {
+			if (forward(route, &msgs[j], FILTER_SUCCESS) < 0)
+				result = -1;
+		}
+	}
+	return result;
+}
+
+/**
+ * Sets up the worker pool to execute filters, must be called after
+ * the routes are set up. If there are no workers, all filters are
+ * executed by route_msg. Otherwise all filters are executed by the
+ * workers, except those configured otherwise. The filter properties
+ * are:
+ * - '_exec_' : 'worker' or 'inline' (executed by route_msg), default is 'worker'
+ * - '_queue_' : maximum number of messages queued for the filter
+ * - '_timeout_' : maximum execution time in msec, results of executions
+ *   taking longer are discarded, default is 0 (unlimited)
+ *
+ * Routes sharing a filter share the queue, the order of messages is
+ * kept for every queue.
+ *
+ * @param[in] config The configuration data.
+ * @param[in] num_workers Number of worker threads.
+ * @retval  0 Success
+ * @retval -1 Failure
+ */
+int route_setup_workers(const struct config_t * config, size_t num_workers)
+{
+	size_t i;
+	struct msg_route_t * route;
+	const char * exec;
+	uint32_t size;
+	uint32_t timeout;
+
+	if (config == NULL)
+		return -1;
+	if (num_workers == 0)
+		return 0;
+	if (msg_routes == NULL)
+		return -1;
+
+	if (filter_pool_create(&filter_pool, num_workers) != EXIT_SUCCESS) {
+		syslog(LOG_ERR, "%s:unable to create filter worker pool", __FUNCTION__);
+		return -1;
+	}
+	filter_pool_active = 1;
+
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (route->filter == NULL || route->filter_route != route)
+			continue;
+
+		exec = proplist_value(route->filter_cfg, "_exec_");
+		if (exec && strcmp(exec, "inline") == 0)
+			continue;
+		if (exec && strcmp(exec, "worker") != 0) {
+			syslog(LOG_ERR, "%s:unknown execution for filter '%s': '%s'", __FUNCTION__,
+					route->filter->name, exec);
+			return -1;
 		}
 
-		/* send message to destination */
-		syslog(LOG_DEBUG, "route: %08x\n", msg->type);
-		if (message_write(route->destination->wfd, &out) != EXIT_SUCCESS) {
-			syslog(LOG_CRIT, "unable to route message");
+		size = FILTER_QUEUE_SIZE_DEFAULT;
+		timeout = 0;
+		if (property_read_uint32(route->filter_cfg, "_queue_", &size) != EXIT_SUCCESS)
+			return -1;
+		if (property_read_uint32(route->filter_cfg, "_timeout_", &timeout) != EXIT_SUCCESS)
+			return -1;
+		if (filter_queue_init(&route->queue, route->filter, &route->filter_ctx,
+			route->filter_cfg, size, timeout) != EXIT_SUCCESS) {
+			syslog(LOG_ERR, "%s:unable to create filter queue for route from '%s' to '%s'",
+					__FUNCTION__, route->source->cfg->name, route->destination->cfg->name);
 			return -1;
 		}
+		route->worker = 1;
 	}
 	return 0;
 }
 
+/**
+ * Returns the file descriptor which becomes readable if results
+ * of the worker pool are available, -1 if there is no worker pool.
+ */
+int route_fd(void)
+{
+	return filter_pool_active ? filter_pool.efd : -1;
+}
+
+/**
+ * Forwards the result of the filter to all routes sharing the filter
+ * of the specified route.
+ */
+static int deliver(struct msg_route_t * exec, const struct message_t * out, int filter_result)
+{
+	size_t i;
+	size_t src = exec->source - msg_route_sources;
+	int result = 0;
+
+	for (i = exec - msg_routes; i < msg_route_index[src + 1]; ++i) {
+		if (msg_routes[i].filter_route != exec)
+			continue;
+		if (forward(&msg_routes[i], out, filter_result) < 0)
+			result = -1;
+	}
+	return result;
+}
+
+/**
+ * Collects the results of the worker pool and routes the filtered
+ * messages to their destinations. To be called if the file descriptor
+ * returned by route_fd is readable.
+ *
+ * @param[in] config The system configuration.
+ * @retval  0 Success
+ * @retval -1 Failure, at least one route failed.
+ */
+int route_collect(const struct config_t * config)
+{
+	size_t i;
+	int result = 0;
+	int filter_result;
+	struct msg_route_t * route;
+	struct message_t out;
+
+	if (config == NULL)
+		return -1;
+	if (!filter_pool_active)
+		return 0;
+
+	filter_pool_acknowledge(&filter_pool);
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (!route->worker)
+			continue;
+		while (filter_pool_result(&filter_pool, &route->queue, &out, &filter_result) > 0) {
+			if (deliver(route, &out, filter_result) < 0)
+				result = -1;
+		}
+	}
+	return result;
+}
+
+/**
+ * Lets the filters executed by route_msg do work of low priority,
+ * one portion per filter, see filter_desc_t::idle. To be called
+ * while there are no messages to route. Filters executed by the
+ * worker pool are not called.
+ *
+ * @param[in] config The system configuration.
+ * @return Number of filters which still have work left.
+ */
+int route_idle(const struct config_t * config)
+{
+	size_t i;
+	int pending = 0;
+	struct msg_route_t * route;
+
+	if (config == NULL || msg_routes == NULL)
+		return 0;
+
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (route->filter == NULL || route->filter_route != route || route->worker)
+			continue;
+		if (route->filter->idle == NULL)
+			continue;
+		if (route->filter->idle(&route->filter_ctx))
+			++pending;
+	}
+	return pending;
+}
+
+/**
+ * Writes the counters of all routes and the execution times of
+ * their filters as text, one line per route and per filter. Filters
+ * may add their own statistics to their line.
+ *
+ * Example:
+ * @code
+ * route gps --[nmea]--> log in=120 out=60 discarded=60 filter_failures=0 write_failures=0
+ * filter gps:nmea exec=worker dropped=0 timeouts=0
+ * filter gps:lua exec=inline lua_used=40960 lua_peak=51200 lua_limit=0 lua_slabs=32768 lua_failures=0 gc=auto gc_steps=0 gc_cycles=0 gc_max_pause=0
+ * histogram filter:gps:nmea count=120 ...
+ * @endcode
+ *
+ * @param[in] config The system configuration.
+ * @param[in] file The file to write to.
+ */
+void route_write_metrics(const struct config_t * config, FILE * file)
+{
+	size_t i;
+	struct msg_route_t * route;
+	unsigned long dropped;
+	unsigned long timeouts;
+	struct histogram_t exec_time;
+	char name[128];
+
+	if (config == NULL || file == NULL || msg_routes == NULL)
+		return;
+
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (route->cfg == NULL)
+			continue;
+		if (route->cfg->name_filter)
+			fprintf(file, "route %s --[%s]--> %s", route->cfg->name_source,
+				route->cfg->name_filter, route->cfg->name_destination);
+		else
+			fprintf(file, "route %s --> %s", route->cfg->name_source,
+				route->cfg->name_destination);
+		fprintf(file, " in=%" PRIu64 " out=%" PRIu64 " discarded=%" PRIu64
+			" filter_failures=%" PRIu64 " write_failures=%" PRIu64 "\n",
+			route->msgs_in, route->msgs_out, route->discarded,
+			route->filter_failures, route->write_failures);
+	}
+
+	for (i = 0; i < config->num_routes; ++i) {
+		route = &msg_routes[i];
+		if (route->cfg == NULL || route->filter == NULL || route->filter_route != route)
+			continue;
+		snprintf(name, sizeof(name), "%s:%s", route->cfg->name_source, route->cfg->name_filter);
+		if (route->worker) {
+			filter_pool_stats(&filter_pool, &route->queue, &dropped, &timeouts, &exec_time);
+			fprintf(file, "filter %s exec=worker dropped=%lu timeouts=%lu", name, dropped, timeouts);
+		} else {
+			memcpy(&exec_time, &route->filter_time, sizeof(exec_time));
+			fprintf(file, "filter %s exec=inline", name);
+		}
+		if (route->filter->stats)
+			route->filter->stats(&route->filter_ctx, file);
+		fprintf(file, "\n");
+		snprintf(name, sizeof(name), "filter:%s:%s", route->cfg->name_source, route->cfg->name_filter);
+		histogram_write(file, name, &exec_time);
+	}
+}
@@ -2,6 +2,7 @@
 #define __ROUTE__H__
 
 #include <stddef.h>
+#include <stdio.h>
 
 struct config_t;
 struct proc_config_t;
@@ -15,6 +16,8 @@ int route_setup(
 		size_t,
 		size_t);
 
+int route_setup_workers(const struct config_t *, size_t);
+
 void route_destroy(const struct config_t *);
 
 int route_msg(
@@ -22,4 +25,18 @@ int route_msg(
 		const struct proc_config_t *,
 		const struct message_t *);
 
+int route_msg_batch(
+		const struct config_t *,
+		const struct proc_config_t *,
+		const struct message_t *,
+		size_t);
+
+int route_fd(void);
+
+int route_collect(const struct config_t *);
+
+int route_idle(const struct config_t *);
+
+void route_write_metrics(const struct config_t *, FILE *);
+
 #endif
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <navcom/lua_alloc.h>
+#include <common/macros.h>
+#include <lua/lua.h>
+#include <lua/lualib.h>
+#include <lua/lauxlib.h>
+
+/**
+ * Benchmark of the allocator of Lua states. The same allocation heavy
+ * script (short lived tables and strings, like a filter converting
+ * messages into tables) is executed by a Lua state using the default
+ * allocator (realloc) and by a Lua state using the pool allocator.
+ */
+
+#define NUM_CALLS 200000
+
+static const char * SCRIPT =
+	"function handle(i)\n"
+	"	local t = { id = i, name = 'msg' .. i, data = { lat = 1.0, lon = 2.0 } }\n"
+	"	return #t.name\n"
+	"end\n"
+	;
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+/**
+ * Executes the script with the specified Lua state.
+ *
+ * @return Calls per second, 0.0 in case of an error.
+ */
+static double bench(lua_State * lua)
+{
+	size_t i;
+	double t;
+
+	luaL_openlibs(lua);
+	if (luaL_dostring(lua, SCRIPT) != LUA_OK) {
+		printf("error: %s\n", lua_tostring(lua, -1));
+		return 0.0;
+	}
+
+	t = now();
+	for (i = 0; i < NUM_CALLS; ++i) {
+		lua_getglobal(lua, "handle");
+		lua_pushinteger(lua, i);
+		if (lua_pcall(lua, 1, 1, 0) != LUA_OK) {
+			printf("error: %s\n", lua_tostring(lua, -1));
+			return 0.0;
+		}
+		lua_pop(lua, 1);
+	}
+	t = now() - t;
+
+	return NUM_CALLS / t;
+}
+
+int main(int argc, char ** argv)
+{
+	lua_State * lua;
+	struct lua_alloc_t a;
+
+	UNUSED_ARG(argc);
+	UNUSED_ARG(argv);
+
+	printf("%-14s %14s\n", "allocator", "calls/sec");
+
+	lua = luaL_newstate();
+	printf("%-14s %14.0f\n", "realloc", bench(lua));
+	lua_close(lua);
+
+	luaH_alloc_init(&a, 0);
+	lua = luaH_newstate(&a);
+	printf("%-14s %14.0f\n", "pool", bench(lua));
+	lua_close(lua);
+	printf("%-14s %14lu\n", "peak bytes", (unsigned long)a.peak);
+	printf("%-14s %14lu\n", "slab bytes", (unsigned long)a.slabs);
+	luaH_alloc_destroy(&a);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <navcom/filter/filter_lua.h>
+#include <navcom/message.h>
+#include <common/macros.h>
+
+/**
+ * Benchmark of the message access from Lua filters. The same trivial
+ * filter (discard fast NMEA RMC messages, pass all others) is executed
+ * by filter_lua, once converting the message with msg_to_table, once
+ * reading the fields of the message object directly and once for
+ * batches of messages with one call of the script per batch.
+ */
+
+#define NUM_MESSAGES 500000
+#define BATCH_SIZE 16
+
+static const char * SCRIPT_TABLE =
+	"function filter(msg_out, msg_in)\n"
+	"	local t = msg_to_table(msg_in)\n"
+	"	if t.msg_type == MSG_NMEA and t.data.nmea.nmea_type == NMEA_RMC then\n"
+	"		if t.data.nmea.sentence.sog > 50.0 then\n"
+	"			return FILTER_DISCARD\n"
+	"		end\n"
+	"	end\n"
+	"	msg_clone(msg_out, msg_in)\n"
+	"	return FILTER_SUCCESS\n"
+	"end\n"
+	;
+
+static const char * SCRIPT_OBJECT =
+	"function filter(msg_out, msg_in)\n"
+	"	if msg_in.msg_type == MSG_NMEA and msg_in.nmea_type == NMEA_RMC then\n"
+	"		if msg_in.sog > 50.0 then\n"
+	"			return FILTER_DISCARD\n"
+	"		end\n"
+	"	end\n"
+	"	msg_clone(msg_out, msg_in)\n"
+	"	return FILTER_SUCCESS\n"
+	"end\n"
+	;
+
+static const char * SCRIPT_BATCH =
+	"local results = {}\n"
+	"function filter_batch(msgs_out, msgs_in, n)\n"
+	"	for i = 1, n do\n"
+	"		local msg_in = msgs_in[i]\n"
+	"		results[i] = FILTER_SUCCESS\n"
+	"		if msg_in.msg_type == MSG_NMEA and msg_in.nmea_type == NMEA_RMC then\n"
+	"			if msg_in.sog > 50.0 then\n"
+	"				results[i] = FILTER_DISCARD\n"
+	"			end\n"
+	"		end\n"
+	"		if results[i] == FILTER_SUCCESS then\n"
+	"			msg_clone(msgs_out[i], msg_in)\n"
+	"		end\n"
+	"	end\n"
+	"	return results\n"
+	"end\n"
+	;
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+/**
+ * Executes the script as filter for all messages.
+ *
+ * @param[in] script The Lua script.
+ * @param[in] batch Number of messages per call of the batch function
+ *   of the filter, 0 to call the filter for every message.
+ * @return Messages per second, 0.0 in case of an error.
+ */
+static double bench(const char * script, size_t batch)
+{
+	char filename[64];
+	struct property_list_t properties;
+	struct filter_context_t ctx;
+	struct message_t msg_in[BATCH_SIZE];
+	struct message_t msg_out[BATCH_SIZE];
+	int results[BATCH_SIZE];
+	size_t i;
+	size_t j;
+	double t;
+	int fd;
+
+	strncpy(filename, "/tmp/bench_lua_messageXXXXXX", sizeof(filename));
+	fd = mkstemp(filename);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 0.0;
+	}
+	if (write(fd, script, strlen(script)) != (ssize_t)strlen(script)) {
+		perror("write");
+		close(fd);
+		unlink(filename);
+		return 0.0;
+	}
+	close(fd);
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", filename);
+	memset(&ctx, 0, sizeof(ctx));
+	if (filter_lua.init(&ctx, &properties) != EXIT_SUCCESS) {
+		printf("error: unable to initialize filter\n");
+		proplist_free(&properties);
+		unlink(filename);
+		return 0.0;
+	}
+
+	memset(msg_in, 0, sizeof(msg_in));
+	for (j = 0; j < BATCH_SIZE; ++j) {
+#if defined(NEEDS_NMEA)
+		msg_in[j].type = MSG_NMEA;
+		nmea_read(&msg_in[j].data.attr.nmea,
+			"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17");
+#else
+		msg_in[j].type = MSG_TIMER;
+		msg_in[j].data.attr.timer_id = 1;
+#endif
+	}
+
+	t = now();
+	if (batch == 0) {
+		for (i = 0; i < NUM_MESSAGES; ++i) {
+			if (filter_lua.func(&msg_out[0], &msg_in[0], &ctx, &properties) != FILTER_SUCCESS) {
+				printf("error: filter failed\n");
+				break;
+			}
+		}
+	} else {
+		for (i = 0; i < NUM_MESSAGES; i += batch) {
+			if (filter_lua.batch(msg_out, msg_in, results, batch, &ctx, &properties) != EXIT_SUCCESS
+				|| results[0] != FILTER_SUCCESS) {
+				printf("error: filter failed\n");
+				break;
+			}
+		}
+	}
+	t = now() - t;
+
+	filter_lua.exit(&ctx);
+	proplist_free(&properties);
+	unlink(filename);
+
+	if (i < NUM_MESSAGES)
+		return 0.0;
+	return NUM_MESSAGES / t;
+}
+
+int main(int argc, char ** argv)
+{
+	UNUSED_ARG(argc);
+	UNUSED_ARG(argv);
+
+	setlogmask(LOG_UPTO(LOG_ERR));
+
+	printf("%-14s %14s\n", "api", "messages/sec");
+	printf("%-14s %14.0f\n", "msg_to_table", bench(SCRIPT_TABLE, 0));
+	printf("%-14s %14.0f\n", "message object", bench(SCRIPT_OBJECT, 0));
+	printf("%-14s %14.0f\n", "batch of 16", bench(SCRIPT_BATCH, BATCH_SIZE));
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nmea/nmea.h>
+#include <common/macros.h>
+
+/**
+ * Benchmark of reading NMEA sentences. A mix of typical sentences
+ * is parsed repeatedly, the number of sentences per second is reported.
+ */
+
+#define NUM_ROUNDS 200000
+
+static const char * SENTENCES[] = {
+	"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17",
+	"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+	"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+	"$GPGSV,3,1,10,05,07,188,29,08,15,075,35,09,40,277,00,12,20,212,00*75",
+	"$GPGLL,4916.45,N,12311.12,W,225444,A*31",
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48",
+	"$GPRMB,A,0.66,L,003,004,4917.24,N,12309.57,W,001.3,052.5,000.5,V*20",
+	"$HCHDG,98.3,0.0,E,12.6,W*57",
+	"$IIMWV,214.8,R,0.1,K,A*36",
+	"$IIDBT,0017.6,f,0005.4,M,0002.9,F*2B",
+	"$IIVHW,245.1,T,245.1,M,000.01,N,000.01,K*55",
+	"$IIMTW,15.2,C*15",
+};
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+int main(int argc, char ** argv)
+{
+	static const size_t NUM_SENTENCES = sizeof(SENTENCES) / sizeof(SENTENCES[0]);
+
+	struct nmea_t nmea;
+	size_t i;
+	size_t j;
+	size_t errors = 0;
+	double t;
+
+	UNUSED_ARG(argc);
+	UNUSED_ARG(argv);
+
+	for (j = 0; j < NUM_SENTENCES; ++j) {
+		if (nmea_read(&nmea, SENTENCES[j]) != 0) {
+			printf("error: unable to read sentence: '%s'\n", SENTENCES[j]);
+			++errors;
+		}
+	}
+
+	t = now();
+	for (i = 0; i < NUM_ROUNDS; ++i) {
+		for (j = 0; j < NUM_SENTENCES; ++j) {
+			nmea_read(&nmea, SENTENCES[j]);
+		}
+	}
+	t = now() - t;
+
+	printf("%14s %14s\n", "sentences/s", "ns/sentence");
+	printf("%14.0f %14.1f\n",
+		(double)(NUM_ROUNDS * NUM_SENTENCES) / t,
+		t * 1.0e9 / (NUM_ROUNDS * NUM_SENTENCES));
+
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nmea/nmea_base.h>
+#include <nmea/nmea_scan.h>
+#include <common/macros.h>
+
+/**
+ * Microbenchmark of the NMEA scan kernels (checksum and delimiters).
+ *
+ * The sentences are read from a recorded log, one sentence per line,
+ * specified as argument. Without argument a built in set of sentences
+ * is used.
+ *
+ * Usage: bench_nmea_scan [logfile]
+ */
+
+#define MAX_SENTENCES 100000
+#define MIN_BYTES (64 * 1024 * 1024)
+
+static const char * DEFAULT_SENTENCES[] = {
+	"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17",
+	"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+	"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+	"$GPGSV,3,1,10,05,07,188,29,08,15,075,35,09,40,277,00,12,20,212,00*75",
+	"$GPGLL,4916.45,N,12311.12,W,225444,A*31",
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48",
+	"$HCHDG,98.3,0.0,E,12.6,W*57",
+	"$IIMWV,214.8,R,0.1,K,A*36",
+};
+
+static char sentences[MAX_SENTENCES][NMEA_MAX_SENTENCE + 1];
+static uint32_t lengths[MAX_SENTENCES];
+static size_t num_sentences = 0;
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+static void add_sentence(const char * s)
+{
+	size_t len = strcspn(s, "\r\n");
+
+	if (num_sentences >= MAX_SENTENCES)
+		return;
+	if (s[0] != START_TOKEN_NMEA && s[0] != START_TOKEN_AIVDM)
+		return;
+	if (len > NMEA_MAX_SENTENCE)
+		return;
+	memcpy(sentences[num_sentences], s, len);
+	sentences[num_sentences][len] = '\0';
+	lengths[num_sentences] = (uint32_t)len - 1;
+	++num_sentences;
+}
+
+static int load(const char * filename)
+{
+	FILE * file;
+	char line[256];
+
+	file = fopen(filename, "r");
+	if (file == NULL) {
+		perror("fopen");
+		return -1;
+	}
+	while (fgets(line, sizeof(line), file))
+		add_sentence(line);
+	fclose(file);
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	const struct nmea_scan_kernel_t * kernel;
+	struct nmea_scan_t result;
+	size_t bytes = 0;
+	size_t rounds;
+	size_t i;
+	size_t j;
+	uint32_t sum;
+	double t;
+
+	if (argc > 1) {
+		if (load(argv[1]) < 0)
+			return EXIT_FAILURE;
+	} else {
+		for (i = 0; i < sizeof(DEFAULT_SENTENCES) / sizeof(DEFAULT_SENTENCES[0]); ++i)
+			add_sentence(DEFAULT_SENTENCES[i]);
+	}
+	if (num_sentences == 0) {
+		printf("error: no sentences\n");
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < num_sentences; ++i)
+		bytes += lengths[i];
+	rounds = MIN_BYTES / bytes + 1;
+
+	printf("sentences: %lu, selected kernel: %s\n",
+		(unsigned long)num_sentences, nmea_scan_kernel()->name);
+	printf("%8s %14s %14s\n", "kernel", "MB/s", "sentences/s");
+	for (kernel = nmea_scan_kernels; kernel->name; ++kernel) {
+		if (!kernel->supported())
+			continue;
+		sum = 0;
+		t = now();
+		for (i = 0; i < rounds; ++i) {
+			for (j = 0; j < num_sentences; ++j) {
+				kernel->scan(&result, sentences[j] + 1, lengths[j]);
+				sum += result.checksum;
+			}
+		}
+		t = now() - t;
+		printf("%8s %14.1f %14.0f\n", kernel->name,
+			(double)(bytes * rounds) / t * 1.0e-6,
+			(double)(num_sentences * rounds) / t);
+		UNUSED_ARG(sum);
+	}
+
+	return EXIT_SUCCESS;
+}
+
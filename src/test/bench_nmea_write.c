@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nmea/nmea.h>
+#include <common/macros.h>
+
+/**
+ * Benchmark of writing NMEA sentences. A set of sentences with varying
+ * content is written repeatedly, the number of sentences per second
+ * and the throughput are reported.
+ */
+
+#define NUM_ROUNDS 200000
+
+static const char * SENTENCES[] = {
+	"$GPRMC,201124,A,4702.3947,N,00818.3372,E,0.3,328.4,260807,0.6,E,A*10",
+	"$GPRMC,201126,A,4702.3944,N,00818.3381,E,1.2,328.4,260807,0.6,E,A*1D",
+	"$GPRMC,123519,A,4807.0380,N,01131.0000,E,22.4,84.4,230394,3.1,W,A*07",
+	"$GPRMC,225446,A,4916.4500,N,12311.1200,W,5.5,54.7,191194,20.3,E,A*00",
+};
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+int main(int argc, char ** argv)
+{
+	static const size_t NUM_SENTENCES = sizeof(SENTENCES) / sizeof(SENTENCES[0]);
+
+	struct nmea_t nmea[sizeof(SENTENCES) / sizeof(SENTENCES[0])];
+	char buf[NMEA_MAX_SENTENCE + 1];
+	size_t i;
+	size_t j;
+	size_t bytes = 0;
+	size_t errors = 0;
+	int rc;
+	double t;
+
+	UNUSED_ARG(argc);
+	UNUSED_ARG(argv);
+
+	for (j = 0; j < NUM_SENTENCES; ++j) {
+		memset(&nmea[j], 0, sizeof(nmea[j]));
+		if (nmea_read(&nmea[j], SENTENCES[j]) != 0) {
+			printf("error: unable to read sentence: '%s'\n", SENTENCES[j]);
+			++errors;
+			continue;
+		}
+		rc = nmea_write(buf, sizeof(buf), &nmea[j]);
+		if (rc < 0 || strcmp(buf, SENTENCES[j]) != 0) {
+			printf("error: sentence not written correctly: '%s'\n", SENTENCES[j]);
+			++errors;
+		}
+	}
+	if (errors)
+		return EXIT_FAILURE;
+
+	t = now();
+	for (i = 0; i < NUM_ROUNDS; ++i) {
+		for (j = 0; j < NUM_SENTENCES; ++j) {
+			nmea[j].sentence.rmc.time.s = i % 60;
+			rc = nmea_write(buf, sizeof(buf), &nmea[j]);
+			bytes += (rc > 0) ? (size_t)rc : 0;
+		}
+	}
+	t = now() - t;
+
+	printf("%14s %14s %14s\n", "sentences/s", "ns/sentence", "MB/s");
+	printf("%14.0f %14.1f %14.1f\n",
+		(double)(NUM_ROUNDS * NUM_SENTENCES) / t,
+		t * 1.0e9 / (NUM_ROUNDS * NUM_SENTENCES),
+		(double)bytes / t * 1.0e-6);
+
+	return EXIT_SUCCESS;
+}
+
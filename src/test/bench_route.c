@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <route.h>
+#include <config/config.h>
+#include <navcom/message.h>
+#include <navcom/proc.h>
+#include <common/macros.h>
+
+/**
+ * Benchmark of the message routing. The configuration consists of
+ * an increasing number of sources, each having one route to the
+ * same destination. The time to route a message of one source
+ * is measured, which should not depend on the total number of routes.
+ *
+ * The destination writes to /dev/null.
+ */
+
+#define NUM_MESSAGES 200000
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+static void setup_config(struct config_t * config, size_t num_routes)
+{
+	size_t i;
+	char name[32];
+	struct property_list_t properties;
+
+	config_init(config);
+
+	proplist_init(&properties);
+	config_add_destination(config, "dst", "bench", &properties);
+
+	for (i = 0; i < num_routes; ++i) {
+		snprintf(name, sizeof(name), "src%lu", (unsigned long)i);
+		proplist_init(&properties);
+		config_add_source(config, name, "bench", &properties);
+		config_add_route(config, name, NULL, "dst");
+	}
+
+	/* done by the parser otherwise */
+	for (i = 0; i < num_routes; ++i) {
+		config->routes[i].source = &config->sources[i];
+		config->routes[i].destination = &config->destinations[0];
+	}
+}
+
+static double bench(size_t num_routes, int fd)
+{
+	struct config_t config;
+	struct proc_config_t * proc;
+	struct message_t msg;
+	size_t num;
+	size_t i;
+	double t;
+
+	setup_config(&config, num_routes);
+
+	num = config.num_sources + config.num_destinations;
+	proc = malloc(sizeof(struct proc_config_t) * num);
+	for (i = 0; i < num; ++i)
+		proc_config_init(&proc[i]);
+	for (i = 0; i < config.num_sources; ++i)
+		proc[i].cfg = &config.sources[i];
+	proc[config.num_sources].cfg = &config.destinations[0];
+	proc[config.num_sources].wfd = fd;
+
+	route_init(&config);
+	if (route_setup(&config, proc, 0, config.num_sources) < 0) {
+		printf("error: unable to setup routes\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	msg.data.attr.timer_id = 1;
+
+	/* the last source has to look at all routes if they are not indexed */
+	t = now();
+	for (i = 0; i < NUM_MESSAGES; ++i)
+		route_msg(&config, &proc[config.num_sources - 1], &msg);
+	t = now() - t;
+
+	route_destroy(&config);
+	free(proc);
+	config_free(&config);
+
+	return t * 1.0e9 / NUM_MESSAGES;
+}
+
+int main(int argc, char ** argv)
+{
+	static const size_t ROUTES[] = { 1, 10, 100, 250, 500, 1000 };
+
+	size_t i;
+	int fd;
+
+	UNUSED_ARG(argc);
+	UNUSED_ARG(argv);
+
+	setlogmask(LOG_UPTO(LOG_ERR));
+
+	fd = open("/dev/null", O_WRONLY);
+	if (fd < 0) {
+		perror("open");
+		return EXIT_FAILURE;
+	}
+
+	printf("%8s %14s\n", "routes", "ns/message");
+	for (i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); ++i)
+		printf("%8lu %14.1f\n", (unsigned long)ROUTES[i], bench(ROUTES[i], fd));
+
+	close(fd);
+	return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <navcom/message.h>
+#include <navcom/message_comm.h>
+#include <navcom/message_ring.h>
+#include <common/macros.h>
+
+/**
+ * Benchmark of the transport of messages from the hub to the procs.
+ * One producer (the hub) sends messages to a number of consumer
+ * processes (fan out), using pipes or shared memory rings. The CPU
+ * time of the producer is measured, as well as the elapsed time.
+ *
+ * Usage: bench_transport [num_consumers]
+ */
+
+#define NUM_MESSAGES 200000
+#define MAX_CONSUMERS 64
+
+static double now(clockid_t clock)
+{
+	struct timespec t;
+
+	clock_gettime(clock, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+}
+
+static void message(struct message_t * msg, uint32_t i)
+{
+	memset(msg, 0, sizeof(struct message_t));
+#if defined(NEEDS_NMEA)
+	msg->type = MSG_NMEA;
+	nmea_read(&msg->data.attr.nmea,
+		"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17");
+	msg->data.attr.nmea.sentence.rmc.date.y = i;
+#else
+	msg->type = MSG_TIMER;
+	msg->data.attr.timer_id = i;
+#endif
+}
+
+/**
+ * Consumer, waits for the file descriptor like a proc does.
+ */
+static int consume(int fd, struct message_ring_t * ring)
+{
+	struct pollfd pfd;
+	struct message_t msg;
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < NUM_MESSAGES; ++i) {
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, -1) != 1)
+			return EXIT_FAILURE;
+		if (ring)
+			rc = message_ring_read(ring, &msg);
+		else
+			rc = message_read(fd, &msg);
+		if (rc != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+static void bench(const char * name, size_t num, int use_ring)
+{
+	struct message_ring_t ring[MAX_CONSUMERS];
+	int fd[MAX_CONSUMERS][2];
+	pid_t pid[MAX_CONSUMERS];
+	struct message_t msg;
+	double t_cpu;
+	double t_wall;
+	size_t i;
+	uint32_t k;
+	int status;
+	int failed = 0;
+
+	for (i = 0; i < num; ++i) {
+		if (use_ring) {
+			if (message_ring_create(&ring[i], MESSAGE_RING_SIZE_DEFAULT) != EXIT_SUCCESS)
+				exit(EXIT_FAILURE);
+			fd[i][0] = ring[i].efd;
+			fd[i][1] = -1;
+		} else {
+			if (pipe(fd[i]) < 0)
+				exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0; i < num; ++i) {
+		pid[i] = fork();
+		if (pid[i] < 0)
+			exit(EXIT_FAILURE);
+		if (pid[i] == 0)
+			_exit(consume(fd[i][0], use_ring ? &ring[i] : NULL));
+	}
+
+	t_cpu = now(CLOCK_PROCESS_CPUTIME_ID);
+	t_wall = now(CLOCK_MONOTONIC);
+	for (k = 0; k < NUM_MESSAGES; ++k) {
+		message(&msg, k);
+		for (i = 0; i < num; ++i) {
+			if (use_ring) {
+				/* ring full: wait for the consumer, like a blocking pipe */
+				while (message_ring_write(&ring[i], &msg) != EXIT_SUCCESS)
+					usleep(50);
+			} else {
+				message_write(fd[i][1], &msg);
+			}
+		}
+	}
+	t_cpu = now(CLOCK_PROCESS_CPUTIME_ID) - t_cpu;
+
+	for (i = 0; i < num; ++i) {
+		waitpid(pid[i], &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+			failed = 1;
+	}
+	t_wall = now(CLOCK_MONOTONIC) - t_wall;
+
+	for (i = 0; i < num; ++i) {
+		if (use_ring) {
+			message_ring_destroy(&ring[i]);
+		} else {
+			close(fd[i][0]);
+			close(fd[i][1]);
+		}
+	}
+
+	printf("%8s %12lu %18.1f %18.1f%s\n", name, (unsigned long)num,
+		t_cpu * 1.0e9 / NUM_MESSAGES, t_wall * 1.0e9 / NUM_MESSAGES,
+		failed ? " (consumer failed)" : "");
+}
+
+int main(int argc, char ** argv)
+{
+	size_t num = 6;
+
+	if (argc > 1)
+		num = strtoul(argv[1], NULL, 0);
+	if (num < 1 || num > MAX_CONSUMERS) {
+		printf("error: number of consumers must be 1..%d\n", MAX_CONSUMERS);
+		return EXIT_FAILURE;
+	}
+
+	setlogmask(LOG_UPTO(LOG_ERR));
+
+	printf("%8s %12s %18s %18s\n", "transport", "consumers", "hub cpu ns/msg", "wall ns/msg");
+	bench("pipe", num, 0);
+	bench("ring", num, 1);
+	return EXIT_SUCCESS;
+}
+
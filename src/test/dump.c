@@ -1,8 +1,10 @@
 #include <stdio.h>
+#include <errno.h>
 #include <string.h>
 #include <stdint.h>
 
 #include <nmea/nmea.h>
+#include <nmea/nmea_stream.h>
 #include <device/simulator_serial_gps.h>
 #include <device/serial.h>
 #include <common/macros.h>
@@ -10,9 +12,10 @@
 int main(int argc, char ** argv)
 {
 	int rc;
-	char c;
-	int i = 0;
-	char s[NMEA_MAX_SENTENCE + 1];
+	char buf[NMEA_STREAM_CHUNK];
+	const char * p;
+	uint32_t size;
+	struct nmea_stream_t stream;
 	struct nmea_t nmea;
 	int num_sentences = 4;
 	int type = 0;
@@ -32,7 +35,7 @@ int main(int argc, char ** argv)
 	UNUSED_ARG(argc);
 	UNUSED_ARG(argv);
 
-	memset(s, 0, sizeof(s));
+	nmea_stream_init(&stream);
 	nmea_init(&nmea);
 	device_init(&device);
 
@@ -54,43 +57,42 @@ int main(int argc, char ** argv)
 	}
 
 	while (num_sentences > 0) {
-		rc = ops->read(&device, &c, sizeof(c));
+		rc = ops->read(&device, buf, sizeof(buf));
+		if (rc < 0 && errno == EINTR)
+			continue;
 		if (rc < 0) {
 			perror("read");
 			break;
 		}
-		if (rc != sizeof(c)) {
-			perror("read");
+		if (rc == 0) {
+			fprintf(stderr, "no data read\n");
 			break;
 		}
-		switch (c) {
-			case '\r':
-				break;
-			case '\n':
-				rc = nmea_read(&nmea, s);
-				if (rc == 0) {
-					printf("OK : [%s]\n", s);
-				} else if (rc == 1) {
-					printf("[%s] : UNKNOWN SENTENCE\n", s);
-				} else if (rc == -2) {
-					printf("[%s] : CHECKSUM ERROR\n", s);
-				} else {
-					fprintf(stderr, "parameter error\n");
-					return -1;
-				}
-				i = 0;
-				s[i] = 0;
-				--num_sentences;
-				break;
-			default:
-				if (i < NMEA_MAX_SENTENCE) {
-					s[i++] = c;
-				} else {
-					fprintf(stderr, "sentence too long, discarding\n");
-					i = 0;
-				}
-				s[i] = 0;
+		p = buf;
+		size = (uint32_t)rc;
+		while ((num_sentences > 0) && (size > 0)) {
+			rc = nmea_stream_next(&stream, &p, &size);
+			if (rc == 0) {
 				break;
+			} else if (rc == -2) {
+				fprintf(stderr, "sentence too long, discarding\n");
+				continue;
+			} else if (rc < 0) {
+				fprintf(stderr, "parameter error\n");
+				return -1;
+			}
+			rc = nmea_read(&nmea, stream.data);
+			if (rc == 0) {
+				printf("OK : [%s]\n", stream.data);
+			} else if (rc == 1) {
+				printf("[%s] : UNKNOWN SENTENCE\n", stream.data);
+			} else if (rc == -2) {
+				printf("[%s] : CHECKSUM ERROR\n", stream.data);
+			} else {
+				fprintf(stderr, "parameter error\n");
+				return -1;
+			}
+			--num_sentences;
 		}
 	}
 
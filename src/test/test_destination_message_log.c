@@ -1,9 +1,13 @@
 #include <cunit/CUnit.h>
 #include <test_destination_message_log.h>
 #include <navcom/destination/message_log.h>
+#include <navcom/message_comm.h>
 #include <common/macros.h>
 #include <string.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
 
 static const struct proc_desc_t * proc = &message_log;
 
@@ -42,6 +46,194 @@ static void test_exit(void)
 	CU_ASSERT_EQUAL(proc->exit(NULL), EXIT_FAILURE);
 }
 
+#if defined(NEEDS_NMEA)
+/**
+ * Runtime of a message log executed by a thread, messages are
+ * sent through a pipe, like from the hub.
+ */
+struct log_runtime_t
+{
+	struct property_list_t properties;
+	struct proc_t info;
+	struct proc_config_t config;
+	pthread_t thread;
+	int hub[2];
+	int sig[2];
+	char dst[64];
+};
+
+static void * run_proc(void * arg)
+{
+	proc->func((struct proc_config_t *)arg);
+	return NULL;
+}
+
+static void start(struct log_runtime_t * rt, const char * flush, const char * sync)
+{
+	int fd;
+
+	memset(rt, 0, sizeof(struct log_runtime_t));
+	strcpy(rt->dst, "/tmp/test_message_log_XXXXXX");
+	fd = mkstemp(rt->dst);
+	CU_ASSERT_TRUE_FATAL(fd >= 0);
+	close(fd);
+	CU_ASSERT_EQUAL_FATAL(pipe(rt->hub), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(rt->sig), 0);
+
+	rt->info.name = "log";
+	rt->info.type = "message_log";
+	proplist_init(&rt->properties);
+	proplist_set(&rt->properties, "enable", NULL);
+	proplist_set(&rt->properties, "dst", rt->dst);
+	proplist_set(&rt->properties, "flush", flush);
+	if (sync)
+		proplist_set(&rt->properties, "sync", sync);
+	proc_config_init(&rt->config);
+	rt->config.cfg = &rt->info;
+	CU_ASSERT_EQUAL_FATAL(proc->init(&rt->config, &rt->properties), EXIT_SUCCESS);
+	rt->config.rfd = rt->hub[0];
+	rt->config.signal_fd = rt->sig[0];
+	CU_ASSERT_EQUAL_FATAL(pthread_create(&rt->thread, NULL, run_proc, &rt->config), 0);
+}
+
+static void send_system(struct log_runtime_t * rt, uint32_t system)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = system;
+	message_write(rt->hub[1], &msg);
+}
+
+static void send_timer(struct log_runtime_t * rt)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	message_write(rt->hub[1], &msg);
+}
+
+static void send_nmea(struct log_runtime_t * rt)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_NMEA;
+	nmea_read(&msg.data.attr.nmea, "$HCHDG,45.8,,,0.6,E*16");
+	message_write(rt->hub[1], &msg);
+}
+
+static void stop(struct log_runtime_t * rt)
+{
+	send_system(rt, SYSTEM_TERMINATE);
+	pthread_join(rt->thread, NULL);
+	CU_ASSERT_EQUAL(proc->exit(&rt->config), EXIT_SUCCESS);
+	proplist_free(&rt->properties);
+	close(rt->hub[0]);
+	close(rt->hub[1]);
+	close(rt->sig[0]);
+	close(rt->sig[1]);
+}
+
+/**
+ * Returns the number of lines of the file.
+ */
+static int count_lines(const char * path)
+{
+	FILE * file;
+	int c;
+	int n = 0;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+		return -1;
+	while ((c = fgetc(file)) != EOF) {
+		if (c == '\n')
+			++n;
+	}
+	fclose(file);
+	return n;
+}
+
+/**
+ * Waits up to one second for the file to contain the number of lines.
+ */
+static int wait_lines(const char * path, int n)
+{
+	int i;
+
+	for (i = 0; i < 100; ++i) {
+		if (count_lines(path) == n)
+			return 1;
+		usleep(10000);
+	}
+	return 0;
+}
+
+static void test_buffered(void)
+{
+	struct log_runtime_t rt;
+
+	start(&rt, "60000", NULL);
+	send_nmea(&rt);
+	send_nmea(&rt);
+	send_nmea(&rt);
+	usleep(100000);
+	CU_ASSERT_EQUAL(count_lines(rt.dst), 0);
+
+	/* timer messages flush the buffer */
+	send_timer(&rt);
+	CU_ASSERT_TRUE(wait_lines(rt.dst, 3));
+
+	/* termination flushes the buffer */
+	send_nmea(&rt);
+	stop(&rt);
+	CU_ASSERT_EQUAL(count_lines(rt.dst), 4);
+	unlink(rt.dst);
+}
+
+static void test_flush_interval(void)
+{
+	struct log_runtime_t rt;
+
+	start(&rt, "50", "20");
+	send_nmea(&rt);
+	CU_ASSERT_TRUE(wait_lines(rt.dst, 1));
+	send_nmea(&rt);
+	CU_ASSERT_TRUE(wait_lines(rt.dst, 2));
+	stop(&rt);
+	CU_ASSERT_EQUAL(count_lines(rt.dst), 2);
+	unlink(rt.dst);
+}
+
+static void test_reopen(void)
+{
+	struct log_runtime_t rt;
+	char rotated[sizeof(rt.dst) + 2];
+
+	start(&rt, "60000", NULL);
+	send_nmea(&rt);
+	send_nmea(&rt);
+	send_timer(&rt);
+	CU_ASSERT_TRUE(wait_lines(rt.dst, 2));
+
+	/* log rotation: the file is renamed, the log continues with a new file */
+	snprintf(rotated, sizeof(rotated), "%s.1", rt.dst);
+	CU_ASSERT_EQUAL(rename(rt.dst, rotated), 0);
+	send_nmea(&rt);
+	send_system(&rt, SYSTEM_REOPEN);
+	send_nmea(&rt);
+	stop(&rt);
+
+	CU_ASSERT_EQUAL(count_lines(rotated), 3);
+	CU_ASSERT_EQUAL(count_lines(rt.dst), 1);
+	unlink(rotated);
+	unlink(rt.dst);
+}
+#endif
+
 void register_suite_destination_message_log(void)
 {
 	CU_Suite * suite;
@@ -50,5 +242,10 @@ void register_suite_destination_message_log(void)
 	CU_add_test(suite, "existance", test_existance);
 	CU_add_test(suite, "init", test_init);
 	CU_add_test(suite, "exit", test_exit);
+#if defined(NEEDS_NMEA)
+	CU_add_test(suite, "buffered", test_buffered);
+	CU_add_test(suite, "flush interval", test_flush_interval);
+	CU_add_test(suite, "reopen", test_reopen);
+#endif
 }
 
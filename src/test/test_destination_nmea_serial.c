@@ -1,9 +1,16 @@
+#define _GNU_SOURCE /* posix_openpt, ptsname */
 #include <cunit/CUnit.h>
 #include <test_destination_nmea_serial.h>
 #include <navcom/destination/nmea_serial.h>
+#include <navcom/message_comm.h>
 #include <common/macros.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 static const struct proc_desc_t * proc = &nmea_serial;
 
@@ -77,6 +84,129 @@ static void test_exit(void)
 	CU_ASSERT_EQUAL(proc->exit(NULL), EXIT_FAILURE);
 }
 
+static uint32_t now_msec(const struct timespec * start)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (t.tv_sec - start->tv_sec) * 1000 + (t.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static void * run_proc(void * arg)
+{
+	proc->func((struct proc_config_t *)arg);
+	return NULL;
+}
+
+/**
+ * The proc writes to a pseudo terminal at 4800 baud in the output
+ * mode 'latest', while sentences are sent much faster than the line
+ * rate. RMC sentences contain the time they were sent (as speed over
+ * ground), the time they appear on the terminal must not be much later
+ * than the transmission of a few sentences.
+ */
+static void test_latest_staleness(void)
+{
+	static const uint32_t DURATION = 1500; /* msec */
+	static const uint32_t WARMUP = 300; /* msec */
+	static const char * RMC = "$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17";
+	static const char * HDG = "$HCHDG,45.8,,,0.6,E*16";
+
+	struct property_list_t properties;
+	struct proc_config_t config;
+	struct message_t msg;
+	struct timespec start;
+	struct pollfd pfd;
+	pthread_t thread;
+	int master;
+	int hub[2];
+	int sig[2];
+	char line[NMEA_MAX_SENTENCE + 1];
+	size_t len = 0;
+	uint32_t t;
+	uint32_t next = 0;
+	uint32_t received = 0;
+	uint32_t num_rmc = 0;
+	uint32_t max_stale = 0;
+	char c;
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	CU_ASSERT_TRUE_FATAL(master >= 0);
+	CU_ASSERT_EQUAL_FATAL(grantpt(master), 0);
+	CU_ASSERT_EQUAL_FATAL(unlockpt(master), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(hub), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(sig), 0);
+
+	proplist_init(&properties);
+	proplist_set(&properties, "device", ptsname(master));
+	proplist_set(&properties, "baud", "4800");
+	proplist_set(&properties, "mode", "latest");
+	proc_config_init(&config);
+	CU_ASSERT_EQUAL_FATAL(proc->init(&config, &properties), EXIT_SUCCESS);
+	config.rfd = hub[0];
+	config.signal_fd = sig[0];
+	CU_ASSERT_EQUAL_FATAL(pthread_create(&thread, NULL, run_proc, &config), 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (t = 0; t < DURATION; t = now_msec(&start)) {
+		/* 100 RMC and 100 HDG per second, far more than 4800 baud are able to transmit */
+		if (t >= next) {
+			memset(&msg, 0, sizeof(msg));
+			msg.type = MSG_NMEA;
+			nmea_read(&msg.data.attr.nmea, RMC);
+			msg.data.attr.nmea.sentence.rmc.sog.i = t;
+			message_write(hub[1], &msg);
+			nmea_read(&msg.data.attr.nmea, HDG);
+			message_write(hub[1], &msg);
+			next += 10;
+		}
+
+		pfd.fd = master;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 1) != 1)
+			continue;
+		if (read(master, &c, 1) != 1)
+			continue;
+		++received;
+		if (c == '\r')
+			continue;
+		if (c != '\n') {
+			if (len < sizeof(line) - 1)
+				line[len++] = c;
+			continue;
+		}
+		line[len] = '\0';
+		len = 0;
+		if (nmea_read(&msg.data.attr.nmea, line) != 0)
+			continue;
+		if (msg.data.attr.nmea.type != NMEA_RMC)
+			continue;
+		++num_rmc;
+		if (t > WARMUP && t - msg.data.attr.nmea.sentence.rmc.sog.i > max_stale)
+			max_stale = t - msg.data.attr.nmea.sentence.rmc.sog.i;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = SYSTEM_TERMINATE;
+	message_write(hub[1], &msg);
+	pthread_join(thread, NULL);
+
+	/* 4800 baud, 10 bits per character */
+	CU_ASSERT_TRUE(received <= (DURATION + 200) * 480 / 1000);
+	CU_ASSERT_TRUE(num_rmc >= 3);
+	CU_ASSERT_TRUE(max_stale < 500);
+
+	CU_ASSERT_EQUAL(proc->exit(&config), EXIT_SUCCESS);
+	proplist_free(&properties);
+	close(hub[0]);
+	close(hub[1]);
+	close(sig[0]);
+	close(sig[1]);
+	close(master);
+}
+
 void register_suite_destination_nmea_serial(void)
 {
 	char name[128];
@@ -88,5 +218,6 @@ void register_suite_destination_nmea_serial(void)
 	CU_add_test(suite, "existance", test_existance);
 	CU_add_test(suite, "exit", test_exit);
 	CU_add_test(suite, "init", test_init);
+	CU_add_test(suite, "latest staleness", test_latest_staleness);
 }
 
@@ -541,6 +541,235 @@ static void test_func_msg_to_table_nmea_rmc(void) /* TODO: move test to test_lua
 	proplist_free(&properties);
 }
 
+static void test_func_batch(void)
+{
+	struct filter_context_t ctx;
+	struct property_list_t properties;
+	struct message_t msg_in[3];
+	struct message_t msg_out[3];
+	int results[3];
+	size_t i;
+
+	const char SCRIPT[] =
+		"function filter(msg_out, msg_in)\n"
+		"	return FILTER_FAILURE\n"
+		"end\n"
+		"function filter_batch(msgs_out, msgs_in, n)\n"
+		"	local results = {}\n"
+		"	for i = 1, n do\n"
+		"		if msgs_in[i].timer_id == 2 then\n"
+		"			results[i] = FILTER_DISCARD\n"
+		"		else\n"
+		"			msg_clone(msgs_out[i], msgs_in[i])\n"
+		"			msgs_out[i].timer_id = msgs_in[i].timer_id * 10\n"
+		"			results[i] = FILTER_SUCCESS\n"
+		"		end\n"
+		"	end\n"
+		"	return results\n"
+		"end\n"
+		"\n"
+		;
+
+	memset(msg_in, 0, sizeof(msg_in));
+	memset(msg_out, 0, sizeof(msg_out));
+	for (i = 0; i < 3; ++i) {
+		msg_in[i].type = MSG_TIMER;
+		msg_in[i].data.attr.timer_id = i + 1;
+	}
+
+	CU_ASSERT_PTR_NOT_NULL_FATAL(filter->batch);
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(filter->init(&ctx, &properties), EXIT_SUCCESS);
+
+	CU_ASSERT_EQUAL(filter->batch(msg_out, NULL, results, 3, &ctx, &properties), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter->batch(NULL, msg_in, results, 3, &ctx, &properties), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, NULL, 3, &ctx, &properties), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, results, 3, &ctx, &properties), EXIT_SUCCESS);
+
+	CU_ASSERT_EQUAL(results[0], FILTER_SUCCESS);
+	CU_ASSERT_EQUAL(results[1], FILTER_DISCARD);
+	CU_ASSERT_EQUAL(results[2], FILTER_SUCCESS);
+	CU_ASSERT_EQUAL(msg_out[0].type, MSG_TIMER);
+	CU_ASSERT_EQUAL(msg_out[0].data.attr.timer_id, 10);
+	CU_ASSERT_EQUAL(msg_out[2].type, MSG_TIMER);
+	CU_ASSERT_EQUAL(msg_out[2].data.attr.timer_id, 30);
+
+	/* smaller batch reuses the message objects */
+	CU_ASSERT_EQUAL(filter->batch(msg_out, &msg_in[1], results, 1, &ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(results[0], FILTER_DISCARD);
+
+	CU_ASSERT_EQUAL(filter->exit(&ctx), EXIT_SUCCESS);
+	proplist_free(&properties);
+}
+
+static void test_func_batch_single_result(void)
+{
+	struct filter_context_t ctx;
+	struct property_list_t properties;
+	struct message_t msg_in[2];
+	struct message_t msg_out[2];
+	int results[2];
+
+	const char SCRIPT[] =
+		"function filter_batch(msgs_out, msgs_in, n)\n"
+		"	if #msgs_in ~= n or #msgs_out ~= n then\n"
+		"		return FILTER_FAILURE\n"
+		"	end\n"
+		"	msgs_out[1].msg_type = MSG_TIMER\n"
+		"	msgs_out[1].timer_id = 1\n"
+		"	return FILTER_DISCARD\n"
+		"end\n"
+		"\n"
+		;
+
+	memset(msg_in, 0, sizeof(msg_in));
+	memset(msg_out, 0, sizeof(msg_out));
+	results[0] = FILTER_SUCCESS;
+	results[1] = FILTER_SUCCESS;
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(filter->init(&ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, results, 2, &ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(results[0], FILTER_DISCARD);
+	CU_ASSERT_EQUAL(results[1], FILTER_DISCARD);
+	CU_ASSERT_EQUAL(msg_out[0].type, MSG_TIMER);
+	CU_ASSERT_EQUAL(msg_out[0].data.attr.timer_id, 1);
+	CU_ASSERT_EQUAL(filter->exit(&ctx), EXIT_SUCCESS);
+	proplist_free(&properties);
+}
+
+static void test_func_batch_readonly(void)
+{
+	struct filter_context_t ctx;
+	struct property_list_t properties;
+	struct message_t msg_in[1];
+	struct message_t msg_out[1];
+	int results[1];
+
+	const char SCRIPT[] =
+		"function filter_batch(msgs_out, msgs_in, n)\n"
+		"	msgs_in[1].timer_id = 1\n"
+		"	return FILTER_SUCCESS\n"
+		"end\n"
+		"\n"
+		;
+
+	memset(msg_in, 0, sizeof(msg_in));
+	memset(msg_out, 0, sizeof(msg_out));
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(filter->init(&ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, results, 1, &ctx, &properties), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(msg_in[0].data.attr.timer_id, 0);
+	CU_ASSERT_EQUAL(filter->exit(&ctx), EXIT_SUCCESS);
+	proplist_free(&properties);
+}
+
+static void test_func_batch_modified_tables(void)
+{
+	struct filter_context_t ctx;
+	struct property_list_t properties;
+	struct message_t msg_in[2];
+	struct message_t msg_out[2];
+	int results[2];
+	uint32_t i;
+
+	const char SCRIPT[] =
+		"function filter_batch(msgs_out, msgs_in, n)\n"
+		"	if #msgs_in ~= n or #msgs_out ~= n then\n"
+		"		return FILTER_FAILURE\n"
+		"	end\n"
+		"	for i = 1, n do\n"
+		"		msg_clone(msgs_out[i], msgs_in[i])\n"
+		"	end\n"
+		"	msgs_out[1] = nil\n"
+		"	msgs_in[#msgs_in] = nil\n"
+		"	msgs_in[1] = 'x'\n"
+		"	return FILTER_SUCCESS\n"
+		"end\n"
+		"\n"
+		;
+
+	memset(msg_in, 0, sizeof(msg_in));
+	msg_in[0].type = MSG_TIMER;
+	msg_in[0].data.attr.timer_id = 1;
+	msg_in[1].type = MSG_TIMER;
+	msg_in[1].data.attr.timer_id = 2;
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(filter->init(&ctx, &properties), EXIT_SUCCESS);
+
+	/* the next batch of the same size gets the complete tables */
+	for (i = 0; i < 3; ++i) {
+		memset(msg_out, 0, sizeof(msg_out));
+		CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, results, 2, &ctx, &properties), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(results[0], FILTER_SUCCESS);
+		CU_ASSERT_EQUAL(results[1], FILTER_SUCCESS);
+		CU_ASSERT_EQUAL(msg_out[0].data.attr.timer_id, 1);
+		CU_ASSERT_EQUAL(msg_out[1].data.attr.timer_id, 2);
+	}
+
+	CU_ASSERT_EQUAL(filter->exit(&ctx), EXIT_SUCCESS);
+	proplist_free(&properties);
+}
+
+static void test_func_batch_fallback(void)
+{
+	struct filter_context_t ctx;
+	struct property_list_t properties;
+	struct message_t msg_in[2];
+	struct message_t msg_out[2];
+	int results[2];
+
+	const char SCRIPT[] =
+		"function filter(msg_out, msg_in)\n"
+		"	if msg_in.timer_id == 1 then\n"
+		"		return FILTER_DISCARD\n"
+		"	end\n"
+		"	return msg_clone(msg_out, msg_in)\n"
+		"end\n"
+		"\n"
+		;
+
+	memset(msg_in, 0, sizeof(msg_in));
+	memset(msg_out, 0, sizeof(msg_out));
+	msg_in[0].type = MSG_TIMER;
+	msg_in[0].data.attr.timer_id = 1;
+	msg_in[1].type = MSG_TIMER;
+	msg_in[1].data.attr.timer_id = 2;
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(filter->init(&ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(filter->batch(msg_out, msg_in, results, 2, &ctx, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(results[0], FILTER_DISCARD);
+	CU_ASSERT_EQUAL(results[1], FILTER_SUCCESS);
+	CU_ASSERT_EQUAL(msg_out[1].type, MSG_TIMER);
+	CU_ASSERT_EQUAL(msg_out[1].data.attr.timer_id, 2);
+	CU_ASSERT_EQUAL(filter->exit(&ctx), EXIT_SUCCESS);
+	proplist_free(&properties);
+}
+
 void register_suite_filter_lua(void)
 {
 	CU_Suite * suite;
@@ -558,5 +787,10 @@ void register_suite_filter_lua(void)
 	CU_add_test(suite, "func: msg_to_table: timer", test_func_msg_to_table_timer);
 	CU_add_test(suite, "func: msg_to_table: nmea", test_func_msg_to_table_nmea);
 	CU_add_test(suite, "func: msg_to_table: nmea: RMC", test_func_msg_to_table_nmea_rmc);
+	CU_add_test(suite, "func: batch", test_func_batch);
+	CU_add_test(suite, "func: batch: single result", test_func_batch_single_result);
+	CU_add_test(suite, "func: batch: read only input", test_func_batch_readonly);
+	CU_add_test(suite, "func: batch: modified tables", test_func_batch_modified_tables);
+	CU_add_test(suite, "func: batch: fallback", test_func_batch_fallback);
 }
 
@@ -0,0 +1,210 @@
+#include <cunit/CUnit.h>
+#include <test_filter_pool.h>
+#include <navcom/filter_pool.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+/**
+ * Filter copying the message, timer messages with odd ids are discarded
+ * if the context data is not NULL.
+ */
+static int filter_copy(
+		struct message_t * out,
+		const struct message_t * in,
+		struct filter_context_t * ctx,
+		const struct property_list_t * properties)
+{
+	UNUSED_ARG(properties);
+
+	if (ctx->data && (in->data.attr.timer_id & 1))
+		return FILTER_DISCARD;
+	memcpy(out, in, sizeof(struct message_t));
+	return FILTER_SUCCESS;
+}
+
+static int filter_slow(
+		struct message_t * out,
+		const struct message_t * in,
+		struct filter_context_t * ctx,
+		const struct property_list_t * properties)
+{
+	usleep(20000);
+	return filter_copy(out, in, ctx, properties);
+}
+
+static const struct filter_desc_t COPY = {
+	.name = "copy",
+	.init = NULL,
+	.exit = NULL,
+	.func = filter_copy,
+	.help = NULL,
+};
+
+static const struct filter_desc_t SLOW = {
+	.name = "slow",
+	.init = NULL,
+	.exit = NULL,
+	.func = filter_slow,
+	.help = NULL,
+};
+
+static void timer_message(struct message_t * msg, uint32_t id)
+{
+	memset(msg, 0, sizeof(struct message_t));
+	msg->type = MSG_TIMER;
+	msg->data.attr.timer_id = id;
+}
+
+static int wait_results(struct filter_pool_t * pool)
+{
+	struct pollfd pfd;
+
+	pfd.fd = pool->efd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 5000) != 1)
+		return -1;
+	return filter_pool_acknowledge(pool) == EXIT_SUCCESS ? 0 : -1;
+}
+
+static void test_parameters(void)
+{
+	struct filter_pool_t pool;
+	struct filter_queue_t queue;
+	struct filter_context_t ctx = { NULL };
+	struct message_t msg;
+	int result;
+
+	timer_message(&msg, 1);
+
+	CU_ASSERT_EQUAL(filter_queue_init(NULL, &COPY, &ctx, NULL, 1, 0), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_queue_init(&queue, NULL, &ctx, NULL, 1, 0), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_queue_init(&queue, &COPY, &ctx, NULL, 0, 0), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_pool_create(NULL, 1), EXIT_FAILURE);
+
+	CU_ASSERT_EQUAL_FATAL(filter_pool_create(&pool, 0), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(filter_pool_submit(NULL, &queue, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_pool_submit(&pool, NULL, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_pool_submit(&pool, &queue, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(filter_pool_result(&pool, &queue, &msg, &result), -1);
+	CU_ASSERT_EQUAL(filter_pool_result(&pool, NULL, &msg, &result), -1);
+	CU_ASSERT_EQUAL(filter_pool_acknowledge(NULL), EXIT_FAILURE);
+	filter_pool_destroy(&pool);
+	filter_pool_destroy(&pool);
+	filter_pool_destroy(NULL);
+	filter_queue_destroy(NULL);
+}
+
+static void test_full(void)
+{
+	struct filter_pool_t pool;
+	struct filter_queue_t queue;
+	struct filter_context_t ctx = { NULL };
+	struct message_t msg;
+	int result;
+	uint32_t i;
+
+	/* without workers, nothing is filtered */
+	CU_ASSERT_EQUAL_FATAL(filter_pool_create(&pool, 0), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(filter_queue_init(&queue, &COPY, &ctx, NULL, 4, 0), EXIT_SUCCESS);
+
+	for (i = 0; i < 4; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL(filter_pool_submit(&pool, &queue, &msg), EXIT_SUCCESS);
+	}
+	errno = 0;
+	CU_ASSERT_EQUAL(filter_pool_submit(&pool, &queue, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(errno, EAGAIN);
+	CU_ASSERT_EQUAL(queue.dropped, 1);
+	CU_ASSERT_EQUAL(filter_pool_result(&pool, &queue, &msg, &result), 0);
+
+	filter_pool_destroy(&pool);
+	filter_queue_destroy(&queue);
+}
+
+static void test_order(void)
+{
+	static const uint32_t NUM = 10000;
+
+	struct filter_pool_t pool;
+	struct filter_queue_t queue[2];
+	struct filter_context_t ctx[2] = { { NULL }, { (void *)1 } };
+	struct message_t msg;
+	uint32_t submitted[2] = { 0, 0 };
+	uint32_t expected[2] = { 0, 0 };
+	uint32_t i;
+	int result;
+	int failed = 0;
+
+	CU_ASSERT_EQUAL_FATAL(filter_pool_create(&pool, 4), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(filter_queue_init(&queue[0], &COPY, &ctx[0], NULL, 16, 0), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(filter_queue_init(&queue[1], &COPY, &ctx[1], NULL, 16, 0), EXIT_SUCCESS);
+
+	while (expected[0] < NUM || expected[1] < NUM) {
+		for (i = 0; i < 2; ++i) {
+			timer_message(&msg, submitted[i]);
+			if ((submitted[i] < NUM) && (filter_pool_submit(&pool, &queue[i], &msg) == EXIT_SUCCESS))
+				++submitted[i];
+		}
+		if (wait_results(&pool) < 0)
+			break;
+		for (i = 0; i < 2; ++i) {
+			while (filter_pool_result(&pool, &queue[i], &msg, &result) > 0) {
+				/* queue 1 discards odd ids, the results are still in order */
+				if ((i == 1) && (expected[i] & 1)) {
+					failed |= result != FILTER_DISCARD;
+				} else {
+					failed |= result != FILTER_SUCCESS;
+					failed |= msg.data.attr.timer_id != expected[i];
+				}
+				++expected[i];
+			}
+		}
+	}
+
+	CU_ASSERT_FALSE(failed);
+	CU_ASSERT_EQUAL(expected[0], NUM);
+	CU_ASSERT_EQUAL(expected[1], NUM);
+	CU_ASSERT_EQUAL(queue[0].dropped + queue[1].dropped, 0);
+
+	filter_pool_destroy(&pool);
+	filter_queue_destroy(&queue[0]);
+	filter_queue_destroy(&queue[1]);
+}
+
+static void test_timeout(void)
+{
+	struct filter_pool_t pool;
+	struct filter_queue_t queue;
+	struct filter_context_t ctx = { NULL };
+	struct message_t msg;
+	int result;
+
+	CU_ASSERT_EQUAL_FATAL(filter_pool_create(&pool, 1), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(filter_queue_init(&queue, &SLOW, &ctx, NULL, 4, 5), EXIT_SUCCESS);
+
+	timer_message(&msg, 2);
+	CU_ASSERT_EQUAL(filter_pool_submit(&pool, &queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(wait_results(&pool), 0);
+	CU_ASSERT_EQUAL(filter_pool_result(&pool, &queue, &msg, &result), 1);
+	CU_ASSERT_EQUAL(result, FILTER_DISCARD);
+	CU_ASSERT_EQUAL(queue.timeouts, 1);
+	CU_ASSERT_EQUAL(filter_pool_result(&pool, &queue, &msg, &result), 0);
+
+	filter_pool_destroy(&pool);
+	filter_queue_destroy(&queue);
+}
+
+void register_suite_filter_pool(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("filter_pool", NULL, NULL);
+	CU_add_test(suite, "parameters", test_parameters);
+	CU_add_test(suite, "full", test_full);
+	CU_add_test(suite, "order", test_order);
+	CU_add_test(suite, "timeout", test_timeout);
+}
@@ -0,0 +1,6 @@
+#ifndef __TEST_FILTER_POOL__H__
+#define __TEST_FILTER_POOL__H__
+
+void register_suite_filter_pool(void);
+
+#endif
@@ -0,0 +1,199 @@
+#include <cunit/CUnit.h>
+#include <test_lua_alloc.h>
+#include <navcom/lua_alloc.h>
+#include <lua/lua.h>
+#include <lua/lualib.h>
+#include <lua/lauxlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char * SCRIPT =
+	"local t = {}\n"
+	"for i = 1, 1000 do\n"
+	"	t[i] = { id = i, name = 'item' .. i }\n"
+	"end\n"
+	"result = #t\n"
+	;
+
+static void test_init_destroy(void)
+{
+	struct lua_alloc_t a;
+
+	luaH_alloc_init(&a, 1024);
+	CU_ASSERT_EQUAL(a.limit, 1024);
+	CU_ASSERT_EQUAL(a.used, 0);
+	CU_ASSERT_EQUAL(a.peak, 0);
+	CU_ASSERT_EQUAL(a.failures, 0);
+	CU_ASSERT_PTR_NULL(a.slab);
+	luaH_alloc_destroy(&a);
+	luaH_alloc_destroy(&a);
+}
+
+static void test_accounting(void)
+{
+	struct lua_alloc_t a;
+	lua_State * lua;
+
+	luaH_alloc_init(&a, 0);
+	lua = luaH_newstate(&a);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	luaL_openlibs(lua);
+	CU_ASSERT(a.used > 0);
+
+	CU_ASSERT_EQUAL(luaL_dostring(lua, SCRIPT), LUA_OK);
+	lua_getglobal(lua, "result");
+	CU_ASSERT_EQUAL(lua_tointeger(lua, -1), 1000);
+	lua_pop(lua, 1);
+
+	/* allocator and Lua agree about the memory in use */
+	CU_ASSERT_EQUAL(a.used, (size_t)lua_gc(lua, LUA_GCCOUNT, 0) * 1024
+		+ (size_t)lua_gc(lua, LUA_GCCOUNTB, 0));
+	CU_ASSERT(a.peak >= a.used);
+	CU_ASSERT(a.slabs > 0);
+	CU_ASSERT_EQUAL(a.failures, 0);
+
+	lua_close(lua);
+	CU_ASSERT_EQUAL(a.used, 0);
+	CU_ASSERT(a.peak > 0);
+	luaH_alloc_destroy(&a);
+	CU_ASSERT_EQUAL(a.slabs, 0);
+}
+
+static void test_limit(void)
+{
+	struct lua_alloc_t a;
+	lua_State * lua;
+
+	luaH_alloc_init(&a, 64 * 1024);
+	lua = luaH_newstate(&a);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	luaL_openlibs(lua);
+
+	/* script exceeds the limit, the state stays usable */
+	CU_ASSERT_NOT_EQUAL(luaL_dostring(lua, SCRIPT), LUA_OK);
+	CU_ASSERT_STRING_EQUAL(lua_tostring(lua, -1), "not enough memory");
+	lua_pop(lua, 1);
+	CU_ASSERT(a.failures > 0);
+	CU_ASSERT(a.used <= a.limit);
+	CU_ASSERT(a.peak <= a.limit);
+
+	lua_gc(lua, LUA_GCCOLLECT, 0);
+	CU_ASSERT_EQUAL(luaL_dostring(lua, "result = 1 + 2"), LUA_OK);
+	lua_getglobal(lua, "result");
+	CU_ASSERT_EQUAL(lua_tointeger(lua, -1), 3);
+	lua_pop(lua, 1);
+
+	lua_close(lua);
+	CU_ASSERT_EQUAL(a.used, 0);
+	luaH_alloc_destroy(&a);
+}
+
+static void test_shrink_without_slab(void)
+{
+	enum { MAX_BLOCKS = 1024 };
+
+	struct lua_alloc_t a;
+	lua_State * lua;
+	lua_Alloc f;
+	void * ud;
+	void * blocks[MAX_BLOCKS];
+	void * large;
+	void * p;
+	size_t n;
+	size_t i;
+
+	luaH_alloc_init(&a, 0);
+	lua = luaH_newstate(&a);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	f = lua_getallocf(lua, &ud);
+
+	large = f(ud, NULL, 0, 1024);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(large);
+	memset(large, 'x', 1024);
+
+	/* tight limit, no more slabs, take all free blocks of the class */
+	a.limit = a.slabs + LUA_ALLOC_SLAB_SIZE - 1;
+	CU_ASSERT_FATAL(a.used + MAX_BLOCKS < a.limit);
+	for (n = 0; n < MAX_BLOCKS; ++n) {
+		blocks[n] = f(ud, NULL, 0, 16);
+		if (blocks[n] == NULL)
+			break;
+	}
+	CU_ASSERT_FATAL(n < MAX_BLOCKS);
+	CU_ASSERT(a.failures > 0);
+
+	/* shrinking succeeds nevertheless, keeping the block of malloc */
+	p = f(ud, large, 1024, 16);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(p);
+	CU_ASSERT_EQUAL(a.foreign, 1);
+	CU_ASSERT_EQUAL(((const char *)p)[15], 'x');
+
+	/* blocks of slabs are still released into the free list */
+	for (i = 0; i < n; ++i) {
+		f(ud, blocks[i], 16, 0);
+		CU_ASSERT_PTR_EQUAL(a.free[0], blocks[i]);
+	}
+	CU_ASSERT_EQUAL(a.foreign, 1);
+
+	/* released by free, not into the free list of the slabs */
+	CU_ASSERT_PTR_NULL(f(ud, p, 16, 0));
+	CU_ASSERT_EQUAL(a.foreign, 0);
+	CU_ASSERT_PTR_EQUAL(a.free[0], blocks[n - 1]);
+
+	lua_close(lua);
+	CU_ASSERT_EQUAL(a.used, 0);
+	luaH_alloc_destroy(&a);
+}
+
+static void test_limit_from_prop(void)
+{
+	struct property_list_t properties;
+	size_t limit = 1;
+
+	proplist_init(&properties);
+	CU_ASSERT_EQUAL(luaH_alloc_limit_from_prop(&properties, &limit), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(limit, 0);
+
+	proplist_set(&properties, "memory_limit", "16");
+	CU_ASSERT_EQUAL(luaH_alloc_limit_from_prop(&properties, &limit), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(limit, 16 * 1024);
+
+	proplist_set(&properties, "memory_limit", "16k");
+	CU_ASSERT_EQUAL(luaH_alloc_limit_from_prop(&properties, &limit), EXIT_FAILURE);
+	proplist_free(&properties);
+}
+
+static void test_write_stats(void)
+{
+	struct lua_alloc_t a;
+	char buf[256];
+	FILE * file;
+
+	luaH_alloc_init(&a, 2048);
+	a.used = 10;
+	a.peak = 20;
+
+	file = tmpfile();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	luaH_alloc_write_stats(&a, file);
+	rewind(file);
+	CU_ASSERT_PTR_NOT_NULL(fgets(buf, sizeof(buf), file));
+	fclose(file);
+
+	CU_ASSERT_STRING_EQUAL(buf, " lua_used=10 lua_peak=20 lua_limit=2048 lua_slabs=0 lua_failures=0");
+}
+
+void register_suite_lua_alloc(void)
+{
+	CU_Suite * suite;
+
+	suite = CU_add_suite("lua_alloc", NULL, NULL);
+	CU_add_test(suite, "init / destroy", test_init_destroy);
+	CU_add_test(suite, "accounting", test_accounting);
+	CU_add_test(suite, "limit", test_limit);
+	CU_add_test(suite, "shrink without slab", test_shrink_without_slab);
+	CU_add_test(suite, "limit from property", test_limit_from_prop);
+	CU_add_test(suite, "write stats", test_write_stats);
+}
+
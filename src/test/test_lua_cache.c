@@ -0,0 +1,178 @@
+#include <cunit/CUnit.h>
+#include <test_lua_cache.h>
+#include <navcom/lua_cache.h>
+#include <lua/lua.h>
+#include <lua/lualib.h>
+#include <lua/lauxlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char tmpdir[64];
+static char cachedir[128];
+static char script[128];
+static char cachefile[128];
+
+/**
+ * Writes the script, keeps the modification time if requested.
+ */
+static void prepare_script(const char * code, int keep_mtime)
+{
+	FILE * file;
+	struct stat s;
+	struct timespec times[2];
+
+	if (keep_mtime)
+		CU_ASSERT_EQUAL(stat(script, &s), 0);
+
+	file = fopen(script, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	fputs(code, file);
+	fclose(file);
+
+	if (keep_mtime) {
+		times[0] = s.st_atim;
+		times[1] = s.st_mtim;
+		CU_ASSERT_EQUAL(utimensat(AT_FDCWD, script, times, 0), 0);
+	}
+}
+
+/**
+ * Loads the script and returns the value of the global 'x'.
+ */
+static int load(void)
+{
+	lua_State * lua;
+	int x = -1;
+
+	lua = luaL_newstate();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	if (luaH_dofile(lua, script) == LUA_OK) {
+		lua_getglobal(lua, "x");
+		x = lua_tointeger(lua, -1);
+	}
+	lua_close(lua);
+	return x;
+}
+
+static int setup(void)
+{
+	strncpy(tmpdir, "/tmp/test_lua_cacheXXXXXX", sizeof(tmpdir));
+	if (mkdtemp(tmpdir) == NULL)
+		return -1;
+	snprintf(cachedir, sizeof(cachedir), "%s/cache", tmpdir);
+	snprintf(script, sizeof(script), "%s/script.lua", tmpdir);
+	snprintf(cachefile, sizeof(cachefile), "%s/script.luac", tmpdir);
+	return mkdir(cachedir, 0700);
+}
+
+static int cleanup(void)
+{
+	char cmd[sizeof(tmpdir) + 16];
+
+	luaH_set_cache_dir(NULL);
+	snprintf(cmd, sizeof(cmd), "rm -rf '%s'", tmpdir);
+	return system(cmd) != 0;
+}
+
+static void test_no_cache(void)
+{
+	prepare_script("x = 1\n", 0);
+	unlink(cachefile);
+
+	CU_ASSERT_EQUAL(load(), 1);
+
+	/* without cache directory, the cache is written only by precompile */
+	CU_ASSERT_NOT_EQUAL(access(cachefile, F_OK), 0);
+}
+
+static void test_precompile(void)
+{
+	prepare_script("x = 2\n", 0);
+
+	CU_ASSERT_EQUAL(luaH_precompile(script), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(access(cachefile, R_OK), 0);
+
+	/* same size and modification time: precompiled script is used */
+	prepare_script("x = 3\n", 1);
+	CU_ASSERT_EQUAL(load(), 2);
+
+	/* modified script: cache is not valid anymore */
+	prepare_script("x = 33\n", 1);
+	CU_ASSERT_EQUAL(load(), 33);
+
+	unlink(cachefile);
+}
+
+static void test_precompile_error(void)
+{
+	prepare_script("x = = 1\n", 0);
+
+	CU_ASSERT_EQUAL(luaH_precompile(script), EXIT_FAILURE);
+	CU_ASSERT_NOT_EQUAL(access(cachefile, F_OK), 0);
+	CU_ASSERT_EQUAL(luaH_precompile("/tmp/this/file/does/not/exist.lua"), EXIT_FAILURE);
+}
+
+static void test_invalid_cache(void)
+{
+	FILE * file;
+
+	prepare_script("x = 4\n", 0);
+
+	file = fopen(cachefile, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	fputs("garbage", file);
+	fclose(file);
+
+	CU_ASSERT_EQUAL(load(), 4);
+	unlink(cachefile);
+}
+
+static void test_cache_dir(void)
+{
+	char path[sizeof(cachedir) + sizeof(script) + 2];
+	char * p;
+
+	CU_ASSERT_EQUAL(luaH_set_cache_dir(cachedir), EXIT_SUCCESS);
+
+	snprintf(path, sizeof(path), "%s/%sc", cachedir, script);
+	for (p = path + strlen(cachedir) + 1; *p; ++p) {
+		if (*p == '/')
+			*p = '_';
+	}
+
+	/* cache is written when the script is loaded */
+	prepare_script("x = 5\n", 0);
+	CU_ASSERT_EQUAL(load(), 5);
+	CU_ASSERT_EQUAL(access(path, R_OK), 0);
+	CU_ASSERT_NOT_EQUAL(access(cachefile, F_OK), 0);
+
+	prepare_script("x = 6\n", 1);
+	CU_ASSERT_EQUAL(load(), 5);
+
+	/* outdated cache is rewritten */
+	prepare_script("x = 77\n", 0);
+	CU_ASSERT_EQUAL(load(), 77);
+	prepare_script("x = 78\n", 1);
+	CU_ASSERT_EQUAL(load(), 77);
+
+	CU_ASSERT_EQUAL(luaH_set_cache_dir(NULL), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(load(), 78);
+}
+
+void register_suite_lua_cache(void)
+{
+	CU_Suite * suite;
+
+	suite = CU_add_suite("lua_cache", setup, cleanup);
+	CU_add_test(suite, "no cache", test_no_cache);
+	CU_add_test(suite, "precompile", test_precompile);
+	CU_add_test(suite, "precompile: error", test_precompile_error);
+	CU_add_test(suite, "invalid cache", test_invalid_cache);
+	CU_add_test(suite, "cache directory", test_cache_dir);
+}
+
@@ -0,0 +1,6 @@
+#ifndef __TEST_LUA_CACHE__H__
+#define __TEST_LUA_CACHE__H__
+
+void register_suite_lua_cache(void);
+
+#endif
@@ -0,0 +1,153 @@
+#include <cunit/CUnit.h>
+#include <test_lua_gc.h>
+#include <navcom/lua_gc.h>
+#include <lua/lua.h>
+#include <lua/lualib.h>
+#include <lua/lauxlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char * SCRIPT =
+	"local t = {}\n"
+	"for i = 1, 1000 do\n"
+	"	t[i] = { id = i, name = 'item' .. i }\n"
+	"end\n"
+	;
+
+static void test_setup_default(void)
+{
+	struct property_list_t properties;
+	struct lua_gc_t gc;
+	lua_State * lua;
+
+	lua = luaL_newstate();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	proplist_init(&properties);
+
+	CU_ASSERT_EQUAL(luaH_gc_setup(&gc, lua, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(gc.idle, 0);
+	CU_ASSERT_EQUAL(gc.step, 4);
+
+	/* nothing to do in 'auto' mode */
+	luaH_gc_called(&gc);
+	CU_ASSERT_EQUAL(gc.pending, 0);
+	CU_ASSERT_EQUAL(luaH_gc_idle(&gc, lua), 0);
+	CU_ASSERT_EQUAL(gc.steps, 0);
+
+	proplist_free(&properties);
+	lua_close(lua);
+}
+
+static void test_setup_invalid(void)
+{
+	struct property_list_t properties;
+	struct lua_gc_t gc;
+	lua_State * lua;
+
+	lua = luaL_newstate();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	proplist_init(&properties);
+
+	proplist_set(&properties, "gc", "sometimes");
+	CU_ASSERT_EQUAL(luaH_gc_setup(&gc, lua, &properties), EXIT_FAILURE);
+
+	proplist_set(&properties, "gc", "idle");
+	proplist_set(&properties, "gc_step", "4k");
+	CU_ASSERT_EQUAL(luaH_gc_setup(&gc, lua, &properties), EXIT_FAILURE);
+
+	proplist_set(&properties, "gc_step", "16");
+	proplist_set(&properties, "gc_pause", "200");
+	CU_ASSERT_EQUAL(luaH_gc_setup(&gc, lua, &properties), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(gc.idle, 1);
+	CU_ASSERT_EQUAL(gc.step, 16);
+
+	proplist_free(&properties);
+	lua_close(lua);
+}
+
+static void test_idle_steps(void)
+{
+	struct property_list_t properties;
+	struct lua_gc_t gc;
+	lua_State * lua;
+	int before;
+	int n;
+
+	lua = luaL_newstate();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	luaL_openlibs(lua);
+	proplist_init(&properties);
+	proplist_set(&properties, "gc", "idle");
+	CU_ASSERT_EQUAL_FATAL(luaH_gc_setup(&gc, lua, &properties), EXIT_SUCCESS);
+
+	CU_ASSERT_EQUAL(luaL_dostring(lua, SCRIPT), LUA_OK);
+	luaH_gc_called(&gc);
+	CU_ASSERT_EQUAL(gc.pending, 1);
+	before = lua_gc(lua, LUA_GCCOUNT, 0);
+
+	/* steps until the garbage of the script is collected */
+	for (n = 0; (n < 100000) && luaH_gc_idle(&gc, lua); ++n)
+		;
+	CU_ASSERT_EQUAL(gc.pending, 0);
+	CU_ASSERT(gc.cycles >= 1);
+	CU_ASSERT(gc.steps > 1);
+	CU_ASSERT(gc.max_pause > 0);
+	CU_ASSERT(lua_gc(lua, LUA_GCCOUNT, 0) < before);
+
+	/* no more work without another call */
+	CU_ASSERT_EQUAL(luaH_gc_idle(&gc, lua), 0);
+
+	proplist_free(&properties);
+	lua_close(lua);
+}
+
+static void test_called_during_cycle(void)
+{
+	struct lua_gc_t gc;
+
+	memset(&gc, 0, sizeof(gc));
+	gc.idle = 1;
+
+	luaH_gc_called(&gc);
+	CU_ASSERT_EQUAL(gc.pending, 1);
+
+	gc.in_cycle = 1;
+	luaH_gc_called(&gc);
+	CU_ASSERT_EQUAL(gc.pending, 2);
+}
+
+static void test_write_stats(void)
+{
+	struct lua_gc_t gc;
+	char buf[256];
+	FILE * file;
+
+	memset(&gc, 0, sizeof(gc));
+	gc.idle = 1;
+	gc.steps = 120;
+	gc.cycles = 4;
+	gc.max_pause = 35000;
+
+	file = tmpfile();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	luaH_gc_write_stats(&gc, file);
+	rewind(file);
+	CU_ASSERT_PTR_NOT_NULL(fgets(buf, sizeof(buf), file));
+	fclose(file);
+
+	CU_ASSERT_STRING_EQUAL(buf, " gc=idle gc_steps=120 gc_cycles=4 gc_max_pause=35000");
+}
+
+void register_suite_lua_gc(void)
+{
+	CU_Suite * suite;
+
+	suite = CU_add_suite("lua_gc", NULL, NULL);
+	CU_add_test(suite, "setup default", test_setup_default);
+	CU_add_test(suite, "setup invalid", test_setup_invalid);
+	CU_add_test(suite, "idle steps", test_idle_steps);
+	CU_add_test(suite, "called during cycle", test_called_during_cycle);
+	CU_add_test(suite, "write stats", test_write_stats);
+}
+
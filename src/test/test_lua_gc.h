@@ -0,0 +1,6 @@
+#ifndef __TEST_LUA_GC__H__
+#define __TEST_LUA_GC__H__
+
+void register_suite_lua_gc(void);
+
+#endif
@@ -3,6 +3,7 @@
 #include <navcom/lua_message.h>
 #include <navcom/lua_debug.h>
 #include <navcom/message.h>
+#include <nmea/nmea.h>
 #include <common/macros.h>
 #include <lua/lua.h>
 #include <lua/lualib.h>
@@ -102,6 +103,60 @@ static int call_write_read(
 	return rc;
 }
 
+/**
+ * Calls the function 'process' with message objects, the input
+ * message is read only. Returns the result of the function, or -1
+ * if the script failed.
+ */
+static int call_object(
+		const char * script,
+		struct message_t * msg_out,
+		struct message_t * msg_in)
+{
+	lua_State * lua;
+	int ref_out;
+	int ref_in;
+	int rc = -1;
+
+	lua = luaL_newstate();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(lua);
+	if (!lua) return -1;
+
+	lua_atpanic(lua, panic);
+	luaL_openlibs(lua);
+	luaH_setup_message_handling(lua);
+	ref_out = luaH_newmsg(lua, 0);
+	ref_in = luaH_newmsg(lua, 1);
+
+	if (setjmp(env) == 0) {
+		CU_ASSERT_EQUAL(luaL_dostring(lua, script), LUA_OK);
+
+		lua_getglobal(lua, "process");
+		luaH_pushmsg(lua, ref_out, msg_out);
+		luaH_pushmsg(lua, ref_in, msg_in);
+		if (lua_pcall(lua, 2, 1, 0) == LUA_OK)
+			rc = luaL_checkinteger(lua, -1);
+		lua_pop(lua, 1);
+		luaH_clearmsg(lua, ref_out);
+		luaH_clearmsg(lua, ref_in);
+
+		/* the script may keep the objects, but not use them */
+		lua_getglobal(lua, "later");
+		if (lua_isfunction(lua, -1)) {
+			CU_ASSERT_NOT_EQUAL(lua_pcall(lua, 0, 0, 0), LUA_OK);
+		}
+		lua_settop(lua, 0);
+	} else {
+		lua_atpanic(lua, NULL);
+		printf("LUA ERROR: %s\n", lua_tostring(lua, -1));
+		lua_pop(lua, 1);
+	}
+
+	lua_close(lua);
+
+	return rc;
+}
+
 static void test_msg_system_type(void)
 {
 	const char * SCRIPT =
@@ -301,6 +356,203 @@ static void test_msg_wr_nmea_rmc(void)
 	CU_ASSERT_EQUAL(memcmp(&msg_out, &msg_in, sizeof(msg_in)), 0);
 }
 
+static void test_msg_wr_nmea_all(void)
+{
+	static const char * SENTENCES[] =
+	{
+		"$GPRMB,A,0.66,L,003,004,4917.24,N,12309.57,W,001.3,052.5,000.5,V*20",
+		"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+		"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+		"$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75",
+		"$GPGLL,4916.45,N,12311.12,W,225444,A*31",
+		"$GPRTE,2,1,c,0,W3IWI,DRIVWY,32CEDR,32-29,32BKLD,32-I95,32-US1,BW-32,BW-198*69",
+		"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48",
+		"$GPBOD,099.3,T,105.6,M,2,1*45",
+		"$PGRME,15.0,M,45.0,M,25.0,M*1C",
+		"$PGRMZ,2062,f,3*2D",
+		"$HCHDG,98.3,0.0,E,12.6,W*57",
+		"$IIMWV,084.0,R,10.4,N,A*04",
+		"$IIVWR,084.0,R,10.4,N,5.4,M,19.3,K*4A",
+		"$IIVWT,084.0,R,10.4,N,5.4,M,19.3,K*4C",
+		"$IIDBT,9.3,f,2.84,M,1.55,F*14",
+		"$IIVLW,7803.2,N,0.00,N*43",
+		"$IIVHW,,T,211.0,M,0.00,N,0.00,K*79",
+		"$IIMTW,9.5,C*2F",
+	};
+
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	return msg_from_table(msg_out, msg_to_table(msg_in))\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+	size_t i;
+
+	for (i = 0; i < sizeof(SENTENCES) / sizeof(SENTENCES[0]); ++i) {
+		memset(&msg_in, 0, sizeof(msg_in));
+		memset(&msg_out, 0, sizeof(msg_out));
+
+		msg_in.type = MSG_NMEA;
+		CU_ASSERT_EQUAL(nmea_read(&msg_in.data.attr.nmea, SENTENCES[i]), 0);
+
+		CU_ASSERT_EQUAL(call_write_read(SCRIPT, &msg_out, &msg_in), 0);
+		CU_ASSERT_EQUAL(msg_out.data.attr.nmea.type, msg_in.data.attr.nmea.type);
+		CU_ASSERT_EQUAL(memcmp(&msg_out, &msg_in, sizeof(msg_in)), 0);
+	}
+}
+
+static void test_msg_object_read(void)
+{
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	if msg_in.msg_type ~= MSG_NMEA then return 1 end\n"
+		"	if msg_in.nmea_type ~= NMEA_RMC then return 2 end\n"
+		"	if msg_in.status ~= NMEA_STATUS_OK then return 3 end\n"
+		"	if msg_in.time.h ~= 20 or msg_in.time.m ~= 10 then return 4 end\n"
+		"	if msg_in.date.d ~= 26 or msg_in.date.m ~= 8 then return 5 end\n"
+		"	if math.abs(msg_in.head - 328.4) > 0.0001 then return 6 end\n"
+		"	if msg_in.lat_dir ~= NMEA_NORTH then return 7 end\n"
+		"	if msg_in.sats ~= nil then return 8 end\n"
+		"	if msg_in.timer_id ~= nil then return 9 end\n"
+		"	if string.sub(msg_in.raw, 1, 6) ~= '$GPRMC' then return 10 end\n"
+		"	return 0\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+
+	msg_in.type = MSG_NMEA;
+	CU_ASSERT_EQUAL(nmea_read(&msg_in.data.attr.nmea,
+		"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17"), 0);
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), 0);
+}
+
+static void test_msg_object_write(void)
+{
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	msg_out.msg_type = MSG_NMEA\n"
+		"	msg_out.nmea_type = NMEA_GSV\n"
+		"	msg_out.n_messages = 3\n"
+		"	msg_out.sat = { { id = 12, elevation = 45, azimuth = 270, snr = 38 } }\n"
+		"	return 0\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), 0);
+	CU_ASSERT_EQUAL(msg_out.type, MSG_NMEA);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.type, NMEA_GSV);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.n_messages, 3);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.sat[0].id, 12);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.sat[0].elevation, 45);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.sat[0].azimuth, 270);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.sat[0].snr, 38);
+	CU_ASSERT_EQUAL(msg_out.data.attr.nmea.sentence.gsv.sat[1].id, 0);
+}
+
+static void test_msg_object_timer(void)
+{
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	msg_out.msg_type = MSG_TIMER\n"
+		"	msg_out.timer_id = msg_in.timer_id + 1\n"
+		"	return 0\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+	msg_in.type = MSG_TIMER;
+	msg_in.data.attr.timer_id = 41;
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), 0);
+	CU_ASSERT_EQUAL(msg_out.type, MSG_TIMER);
+	CU_ASSERT_EQUAL(msg_out.data.attr.timer_id, 42);
+}
+
+static void test_msg_object_readonly(void)
+{
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	msg_in.timer_id = 2\n"
+		"	return 0\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+	msg_in.type = MSG_TIMER;
+	msg_in.data.attr.timer_id = 1;
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), -1);
+	CU_ASSERT_EQUAL(msg_in.data.attr.timer_id, 1);
+}
+
+static void test_msg_object_unknown_field(void)
+{
+	const char * SCRIPT =
+		"function process(msg_out, msg_in)\n"
+		"	msg_out.msg_type = MSG_TIMER\n"
+		"	msg_out.sog = 2\n"
+		"	return 0\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), -1);
+}
+
+static void test_msg_object_functions(void)
+{
+	const char * SCRIPT =
+		"local kept = nil\n"
+		"function process(msg_out, msg_in)\n"
+		"	kept = msg_in\n"
+		"	if msg_type(msg_in) ~= MSG_SYSTEM then return 1 end\n"
+		"	if msg_clone(msg_in, msg_out) ~= 1 then return 2 end\n"
+		"	return msg_clone(msg_out, msg_in)\n"
+		"end\n"
+		"function later()\n"
+		"	return kept.msg_type\n"
+		"end\n"
+		;
+
+	struct message_t msg_in;
+	struct message_t msg_out;
+
+	memset(&msg_in, 0, sizeof(msg_in));
+	memset(&msg_out, 0, sizeof(msg_out));
+	msg_in.type = MSG_SYSTEM;
+	msg_in.data.attr.system = SYSTEM_TERMINATE;
+
+	CU_ASSERT_EQUAL(call_object(SCRIPT, &msg_out, &msg_in), 0);
+	CU_ASSERT_EQUAL(memcmp(&msg_out, &msg_in, sizeof(msg_in)), 0);
+}
+
 void register_suite_lua_message(void)
 {
 	CU_Suite * suite;
@@ -313,5 +565,12 @@ void register_suite_lua_message(void)
 	CU_add_test(suite, "message write/read system terminate", test_msg_wr_system_terminate);
 	CU_add_test(suite, "message write/read timer", test_msg_wr_timer);
 	CU_add_test(suite, "message write/read nmea RMC", test_msg_wr_nmea_rmc);
+	CU_add_test(suite, "message write/read nmea all sentences", test_msg_wr_nmea_all);
+	CU_add_test(suite, "message object read", test_msg_object_read);
+	CU_add_test(suite, "message object write", test_msg_object_write);
+	CU_add_test(suite, "message object timer", test_msg_object_timer);
+	CU_add_test(suite, "message object read only", test_msg_object_readonly);
+	CU_add_test(suite, "message object unknown field", test_msg_object_unknown_field);
+	CU_add_test(suite, "message object functions", test_msg_object_functions);
 }
 
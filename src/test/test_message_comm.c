@@ -0,0 +1,247 @@
+#include <cunit/CUnit.h>
+#include <test_message_comm.h>
+#include <navcom/message_comm.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static int fd[2];
+
+static int setup(void)
+{
+	return pipe(fd);
+}
+
+static int cleanup(void)
+{
+	close(fd[0]);
+	close(fd[1]);
+	return 0;
+}
+
+static void test_parameters(void)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+
+	CU_ASSERT_EQUAL(message_write(-1, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_write(fd[1], NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_read(-1, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_read(fd[0], NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_recv(-1, &msg), -1);
+	CU_ASSERT_EQUAL(message_recv(fd[0], NULL), -1);
+}
+
+static void test_frame_size(void)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+
+	msg.type = MSG_TIMER;
+	msg.data.attr.timer_id = 0;
+	CU_ASSERT_EQUAL(message_frame_size(&msg), sizeof(struct message_header_t));
+
+	msg.data.attr.timer_id = 0x12345678;
+	CU_ASSERT_EQUAL(message_frame_size(&msg), sizeof(struct message_header_t) + sizeof(uint32_t));
+
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = 0;
+	CU_ASSERT_EQUAL(message_frame_size(&msg), sizeof(struct message_header_t));
+
+	msg.type = MSG_INVALID;
+	CU_ASSERT(message_frame_size(&msg) <= MESSAGE_FRAME_MAX);
+}
+
+static void test_write_read_timer(void)
+{
+	struct message_t msg;
+	struct message_t res;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	msg.data.attr.timer_id = 0x12345678;
+
+	memset(&res, 0xff, sizeof(res));
+	CU_ASSERT_EQUAL(message_write(fd[1], &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_read(fd[0], &res), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(memcmp(&msg, &res, sizeof(msg)), 0);
+}
+
+static void test_write_read_multiple(void)
+{
+	struct message_t msg[3];
+	struct message_t res;
+	size_t i;
+
+	memset(msg, 0, sizeof(msg));
+	msg[0].type = MSG_SYSTEM;
+	msg[0].data.attr.system = SYSTEM_TERMINATE;
+	msg[1].type = MSG_TIMER;
+	msg[1].data.attr.timer_id = 0;
+	msg[2].type = MSG_TIMER;
+	msg[2].data.attr.timer_id = 7;
+
+	for (i = 0; i < sizeof(msg) / sizeof(msg[0]); ++i)
+		CU_ASSERT_EQUAL(message_write(fd[1], &msg[i]), EXIT_SUCCESS);
+
+	for (i = 0; i < sizeof(msg) / sizeof(msg[0]); ++i) {
+		CU_ASSERT_EQUAL(message_recv(fd[0], &res), (int)message_frame_size(&msg[i]));
+		CU_ASSERT_EQUAL(memcmp(&msg[i], &res, sizeof(res)), 0);
+	}
+}
+
+#if defined(NEEDS_NMEA)
+static void test_write_read_nmea(void)
+{
+	static const char * SENTENCE = "$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17";
+
+	struct message_t msg;
+	struct message_t res;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_NMEA;
+	CU_ASSERT_EQUAL(nmea_read(&msg.data.attr.nmea, SENTENCE), 0);
+	CU_ASSERT(message_frame_size(&msg) < MESSAGE_FRAME_MAX);
+
+	memset(&res, 0xff, sizeof(res));
+	CU_ASSERT_EQUAL(message_write(fd[1], &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_read(fd[0], &res), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(memcmp(&msg, &res, sizeof(msg)), 0);
+}
+#endif
+
+static void test_invalid_header(void)
+{
+	struct message_header_t header;
+	struct message_t res;
+
+	header.type = MSG_TIMER;
+	header.size = sizeof(uint32_t) + 1;
+	CU_ASSERT_EQUAL(message_header_valid(&header), 0);
+
+	CU_ASSERT_EQUAL(write(fd[1], &header, sizeof(header)), (int)sizeof(header));
+	CU_ASSERT_EQUAL(message_recv(fd[0], &res), -1);
+}
+
+static void test_end_of_file(void)
+{
+	int p[2];
+	struct message_t res;
+
+	CU_ASSERT_EQUAL_FATAL(pipe(p), 0);
+	close(p[1]);
+	CU_ASSERT_EQUAL(message_recv(p[0], &res), 0);
+	CU_ASSERT_EQUAL(message_read(p[0], &res), EXIT_FAILURE);
+	close(p[0]);
+}
+
+static void test_reader_batch(void)
+{
+	struct message_reader_t reader;
+	struct message_t msg;
+	struct message_t res;
+	uint32_t i;
+
+	message_reader_init(&reader);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	for (i = 1; i <= 10; ++i) {
+		msg.data.attr.timer_id = i;
+		CU_ASSERT_EQUAL(message_write(fd[1], &msg), EXIT_SUCCESS);
+	}
+
+	/* all messages with one read */
+	CU_ASSERT(message_reader_fill(&reader, fd[0]) > 0);
+	for (i = 1; i <= 10; ++i) {
+		CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 1);
+		CU_ASSERT_EQUAL(res.type, MSG_TIMER);
+		CU_ASSERT_EQUAL(res.data.attr.timer_id, i);
+	}
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+}
+
+static void test_reader_partial(void)
+{
+	struct message_reader_t reader;
+	struct message_t msg;
+	struct message_t res;
+	uint8_t frame[MESSAGE_FRAME_MAX];
+	uint32_t size;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	msg.data.attr.timer_id = 0x01020304;
+	size = message_encode(frame, &msg);
+
+	message_reader_init(&reader);
+
+	/* incomplete header */
+	CU_ASSERT_EQUAL(write(fd[1], frame, 3), 3);
+	CU_ASSERT_EQUAL(message_reader_fill(&reader, fd[0]), 3);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+
+	/* incomplete payload */
+	CU_ASSERT_EQUAL(write(fd[1], frame + 3, size - 4), (int)size - 4);
+	CU_ASSERT_EQUAL(message_reader_fill(&reader, fd[0]), (int)size - 4);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+
+	/* rest of the message */
+	CU_ASSERT_EQUAL(write(fd[1], frame + size - 1, 1), 1);
+	CU_ASSERT_EQUAL(message_reader_fill(&reader, fd[0]), 1);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 1);
+	CU_ASSERT_EQUAL(memcmp(&msg, &res, sizeof(msg)), 0);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+}
+
+static void test_reader_invalid(void)
+{
+	struct message_reader_t reader;
+	struct message_header_t header;
+	struct message_t res;
+
+	header.type = MSG_SYSTEM;
+	header.size = 100;
+
+	message_reader_init(&reader);
+	CU_ASSERT_EQUAL(write(fd[1], &header, sizeof(header)), (int)sizeof(header));
+	CU_ASSERT_EQUAL(message_reader_fill(&reader, fd[0]), (int)sizeof(header));
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), -1);
+	CU_ASSERT_EQUAL(message_reader_next(&reader, &res), 0);
+}
+
+static void test_reader_end_of_file(void)
+{
+	int p[2];
+	struct message_reader_t reader;
+
+	CU_ASSERT_EQUAL_FATAL(pipe(p), 0);
+	close(p[1]);
+	message_reader_init(&reader);
+	CU_ASSERT_EQUAL(message_reader_fill(&reader, p[0]), 0);
+	close(p[0]);
+}
+
+void register_suite_message_comm(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("message_comm", setup, cleanup);
+	CU_add_test(suite, "parameters", test_parameters);
+	CU_add_test(suite, "frame size", test_frame_size);
+	CU_add_test(suite, "write/read timer", test_write_read_timer);
+	CU_add_test(suite, "write/read multiple", test_write_read_multiple);
+#if defined(NEEDS_NMEA)
+	CU_add_test(suite, "write/read nmea", test_write_read_nmea);
+#endif
+	CU_add_test(suite, "invalid header", test_invalid_header);
+	CU_add_test(suite, "end of file", test_end_of_file);
+	CU_add_test(suite, "reader: batch", test_reader_batch);
+	CU_add_test(suite, "reader: partial", test_reader_partial);
+	CU_add_test(suite, "reader: invalid", test_reader_invalid);
+	CU_add_test(suite, "reader: end of file", test_reader_end_of_file);
+}
+
@@ -0,0 +1,366 @@
+#include <cunit/CUnit.h>
+#include <test_message_queue.h>
+#include <navcom/message_queue.h>
+#include <navcom/message_comm.h>
+#include <navcom/proc.h>
+#include <navcom/metrics.h>
+#include <navcom/reactor.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+
+static void timer_message(struct message_t * msg, uint32_t id)
+{
+	memset(msg, 0, sizeof(struct message_t));
+	msg->type = MSG_TIMER;
+	msg->data.attr.timer_id = id;
+}
+
+static void system_message(struct message_t * msg)
+{
+	memset(msg, 0, sizeof(struct message_t));
+	msg->type = MSG_SYSTEM;
+	msg->data.attr.system = SYSTEM_TERMINATE;
+}
+
+/**
+ * Returns the timer ids of all queued messages as decimal digits,
+ * the queue is empty afterwards.
+ */
+static uint32_t drain(struct message_queue_t * queue)
+{
+	uint32_t ids = 0;
+
+	while (!message_queue_empty(queue)) {
+		ids = ids * 10 + message_queue_front(queue)->data.attr.timer_id;
+		message_queue_pop(queue);
+	}
+	return ids;
+}
+
+static void test_parameters(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+
+	timer_message(&msg, 1);
+
+	CU_ASSERT_EQUAL(message_queue_init(NULL, 1, MESSAGE_QUEUE_BLOCK), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_init(&queue, 0, MESSAGE_QUEUE_BLOCK), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_init(&queue, 1, -1), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_init(&queue, 1, MESSAGE_QUEUE_COALESCE + 1), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_push(NULL, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_queue_empty(NULL), 1);
+	CU_ASSERT_PTR_NULL(message_queue_front(NULL));
+	CU_ASSERT_PTR_NULL(message_queue_front(&queue));
+	message_queue_pop(NULL);
+	message_queue_pop(&queue);
+	message_queue_destroy(NULL);
+
+	CU_ASSERT_EQUAL(message_queue_policy(NULL), -1);
+	CU_ASSERT_EQUAL(message_queue_policy(""), -1);
+	CU_ASSERT_EQUAL(message_queue_policy("drop"), -1);
+	CU_ASSERT_EQUAL(message_queue_policy("block"), MESSAGE_QUEUE_BLOCK);
+	CU_ASSERT_EQUAL(message_queue_policy("drop-oldest"), MESSAGE_QUEUE_DROP_OLDEST);
+	CU_ASSERT_EQUAL(message_queue_policy("drop-newest"), MESSAGE_QUEUE_DROP_NEWEST);
+	CU_ASSERT_EQUAL(message_queue_policy("coalesce"), MESSAGE_QUEUE_COALESCE);
+}
+
+static void test_fifo(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+	uint32_t i;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 3, MESSAGE_QUEUE_BLOCK), EXIT_SUCCESS);
+	CU_ASSERT_TRUE(message_queue_empty(&queue));
+
+	/* wraps around */
+	for (i = 1; i <= 5; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+		timer_message(&msg, i + 1);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+		CU_ASSERT_FALSE(message_queue_empty(&queue));
+		CU_ASSERT_EQUAL(drain(&queue), i * 10 + i + 1);
+	}
+	message_queue_destroy(&queue);
+}
+
+static void test_block(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+	uint32_t i;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 3, MESSAGE_QUEUE_BLOCK), EXIT_SUCCESS);
+	for (i = 1; i <= 3; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	}
+	timer_message(&msg, 4);
+	errno = 0;
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(errno, EAGAIN);
+	CU_ASSERT_EQUAL(queue.blocked, 1);
+	CU_ASSERT_EQUAL(queue.dropped, 0);
+	CU_ASSERT_EQUAL(drain(&queue), 123);
+	message_queue_destroy(&queue);
+}
+
+static void test_drop_oldest(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+	uint32_t i;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 3, MESSAGE_QUEUE_DROP_OLDEST), EXIT_SUCCESS);
+	for (i = 1; i <= 5; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	}
+	CU_ASSERT_EQUAL(queue.dropped, 2);
+	CU_ASSERT_EQUAL(drain(&queue), 345);
+	message_queue_destroy(&queue);
+}
+
+static void test_drop_newest(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+	uint32_t i;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 3, MESSAGE_QUEUE_DROP_NEWEST), EXIT_SUCCESS);
+	for (i = 1; i <= 5; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	}
+	CU_ASSERT_EQUAL(queue.dropped, 2);
+	CU_ASSERT_EQUAL(drain(&queue), 123);
+	message_queue_destroy(&queue);
+}
+
+static void test_coalesce(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 3, MESSAGE_QUEUE_COALESCE), EXIT_SUCCESS);
+
+	/* the latest value replaces the queued one, at its position */
+	timer_message(&msg, 1);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	timer_message(&msg, 2);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	timer_message(&msg, 1);
+	msg.data.attr.system = 7;
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(queue.coalesced, 1);
+	CU_ASSERT_EQUAL(queue.count, 2);
+	CU_ASSERT_EQUAL(message_queue_front(&queue)->data.attr.system, 7);
+
+	/* full, no message of the same kind: oldest is dropped */
+	timer_message(&msg, 3);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	timer_message(&msg, 4);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(queue.dropped, 1);
+	CU_ASSERT_EQUAL(drain(&queue), 234);
+	message_queue_destroy(&queue);
+}
+
+#if defined(NEEDS_NMEA)
+static void test_coalesce_nmea(void)
+{
+	static const char * RMC = "$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17";
+
+	struct message_queue_t queue;
+	struct message_t msg;
+
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 4, MESSAGE_QUEUE_COALESCE), EXIT_SUCCESS);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_NMEA;
+	CU_ASSERT_EQUAL(nmea_read(&msg.data.attr.nmea, RMC), 0);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(queue.count, 1);
+
+	/* sentences not parsed are distinguished by their tag */
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_NMEA;
+	strcpy(msg.data.attr.nmea.raw, "$PGRME,1,M,2,M,3,M*00");
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	strcpy(msg.data.attr.nmea.raw, "$PGRMZ,1,f,3*00");
+	CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(queue.count, 3);
+	CU_ASSERT_EQUAL(queue.coalesced, 2);
+
+	message_queue_destroy(&queue);
+}
+#endif
+
+static void test_system(void)
+{
+	struct message_queue_t queue;
+	struct message_t msg;
+	int policy;
+	int expected;
+
+	/* system messages are neither coalesced nor dropped */
+	for (policy = MESSAGE_QUEUE_BLOCK; policy <= MESSAGE_QUEUE_COALESCE; ++policy) {
+		CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 2, policy), EXIT_SUCCESS);
+		system_message(&msg);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), EXIT_FAILURE);
+		timer_message(&msg, 1);
+		expected = (policy == MESSAGE_QUEUE_DROP_NEWEST) ? EXIT_SUCCESS : EXIT_FAILURE;
+		CU_ASSERT_EQUAL(message_queue_push(&queue, &msg), expected);
+		CU_ASSERT_EQUAL(queue.count, 2);
+		CU_ASSERT_EQUAL(message_queue_front(&queue)->type, MSG_SYSTEM);
+		message_queue_destroy(&queue);
+	}
+}
+
+static void test_proc_send(void)
+{
+	struct message_queue_t queue;
+	struct proc_config_t proc;
+	struct message_t msg;
+	int fd[2];
+	uint32_t i;
+	uint32_t n = 0;
+
+	CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+	CU_ASSERT_EQUAL_FATAL(fd_set_nonblocking(fd[1]), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 4, MESSAGE_QUEUE_DROP_OLDEST), EXIT_SUCCESS);
+	proc_config_init(&proc);
+	proc.wfd = fd[1];
+	proc.queue = &queue;
+
+	/* fill the pipe, the hub does not block */
+	for (i = 0; message_queue_empty(&queue); ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL_FATAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+	}
+	CU_ASSERT_EQUAL(proc_flush(&proc, 0), 1);
+	for (; queue.dropped == 0; ++i) {
+		timer_message(&msg, i);
+		CU_ASSERT_EQUAL_FATAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+	}
+
+	/* the receiver catches up, the queued messages are the latest ones */
+	while (proc_flush(&proc, 0) > 0) {
+		if (message_read(fd[0], &msg) == EXIT_SUCCESS)
+			++n;
+	}
+	CU_ASSERT_EQUAL(proc_flush(&proc, 0), 0);
+	close(fd[1]);
+	while (message_read(fd[0], &msg) == EXIT_SUCCESS)
+		++n;
+	CU_ASSERT_EQUAL(msg.data.attr.timer_id, i - 1);
+	CU_ASSERT_EQUAL(n + queue.dropped, i);
+
+	close(fd[0]);
+	message_queue_destroy(&queue);
+}
+
+/**
+ * Sends messages to a proc with a full pipe, using the queue with the
+ * specified policy, and checks the counters after the receiver has
+ * caught up: only the received messages count as sent.
+ */
+static void check_proc_send_counters(int policy, uint32_t extra)
+{
+	struct message_queue_t queue;
+	struct proc_config_t proc;
+	struct proc_metrics_t metrics;
+	struct message_t msg;
+	int fd[2];
+	uint32_t i;
+	uint32_t n;
+
+	CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+	CU_ASSERT_EQUAL_FATAL(fd_set_nonblocking(fd[1]), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 4, policy), EXIT_SUCCESS);
+	proc_config_init(&proc);
+	proc_metrics_init(&metrics);
+	proc.wfd = fd[1];
+	proc.queue = &queue;
+	proc.metrics = &metrics;
+
+	/* fill the pipe, then send more messages than the queue is able to hold */
+	timer_message(&msg, 1);
+	for (i = 0; message_queue_empty(&queue); ++i)
+		CU_ASSERT_EQUAL_FATAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(metrics.msgs_out, i - 1);
+	for (n = 0; n < extra; ++n, ++i)
+		CU_ASSERT_EQUAL_FATAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(metrics.msgs_out, i - 1 - extra);
+	CU_ASSERT_EQUAL(metrics.msgs_out + queue.count + message_queue_lost(&queue), i);
+
+	/* the receiver catches up */
+	n = 0;
+	while (proc_flush(&proc, 0) > 0) {
+		if (message_read(fd[0], &msg) == EXIT_SUCCESS)
+			++n;
+	}
+	close(fd[1]);
+	while (message_read(fd[0], &msg) == EXIT_SUCCESS)
+		++n;
+
+	CU_ASSERT_EQUAL(metrics.msgs_out, n);
+	CU_ASSERT_EQUAL(metrics.bytes_out, n * message_frame_size(&msg));
+	CU_ASSERT_EQUAL(metrics.msgs_out + message_queue_lost(&queue), i);
+	CU_ASSERT_EQUAL(metrics.write_failures, 0);
+
+	close(fd[0]);
+	message_queue_destroy(&queue);
+}
+
+static void test_proc_send_counters_block(void)
+{
+	/* no more than the queue holds, the hub would wait for the receiver */
+	check_proc_send_counters(MESSAGE_QUEUE_BLOCK, 3);
+}
+
+static void test_proc_send_counters_drop_oldest(void)
+{
+	check_proc_send_counters(MESSAGE_QUEUE_DROP_OLDEST, 10);
+}
+
+static void test_proc_send_counters_drop_newest(void)
+{
+	check_proc_send_counters(MESSAGE_QUEUE_DROP_NEWEST, 10);
+}
+
+static void test_proc_send_counters_coalesce(void)
+{
+	check_proc_send_counters(MESSAGE_QUEUE_COALESCE, 10);
+}
+
+void register_suite_message_queue(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("message_queue", NULL, NULL);
+	CU_add_test(suite, "parameters", test_parameters);
+	CU_add_test(suite, "fifo", test_fifo);
+	CU_add_test(suite, "block", test_block);
+	CU_add_test(suite, "drop oldest", test_drop_oldest);
+	CU_add_test(suite, "drop newest", test_drop_newest);
+	CU_add_test(suite, "coalesce", test_coalesce);
+#if defined(NEEDS_NMEA)
+	CU_add_test(suite, "coalesce nmea", test_coalesce_nmea);
+#endif
+	CU_add_test(suite, "system", test_system);
+	CU_add_test(suite, "proc send", test_proc_send);
+	CU_add_test(suite, "proc send counters: block", test_proc_send_counters_block);
+	CU_add_test(suite, "proc send counters: drop oldest", test_proc_send_counters_drop_oldest);
+	CU_add_test(suite, "proc send counters: drop newest", test_proc_send_counters_drop_newest);
+	CU_add_test(suite, "proc send counters: coalesce", test_proc_send_counters_coalesce);
+}
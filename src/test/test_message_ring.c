@@ -0,0 +1,239 @@
+#include <cunit/CUnit.h>
+#include <test_message_ring.h>
+#include <navcom/message_ring.h>
+#include <navcom/message_comm.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static struct message_ring_t ring;
+
+static int setup(void)
+{
+	return message_ring_create(&ring, MESSAGE_RING_SIZE_MIN) == EXIT_SUCCESS ? 0 : -1;
+}
+
+static int cleanup(void)
+{
+	message_ring_destroy(&ring);
+	return 0;
+}
+
+static int readable(int fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, 0) == 1;
+}
+
+static void timer_message(struct message_t * msg, uint32_t id)
+{
+	memset(msg, 0, sizeof(struct message_t));
+	msg->type = MSG_TIMER;
+	msg->data.attr.timer_id = id;
+}
+
+static void test_parameters(void)
+{
+	struct message_ring_t r;
+	struct message_t msg;
+
+	message_ring_init(&r);
+	timer_message(&msg, 1);
+
+	CU_ASSERT_EQUAL(message_ring_create(NULL, 0), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_write(NULL, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_write(&r, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_write(&ring, NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_read(NULL, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_read(&r, &msg), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_read(&ring, NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(message_ring_empty(NULL), 1);
+	CU_ASSERT_EQUAL(message_ring_empty(&r), 1);
+	message_ring_destroy(NULL);
+	message_ring_destroy(&r);
+}
+
+static void test_size(void)
+{
+	struct message_ring_t r;
+
+	CU_ASSERT_EQUAL(message_ring_create(&r, 0), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(r.size, MESSAGE_RING_SIZE_MIN);
+	message_ring_destroy(&r);
+	CU_ASSERT_PTR_NULL(r.shm);
+	CU_ASSERT_EQUAL(r.efd, -1);
+
+	CU_ASSERT_EQUAL(message_ring_create(&r, MESSAGE_RING_SIZE_MIN + 1), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(r.size, 2 * MESSAGE_RING_SIZE_MIN);
+	message_ring_destroy(&r);
+
+	CU_ASSERT_EQUAL(message_ring_create(&r, 0xffffffff), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(r.size, MESSAGE_RING_SIZE_MAX);
+	message_ring_destroy(&r);
+}
+
+static void test_write_read(void)
+{
+	struct message_t msg;
+	struct message_t res;
+
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+	CU_ASSERT_FALSE(readable(ring.efd));
+
+	timer_message(&msg, 0x12345678);
+	CU_ASSERT_EQUAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+	CU_ASSERT_FALSE(message_ring_empty(&ring));
+	CU_ASSERT_TRUE(readable(ring.efd));
+
+	memset(&res, 0xff, sizeof(res));
+	CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(memcmp(&msg, &res, sizeof(msg)), 0);
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+	CU_ASSERT_FALSE(readable(ring.efd));
+}
+
+static void test_wakeup_only_if_idle(void)
+{
+	struct message_t msg;
+	struct message_t res;
+	uint32_t i;
+
+	/* the eventfd stays readable as long as messages are available */
+	for (i = 0; i < 3; ++i) {
+		timer_message(&msg, i + 1);
+		CU_ASSERT_EQUAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+	}
+	for (i = 0; i < 3; ++i) {
+		CU_ASSERT_TRUE(readable(ring.efd));
+		CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(res.data.attr.timer_id, i + 1);
+	}
+	CU_ASSERT_FALSE(readable(ring.efd));
+
+	/* messages written while the consumer is busy do not wake it up again */
+	timer_message(&msg, 10);
+	CU_ASSERT_EQUAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+	CU_ASSERT_TRUE(readable(ring.efd));
+	CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+	CU_ASSERT_FALSE(readable(ring.efd));
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+}
+
+static void test_full(void)
+{
+	struct message_t msg;
+	struct message_t res;
+	uint32_t n = 0;
+	uint32_t i;
+
+	/* all frames of the same size, no trailing zeros */
+	timer_message(&msg, 0);
+	for (;;) {
+		msg.data.attr.timer_id = 0x01000000 + n;
+		if (message_ring_write(&ring, &msg) != EXIT_SUCCESS)
+			break;
+		++n;
+	}
+	CU_ASSERT_EQUAL(errno, EAGAIN);
+	CU_ASSERT_EQUAL(n, ring.size / message_frame_size(&msg));
+
+	for (i = 0; i < n; ++i) {
+		CU_ASSERT_EQUAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(res.data.attr.timer_id, 0x01000000 + i);
+	}
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+	CU_ASSERT_FALSE(readable(ring.efd));
+}
+
+#if defined(NEEDS_NMEA)
+static void test_wrap_around(void)
+{
+	static const char * SENTENCE = "$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17";
+
+	struct message_t msg;
+	struct message_t res;
+	uint32_t i;
+
+	/* frames of odd sizes, which are split at the end of the ring */
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_NMEA;
+	CU_ASSERT_EQUAL(nmea_read(&msg.data.attr.nmea, SENTENCE), 0);
+	for (i = 0; i < 4 * ring.size / message_frame_size(&msg); ++i) {
+		msg.data.attr.nmea.sentence.rmc.date.y = i;
+		CU_ASSERT_EQUAL_FATAL(message_ring_write(&ring, &msg), EXIT_SUCCESS);
+		memset(&res, 0xff, sizeof(res));
+		CU_ASSERT_EQUAL_FATAL(message_ring_read(&ring, &res), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL_FATAL(memcmp(&msg, &res, sizeof(msg)), 0);
+	}
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+}
+#endif
+
+static void test_processes(void)
+{
+	static const uint32_t NUM = 100000;
+
+	struct message_t msg;
+	uint32_t i;
+	int status;
+	pid_t pid;
+
+	pid = fork();
+	CU_ASSERT_TRUE_FATAL(pid >= 0);
+	if (pid == 0) {
+		/* consumer, waits like a proc for the eventfd to become readable */
+		struct pollfd pfd;
+		struct message_t res;
+
+		for (i = 0; i < NUM; ++i) {
+			pfd.fd = ring.efd;
+			pfd.events = POLLIN;
+			if (poll(&pfd, 1, 5000) != 1)
+				_exit(1);
+			if (message_ring_read(&ring, &res) != EXIT_SUCCESS)
+				_exit(2);
+			if (res.data.attr.timer_id != i)
+				_exit(3);
+		}
+		_exit(0);
+	}
+
+	/* producer, retries if the ring is full */
+	for (i = 0; i < NUM; ++i) {
+		timer_message(&msg, i);
+		while (message_ring_write(&ring, &msg) != EXIT_SUCCESS)
+			usleep(10);
+	}
+	CU_ASSERT_EQUAL(waitpid(pid, &status, 0), pid);
+	CU_ASSERT_TRUE(WIFEXITED(status));
+	CU_ASSERT_EQUAL(WEXITSTATUS(status), 0);
+	CU_ASSERT_TRUE(message_ring_empty(&ring));
+}
+
+void register_suite_message_ring(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("message_ring", setup, cleanup);
+	CU_add_test(suite, "parameters", test_parameters);
+	CU_add_test(suite, "size", test_size);
+	CU_add_test(suite, "write/read", test_write_read);
+	CU_add_test(suite, "wakeup only if idle", test_wakeup_only_if_idle);
+	CU_add_test(suite, "full", test_full);
+#if defined(NEEDS_NMEA)
+	CU_add_test(suite, "wrap around", test_wrap_around);
+#endif
+	CU_add_test(suite, "processes", test_processes);
+}
+
@@ -0,0 +1,6 @@
+#ifndef __TEST_MESSAGE_RING__H__
+#define __TEST_MESSAGE_RING__H__
+
+void register_suite_message_ring(void);
+
+#endif
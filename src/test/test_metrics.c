@@ -0,0 +1,117 @@
+#include <cunit/CUnit.h>
+#include <test_metrics.h>
+#include <navcom/metrics.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void test_init(void)
+{
+	struct histogram_t h;
+	unsigned int i;
+
+	memset(&h, 0xff, sizeof(h));
+	histogram_init(&h);
+	CU_ASSERT_EQUAL(h.count, 0);
+	CU_ASSERT_EQUAL(h.sum, 0);
+	CU_ASSERT_EQUAL(h.max, 0);
+	for (i = 0; i < HISTOGRAM_BUCKETS; ++i)
+		CU_ASSERT_EQUAL(h.buckets[i], 0);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 50), 0);
+	CU_ASSERT_EQUAL(histogram_percentile(NULL, 50), 0);
+}
+
+static void test_buckets(void)
+{
+	struct histogram_t h;
+
+	histogram_init(&h);
+	histogram_add(&h, 0);
+	histogram_add(&h, 1);
+	histogram_add(&h, 2);
+	histogram_add(&h, 3);
+	histogram_add(&h, 4);
+	histogram_add(&h, 1023);
+	histogram_add(&h, 1024);
+	histogram_add(&h, 0xffffffffffffffffull);
+
+	CU_ASSERT_EQUAL(h.count, 8);
+	CU_ASSERT_EQUAL(h.max, 0xffffffffffffffffull);
+	CU_ASSERT_EQUAL(h.buckets[0], 1);
+	CU_ASSERT_EQUAL(h.buckets[1], 1);
+	CU_ASSERT_EQUAL(h.buckets[2], 2);
+	CU_ASSERT_EQUAL(h.buckets[3], 1);
+	CU_ASSERT_EQUAL(h.buckets[10], 1);
+	CU_ASSERT_EQUAL(h.buckets[11], 1);
+	CU_ASSERT_EQUAL(h.buckets[HISTOGRAM_BUCKETS - 1], 1);
+}
+
+static void test_percentile(void)
+{
+	struct histogram_t h;
+	unsigned int i;
+
+	histogram_init(&h);
+	for (i = 0; i < 90; ++i)
+		histogram_add(&h, 100);
+	for (i = 0; i < 9; ++i)
+		histogram_add(&h, 1000);
+	histogram_add(&h, 5000);
+
+	CU_ASSERT_EQUAL(h.sum, 90 * 100 + 9 * 1000 + 5000);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 0), 127);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 50), 127);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 90), 127);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 99), 1023);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 100), 5000);
+	CU_ASSERT_EQUAL(histogram_percentile(&h, 200), 5000);
+}
+
+static void test_write(void)
+{
+	struct histogram_t h;
+	char buf[512];
+	FILE * file;
+	size_t n;
+
+	histogram_init(&h);
+	histogram_add(&h, 300);
+	histogram_add(&h, 300);
+	histogram_add(&h, 800);
+
+	file = tmpfile();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	histogram_write(file, "test", &h);
+	rewind(file);
+	n = fread(buf, 1, sizeof(buf) - 1, file);
+	buf[n] = '\0';
+	fclose(file);
+
+	CU_ASSERT_STRING_EQUAL(buf,
+		"histogram test count=3 sum=1400 avg=466 max=800 p50=511 p90=800 p99=800"
+		" buckets=0,0,0,0,0,0,0,0,0,2,1\n");
+}
+
+static void test_proc_metrics(void)
+{
+	struct proc_metrics_t m;
+
+	memset(&m, 0xff, sizeof(m));
+	proc_metrics_init(&m);
+	CU_ASSERT_EQUAL(m.msgs_in, 0);
+	CU_ASSERT_EQUAL(m.bytes_in, 0);
+	CU_ASSERT_EQUAL(m.msgs_out, 0);
+	CU_ASSERT_EQUAL(m.bytes_out, 0);
+	CU_ASSERT_EQUAL(m.write_failures, 0);
+}
+
+void register_suite_metrics(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("metrics", NULL, NULL);
+	CU_add_test(suite, "init", test_init);
+	CU_add_test(suite, "buckets", test_buckets);
+	CU_add_test(suite, "percentile", test_percentile);
+	CU_add_test(suite, "write", test_write);
+	CU_add_test(suite, "proc metrics", test_proc_metrics);
+}
@@ -0,0 +1,6 @@
+#ifndef __TEST_METRICS__H__
+#define __TEST_METRICS__H__
+
+void register_suite_metrics(void);
+
+#endif
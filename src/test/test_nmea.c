@@ -2,12 +2,16 @@
 #include <common/endian.h>
 #include <nmea/nmea.h>
 #include <nmea/nmea_util.h>
+#include <nmea/nmea_schema.h>
 #include <nmea/nmea_int.h>
 #include <nmea/nmea_fix.h>
 #include <nmea/nmea_checksum.h>
+#include <nmea/nmea_stream.h>
+#include <nmea/nmea_scan.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 /*
 	GP = General Positioning System (GPS)
@@ -403,25 +407,6 @@ static void test_sentence_parsing()
 	}
 }
 
-static void test_basic_string_writing(void)
-{
-	enum { SIZE = 128 };
-
-	char buf[SIZE];
-
-	memset(buf, 0, sizeof(buf));
-	CU_ASSERT_EQUAL(write_string(buf, SIZE, ""), 0);
-
-	memset(buf, 0, sizeof(buf));
-	CU_ASSERT_EQUAL(write_string(buf, 0, "hello"), -1);
-
-	memset(buf, 0, sizeof(buf));
-	CU_ASSERT_EQUAL(write_string(NULL, SIZE, "hello"), -1);
-
-	memset(buf, 0, sizeof(buf));
-	CU_ASSERT_EQUAL(write_string(buf, SIZE, "hello"), strlen("hello"));
-}
-
 static void test_nmea_fix_write(const struct nmea_fix_t * t, uint32_t ni, uint32_t nd, const char * outcome)
 {
 	enum { SIZE = 128 };
@@ -590,6 +575,79 @@ static void test_basic_longitude_writing(void)
 	t.d = 181; t.m =  0; t.s.i = 61; test_write_lon(&t, "");
 }
 
+static void test_basic_uint_writing(void)
+{
+	char buf[16];
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(NULL, sizeof(buf), 1, 1, '0'), -1);
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, sizeof(buf), 0, 0, '0'), 1);
+	CU_ASSERT_STRING_EQUAL(buf, "0");
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, sizeof(buf), 7, 3, '0'), 3);
+	CU_ASSERT_STRING_EQUAL(buf, "007");
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, sizeof(buf), 12345, 2, ' '), 5);
+	CU_ASSERT_STRING_EQUAL(buf, "12345");
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, sizeof(buf), 42, 5, ' '), 5);
+	CU_ASSERT_STRING_EQUAL(buf, "   42");
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, sizeof(buf), 4294967295u, 0, '0'), 10);
+	CU_ASSERT_STRING_EQUAL(buf, "4294967295");
+
+	memset(buf, 0, sizeof(buf));
+	CU_ASSERT_EQUAL(nmea_uint_write(buf, 2, 123, 0, '0'), -2);
+	CU_ASSERT_STRING_EQUAL(buf, "");
+
+	CU_ASSERT_EQUAL(nmea_uint_digits(0), 1);
+	CU_ASSERT_EQUAL(nmea_uint_digits(9), 1);
+	CU_ASSERT_EQUAL(nmea_uint_digits(10), 2);
+	CU_ASSERT_EQUAL(nmea_uint_digits(999999999), 9);
+	CU_ASSERT_EQUAL(nmea_uint_digits(1000000000), 10);
+}
+
+static void test_sentence_writer(void)
+{
+	static const char * SENTENCE = "$GPRMC,201124,A,4702.3947,N,00818.3372,E,0.3,328.4,260807,0.6,E,A*10";
+
+	struct nmea_writer_t w;
+	struct nmea_t nmea;
+	struct nmea_time_t t = { 25, 0, 0, 0 };
+	char buf[128];
+	uint32_t len = strlen(SENTENCE);
+	uint32_t size;
+
+	nmea_writer_start(&w, buf, sizeof(buf), START_TOKEN_NMEA, "GPXXX");
+	nmea_writer_char(&w, ',');
+	nmea_writer_uint(&w, 7, 3);
+	nmea_writer_char(&w, ',');
+	nmea_writer_string(&w, "A");
+	CU_ASSERT_EQUAL(nmea_writer_end(&w), 15);
+	CU_ASSERT_STRING_EQUAL(buf, "$GPXXX,007,A*39");
+	CU_ASSERT_EQUAL(nmea_checksum_check(buf, START_TOKEN_NMEA), 0);
+
+	/* invalid data */
+	nmea_writer_start(&w, buf, sizeof(buf), START_TOKEN_NMEA, "GPXXX");
+	nmea_writer_time(&w, &t, 0);
+	nmea_writer_char(&w, ',');
+	CU_ASSERT_EQUAL(nmea_writer_end(&w), -1);
+	CU_ASSERT_EQUAL(nmea_writer_end(NULL), -1);
+
+	/* buffer too small, the buffer is never overrun */
+	CU_ASSERT_EQUAL(nmea_read(&nmea, SENTENCE), 0);
+	for (size = 1; size <= len + 1; ++size) {
+		memset(buf, 0x55, sizeof(buf));
+		CU_ASSERT_EQUAL(nmea_write(buf, size, &nmea), (size > len) ? (int)len : -1);
+		CU_ASSERT_EQUAL(buf[size], 0x55);
+	}
+	CU_ASSERT_STRING_EQUAL(buf, SENTENCE);
+}
+
 static void test_sentence_writing(void)
 {
 	unsigned int i;
@@ -604,9 +662,6 @@ static void test_sentence_writing(void)
 		CU_ASSERT_EQUAL(rc, 0);
 
 		rc = nmea_write(buf, sizeof(buf), &nmea);
-		if (rc == -3) {
-			continue; /* writing not supported, which is ok */
-		}
 		if (rc == -2) {
 			printf("nmea_write: unknown sentence: '%s' (raw:'%s', type:%u)\n", SENTENCES[i], nmea.raw, nmea.type);
 			CU_ASSERT_NOT_EQUAL_FATAL(rc, -2);
@@ -618,7 +673,6 @@ static void test_sentence_writing(void)
 
 static void test_endianess(void)
 {
-	int rc;
 	struct nmea_t a;
 	struct nmea_t b;
 	unsigned int i;
@@ -627,14 +681,8 @@ static void test_endianess(void)
 		memset(&a, 0, sizeof(a));
 		CU_ASSERT_EQUAL(nmea_read(&a, SENTENCES[i]), 0);
 		memcpy(&b, &a, sizeof(b));
-		rc = nmea_hton(&a);
-		CU_ASSERT(rc != -1);
-		CU_ASSERT(rc != -2);
-		if (rc == -3) continue;
-		rc = nmea_ntoh(&a);
-		CU_ASSERT(rc != -1);
-		CU_ASSERT(rc != -2);
-		if (rc == -3) continue;
+		CU_ASSERT_EQUAL(nmea_hton(&a), 0);
+		CU_ASSERT_EQUAL(nmea_ntoh(&a), 0);
 		CU_ASSERT_EQUAL(memcmp(&a, &b, sizeof(a)), 0);
 	}
 }
@@ -956,6 +1004,456 @@ static void test_nmea_angle_endianess_ntoh()
 	}
 }
 
+static void test_stream_parameters(void)
+{
+	struct nmea_stream_t stream;
+	const char * p = "$";
+	uint32_t size = 1;
+
+	nmea_stream_init(&stream);
+	CU_ASSERT_EQUAL(nmea_stream_next(NULL, &p, &size), -1);
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, NULL, &size), -1);
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, NULL), -1);
+	p = NULL;
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), -1);
+}
+
+static void test_stream_sentences(void)
+{
+	static const char * DATA =
+		"garbage$GPRMC,1*00\r\n"
+		"!AIVDM,2*00\n"
+		"\r\n"
+		"$GPGLL,3*00\r";
+
+	struct nmea_stream_t stream;
+	const char * p = DATA;
+	uint32_t size = strlen(DATA);
+
+	nmea_stream_init(&stream);
+
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 1);
+	CU_ASSERT_STRING_EQUAL(stream.data, "$GPRMC,1*00");
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 1);
+	CU_ASSERT_STRING_EQUAL(stream.data, "!AIVDM,2*00");
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 1);
+	CU_ASSERT_STRING_EQUAL(stream.data, "$GPGLL,3*00");
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 0);
+	CU_ASSERT_EQUAL(size, 0);
+}
+
+static void test_stream_chunked(void)
+{
+	static const char * DATA =
+		"$GPRMC,201034,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*17\r\n"
+		"$GPRMC,201035,A,4702.4040,N,00818.3281,E,0.0,328.4,260807,0.6,E,A*16\r\n";
+
+	struct nmea_stream_t stream;
+	const char * p;
+	uint32_t size;
+	uint32_t i;
+	uint32_t chunk;
+	int rc;
+	int count;
+
+	/* all chunk sizes must yield the same sentences */
+	for (chunk = 1; chunk <= strlen(DATA); ++chunk) {
+		nmea_stream_init(&stream);
+		count = 0;
+		for (i = 0; i < strlen(DATA); i += chunk) {
+			p = DATA + i;
+			size = (i + chunk <= strlen(DATA)) ? chunk : strlen(DATA) - i;
+			while ((rc = nmea_stream_next(&stream, &p, &size)) != 0) {
+				CU_ASSERT_EQUAL(rc, 1);
+				CU_ASSERT_EQUAL(strlen(stream.data), 68);
+				CU_ASSERT_EQUAL(nmea_checksum_check(stream.data, START_TOKEN_NMEA), 0);
+				++count;
+			}
+			CU_ASSERT_EQUAL(size, 0);
+		}
+		CU_ASSERT_EQUAL(count, 2);
+	}
+}
+
+static void test_stream_too_long(void)
+{
+	char data[2 * NMEA_MAX_SENTENCE + 32];
+	struct nmea_stream_t stream;
+	const char * p = data;
+	uint32_t size;
+
+	memset(data, 'A', sizeof(data));
+	data[0] = '$';
+	strcpy(data + 2 * NMEA_MAX_SENTENCE, "\r\n$GPGLL,1*00\r\n");
+	size = strlen(data);
+
+	nmea_stream_init(&stream);
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), -2);
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 1);
+	CU_ASSERT_STRING_EQUAL(stream.data, "$GPGLL,1*00");
+	CU_ASSERT_EQUAL(nmea_stream_next(&stream, &p, &size), 0);
+}
+
+static const uint32_t TYPES[] = {
+	NMEA_RMB, NMEA_RMC, NMEA_GGA, NMEA_GSA, NMEA_GSV, NMEA_GLL, NMEA_RTE,
+	NMEA_VTG, NMEA_BOD, NMEA_GARMIN_RME, NMEA_GARMIN_RMM, NMEA_GARMIN_RMZ,
+	NMEA_HC_HDG, NMEA_II_MWV, NMEA_II_VWR, NMEA_II_VWT, NMEA_II_DBT,
+	NMEA_II_VLW, NMEA_II_VHW, NMEA_II_MTW,
+};
+
+static void test_sentence_lookup(void)
+{
+	const struct nmea_sentence_t * entry;
+	struct nmea_t nmea;
+	char s[NMEA_MAX_SENTENCE + 1];
+	size_t i;
+
+	for (i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); ++i) {
+		entry = nmea_sentence(TYPES[i]);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+		CU_ASSERT_EQUAL(entry->type, TYPES[i]);
+
+		/* the sentence must be found by its tag, even if the data is not valid */
+		snprintf(s, sizeof(s), "$%s,*", entry->tag);
+		nmea_checksum_write(s + strlen(s), 3, s + 1, s + strlen(s) - 1);
+		CU_ASSERT_NOT_EQUAL(nmea_read(&nmea, s), -4);
+	}
+
+	CU_ASSERT_PTR_NULL(nmea_sentence(NMEA_NONE));
+	CU_ASSERT_PTR_NULL(nmea_sentence(0x12345678));
+	CU_ASSERT_PTR_NULL(nmea_sentence(NMEA_RMC | 0x0100));
+
+	CU_ASSERT_EQUAL(nmea_read(&nmea, "$GPXXX,*63"), -4);
+	CU_ASSERT_EQUAL(nmea_read(&nmea, "$GPRM,*24"), -4);
+	CU_ASSERT_EQUAL(nmea_read(&nmea, "$GPRMCX,*3F"), -4);
+}
+
+static void test_scan_kernels(void)
+{
+	static const char CHARS[] = "$GPRMC,.0123456789*";
+
+	const struct nmea_scan_kernel_t * kernel;
+	const struct nmea_scan_kernel_t * scalar = NULL;
+	struct nmea_scan_t expected;
+	struct nmea_scan_t result;
+	char s[NMEA_SCAN_MAX];
+	uint32_t len;
+	uint32_t i;
+	int round;
+
+	for (kernel = nmea_scan_kernels; kernel->name; ++kernel) {
+		if (strcmp(kernel->name, "scalar") == 0)
+			scalar = kernel;
+	}
+	CU_ASSERT_PTR_NOT_NULL_FATAL(scalar);
+	CU_ASSERT_PTR_NOT_NULL(nmea_scan_kernel());
+	CU_ASSERT_PTR_EQUAL(nmea_scan_kernel(), nmea_scan_kernel());
+#if defined(__GNUC__) && defined(__ARM_NEON)
+	/* the NEON kernel must be checked against the scalar one on ARM targets */
+	CU_ASSERT_STRING_EQUAL(nmea_scan_kernel()->name, "neon");
+#endif
+	CU_ASSERT_EQUAL(nmea_scan(&result, s, NMEA_SCAN_MAX + 1), -1);
+	CU_ASSERT_EQUAL(nmea_scan(NULL, s, 0), -1);
+
+	srand(1);
+	for (kernel = nmea_scan_kernels; kernel->name; ++kernel) {
+		if (!kernel->supported())
+			continue;
+		for (round = 0; round < 50; ++round) {
+			for (len = 0; len <= NMEA_SCAN_MAX; ++len) {
+				for (i = 0; i < len; ++i) {
+					s[i] = CHARS[rand() % (sizeof(CHARS) - 1)];
+					/* keep the delimiter rare to test long sentences */
+					if (s[i] == '*' && (rand() % 8))
+						s[i] = ',';
+				}
+				CU_ASSERT_EQUAL(scalar->scan(&expected, s, len), 0);
+				CU_ASSERT_EQUAL(kernel->scan(&result, s, len), 0);
+				CU_ASSERT_EQUAL(result.end, expected.end);
+				CU_ASSERT_EQUAL(result.checksum, expected.checksum);
+				CU_ASSERT_EQUAL(result.commas[0], expected.commas[0]);
+				CU_ASSERT_EQUAL(result.commas[1], expected.commas[1]);
+			}
+		}
+	}
+}
+
+/*
+ * Reference implementations of the parsers, character by character,
+ * used to verify the fast implementations.
+ */
+
+static const char * ref_parse_int(const char * s, const char * e, uint32_t * v)
+{
+	*v = 0;
+	for (; *s && s < e; ++s) {
+		if (!isdigit((int)*s)) return s;
+		*v *= 10;
+		*v += *s - '0';
+	}
+	return s;
+}
+
+static const char * ref_fix_parse(const char * s, const char * e, struct nmea_fix_t * v)
+{
+	uint32_t f = NMEA_FIX_DECIMALS;
+	int state = 0;
+
+	v->i = 0;
+	v->d = 0;
+	for (; *s && s < e && f > 0; ++s) {
+		switch (state) {
+			case 0:
+				if (*s == '.') {
+					state = 1;
+				} else if (isdigit((int)*s)) {
+					v->i *= 10;
+					v->i += *s - '0';
+				} else return s;
+				break;
+			case 1:
+				if (!isdigit((int)*s)) return s;
+				f /= 10;
+				v->d += f * (*s - '0');
+				break;
+		}
+	}
+	return e;
+}
+
+static const char * ref_angle_parse(const char * s, const char * e, struct nmea_angle_t * v)
+{
+	struct nmea_fix_t t;
+	const char * p;
+
+	if (s == e) {
+		memset(v, 0, sizeof(*v));
+		return e;
+	}
+	p = ref_fix_parse(s, e, &t);
+	if (p == e) {
+		v->d = t.i / 100;
+		v->m = t.i % 100;
+		v->s.i = (t.d * 60) / NMEA_FIX_DECIMALS;
+		v->s.d = (t.d * 60) % NMEA_FIX_DECIMALS;
+	}
+	return p;
+}
+
+static const char * ref_time_parse(const char * s, const char * e, struct nmea_time_t * v)
+{
+	struct nmea_fix_t t;
+	const char * p;
+
+	if (s == e) {
+		memset(v, 0, sizeof(*v));
+		return e;
+	}
+	p = ref_fix_parse(s, e, &t);
+	if (p == e) {
+		v->h = (t.i / 10000) % 100;
+		v->m = (t.i / 100) % 100;
+		v->s = t.i % 100;
+		v->ms = t.d / 1000;
+	}
+	return p;
+}
+
+static const char * ref_date_parse(const char * s, const char * e, struct nmea_date_t * v)
+{
+	uint32_t t;
+	const char * p;
+
+	if (s == e) {
+		memset(v, 0, sizeof(*v));
+		return e;
+	}
+	p = ref_parse_int(s, e, &t);
+	if (p == e) {
+		v->d = (t / 10000) % 100;
+		v->m = (t / 100) % 100;
+		v->y = t % 100;
+	}
+	return p;
+}
+
+#define PARSE_COMPARE(type, ref, fast) \
+	static int compare_##fast(const char * s, const char * e) \
+	{ \
+		type a; \
+		type b; \
+		const char * pa; \
+		const char * pb; \
+		memset(&a, 0xab, sizeof(a)); \
+		memset(&b, 0xab, sizeof(b)); \
+		pa = ref(s, e, &a); \
+		pb = fast(s, e, &b); \
+		return (pa == pb) && (memcmp(&a, &b, sizeof(a)) == 0); \
+	}
+
+PARSE_COMPARE(uint32_t, ref_parse_int, parse_int)
+PARSE_COMPARE(struct nmea_fix_t, ref_fix_parse, nmea_fix_parse)
+PARSE_COMPARE(struct nmea_angle_t, ref_angle_parse, nmea_angle_parse)
+PARSE_COMPARE(struct nmea_time_t, ref_time_parse, nmea_time_parse)
+PARSE_COMPARE(struct nmea_date_t, ref_date_parse, nmea_date_parse)
+
+#undef PARSE_COMPARE
+
+/**
+ * Compares the parser against its reference implementation for all
+ * strings up to 6 characters over digits, '.', 'x' and '\0', and
+ * for random strings up to 24 characters.
+ *
+ * @return Number of mismatches.
+ */
+static uint32_t compare_parser(int (*compare)(const char *, const char *))
+{
+	static const char ALPHABET[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', 'x', '\0' };
+	static const uint32_t N = sizeof(ALPHABET);
+
+	char s[32];
+	uint32_t idx[6];
+	uint32_t len;
+	uint32_t i;
+	uint32_t k;
+	uint32_t r;
+	uint32_t mismatches = 0;
+
+	/* exhaustive */
+	for (len = 0; len <= 6; ++len) {
+		memset(idx, 0, sizeof(idx));
+		for (;;) {
+			for (i = 0; i < len; ++i)
+				s[i] = ALPHABET[idx[i]];
+			s[len] = '\0';
+			if (!compare(s, s + len))
+				++mismatches;
+			for (i = 0; i < len && ++idx[i] == N; ++i)
+				idx[i] = 0;
+			if (i == len)
+				break;
+		}
+	}
+
+	/* random, mostly digits */
+	srand(1);
+	for (k = 0; k < 200000; ++k) {
+		len = 7 + rand() % 18;
+		for (i = 0; i < len; ++i) {
+			r = rand() % 100;
+			s[i] = (r < 85) ? (char)('0' + r % 10) : ALPHABET[10 + r % 3];
+		}
+		s[len] = '\0';
+		if (!compare(s, s + len))
+			++mismatches;
+		/* end of string before the end of the data */
+		if (!compare(s, s + len + 1))
+			++mismatches;
+	}
+
+	return mismatches;
+}
+
+static void test_schema_fields(void)
+{
+	const struct nmea_sentence_t * entry;
+	const struct nmea_field_t * field;
+	uint32_t i;
+	uint32_t j;
+
+	for (i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); ++i) {
+		entry = nmea_sentence(TYPES[i]);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(entry->fields);
+		CU_ASSERT_TRUE(entry->num_fields > 0);
+		for (j = 0; j < entry->num_fields; ++j) {
+			field = &entry->fields[j];
+			CU_ASSERT_TRUE(field->kind <= NMEA_KIND_STRING);
+			if (field->kind != NMEA_KIND_SKIP)
+				CU_ASSERT_TRUE(field->offset >= offsetof(struct nmea_t, sentence));
+			CU_ASSERT_TRUE(field->offset + field->size <= sizeof(struct nmea_t));
+			if (NMEA_PRESENCE_RULE(field->presence) == NMEA_REF)
+				CU_ASSERT_TRUE(NMEA_PRESENCE_REF(field->presence) < entry->num_fields);
+		}
+	}
+}
+
+static void test_schema_round_trip(void)
+{
+	struct nmea_t nmea;
+	struct nmea_t copy;
+	char buf[NMEA_MAX_SENTENCE + 1];
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < sizeof(SENTENCES) / sizeof(SENTENCES[0]); ++i) {
+		memset(&nmea, 0, sizeof(nmea));
+		CU_ASSERT_EQUAL(nmea_read(&nmea, SENTENCES[i]), 0);
+
+		/* writing reproduces the original sentence */
+		rc = nmea_write(buf, sizeof(buf), &nmea);
+		CU_ASSERT_EQUAL(rc, (int)strlen(SENTENCES[i]));
+		CU_ASSERT_STRING_EQUAL(buf, SENTENCES[i]);
+
+		/* reading the written sentence results in the same data */
+		memset(&copy, 0, sizeof(copy));
+		CU_ASSERT_EQUAL(nmea_read(&copy, buf), 0);
+		CU_ASSERT_EQUAL(memcmp(&copy.sentence, &nmea.sentence, sizeof(nmea.sentence)), 0);
+
+		/* byte order conversion is reversible */
+		CU_ASSERT_EQUAL(nmea_hton(&copy), 0);
+		CU_ASSERT_EQUAL(nmea_ntoh(&copy), 0);
+		CU_ASSERT_EQUAL(memcmp(&copy.sentence, &nmea.sentence, sizeof(nmea.sentence)), 0);
+	}
+}
+
+static void test_fast_parse_int(void)
+{
+	const char * s = "123456789012,";
+	uint32_t v;
+
+	CU_ASSERT_EQUAL(compare_parser(compare_parse_int), 0);
+	CU_ASSERT_EQUAL(parse_int(s, s + 9, &v), s + 9);
+	CU_ASSERT_EQUAL(v, 123456789);
+	CU_ASSERT_EQUAL(parse_int(s, s + strlen(s), &v), s + 12);
+	CU_ASSERT_EQUAL(v, 3197704724u); /* overflow, as before */
+	CU_ASSERT_EQUAL(nmea_digits_pow10(0), 1);
+	CU_ASSERT_EQUAL(nmea_digits_pow10(6), 1000000);
+}
+
+static void test_fast_parse_fix(void)
+{
+	CU_ASSERT_EQUAL(compare_parser(compare_nmea_fix_parse), 0);
+}
+
+static void test_fast_parse_angle(void)
+{
+	CU_ASSERT_EQUAL(compare_parser(compare_nmea_angle_parse), 0);
+}
+
+static void test_fast_parse_time(void)
+{
+	CU_ASSERT_EQUAL(compare_parser(compare_nmea_time_parse), 0);
+}
+
+static void test_fast_parse_date(void)
+{
+	CU_ASSERT_EQUAL(compare_parser(compare_nmea_date_parse), 0);
+}
+
+static void test_convert_fixed_point(void)
+{
+	struct nmea_angle_t angle = { 47, 2, { 24, 240000 } };
+	uint32_t a = 0;
+	double d;
+
+	CU_ASSERT_EQUAL(nmea_angle_to_microdeg(NULL, &angle), -1);
+	CU_ASSERT_EQUAL(nmea_angle_to_microdeg(&a, NULL), -1);
+	CU_ASSERT_EQUAL(nmea_angle_to_microdeg(&a, &angle), 0);
+	nmea_angle_to_double(&d, &angle);
+	CU_ASSERT_EQUAL(a, (uint32_t)(d * 1.0e6 + 0.5));
+}
+
 void register_suite_nmea(void)
 {
 	CU_Suite * suite;
@@ -971,13 +1469,14 @@ void register_suite_nmea(void)
 	CU_add_test(suite, "parsing: nmea lat", test_parsing_nmea_lat);
 	CU_add_test(suite, "parsing: nmea lon", test_parsing_nmea_lon);
 	CU_add_test(suite, "parsing: sentences", test_sentence_parsing);
-	CU_add_test(suite, "writing: string", test_basic_string_writing);
 	CU_add_test(suite, "writing: nmea fix", test_basic_fix_writing);
 	CU_add_test(suite, "writing: nmea time", test_basic_time_writing);
 	CU_add_test(suite, "writing: nmea date", test_basic_date_writing);
 	CU_add_test(suite, "writing: nmea lat", test_basic_latitude_writing);
 	CU_add_test(suite, "writing: nmea lon", test_basic_longitude_writing);
+	CU_add_test(suite, "writing: uint", test_basic_uint_writing);
 	CU_add_test(suite, "writing: sentence", test_sentence_writing);
+	CU_add_test(suite, "writing: sentence writer", test_sentence_writer);
 	CU_add_test(suite, "endianess", test_endianess);
 	CU_add_test(suite, "endianess: fix hton", test_nmea_fix_endianess_hton);
 	CU_add_test(suite, "endianess: fix ntoh", test_nmea_fix_endianess_ntoh);
@@ -992,5 +1491,19 @@ void register_suite_nmea(void)
 	CU_add_test(suite, "checksum", test_checksum);
 	CU_add_test(suite, "checksum check", test_checksum_check);
 	CU_add_test(suite, "checksum write", test_checksum_write);
+	CU_add_test(suite, "sentence lookup", test_sentence_lookup);
+	CU_add_test(suite, "schema: fields", test_schema_fields);
+	CU_add_test(suite, "schema: round trip", test_schema_round_trip);
+	CU_add_test(suite, "scan kernels", test_scan_kernels);
+	CU_add_test(suite, "fast parse: int", test_fast_parse_int);
+	CU_add_test(suite, "fast parse: fix", test_fast_parse_fix);
+	CU_add_test(suite, "fast parse: angle", test_fast_parse_angle);
+	CU_add_test(suite, "fast parse: time", test_fast_parse_time);
+	CU_add_test(suite, "fast parse: date", test_fast_parse_date);
+	CU_add_test(suite, "conversion: fixed point", test_convert_fixed_point);
+	CU_add_test(suite, "stream: parameters", test_stream_parameters);
+	CU_add_test(suite, "stream: sentences", test_stream_sentences);
+	CU_add_test(suite, "stream: chunked", test_stream_chunked);
+	CU_add_test(suite, "stream: too long", test_stream_too_long);
 }
 
@@ -14,6 +14,7 @@ static void test_init(void)
 	CU_ASSERT_EQUAL(cfg.pid, -1);
 	CU_ASSERT_EQUAL(cfg.rfd, -1);
 	CU_ASSERT_EQUAL(cfg.wfd, -1);
+	CU_ASSERT_EQUAL(cfg.ring, NULL);
 	CU_ASSERT_EQUAL(cfg.cfg, NULL);
 	CU_ASSERT_EQUAL(cfg.data, NULL);
 }
@@ -0,0 +1,144 @@
+#include <cunit/CUnit.h>
+#include <test_proc_thread.h>
+#include <navcom/proc_thread.h>
+#include <navcom/message_comm.h>
+#include <navcom/message_ring.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NUM_MESSAGES 100
+
+static int num_init = 0;
+static int num_exit = 0;
+
+static int echo_init(struct proc_config_t * config, const struct property_list_t * properties)
+{
+	UNUSED_ARG(config);
+	UNUSED_ARG(properties);
+
+	++num_init;
+	return EXIT_SUCCESS;
+}
+
+static int echo_exit(struct proc_config_t * config)
+{
+	UNUSED_ARG(config);
+
+	++num_exit;
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Sends every received message back to the hub, terminates upon
+ * the termination message.
+ */
+static int echo(struct proc_config_t * config)
+{
+	struct message_t msg;
+
+	for (;;) {
+		if (proc_read(config, &msg) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+		if (msg.type == MSG_SYSTEM && msg.data.attr.system == SYSTEM_TERMINATE)
+			return EXIT_SUCCESS;
+		if (message_write(config->wfd, &msg) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+}
+
+static const struct proc_desc_t ECHO = {
+	.name = "echo",
+	.init = echo_init,
+	.exit = echo_exit,
+	.func = echo,
+	.help = NULL,
+};
+
+static void test_init(void)
+{
+	struct proc_thread_t thread;
+
+	memset(&thread, 0xff, sizeof(thread));
+	proc_thread_init(&thread);
+	CU_ASSERT_EQUAL(thread.running, 0);
+	CU_ASSERT_PTR_NULL(thread.desc);
+	CU_ASSERT_EQUAL(thread.cfg.rfd, -1);
+	CU_ASSERT_EQUAL(thread.cfg.wfd, -1);
+
+	/* not started, nothing to join */
+	proc_thread_join(&thread);
+	CU_ASSERT_EQUAL(thread.running, 0);
+}
+
+static void test_exchange_over_ring(void)
+{
+	struct proc_t cfg;
+	struct proc_config_t proc;
+	struct proc_thread_t thread;
+	struct message_ring_t ring;
+	struct message_t msg;
+	int rfd[2] = { -1, -1 };
+	int wfd[2];
+	uint32_t i;
+
+	num_init = 0;
+	num_exit = 0;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.name = "echo";
+	cfg.type = "echo";
+	proplist_init(&cfg.properties);
+
+	proc_config_init(&proc);
+	proc.cfg = &cfg;
+	proc_thread_init(&thread);
+	message_ring_init(&ring);
+	CU_ASSERT_EQUAL_FATAL(message_ring_create(&ring, 4096), EXIT_SUCCESS);
+	proc.ring = &ring;
+	CU_ASSERT_EQUAL_FATAL(pipe(wfd), 0);
+
+	CU_ASSERT_EQUAL_FATAL(proc_thread_start(&thread, &proc, &ECHO, rfd, wfd), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(thread.running, 1);
+	CU_ASSERT_EQUAL(thread.cfg.rfd, ring.efd);
+	CU_ASSERT_EQUAL(thread.cfg.wfd, wfd[1]);
+	CU_ASSERT_EQUAL(proc.rfd, wfd[0]);
+	CU_ASSERT_EQUAL(proc.pid, getpid());
+
+	/* messages sent over the ring come back over the pipe, in order */
+	for (i = 0; i < NUM_MESSAGES; ++i) {
+		memset(&msg, 0, sizeof(msg));
+		msg.type = MSG_TIMER;
+		msg.data.attr.timer_id = i;
+		CU_ASSERT_EQUAL_FATAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+		CU_ASSERT_FATAL(message_recv(proc.rfd, &msg) > 0);
+		CU_ASSERT_EQUAL(msg.type, MSG_TIMER);
+		CU_ASSERT_EQUAL(msg.data.attr.timer_id, i);
+	}
+
+	/* the thread terminates upon request, the hub sees the end of file */
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = SYSTEM_TERMINATE;
+	CU_ASSERT_EQUAL(proc_send(&proc, &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(message_recv(proc.rfd, &msg), 0);
+
+	proc_thread_join(&thread);
+	CU_ASSERT_EQUAL(thread.running, 0);
+	CU_ASSERT_EQUAL(num_init, 1);
+	CU_ASSERT_EQUAL(num_exit, 1);
+
+	close(proc.rfd);
+	message_ring_destroy(&ring);
+	proplist_free(&cfg.properties);
+}
+
+void register_suite_proc_thread(void)
+{
+	CU_Suite * suite;
+
+	suite = CU_add_suite("proc_thread", NULL, NULL);
+	CU_add_test(suite, "init", test_init);
+	CU_add_test(suite, "exchange over ring", test_exchange_over_ring);
+}
+
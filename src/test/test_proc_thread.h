@@ -0,0 +1,6 @@
+#ifndef __TEST_PROC_THREAD__H__
+#define __TEST_PROC_THREAD__H__
+
+void register_suite_proc_thread(void);
+
+#endif
@@ -0,0 +1,120 @@
+#include <cunit/CUnit.h>
+#include <test_reactor.h>
+#include <navcom/reactor.h>
+#include <common/macros.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+
+static void test_parameters(void)
+{
+	struct reactor_t reactor;
+	void * ready[1];
+
+	CU_ASSERT_EQUAL(reactor_init(NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_exit(NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_add(NULL, 0, 0, NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_remove(NULL, 0), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_wait(NULL, ready, 1, 0), -1);
+
+	CU_ASSERT_EQUAL_FATAL(reactor_init(&reactor), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_add(&reactor, -1, 0, NULL), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_remove(&reactor, -1), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, NULL, 1, 0), -1);
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 0, 0), -1);
+	CU_ASSERT_EQUAL(reactor_exit(&reactor), EXIT_SUCCESS);
+}
+
+static void test_timeout(void)
+{
+	struct reactor_t reactor;
+	void * ready[1];
+	int fd[2];
+	int rc;
+
+	CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+	CU_ASSERT_EQUAL_FATAL(reactor_init(&reactor), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_add(&reactor, fd[0], 0, &fd[0]), EXIT_SUCCESS);
+
+	/* other tests may leave timers behind, interrupting the wait */
+	do {
+		rc = reactor_wait(&reactor, ready, 1, 10);
+	} while (rc < 0 && errno == EINTR);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(reactor_exit(&reactor), EXIT_SUCCESS);
+	close(fd[0]);
+	close(fd[1]);
+}
+
+static void test_user_data(void)
+{
+	struct reactor_t reactor;
+	void * ready[2];
+	int a[2];
+	int b[2];
+	char c = 'x';
+
+	CU_ASSERT_EQUAL_FATAL(pipe(a), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(b), 0);
+	CU_ASSERT_EQUAL_FATAL(reactor_init(&reactor), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_add(&reactor, a[0], 0, &a[0]), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_add(&reactor, b[0], 0, &b[0]), EXIT_SUCCESS);
+
+	CU_ASSERT_EQUAL(write(b[1], &c, 1), 1);
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 2, 100), 1);
+	CU_ASSERT_PTR_EQUAL(ready[0], &b[0]);
+
+	/* level triggered: still readable */
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 2, 0), 1);
+	CU_ASSERT_PTR_EQUAL(ready[0], &b[0]);
+
+	CU_ASSERT_EQUAL(reactor_remove(&reactor, b[0]), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 2, 0), 0);
+
+	CU_ASSERT_EQUAL(reactor_exit(&reactor), EXIT_SUCCESS);
+	close(a[0]);
+	close(a[1]);
+	close(b[0]);
+	close(b[1]);
+}
+
+static void test_edge_triggered(void)
+{
+	struct reactor_t reactor;
+	void * ready[1];
+	int fd[2];
+	char c = 'x';
+
+	CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+	CU_ASSERT_EQUAL(fd_set_nonblocking(fd[0]), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(reactor_init(&reactor), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(reactor_add(&reactor, fd[0], REACTOR_EDGE, &fd[0]), EXIT_SUCCESS);
+
+	CU_ASSERT_EQUAL(write(fd[1], &c, 1), 1);
+	CU_ASSERT_EQUAL(write(fd[1], &c, 1), 1);
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 1, 100), 1);
+	CU_ASSERT_PTR_EQUAL(ready[0], &fd[0]);
+
+	/* no notification until new data arrives */
+	CU_ASSERT_EQUAL(reactor_wait(&reactor, ready, 1, 0), 0);
+
+	CU_ASSERT_EQUAL(read(fd[0], &c, 1), 1);
+	CU_ASSERT_EQUAL(read(fd[0], &c, 1), 1);
+	CU_ASSERT_EQUAL(read(fd[0], &c, 1), -1);
+	CU_ASSERT_EQUAL(errno, EAGAIN);
+
+	CU_ASSERT_EQUAL(reactor_exit(&reactor), EXIT_SUCCESS);
+	close(fd[0]);
+	close(fd[1]);
+}
+
+void register_suite_reactor(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("reactor", NULL, NULL);
+	CU_add_test(suite, "parameters", test_parameters);
+	CU_add_test(suite, "timeout", test_timeout);
+	CU_add_test(suite, "user data", test_user_data);
+	CU_add_test(suite, "edge triggered", test_edge_triggered);
+}
+
@@ -0,0 +1,6 @@
+#ifndef __TEST_REACTOR__H__
+#define __TEST_REACTOR__H__
+
+void register_suite_reactor(void);
+
+#endif
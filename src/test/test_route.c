@@ -0,0 +1,372 @@
+#include <cunit/CUnit.h>
+#include <test_route.h>
+#include <route.h>
+#include <registry.h>
+#include <config/config.h>
+#include <navcom/message.h>
+#include <navcom/message_comm.h>
+#include <navcom/proc.h>
+#include <navcom/filter.h>
+#include <navcom/filter_list.h>
+#include <navcom/message_queue.h>
+#include <navcom/reactor.h>
+#include <common/macros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define MAX_PROCS 8
+
+/**
+ * Number of calls of the test filters, for all routes.
+ */
+static unsigned int filter_calls = 0;
+
+static int filter_copy(
+		struct message_t * out,
+		const struct message_t * in,
+		struct filter_context_t * ctx,
+		const struct property_list_t * properties)
+{
+	UNUSED_ARG(ctx);
+	UNUSED_ARG(properties);
+
+	++filter_calls;
+	memcpy(out, in, sizeof(struct message_t));
+	return FILTER_SUCCESS;
+}
+
+static int filter_discard(
+		struct message_t * out,
+		const struct message_t * in,
+		struct filter_context_t * ctx,
+		const struct property_list_t * properties)
+{
+	UNUSED_ARG(out);
+	UNUSED_ARG(in);
+	UNUSED_ARG(ctx);
+	UNUSED_ARG(properties);
+
+	++filter_calls;
+	return FILTER_DISCARD;
+}
+
+static const struct filter_desc_t COPY = {
+	.name = "copy",
+	.init = NULL,
+	.exit = NULL,
+	.func = filter_copy,
+	.help = NULL,
+};
+
+static const struct filter_desc_t DISCARD = {
+	.name = "discard",
+	.init = NULL,
+	.exit = NULL,
+	.func = filter_discard,
+	.help = NULL,
+};
+
+static struct filter_desc_list_t filters;
+
+/**
+ * Replaces the registry of navd, the router looks up the filters
+ * of the test configurations here.
+ */
+const struct filter_desc_list_t * registry_filters(void)
+{
+	return &filters;
+}
+
+static struct config_t config;
+static struct proc_config_t procs[MAX_PROCS];
+static int rfds[MAX_PROCS];
+
+/**
+ * Sets up a configuration with sources 's0', 's1', ... and destinations
+ * 'd0', 'd1', ..., messages sent to the destinations are written to pipes.
+ */
+static void setup(size_t num_sources, size_t num_destinations)
+{
+	size_t i;
+	char name[16];
+	struct property_list_t properties;
+	int fd[2];
+
+	filter_calls = 0;
+	filterlist_init(&filters);
+	filterlist_append(&filters, &COPY);
+	filterlist_append(&filters, &DISCARD);
+
+	config_init(&config);
+	for (i = 0; i < num_sources; ++i) {
+		snprintf(name, sizeof(name), "s%lu", (unsigned long)i);
+		proplist_init(&properties);
+		config_add_source(&config, name, "test", &properties);
+	}
+	for (i = 0; i < num_destinations; ++i) {
+		snprintf(name, sizeof(name), "d%lu", (unsigned long)i);
+		proplist_init(&properties);
+		config_add_destination(&config, name, "test", &properties);
+	}
+
+	for (i = 0; i < MAX_PROCS; ++i) {
+		proc_config_init(&procs[i]);
+		rfds[i] = -1;
+	}
+	for (i = 0; i < num_destinations; ++i) {
+		CU_ASSERT_EQUAL_FATAL(pipe(fd), 0);
+		rfds[num_sources + i] = fd[0];
+		procs[num_sources + i].wfd = fd[1];
+	}
+}
+
+static void add_filter(const char * name, const char * type, const char * value)
+{
+	struct property_list_t properties;
+
+	proplist_init(&properties);
+	proplist_set(&properties, "value", value);
+	config_add_filter(&config, name, type, &properties);
+}
+
+/**
+ * Links the routes of the configuration, like the parser does, and
+ * sets up the router.
+ */
+static void start(void)
+{
+	size_t i;
+	size_t j;
+	struct route_t * route;
+
+	for (i = 0; i < config.num_sources; ++i)
+		procs[i].cfg = &config.sources[i];
+	for (i = 0; i < config.num_destinations; ++i)
+		procs[config.num_sources + i].cfg = &config.destinations[i];
+
+	for (i = 0; i < config.num_routes; ++i) {
+		route = &config.routes[i];
+		route->source = NULL;
+		route->destination = NULL;
+		route->filter = NULL;
+		for (j = 0; j < config.num_sources; ++j)
+			if (strcmp(route->name_source, config.sources[j].name) == 0)
+				route->source = &config.sources[j];
+		for (j = 0; j < config.num_destinations; ++j)
+			if (strcmp(route->name_destination, config.destinations[j].name) == 0)
+				route->destination = &config.destinations[j];
+		for (j = 0; route->name_filter && j < config.num_filters; ++j)
+			if (strcmp(route->name_filter, config.filters[j].name) == 0)
+				route->filter = &config.filters[j];
+	}
+
+	route_init(&config);
+	CU_ASSERT_EQUAL_FATAL(route_setup(&config, procs, 0, config.num_sources), 0);
+}
+
+static const struct proc_config_t * source(size_t i)
+{
+	return &procs[i];
+}
+
+static void send_timer(size_t src, uint32_t id)
+{
+	struct message_t msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_TIMER;
+	msg.data.attr.timer_id = id;
+	CU_ASSERT_EQUAL(route_msg(&config, source(src), &msg), 0);
+}
+
+/**
+ * Returns the timer ids of all messages received by the destination
+ * as decimal digits. Must be called only once per destination, the
+ * pipe is closed afterwards.
+ */
+static const char * received(size_t dst)
+{
+	static char buf[32];
+	struct message_t msg;
+	size_t i = 0;
+	size_t proc = config.num_sources + dst;
+
+	close(procs[proc].wfd);
+	procs[proc].wfd = -1;
+	while ((i < sizeof(buf) - 1) && (message_recv(rfds[proc], &msg) > 0))
+		buf[i++] = '0' + msg.data.attr.timer_id;
+	buf[i] = '\0';
+	close(rfds[proc]);
+	rfds[proc] = -1;
+	return buf;
+}
+
+static void teardown(void)
+{
+	size_t i;
+
+	route_destroy(&config);
+	for (i = 0; i < MAX_PROCS; ++i) {
+		if (procs[i].wfd >= 0)
+			close(procs[i].wfd);
+		if (rfds[i] >= 0)
+			close(rfds[i]);
+	}
+	config_free(&config);
+	filterlist_free(&filters);
+}
+
+static void test_discard_does_not_stop_routing(void)
+{
+	struct message_t msgs[3];
+	size_t i;
+
+	setup(1, 3);
+	add_filter("drop", "discard", "");
+	config_add_route(&config, "s0", NULL, "d0");
+	config_add_route(&config, "s0", "drop", "d1");
+	config_add_route(&config, "s0", NULL, "d2");
+	start();
+
+	send_timer(0, 1);
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < 3; ++i) {
+		msgs[i].type = MSG_TIMER;
+		msgs[i].data.attr.timer_id = 2 + i;
+	}
+	CU_ASSERT_EQUAL(route_msg_batch(&config, source(0), msgs, 3), 0);
+
+	CU_ASSERT_STRING_EQUAL(received(0), "1234");
+	CU_ASSERT_STRING_EQUAL(received(1), "");
+	CU_ASSERT_STRING_EQUAL(received(2), "1234");
+	CU_ASSERT_EQUAL(filter_calls, 4);
+	teardown();
+}
+
+static void test_shared_filter(void)
+{
+	setup(1, 3);
+	add_filter("f", "copy", "1");
+	config_add_route(&config, "s0", "f", "d0");
+	config_add_route(&config, "s0", NULL, "d1");
+	config_add_route(&config, "s0", "f", "d2");
+	start();
+
+	send_timer(0, 1);
+	send_timer(0, 2);
+
+	/* executed once per message for both routes */
+	CU_ASSERT_EQUAL(filter_calls, 2);
+	CU_ASSERT_STRING_EQUAL(received(0), "12");
+	CU_ASSERT_STRING_EQUAL(received(1), "12");
+	CU_ASSERT_STRING_EQUAL(received(2), "12");
+	teardown();
+}
+
+static void test_distinct_filter_configs(void)
+{
+	setup(1, 2);
+	add_filter("f1", "copy", "1");
+	add_filter("f2", "copy", "1");
+	config_add_route(&config, "s0", "f1", "d0");
+	config_add_route(&config, "s0", "f2", "d1");
+	start();
+
+	send_timer(0, 1);
+	send_timer(0, 2);
+
+	/* same type and values, but different configurations */
+	CU_ASSERT_EQUAL(filter_calls, 4);
+	CU_ASSERT_STRING_EQUAL(received(0), "12");
+	CU_ASSERT_STRING_EQUAL(received(1), "12");
+	teardown();
+}
+
+static void test_source_without_routes(void)
+{
+	setup(3, 2);
+	config_add_route(&config, "s0", NULL, "d0");
+	config_add_route(&config, "s2", NULL, "d1");
+	start();
+
+	send_timer(1, 1);
+	send_timer(0, 2);
+	send_timer(2, 3);
+
+	CU_ASSERT_STRING_EQUAL(received(0), "2");
+	CU_ASSERT_STRING_EQUAL(received(1), "3");
+	teardown();
+}
+
+static void test_interleaved_routes(void)
+{
+	setup(3, 4);
+	config_add_route(&config, "s1", NULL, "d0");
+	config_add_route(&config, "s0", NULL, "d1");
+	config_add_route(&config, "s1", NULL, "d2");
+	config_add_route(&config, "s2", NULL, "d3");
+	config_add_route(&config, "s0", NULL, "d0");
+	config_add_route(&config, "s2", NULL, "d1");
+	start();
+
+	send_timer(0, 1);
+	send_timer(1, 2);
+	send_timer(2, 3);
+	send_timer(0, 4);
+
+	CU_ASSERT_STRING_EQUAL(received(0), "124");
+	CU_ASSERT_STRING_EQUAL(received(1), "134");
+	CU_ASSERT_STRING_EQUAL(received(2), "2");
+	CU_ASSERT_STRING_EQUAL(received(3), "3");
+	teardown();
+}
+
+static void test_queue_losses_not_sent(void)
+{
+	struct message_queue_t queue;
+	unsigned long out = 0;
+	uint32_t i;
+	char buf[256];
+	FILE * file;
+
+	setup(1, 1);
+	config_add_route(&config, "s0", NULL, "d0");
+	start();
+	CU_ASSERT_EQUAL_FATAL(fd_set_nonblocking(procs[1].wfd), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL_FATAL(message_queue_init(&queue, 2, MESSAGE_QUEUE_DROP_NEWEST), EXIT_SUCCESS);
+	procs[1].queue = &queue;
+
+	/* the destination does not read, its pipe and queue run full */
+	for (i = 0; queue.dropped < 3; ++i)
+		send_timer(0, 1);
+
+	file = tmpfile();
+	CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+	route_write_metrics(&config, file);
+	rewind(file);
+	CU_ASSERT_PTR_NOT_NULL(fgets(buf, sizeof(buf), file));
+	fclose(file);
+	CU_ASSERT_EQUAL(sscanf(buf, "route s0 --> d0 in=%*u out=%lu", &out), 1);
+	CU_ASSERT_EQUAL(out, i - 3);
+
+	procs[1].queue = NULL;
+	message_queue_destroy(&queue);
+	teardown();
+}
+
+void register_suite_route(void)
+{
+	CU_Suite * suite;
+
+	suite = CU_add_suite("route", NULL, NULL);
+	CU_add_test(suite, "discard does not stop routing", test_discard_does_not_stop_routing);
+	CU_add_test(suite, "shared filter", test_shared_filter);
+	CU_add_test(suite, "distinct filter configs", test_distinct_filter_configs);
+	CU_add_test(suite, "source without routes", test_source_without_routes);
+	CU_add_test(suite, "interleaved routes", test_interleaved_routes);
+	CU_add_test(suite, "queue losses not sent", test_queue_losses_not_sent);
+}
+
@@ -0,0 +1,6 @@
+#ifndef __TEST_ROUTE__H__
+#define __TEST_ROUTE__H__
+
+void register_suite_route(void);
+
+#endif
@@ -2,11 +2,13 @@
 #include <test_source_src_lua.h>
 #include <navcom/source/src_lua.h>
 #include <navcom/source/src_lua_private.h>
+#include <navcom/message_comm.h>
 #include <common/macros.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <limits.h>
+#include <pthread.h>
 #include <lua/lua.h>
 
 static const struct proc_desc_t * proc = &src_lua;
@@ -175,6 +177,85 @@ static void test_init_scripterror(void)
 	proplist_free(&properties);
 }
 
+static void * run_proc(void * arg)
+{
+	static int rc;
+
+	rc = proc->func((struct proc_config_t *)arg);
+	return &rc;
+}
+
+static void test_gc_idle(void)
+{
+	struct proc_config_t config;
+	struct property_list_t properties;
+	struct src_lua_data_t * data;
+	struct message_t msg;
+	pthread_t thread;
+	void * result;
+	int rfd[2];
+	int wfd[2];
+	int sfd[2];
+	int i;
+
+	const char SCRIPT[] =
+		"function handle(msg)\n"
+		"	local t = {}\n"
+		"	for i = 1, 1000 do\n"
+		"		t[i] = { id = i, name = 'item' .. i }\n"
+		"	end\n"
+		"	return msg_from_table(msg, { msg_type = MSG_TIMER, data = { timer_id = 1 }})\n"
+		"end\n";
+
+	proc_config_init(&config);
+
+	proplist_init(&properties);
+	proplist_set(&properties, "script", tmpfilename);
+	proplist_set(&properties, "period", "10");
+	proplist_set(&properties, "gc", "idle");
+
+	prepare_script(SCRIPT);
+
+	CU_ASSERT_EQUAL_FATAL(proc->init(&config, &properties), EXIT_SUCCESS);
+	data = (struct src_lua_data_t *)config.data;
+	CU_ASSERT_EQUAL(data->gc.idle, 1);
+
+	CU_ASSERT_EQUAL_FATAL(pipe(rfd), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(wfd), 0);
+	CU_ASSERT_EQUAL_FATAL(pipe(sfd), 0);
+	config.rfd = rfd[0];
+	config.wfd = wfd[1];
+	config.signal_fd = sfd[0];
+
+	CU_ASSERT_EQUAL_FATAL(pthread_create(&thread, NULL, run_proc, &config), 0);
+
+	/* the garbage of one period is collected before the next period */
+	for (i = 0; i < 3; ++i) {
+		CU_ASSERT_EQUAL(message_read(wfd[0], &msg), EXIT_SUCCESS);
+		CU_ASSERT_EQUAL(msg.type, MSG_TIMER);
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = MSG_SYSTEM;
+	msg.data.attr.system = SYSTEM_TERMINATE;
+	CU_ASSERT_EQUAL(message_write(rfd[1], &msg), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(pthread_join(thread, &result), 0);
+	CU_ASSERT_EQUAL(*(int *)result, EXIT_SUCCESS);
+
+	CU_ASSERT(data->gc.steps > 0);
+	CU_ASSERT(data->gc.cycles > 0);
+
+	CU_ASSERT_EQUAL(proc->exit(&config), EXIT_SUCCESS);
+	close(rfd[0]);
+	close(rfd[1]);
+	close(wfd[0]);
+	close(wfd[1]);
+	close(sfd[0]);
+	close(sfd[1]);
+
+	proplist_free(&properties);
+}
+
 void register_suite_source_src_lua(void)
 {
 	CU_Suite * suite;
@@ -187,5 +268,6 @@ void register_suite_source_src_lua(void)
 	CU_add_test(suite, "init: empty script", test_init_emptyscript);
 	CU_add_test(suite, "init: invalid script", test_init_invalidscript);
 	CU_add_test(suite, "init: script error", test_init_scripterror);
+	CU_add_test(suite, "gc idle", test_gc_idle);
 }
 
@@ -0,0 +1,154 @@
+#include <cunit/CUnit.h>
+#include <test_trace.h>
+#include <navcom/trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/**
+ * Dumps the trace buffer into a string.
+ */
+static uint32_t dump(char * buf, size_t size)
+{
+	FILE * file;
+	size_t n;
+	uint32_t num;
+
+	file = tmpfile();
+	if (file == NULL)
+		return 0;
+	num = trace_dump(file);
+	rewind(file);
+	n = fread(buf, 1, size - 1, file);
+	buf[n] = '\0';
+	fclose(file);
+	return num;
+}
+
+static void test_categories(void)
+{
+	uint32_t c;
+
+	CU_ASSERT_EQUAL(trace_categories(NULL, &c), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(trace_categories("route", NULL), EXIT_FAILURE);
+
+	CU_ASSERT_EQUAL(trace_categories("", &c), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(c, 0);
+	CU_ASSERT_EQUAL(trace_categories("route", &c), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(c, TRACE_ROUTE);
+	CU_ASSERT_EQUAL(trace_categories("route,device,hub", &c), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(c, TRACE_ROUTE | TRACE_DEVICE | TRACE_HUB);
+	CU_ASSERT_EQUAL(trace_categories("all", &c), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(c, TRACE_ALL);
+	CU_ASSERT_EQUAL(trace_categories("rout", &c), EXIT_FAILURE);
+	CU_ASSERT_EQUAL(trace_categories("route,unknown", &c), EXIT_FAILURE);
+}
+
+static void test_no_buffer(void)
+{
+	char buf[256];
+
+	trace_exit();
+	trace_write(TRACE_ROUTE, "test %d", 1);
+	CU_ASSERT_EQUAL(trace_dump(NULL), 0);
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 0);
+}
+
+static void test_write(void)
+{
+	char buf[1024];
+
+	CU_ASSERT_EQUAL(trace_init(TRACE_ROUTE, 16), EXIT_SUCCESS);
+	CU_ASSERT_EQUAL(trace_mask, TRACE_ROUTE);
+	trace_write(TRACE_ROUTE, "message %d", 1);
+	trace_write(TRACE_FILTER, "message %s", "two");
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 2);
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "route       message 1\n"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "filter      message two\n"));
+	CU_ASSERT_TRUE(strstr(buf, "message 1") < strstr(buf, "message two"));
+	trace_exit();
+	CU_ASSERT_EQUAL(trace_mask, 0);
+}
+
+static void test_macro(void)
+{
+	char buf[1024];
+
+	CU_ASSERT_EQUAL(trace_init(TRACE_ROUTE, 16), EXIT_SUCCESS);
+	TRACE(TRACE_ROUTE, "enabled %d", 1);
+	TRACE(TRACE_FILTER, "disabled %d", 2);
+#if defined(ENABLE_TRACE)
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 1);
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "enabled 1"));
+#else
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 0);
+#endif
+	CU_ASSERT_PTR_NULL(strstr(buf, "disabled"));
+	trace_exit();
+}
+
+static void test_wrap(void)
+{
+	char buf[4096];
+	int i;
+
+	CU_ASSERT_EQUAL(trace_init(TRACE_ALL, 5), EXIT_SUCCESS); /* rounded up to 8 */
+	for (i = 0; i < 20; ++i)
+		trace_write(TRACE_HUB, "entry %02d", i);
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 8);
+	CU_ASSERT_PTR_NULL(strstr(buf, "entry 11"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "entry 12"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "entry 19"));
+	trace_exit();
+}
+
+static void test_truncate(void)
+{
+	char buf[1024];
+	char text[TRACE_TEXT_SIZE * 2];
+
+	memset(text, 'x', sizeof(text) - 1);
+	text[sizeof(text) - 1] = '\0';
+	CU_ASSERT_EQUAL(trace_init(TRACE_ALL, 4), EXIT_SUCCESS);
+	trace_write(TRACE_HUB, "%s", text);
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 1);
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, text + sizeof(text) - TRACE_TEXT_SIZE));
+	CU_ASSERT_PTR_NULL(strstr(buf, text + sizeof(text) - TRACE_TEXT_SIZE - 1));
+	trace_exit();
+}
+
+static void test_shared(void)
+{
+	char buf[1024];
+	pid_t pid;
+	int status;
+
+	CU_ASSERT_EQUAL(trace_init(TRACE_ALL, 16), EXIT_SUCCESS);
+	trace_write(TRACE_HUB, "parent");
+	pid = fork();
+	CU_ASSERT_TRUE_FATAL(pid >= 0);
+	if (pid == 0) {
+		trace_write(TRACE_SOURCE, "child");
+		_exit(EXIT_SUCCESS);
+	}
+	waitpid(pid, &status, 0);
+	CU_ASSERT_EQUAL(dump(buf, sizeof(buf)), 2);
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "parent"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(buf, "child"));
+	trace_exit();
+}
+
+void register_suite_trace(void)
+{
+	CU_Suite * suite;
+	suite = CU_add_suite("trace", NULL, NULL);
+	CU_add_test(suite, "categories", test_categories);
+	CU_add_test(suite, "no buffer", test_no_buffer);
+	CU_add_test(suite, "write", test_write);
+	CU_add_test(suite, "macro", test_macro);
+	CU_add_test(suite, "wrap", test_wrap);
+	CU_add_test(suite, "truncate", test_truncate);
+	CU_add_test(suite, "shared", test_shared);
+}
@@ -0,0 +1,6 @@
+#ifndef __TEST_TRACE__H__
+#define __TEST_TRACE__H__
+
+void register_suite_trace(void);
+
+#endif
@@ -16,10 +16,19 @@
 #include <test_fileutil.h>
 #include <test_proc.h>
 #include <test_proc_list.h>
+#include <test_proc_thread.h>
 #include <test_source_timer.h>
 #include <test_destination_nmea_serial.h>
 #include <test_destination_logbook.h>
 #include <test_destination_message_log.h>
+#include <test_message_comm.h>
+#include <test_message_ring.h>
+#include <test_message_queue.h>
+#include <test_filter_pool.h>
+#include <test_metrics.h>
+#include <test_trace.h>
+#include <test_reactor.h>
+#include <test_route.h>
 
 #if defined(ENABLE_SOURCE_GPSSERIAL)
 	#include <test_source_gps_serial.h>
@@ -51,6 +60,9 @@
 
 #if defined(NEEDS_LUA)
 	#include <test_lua_message.h>
+	#include <test_lua_cache.h>
+	#include <test_lua_alloc.h>
+	#include <test_lua_gc.h>
 #endif
 
 #if defined(ENABLE_SOURCE_LUA)
@@ -81,8 +93,17 @@ int main()
 	register_suite_fileutil();
 	register_suite_proc();
 	register_suite_proc_list();
+	register_suite_proc_thread();
 	register_suite_source_timer();
 	register_suite_destination_message_log();
+	register_suite_message_comm();
+	register_suite_message_ring();
+	register_suite_message_queue();
+	register_suite_filter_pool();
+	register_suite_metrics();
+	register_suite_trace();
+	register_suite_reactor();
+	register_suite_route();
 
 #if defined(ENABLE_SOURCE_GPSSERIAL)
 	register_suite_source_gps_serial();
@@ -94,6 +115,9 @@ int main()
 
 #if defined(NEEDS_LUA)
 	register_suite_lua_message();
+	register_suite_lua_cache();
+	register_suite_lua_alloc();
+	register_suite_lua_gc();
 #endif
 
 #if defined(NEEDS_NMEA)